@@ -99,13 +99,29 @@
 #define BLACKBOX_INVERTED_CARD_DETECTION 0
 #endif
 
-PG_REGISTER_WITH_RESET_TEMPLATE(blackboxConfig_t, blackboxConfig, PG_BLACKBOX_CONFIG, 2);
+PG_REGISTER_WITH_RESET_TEMPLATE(blackboxConfig_t, blackboxConfig, PG_BLACKBOX_CONFIG, 6);
 
 PG_RESET_TEMPLATE(blackboxConfig_t, blackboxConfig,
     .device = DEFAULT_BLACKBOX_DEVICE,
     .rate_num = SETTING_BLACKBOX_RATE_NUM_DEFAULT,
     .rate_denom = SETTING_BLACKBOX_RATE_DENOM_DEFAULT,
     .invertedCardDetection = BLACKBOX_INVERTED_CARD_DETECTION,
+#ifdef USE_BLACKBOX_DEFERRED
+    .deferred = SETTING_BLACKBOX_DEFERRED_DEFAULT,
+#endif
+#ifdef USE_BLACKBOX_COMPRESSION
+    .compression = SETTING_BLACKBOX_COMPRESSION_DEFAULT,
+#endif
+    .navRateDenom = SETTING_BLACKBOX_NAV_RATE_DENOM_DEFAULT,
+    .rcRateDenom = SETTING_BLACKBOX_RC_RATE_DENOM_DEFAULT,
+    .attitudeRateDenom = SETTING_BLACKBOX_ATTITUDE_RATE_DENOM_DEFAULT,
+    .batteryRateDenom = SETTING_BLACKBOX_BATTERY_RATE_DENOM_DEFAULT,
+#ifdef USE_BLACKBOX_PRETRIGGER
+    .pretrigger = SETTING_BLACKBOX_PRETRIGGER_DEFAULT,
+    .posttriggerTime = SETTING_BLACKBOX_POSTTRIGGER_TIME_DEFAULT,
+    .triggerImpact = SETTING_BLACKBOX_TRIGGER_IMPACT_DEFAULT,
+    .triggerOnDisarm = SETTING_BLACKBOX_TRIGGER_ON_DISARM_DEFAULT,
+#endif
     .includeFlags = BLACKBOX_FEATURE_NAV_PID | BLACKBOX_FEATURE_NAV_POS |
         BLACKBOX_FEATURE_MAG | BLACKBOX_FEATURE_ACC | BLACKBOX_FEATURE_ATTITUDE |
         BLACKBOX_FEATURE_RC_DATA | BLACKBOX_FEATURE_RC_COMMAND | BLACKBOX_FEATURE_MOTORS,
@@ -560,6 +576,44 @@ typedef struct blackboxSlowState_s {
     uint8_t activeWpNumber;
 } __attribute__((__packed__)) blackboxSlowState_t; // We pack this struct so that padding doesn't interfere with memcmp()
 
+// A logging iteration as the PID task saw it, encoded right away or later by the blackbox task
+typedef struct blackboxIterationInfo_s {
+    timeUs_t time;
+    uint32_t iteration;
+    uint16_t pFrameIndex;
+    uint16_t iFrameIndex;
+    uint32_t armingBeepTime;        // Event sources, compared with what was logged last
+    uint32_t flightModeFlags;
+} blackboxIterationInfo_t;
+
+// Flight controller state of an iteration, taken by the PID task when blackbox_deferred queues it
+typedef struct blackboxIterationState_s {
+    blackboxMainState_t main;       // Main and slow state are only loaded when the iteration logs a main frame
+    blackboxSlowState_t slow;
+#ifdef USE_GPS
+    gpsSolutionData_t gpsSol;
+    gpsLocation_t gpsHome;
+#endif
+} blackboxIterationState_t;
+
+#ifdef USE_BLACKBOX_DEFERRED
+typedef struct blackboxQueuedIteration_s {
+    blackboxIterationInfo_t info;
+    blackboxIterationState_t state;
+} blackboxQueuedIteration_t;
+
+typedef struct blackboxQueuedEvent_s {
+    uint8_t queuePosition;          // Iteration queue head when the event was logged, it goes out after the iterations before it
+    FlightLogEvent event;
+    flightLogEventData_t data;
+} blackboxQueuedEvent_t;
+
+// Must be a power of two, gives the blackbox task this many logged iterations of slack
+#define BLACKBOX_QUEUE_SIZE 4
+// Must be a power of two
+#define BLACKBOX_EVENT_QUEUE_SIZE 4
+#endif
+
 //From rc_controls.c
 extern boxBitmask_t rcModeActivationMask;
 
@@ -590,6 +644,8 @@ static uint32_t blackboxIteration;
 static uint16_t blackboxPFrameIndex;
 static uint16_t blackboxIFrameIndex;
 static uint16_t blackboxSlowFrameIterationTimer;
+// Main frames logged since the last I-frame, decides which decimated field groups are sampled
+static uint16_t blackboxMainFrameIndex;
 static bool blackboxLoggedAnyFrames;
 
 /*
@@ -610,6 +666,68 @@ static EXTENDED_FASTRAM blackboxMainState_t* blackboxHistory[3];
 
 static bool blackboxModeActivationConditionPresent = false;
 
+#ifdef USE_BLACKBOX_DEFERRED
+/*
+ * Single producer, single consumer ring of iterations for blackbox_deferred. The PID task advances
+ * head, the blackbox task advances tail. Both are free running and wrap at 256. Only a full queue
+ * makes the writer encode pending iterations itself, which is safe as tasks don't preempt each other.
+ * Events logged while iterations are pending wait in their own ring, stamped with their place in the
+ * iteration queue.
+ */
+static blackboxQueuedIteration_t blackboxQueue[BLACKBOX_QUEUE_SIZE];
+static volatile uint8_t blackboxQueueHead;
+static volatile uint8_t blackboxQueueTail;
+static bool blackboxQueueEncoding;
+
+static blackboxQueuedEvent_t blackboxEventQueue[BLACKBOX_EVENT_QUEUE_SIZE];
+static uint8_t blackboxEventQueueHead;
+static uint8_t blackboxEventQueueTail;
+
+static void blackboxEncodeQueuedIterations(int maxCount);
+
+static bool blackboxDeferredEnabled(void)
+{
+    return blackboxConfig()->deferred;
+}
+#endif
+
+#ifdef USE_BLACKBOX_PRETRIGGER
+static bool blackboxPretriggerRequested;
+static bool blackboxPretriggered;
+static timeUs_t blackboxPretriggerEndTime;
+// The log file and its headers are only started by the first trigger
+static bool blackboxPretriggerHeaderPending;
+// Disarmed while the headers were pending, the log is finished once they and the buffer are out
+static bool blackboxPretriggerFinishPending;
+
+static bool blackboxPretriggerEnabled(void)
+{
+    return blackboxConfig()->pretrigger;
+}
+#endif
+
+#ifdef USE_BLACKBOX_COMPRESSION
+/*
+ * Serial loggers can drop bytes, which a compressed stream doesn't recover from quickly.
+ * Compressing a block takes more time than the PID task can spare, so it is only done
+ * by the blackbox task of blackbox_deferred.
+ */
+static bool blackboxCompressionEnabled(void)
+{
+#ifdef USE_BLACKBOX_PRETRIGGER
+    // A compressed stream must be continuous, the one out of the pre-trigger buffer has gaps
+    if (blackboxPretriggerEnabled()) {
+        return false;
+    }
+#endif
+#ifdef USE_BLACKBOX_DEFERRED
+    return blackboxConfig()->compression && blackboxDeferredEnabled() && blackboxConfig()->device != BLACKBOX_DEVICE_SERIAL;
+#else
+    return false;
+#endif
+}
+#endif
+
 /**
  * Return true if it is safe to edit the Blackbox configuration.
  */
@@ -794,13 +912,13 @@ static void blackboxSetState(BlackboxState newState)
     blackboxState = newState;
 }
 
-static void writeIntraframe(void)
+static void writeIntraframe(uint32_t iteration)
 {
     blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
 
     blackboxWrite('I');
 
-    blackboxWriteUnsignedVB(blackboxIteration);
+    blackboxWriteUnsignedVB(iteration);
     blackboxWriteUnsignedVB(blackboxCurrent->time);
 
     blackboxWriteSignedVBArray(blackboxCurrent->axisPID_Setpoint, XYZ_AXIS_COUNT);
@@ -1026,11 +1144,21 @@ static void blackboxWriteArrayUsingAveragePredictor32(int arrOffsetInHistory, in
     }
 }
 
+static bool blackboxFieldGroupDue(uint8_t rateDenom)
+{
+    return blackboxMainFrameIndex % rateDenom == 0;
+}
+
 static void writeInterframe(void)
 {
     blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
     blackboxMainState_t *blackboxLast = blackboxHistory[1];
 
+    // Groups that aren't due are left out, the decoder knows their rates from the "Field group rates" header
+    const bool navDue = blackboxFieldGroupDue(blackboxConfig()->navRateDenom);
+    const bool rcDue = blackboxFieldGroupDue(blackboxConfig()->rcRateDenom);
+    const bool batteryDue = blackboxFieldGroupDue(blackboxConfig()->batteryRateDenom);
+
     blackboxWrite('P');
 
     //No need to store iteration count since its delta is always 1
@@ -1068,7 +1196,7 @@ static void writeInterframe(void)
     arraySubInt32(deltas, blackboxCurrent->axisPID_F, blackboxLast->axisPID_F, XYZ_AXIS_COUNT);
     blackboxWriteSignedVBArray(deltas, XYZ_AXIS_COUNT);
 
-    if (testBlackboxCondition(CONDITION(FIXED_WING_NAV))) {
+    if (navDue && testBlackboxCondition(CONDITION(FIXED_WING_NAV))) {
 
         arraySubInt32(deltas, blackboxCurrent->fwAltPID, blackboxLast->fwAltPID, 3);
         blackboxWriteSignedVBArray(deltas, 3);
@@ -1082,7 +1210,7 @@ static void writeInterframe(void)
 
     }
 
-    if (testBlackboxCondition(CONDITION(MC_NAV))) {
+    if (navDue && testBlackboxCondition(CONDITION(MC_NAV))) {
         arraySubInt32(deltas, blackboxCurrent->mcPosAxisP, blackboxLast->mcPosAxisP, XYZ_AXIS_COUNT);
         blackboxWriteSignedVBArray(deltas, XYZ_AXIS_COUNT);
 
@@ -1106,7 +1234,7 @@ static void writeInterframe(void)
      */
 
     // rcData
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_RC_DATA)) {
+    if (rcDue && testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_RC_DATA)) {
         for (int x = 0; x < 4; x++) {
             deltas[x] = blackboxCurrent->rcData[x] - blackboxLast->rcData[x];
         }
@@ -1115,7 +1243,7 @@ static void writeInterframe(void)
     }
 
     // rcCommand
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_RC_COMMAND)) {
+    if (rcDue && testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_RC_COMMAND)) {
         for (int x = 0; x < 4; x++) {
             deltas[x] = blackboxCurrent->rcCommand[x] - blackboxLast->rcCommand[x];
         }
@@ -1126,11 +1254,11 @@ static void writeInterframe(void)
     //Check for sensors that are updated periodically (so deltas are normally zero)
     int optionalFieldCount = 0;
 
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_VBAT)) {
+    if (batteryDue && testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_VBAT)) {
         deltas[optionalFieldCount++] = (int32_t) blackboxCurrent->vbat - blackboxLast->vbat;
     }
 
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_AMPERAGE)) {
+    if (batteryDue && testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_AMPERAGE)) {
         deltas[optionalFieldCount++] = (int32_t) blackboxCurrent->amperage - blackboxLast->amperage;
     }
 
@@ -1190,7 +1318,7 @@ static void writeInterframe(void)
         blackboxWriteSignedVB(blackboxCurrent->accVib - blackboxLast->accVib);
     }
 
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_ATTITUDE)) {
+    if (blackboxFieldGroupDue(blackboxConfig()->attitudeRateDenom) && testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_ATTITUDE)) {
         blackboxWriteArrayUsingAveragePredictor16(offsetof(blackboxMainState_t, attitude), XYZ_AXIS_COUNT);
     }
 
@@ -1213,7 +1341,7 @@ static void writeInterframe(void)
     /*
      * NAV_POS fields
      */
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_NAV_POS)) {
+    if (navDue && testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_NAV_POS)) {
         blackboxWriteSignedVB(blackboxCurrent->navEPH - blackboxLast->navEPH);
         blackboxWriteSignedVB(blackboxCurrent->navEPV - blackboxLast->navEPV);
 
@@ -1238,7 +1366,7 @@ static void writeInterframe(void)
         blackboxWriteSignedVB(blackboxCurrent->navSurface - blackboxLast->navSurface);
     }
 
-    if (testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_NAV_ACC)) {
+    if (navDue && testBlackboxCondition(FLIGHT_LOG_FIELD_CONDITION_NAV_ACC)) {
         for (int x = 0; x < XYZ_AXIS_COUNT; x++) {
             blackboxWriteSignedVB(blackboxHistory[0]->navAccNEU[x] - (blackboxHistory[1]->navAccNEU[x] + blackboxHistory[2]->navAccNEU[x]) / 2);
         }
@@ -1384,12 +1512,18 @@ static void loadSlowState(blackboxSlowState_t *slow)
  * If allowPeriodicWrite is true, the frame is also logged if it has been more than blackboxSInterval logging iterations
  * since the field was last logged.
  */
-static bool writeSlowFrameIfNeeded(bool allowPeriodicWrite)
+static bool writeSlowFrameIfNeeded(bool allowPeriodicWrite, const blackboxSlowState_t *slowState)
 {
     // Write the slow frame peridocially so it can be recovered if we ever lose sync
     bool shouldWrite = allowPeriodicWrite && blackboxSlowFrameIterationTimer >= blackboxSInterval;
 
-    if (shouldWrite) {
+    if (slowState) {
+        // State of a deferred iteration, taken when it was queued. The periodic write may come a few queued iterations late
+        if (shouldWrite || memcmp(slowState, &slowHistory, sizeof(slowHistory)) != 0) {
+            memcpy(&slowHistory, slowState, sizeof(slowHistory));
+            shouldWrite = true;
+        }
+    } else if (shouldWrite) {
         loadSlowState(&slowHistory);
     } else {
         blackboxSlowState_t newSlowState;
@@ -1472,6 +1606,20 @@ void blackboxStart(void)
     blackboxHistory[1] = &blackboxHistoryRing[1];
     blackboxHistory[2] = &blackboxHistoryRing[2];
 
+#ifdef USE_BLACKBOX_DEFERRED
+    blackboxQueueHead = 0;
+    blackboxQueueTail = 0;
+    blackboxEventQueueHead = 0;
+    blackboxEventQueueTail = 0;
+#endif
+
+#ifdef USE_BLACKBOX_PRETRIGGER
+    blackboxPretriggerRequested = false;
+    blackboxPretriggered = false;
+    blackboxPretriggerFinishPending = false;
+    blackboxPretriggerHeaderPending = blackboxPretriggerEnabled();
+#endif
+
     vbatReference = getBatteryRawVoltage();
 
     //No need to clear the content of blackboxHistoryRing since our first frame will be an intra which overwrites it
@@ -1494,14 +1642,43 @@ void blackboxStart(void)
     blackboxLastArmingBeep = getArmingBeepTimeMicros();
     memcpy(&blackboxLastFlightModeFlags, &rcModeActivationMask, sizeof(blackboxLastFlightModeFlags)); // record startup status
 
+#ifdef USE_BLACKBOX_PRETRIGGER
+    if (blackboxPretriggerHeaderPending) {
+        // Nothing goes to the device until a trigger fires, see blackboxStartPretriggerLog()
+        blackboxLoggedAnyFrames = false;
+        blackboxDeviceBeginPretrigger();
+        blackboxSetState(BLACKBOX_STATE_RUNNING);
+        return;
+    }
+#endif
+
+    blackboxSetState(BLACKBOX_STATE_PREPARE_LOG_FILE);
+}
+
+#ifdef USE_BLACKBOX_PRETRIGGER
+/*
+ * Opens the log and writes the headers straight to the device, in front of the frames committed to the
+ * pre-trigger buffer. Frames aren't logged while the headers go out, logging resumes at an I-frame.
+ */
+static void blackboxStartPretriggerLog(void)
+{
+    blackboxDeviceSuspendPretrigger();
     blackboxSetState(BLACKBOX_STATE_PREPARE_LOG_FILE);
 }
+#endif
 
 /**
  * Begin Blackbox shutdown.
  */
 void blackboxFinish(void)
 {
+#ifdef USE_BLACKBOX_PRETRIGGER
+    if (blackboxPretriggerHeaderPending && blackboxState >= BLACKBOX_STATE_PREPARE_LOG_FILE && blackboxState <= BLACKBOX_LAST_HEADER_SENDING_STATE) {
+        blackboxPretriggerFinishPending = true;
+        return;
+    }
+#endif
+
     switch (blackboxState) {
     case BLACKBOX_STATE_DISABLED:
     case BLACKBOX_STATE_STOPPED:
@@ -1511,6 +1688,27 @@ void blackboxFinish(void)
 
     case BLACKBOX_STATE_RUNNING:
     case BLACKBOX_STATE_PAUSED:
+#ifdef USE_BLACKBOX_DEFERRED
+        // Iterations still queued by blackbox_deferred happened before the disarm
+        blackboxEncodeQueuedIterations(BLACKBOX_QUEUE_SIZE);
+#endif
+#ifdef USE_BLACKBOX_PRETRIGGER
+        if (blackboxPretriggerHeaderPending) {
+            if (blackboxConfig()->triggerOnDisarm) {
+                blackboxDeviceCommitPretrigger();
+                blackboxPretriggerFinishPending = true;
+                blackboxStartPretriggerLog();
+            } else {
+                // No trigger fired, there is no log to close
+                blackboxDeviceClose();
+                blackboxSetState(BLACKBOX_STATE_STOPPED);
+            }
+            break;
+        }
+        if (blackboxPretriggerEnabled()) {
+            blackboxDeviceEndPretrigger(blackboxConfig()->triggerOnDisarm);
+        }
+#endif
         blackboxLogEvent(FLIGHT_LOG_EVENT_LOG_END, NULL);
         FALLTHROUGH;
 
@@ -1520,19 +1718,19 @@ void blackboxFinish(void)
 }
 
 #ifdef USE_GPS
-static void writeGPSHomeFrame(void)
+static void writeGPSHomeFrame(const gpsLocation_t *home)
 {
     blackboxWrite('H');
 
-    blackboxWriteSignedVB(GPS_home.lat);
-    blackboxWriteSignedVB(GPS_home.lon);
+    blackboxWriteSignedVB(home->lat);
+    blackboxWriteSignedVB(home->lon);
     //TODO it'd be great if we could grab the GPS current time and write that too
 
-    gpsHistory.GPS_home[0] = GPS_home.lat;
-    gpsHistory.GPS_home[1] = GPS_home.lon;
+    gpsHistory.GPS_home[0] = home->lat;
+    gpsHistory.GPS_home[1] = home->lon;
 }
 
-static void writeGPSFrame(timeUs_t currentTimeUs)
+static void writeGPSFrame(timeUs_t currentTimeUs, const gpsSolutionData_t *sol)
 {
     blackboxWrite('G');
 
@@ -1547,31 +1745,29 @@ static void writeGPSFrame(timeUs_t currentTimeUs)
         blackboxWriteUnsignedVB(currentTimeUs - blackboxHistory[1]->time);
     }
 
-    blackboxWriteUnsignedVB(gpsSol.fixType);
-    blackboxWriteUnsignedVB(gpsSol.numSat);
-    blackboxWriteSignedVB(gpsSol.llh.lat - gpsHistory.GPS_home[0]);
-    blackboxWriteSignedVB(gpsSol.llh.lon - gpsHistory.GPS_home[1]);
-    blackboxWriteSignedVB(gpsSol.llh.alt / 100); // meters
-    blackboxWriteUnsignedVB(gpsSol.groundSpeed);
-    blackboxWriteUnsignedVB(gpsSol.groundCourse);
-    blackboxWriteUnsignedVB(gpsSol.hdop);
-    blackboxWriteUnsignedVB(gpsSol.eph);
-    blackboxWriteUnsignedVB(gpsSol.epv);
-    blackboxWriteSigned16VBArray(gpsSol.velNED, XYZ_AXIS_COUNT);
-
-    gpsHistory.GPS_numSat = gpsSol.numSat;
-    gpsHistory.GPS_coord[0] = gpsSol.llh.lat;
-    gpsHistory.GPS_coord[1] = gpsSol.llh.lon;
+    blackboxWriteUnsignedVB(sol->fixType);
+    blackboxWriteUnsignedVB(sol->numSat);
+    blackboxWriteSignedVB(sol->llh.lat - gpsHistory.GPS_home[0]);
+    blackboxWriteSignedVB(sol->llh.lon - gpsHistory.GPS_home[1]);
+    blackboxWriteSignedVB(sol->llh.alt / 100); // meters
+    blackboxWriteUnsignedVB(sol->groundSpeed);
+    blackboxWriteUnsignedVB(sol->groundCourse);
+    blackboxWriteUnsignedVB(sol->hdop);
+    blackboxWriteUnsignedVB(sol->eph);
+    blackboxWriteUnsignedVB(sol->epv);
+    blackboxWriteSigned16VBArray(sol->velNED, XYZ_AXIS_COUNT);
+
+    gpsHistory.GPS_numSat = sol->numSat;
+    gpsHistory.GPS_coord[0] = sol->llh.lat;
+    gpsHistory.GPS_coord[1] = sol->llh.lon;
 }
 #endif
 
 /**
  * Fill the current state of the blackbox using values read from the flight controller
  */
-static void loadMainState(timeUs_t currentTimeUs)
+static void loadMainState(blackboxMainState_t *blackboxCurrent, timeUs_t currentTimeUs)
 {
-    blackboxMainState_t *blackboxCurrent = blackboxHistory[0];
-
     blackboxCurrent->time = currentTimeUs;
 
     const navigationPIDControllers_t *nav_pids = getNavigationPIDControllers();
@@ -1843,6 +2039,18 @@ static bool blackboxWriteSysinfo(void)
         BLACKBOX_PRINT_HEADER_LINE("Log start datetime", "%s",              blackboxGetStartDateTime(buf));
         BLACKBOX_PRINT_HEADER_LINE("Craft name", "%s",                      systemConfig()->craftName);
         BLACKBOX_PRINT_HEADER_LINE("P interval", "%u/%u",                   blackboxConfig()->rate_num, blackboxConfig()->rate_denom);
+        // Groups are only in P-frames n * denom after each I-frame, decoders hold their values in between
+        BLACKBOX_PRINT_HEADER_LINE("Field group rates", "nav:1/%u,rc:1/%u,attitude:1/%u,battery:1/%u",
+                                                                            blackboxConfig()->navRateDenom, blackboxConfig()->rcRateDenom,
+                                                                            blackboxConfig()->attitudeRateDenom, blackboxConfig()->batteryRateDenom);
+#ifdef USE_BLACKBOX_PRETRIGGER
+        // Frames only reach the log around trigger events, expect gaps between I-frames
+        BLACKBOX_PRINT_HEADER_LINE("Pretrigger", "%d",                      blackboxPretriggerEnabled() ? 1 : 0);
+#endif
+#ifdef USE_BLACKBOX_COMPRESSION
+        // Frames after the headers are compressed, see blackbox_compression.h
+        BLACKBOX_PRINT_HEADER_LINE("Data compression", "%d",                blackboxCompressionEnabled() ? 1 : 0);
+#endif
         BLACKBOX_PRINT_HEADER_LINE("minthrottle", "%d",                     getThrottleIdleValue());
         BLACKBOX_PRINT_HEADER_LINE("maxthrottle", "%d",                     motorConfig()->maxthrottle);
         BLACKBOX_PRINT_HEADER_LINE("gyro_scale", "0x%x",                    castFloatBytesToInt(1.0f));
@@ -1957,16 +2165,8 @@ static bool blackboxWriteSysinfo(void)
     return false;
 }
 
-/**
- * Write the given event to the log immediately
- */
-void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data)
+static void blackboxWriteEvent(FlightLogEvent event, const flightLogEventData_t *data)
 {
-    // Only allow events to be logged after headers have been written
-    if (!(blackboxState == BLACKBOX_STATE_RUNNING || blackboxState == BLACKBOX_STATE_PAUSED)) {
-        return;
-    }
-
     //Shared header for event frames
     blackboxWrite('E');
     blackboxWrite(event);
@@ -2003,12 +2203,74 @@ void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data)
     }
 }
 
+#ifdef USE_BLACKBOX_DEFERRED
+// Events the encoder has caught up with, those logged before the iteration at the queue tail
+static void blackboxWriteQueuedEvents(void)
+{
+    while (blackboxEventQueueTail != blackboxEventQueueHead) {
+        const blackboxQueuedEvent_t *queued = &blackboxEventQueue[blackboxEventQueueTail & (BLACKBOX_EVENT_QUEUE_SIZE - 1)];
+
+        if (queued->queuePosition != blackboxQueueTail) {
+            break;
+        }
+
+        blackboxWriteEvent(queued->event, &queued->data);
+        blackboxEventQueueTail++;
+    }
+}
+
+static void blackboxQueueEvent(FlightLogEvent event, const flightLogEventData_t *data)
+{
+    if ((uint8_t)(blackboxEventQueueHead - blackboxEventQueueTail) == BLACKBOX_EVENT_QUEUE_SIZE) {
+        // The blackbox task fell behind, catch up here rather than lose the event
+        blackboxEncodeQueuedIterations(BLACKBOX_QUEUE_SIZE);
+    }
+
+    blackboxQueuedEvent_t *queued = &blackboxEventQueue[blackboxEventQueueHead & (BLACKBOX_EVENT_QUEUE_SIZE - 1)];
+    queued->queuePosition = blackboxQueueHead;
+    queued->event = event;
+    if (data) {
+        queued->data = *data;
+    }
+
+    blackboxEventQueueHead++;
+}
+#endif
+
+/**
+ * Write the given event to the log. With blackbox_deferred it goes out after the iterations still queued.
+ */
+void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data)
+{
+    // Only allow events to be logged after headers have been written
+    if (!(blackboxState == BLACKBOX_STATE_RUNNING || blackboxState == BLACKBOX_STATE_PAUSED)) {
+        return;
+    }
+
+#ifdef USE_BLACKBOX_DEFERRED
+#ifdef USE_BLACKBOX_COMPRESSION
+    // Written from here, an event could fill a block and leave its compression to the PID task
+    const bool queueAlways = blackboxCompressionEnabled();
+#else
+    const bool queueAlways = false;
+#endif
+
+    // Events of the iteration being encoded belong right there
+    if (!blackboxQueueEncoding && (queueAlways || blackboxQueueTail != blackboxQueueHead || blackboxEventQueueTail != blackboxEventQueueHead)) {
+        blackboxQueueEvent(event, data);
+        return;
+    }
+#endif
+
+    blackboxWriteEvent(event, data);
+}
+
 /* If an arming beep has played since it was last logged, write the time of the arming beep to the log as a synchronization point */
-static void blackboxCheckAndLogArmingBeep(void)
+static void blackboxCheckAndLogArmingBeep(uint32_t armingBeepTime)
 {
     // Use != so that we can still detect a change if the counter wraps
-    if (getArmingBeepTimeMicros() != blackboxLastArmingBeep) {
-        blackboxLastArmingBeep = getArmingBeepTimeMicros();
+    if (armingBeepTime != blackboxLastArmingBeep) {
+        blackboxLastArmingBeep = armingBeepTime;
         flightLogEvent_syncBeep_t eventData;
         eventData.time = blackboxLastArmingBeep;
         blackboxLogEvent(FLIGHT_LOG_EVENT_SYNC_BEEP, (flightLogEventData_t *) &eventData);
@@ -2016,14 +2278,14 @@ static void blackboxCheckAndLogArmingBeep(void)
 }
 
 /* monitor the flight mode event status and trigger an event record if the state changes */
-static void blackboxCheckAndLogFlightMode(void)
+static void blackboxCheckAndLogFlightMode(uint32_t flightModeFlags)
 {
     // Use != so that we can still detect a change if the counter wraps
-    if (memcmp(&rcModeActivationMask, &blackboxLastFlightModeFlags, sizeof(blackboxLastFlightModeFlags))) {
+    if (flightModeFlags != blackboxLastFlightModeFlags) {
         flightLogEvent_flightMode_t eventData; // Add new data for current flight mode flags
         eventData.lastFlags = blackboxLastFlightModeFlags;
-        memcpy(&blackboxLastFlightModeFlags, &rcModeActivationMask, sizeof(blackboxLastFlightModeFlags));
-        memcpy(&eventData.flags, &rcModeActivationMask, sizeof(eventData.flags));
+        blackboxLastFlightModeFlags = flightModeFlags;
+        eventData.flags = flightModeFlags;
         blackboxLogEvent(FLIGHT_LOG_EVENT_FLIGHTMODE, (flightLogEventData_t *)&eventData);
     }
 }
@@ -2058,31 +2320,113 @@ static void blackboxAdvanceIterationTimers(void)
     }
 }
 
-// Called once every FC loop in order to log the current state
-static void blackboxLogIteration(timeUs_t currentTimeUs)
+#define HOLD_FIELD(field) memcpy(&current->field, &last->field, sizeof(current->field))
+
+/*
+ * writeInterframe() leaves the fields of groups that aren't due out of the P-frame. The decoder then
+ * keeps their last values, so does the history the predictors of the next due frame work from.
+ */
+static void blackboxHoldDecimatedFields(blackboxMainState_t *current, const blackboxMainState_t *last)
+{
+    if (!blackboxFieldGroupDue(blackboxConfig()->navRateDenom)) {
+        HOLD_FIELD(mcPosAxisP);
+        HOLD_FIELD(mcVelAxisPID);
+        HOLD_FIELD(mcVelAxisOutput);
+        HOLD_FIELD(mcSurfacePID);
+        HOLD_FIELD(mcSurfacePIDOutput);
+        HOLD_FIELD(fwAltPID);
+        HOLD_FIELD(fwAltPIDOutput);
+        HOLD_FIELD(fwPosPID);
+        HOLD_FIELD(fwPosPIDOutput);
+        HOLD_FIELD(navEPH);
+        HOLD_FIELD(navEPV);
+        HOLD_FIELD(navPos);
+        HOLD_FIELD(navRealVel);
+        HOLD_FIELD(navAccNEU);
+        HOLD_FIELD(navTargetVel);
+        HOLD_FIELD(navTargetPos);
+        HOLD_FIELD(navTargetHeading);
+        HOLD_FIELD(navSurface);
+    }
+
+    if (!blackboxFieldGroupDue(blackboxConfig()->rcRateDenom)) {
+        HOLD_FIELD(rcData);
+        HOLD_FIELD(rcCommand);
+    }
+
+    if (!blackboxFieldGroupDue(blackboxConfig()->attitudeRateDenom)) {
+        HOLD_FIELD(attitude);
+    }
+
+    if (!blackboxFieldGroupDue(blackboxConfig()->batteryRateDenom)) {
+        HOLD_FIELD(vbat);
+        HOLD_FIELD(amperage);
+    }
+}
+
+#undef HOLD_FIELD
+
+static void blackboxSetCurrentState(const blackboxIterationInfo_t *info, const blackboxMainState_t *mainState)
+{
+    if (mainState) {
+        *blackboxHistory[0] = *mainState;
+    } else {
+        loadMainState(blackboxHistory[0], info->time);
+    }
+
+    // I-frames always log everything, the decimated groups are counted from there
+    if (info->pFrameIndex == 0) {
+        blackboxMainFrameIndex = 0;
+    } else {
+        blackboxMainFrameIndex++;
+        blackboxHoldDecimatedFields(blackboxHistory[0], blackboxHistory[1]);
+    }
+}
+
+// Encode the frames of one logging iteration, state is NULL to read the flight controller state now
+static void blackboxEncodeIteration(const blackboxIterationInfo_t *info, const blackboxIterationState_t *state)
 {
+    const blackboxMainState_t *mainState = state ? &state->main : NULL;
+    const blackboxSlowState_t *slowState = state ? &state->slow : NULL;
+#ifdef USE_GPS
+    const gpsSolutionData_t *sol = state ? &state->gpsSol : &gpsSol;
+    const gpsLocation_t *home = state ? &state->gpsHome : &GPS_home;
+#endif
+
     // Write a keyframe every BLACKBOX_I_INTERVAL frames so we can resynchronise upon missing frames
-    if (blackboxShouldLogIFrame()) {
+    if (info->pFrameIndex == 0) {
+#ifdef USE_BLACKBOX_PRETRIGGER
+        // A commit out of the pre-trigger buffer may start here, give it the slow and GPS home state
+        const bool syncPoint = blackboxDeviceMarkPretriggerSyncPoint();
+#ifdef USE_GPS
+        if (syncPoint && feature(FEATURE_GPS)) {
+            writeGPSHomeFrame(home);
+        }
+#endif
+#else
+        const bool syncPoint = false;
+#endif
+
         /*
          * Don't log a slow frame if the slow data didn't change ("I" frames are already large enough without adding
          * an additional item to write at the same time). Unless we're *only* logging "I" frames, then we have no choice.
          */
-        writeSlowFrameIfNeeded(blackboxIsOnlyLoggingIntraframes());
+        writeSlowFrameIfNeeded(blackboxIsOnlyLoggingIntraframes() || syncPoint, slowState);
 
-        loadMainState(currentTimeUs);
-        writeIntraframe();
+        blackboxSetCurrentState(info, mainState);
+        writeIntraframe(info->iteration);
     } else {
-        blackboxCheckAndLogArmingBeep();
-        blackboxCheckAndLogFlightMode();
+        blackboxCheckAndLogArmingBeep(info->armingBeepTime);
+        blackboxCheckAndLogFlightMode(info->flightModeFlags);
 
-        if (blackboxShouldLogPFrame(blackboxPFrameIndex)) {
+        if (blackboxShouldLogPFrame(info->pFrameIndex)) {
             /*
              * We assume that slow frames are only interesting in that they aid the interpretation of the main data stream.
              * So only log slow frames during loop iterations where we log a main frame.
              */
-            writeSlowFrameIfNeeded(true);
+            writeSlowFrameIfNeeded(true, slowState);
 
-            loadMainState(currentTimeUs);
+            blackboxSetCurrentState(info, mainState);
             writeInterframe();
         }
 #ifdef USE_GPS
@@ -2094,15 +2438,15 @@ static void blackboxLogIteration(timeUs_t currentTimeUs)
              * We write it periodically so that if one Home Frame goes missing, the GPS coordinates can
              * still be interpreted correctly.
              */
-            if (GPS_home.lat != gpsHistory.GPS_home[0] || GPS_home.lon != gpsHistory.GPS_home[1]
-                || (blackboxPFrameIndex == (blackboxIFrameInterval / 2) && blackboxIFrameIndex % 128 == 0)) {
+            if (home->lat != gpsHistory.GPS_home[0] || home->lon != gpsHistory.GPS_home[1]
+                || (info->pFrameIndex == (blackboxIFrameInterval / 2) && info->iFrameIndex % 128 == 0)) {
 
-                writeGPSHomeFrame();
-                writeGPSFrame(currentTimeUs);
-            } else if (gpsSol.numSat != gpsHistory.GPS_numSat || gpsSol.llh.lat != gpsHistory.GPS_coord[0]
-                    || gpsSol.llh.lon != gpsHistory.GPS_coord[1]) {
+                writeGPSHomeFrame(home);
+                writeGPSFrame(info->time, sol);
+            } else if (sol->numSat != gpsHistory.GPS_numSat || sol->llh.lat != gpsHistory.GPS_coord[0]
+                    || sol->llh.lon != gpsHistory.GPS_coord[1]) {
                 //We could check for velocity changes as well but I doubt it changes independent of position
-                writeGPSFrame(currentTimeUs);
+                writeGPSFrame(info->time, sol);
             }
         }
 #endif
@@ -2112,6 +2456,145 @@ static void blackboxLogIteration(timeUs_t currentTimeUs)
     blackboxDeviceFlush();
 }
 
+#ifdef USE_BLACKBOX_DEFERRED
+// Encode up to maxCount queued iterations, oldest first, with the events queued in between
+static void blackboxEncodeQueuedIterations(int maxCount)
+{
+    // Events of the encoded iterations are written directly
+    blackboxQueueEncoding = true;
+
+    while (maxCount-- > 0 && blackboxQueueTail != blackboxQueueHead) {
+        const blackboxQueuedIteration_t *queued = &blackboxQueue[blackboxQueueTail & (BLACKBOX_QUEUE_SIZE - 1)];
+        blackboxWriteQueuedEvents();
+        blackboxEncodeIteration(&queued->info, &queued->state);
+        blackboxQueueTail++;
+    }
+    blackboxWriteQueuedEvents();
+
+    blackboxQueueEncoding = false;
+}
+
+static void blackboxDiscardQueuedIterations(void)
+{
+    blackboxQueueTail = blackboxQueueHead;
+    blackboxEventQueueTail = blackboxEventQueueHead;
+}
+
+static void blackboxQueueIteration(const blackboxIterationInfo_t *info)
+{
+    const bool logMainFrame = info->pFrameIndex == 0 || blackboxShouldLogPFrame(info->pFrameIndex);
+
+    /*
+     * GPS and event frames are only checked on queued iterations. Iterations without a main frame are
+     * queued only when the periodic GPS home frame is due.
+     */
+    if (!logMainFrame && !(feature(FEATURE_GPS) && info->pFrameIndex == blackboxIFrameInterval / 2)) {
+        return;
+    }
+
+    if ((uint8_t)(blackboxQueueHead - blackboxQueueTail) == BLACKBOX_QUEUE_SIZE) {
+        // The blackbox task fell behind, encode the oldest iteration here rather than lose a frame
+        blackboxEncodeQueuedIterations(1);
+    }
+
+    // Everything the encoder reads is taken now, the blackbox task may run several iterations later
+    blackboxQueuedIteration_t *queued = &blackboxQueue[blackboxQueueHead & (BLACKBOX_QUEUE_SIZE - 1)];
+    queued->info = *info;
+    if (logMainFrame) {
+        loadMainState(&queued->state.main, info->time);
+        loadSlowState(&queued->state.slow);
+    }
+#ifdef USE_GPS
+    queued->state.gpsSol = gpsSol;
+    queued->state.gpsHome = GPS_home;
+#endif
+
+    blackboxQueueHead++;
+}
+#endif
+
+#ifdef USE_BLACKBOX_PRETRIGGER
+/**
+ * Makes the pre-trigger buffer go out to the device, e.g. from a logic condition. Frames keep going to
+ * the device for blackbox_posttrigger_time after the last request.
+ */
+void blackboxTrigger(void)
+{
+    blackboxPretriggerRequested = true;
+}
+
+static bool blackboxPretriggerEventActive(void)
+{
+    if (blackboxPretriggerRequested || failsafeIsActive()) {
+        return true;
+    }
+
+    const uint8_t impactG = blackboxConfig()->triggerImpact;
+
+    return impactG > 0 && sensors(SENSOR_ACC)
+        && sq(acc.accADCf[X]) + sq(acc.accADCf[Y]) + sq(acc.accADCf[Z]) > sq((float)impactG);
+}
+
+static void blackboxUpdatePretrigger(timeUs_t currentTimeUs)
+{
+    if (blackboxPretriggerEventActive()) {
+        blackboxPretriggerRequested = false;
+        blackboxPretriggerEndTime = currentTimeUs + blackboxConfig()->posttriggerTime * USECS_PER_SEC;
+
+        if (!blackboxPretriggered) {
+            blackboxDeviceCommitPretrigger();
+            blackboxPretriggered = true;
+
+            if (blackboxPretriggerHeaderPending) {
+                blackboxStartPretriggerLog();
+            }
+        }
+    } else if (blackboxPretriggered && cmpTimeUs(currentTimeUs, blackboxPretriggerEndTime) >= 0) {
+        blackboxDeviceReleasePretrigger();
+        blackboxPretriggered = false;
+    }
+}
+#endif
+
+// Called once every FC loop in order to log the current state
+static void blackboxLogIteration(timeUs_t currentTimeUs)
+{
+    blackboxIterationInfo_t info = {
+        .time = currentTimeUs,
+        .iteration = blackboxIteration,
+        .pFrameIndex = blackboxPFrameIndex,
+        .iFrameIndex = blackboxIFrameIndex,
+        .armingBeepTime = getArmingBeepTimeMicros(),
+    };
+    memcpy(&info.flightModeFlags, &rcModeActivationMask, sizeof(info.flightModeFlags));
+
+#ifdef USE_BLACKBOX_DEFERRED
+    if (blackboxDeferredEnabled()) {
+        blackboxQueueIteration(&info);
+        return;
+    }
+#endif
+
+    blackboxEncodeIteration(&info, NULL);
+}
+
+#ifdef USE_BLACKBOX_DEFERRED
+/**
+ * Blackbox task for blackbox_deferred, encodes and writes out the iterations queued by the PID task.
+ */
+void blackboxUpdateDeferred(timeUs_t currentTimeUs)
+{
+    UNUSED(currentTimeUs);
+
+    if (blackboxState == BLACKBOX_STATE_RUNNING || blackboxState == BLACKBOX_STATE_PAUSED) {
+        blackboxEncodeQueuedIterations(BLACKBOX_QUEUE_SIZE);
+    } else {
+        // blackboxFinish() drains the queue, iterations are only left when the device filled up
+        blackboxDiscardQueuedIterations();
+    }
+}
+#endif
+
 /**
  * Call each flight loop iteration to perform blackbox logging.
  */
@@ -2194,13 +2677,33 @@ void blackboxUpdate(timeUs_t currentTimeUs)
              * could wipe out the end of the header if we weren't careful)
              */
             if (blackboxDeviceFlushForce()) {
+#ifdef USE_BLACKBOX_COMPRESSION
+                if (blackboxCompressionEnabled()) {
+                    blackboxDeviceBeginCompression();
+                }
+#endif
+#ifdef USE_BLACKBOX_PRETRIGGER
+                if (blackboxPretriggerHeaderPending) {
+                    // The committed frames follow the headers
+                    blackboxPretriggerHeaderPending = false;
+                    blackboxDeviceResumePretrigger();
+                    blackboxLoggedAnyFrames = true;
+                    blackboxSetState(BLACKBOX_STATE_PAUSED);
+
+                    if (blackboxPretriggerFinishPending) {
+                        blackboxPretriggerFinishPending = false;
+                        blackboxFinish();
+                    }
+                    break;
+                }
+#endif
                 blackboxSetState(BLACKBOX_STATE_RUNNING);
             }
         }
         break;
     case BLACKBOX_STATE_PAUSED:
         // Only allow resume to occur during an I-frame iteration, so that we have an "I" base to work from
-        if (IS_RC_MODE_ACTIVE(BOXBLACKBOX) && blackboxShouldLogIFrame()) {
+        if ((!blackboxModeActivationConditionPresent || IS_RC_MODE_ACTIVE(BOXBLACKBOX)) && blackboxShouldLogIFrame()) {
             // Write a log entry so the decoder is aware that our large time/iteration skip is intended
             flightLogEvent_loggingResume_t resume;
 
@@ -2221,11 +2724,30 @@ void blackboxUpdate(timeUs_t currentTimeUs)
             blackboxSetState(BLACKBOX_STATE_PAUSED);
         } else {
             blackboxLogIteration(currentTimeUs);
+#ifdef USE_BLACKBOX_PRETRIGGER
+            // After the frame, so a trigger commits it as well
+            if (blackboxPretriggerEnabled()) {
+                blackboxUpdatePretrigger(currentTimeUs);
+            }
+#endif
         }
         blackboxAdvanceIterationTimers();
         break;
     case BLACKBOX_STATE_SHUTTING_DOWN:
         //On entry of this state, startTime is set
+#ifdef USE_BLACKBOX_PRETRIGGER
+        /*
+         * Committed frames still in the pre-trigger buffer go out before the log is closed. The timeout
+         * restarts whenever the device takes some of them.
+         */
+        if (blackboxDevicePretriggerPending() && millis() < xmitState.u.startTime + BLACKBOX_SHUTDOWN_TIMEOUT_MILLIS) {
+            if (blackboxDeviceDrainPretrigger() > 0) {
+                xmitState.u.startTime = millis();
+            }
+            blackboxDeviceFlush();
+            break;
+        }
+#endif
         /*
          * Wait for the log we've transmitted to make its way to the logger before we release the serial port,
          * since releasing the port clears the Tx buffer.
@@ -2241,6 +2763,9 @@ void blackboxUpdate(timeUs_t currentTimeUs)
         break;
     }
 
+    // Headers and events written outside of a logging iteration are still staged
+    blackboxWriteBufferFlush();
+
     // Did we run out of room on the device? Stop!
     if (isBlackboxDeviceFull()) {
         blackboxSetState(BLACKBOX_STATE_STOPPED);
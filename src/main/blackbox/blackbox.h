@@ -41,6 +41,16 @@ typedef struct blackboxConfig_s {
     uint16_t rate_denom;
     uint8_t device;
     uint8_t invertedCardDetection;
+    uint8_t deferred;
+    uint8_t compression;
+    uint8_t navRateDenom;       // Field groups logged on every Nth main frame
+    uint8_t rcRateDenom;
+    uint8_t attitudeRateDenom;
+    uint8_t batteryRateDenom;
+    uint8_t pretrigger;
+    uint8_t posttriggerTime;    // Seconds
+    uint8_t triggerImpact;      // g, 0 disables the impact trigger
+    uint8_t triggerOnDisarm;
     uint32_t includeFlags;
 } blackboxConfig_t;
 
@@ -50,9 +60,16 @@ void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data);
 
 void blackboxInit(void);
 void blackboxUpdate(timeUs_t currentTimeUs);
+#ifdef USE_BLACKBOX_DEFERRED
+void blackboxUpdateDeferred(timeUs_t currentTimeUs);
+#endif
 void blackboxStart(void);
 void blackboxFinish(void);
 bool blackboxMayEditConfig(void);
 void blackboxIncludeFlagSet(uint32_t mask);
 void blackboxIncludeFlagClear(uint32_t mask);
-bool blackboxIncludeFlag(uint32_t mask);
\ No newline at end of file
+bool blackboxIncludeFlag(uint32_t mask);
+
+#ifdef USE_BLACKBOX_PRETRIGGER
+void blackboxTrigger(void);
+#endif
\ No newline at end of file
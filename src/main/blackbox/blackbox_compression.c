@@ -0,0 +1,392 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "platform.h"
+
+#ifdef USE_BLACKBOX_COMPRESSION
+
+#include "common/maths.h"
+
+#include "blackbox/blackbox_compression.h"
+
+#define HASH_EMPTY          0xFFFF
+#define MIN_MATCH           4
+#define MAX_HEADER_LENGTH   8   // Tag, sequence and two unsigned VB lengths of up to 3 bytes
+
+static uint32_t read32(const uint8_t *p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static unsigned hash32(uint32_t value)
+{
+    return (value * 2654435761u) >> (32 - BLACKBOX_COMPRESSION_HASH_BITS);
+}
+
+static uint8_t *writeUnsignedVB(uint8_t *out, uint32_t value)
+{
+    while (value > 127) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = value;
+    return out;
+}
+
+// Returns the number of bytes read, 0 if the value doesn't end within count bytes
+static int readUnsignedVB(const uint8_t *in, int count, uint32_t *value)
+{
+    *value = 0;
+
+    for (int i = 0; i < count && i < 3; i++) {
+        *value |= (uint32_t)(in[i] & 0x7F) << (7 * i);
+        if (!(in[i] & 0x80)) {
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+static uint8_t *writeLengthExtension(uint8_t *out, int length)
+{
+    for (length -= 15; length >= 255; length -= 255) {
+        *out++ = 255;
+    }
+    *out++ = length;
+    return out;
+}
+
+static uint8_t *writeSequence(uint8_t *out, const uint8_t *literals, int literalCount, int offset, int matchLength)
+{
+    uint8_t *token = out++;
+
+    *token = MIN(literalCount, 15) << 4;
+    if (literalCount >= 15) {
+        out = writeLengthExtension(out, literalCount);
+    }
+    memcpy(out, literals, literalCount);
+    out += literalCount;
+
+    // The last sequence of a block has no match
+    if (matchLength) {
+        *out++ = offset & 0xFF;
+        *out++ = offset >> 8;
+
+        *token |= MIN(matchLength - MIN_MATCH, 15);
+        if (matchLength - MIN_MATCH >= 15) {
+            out = writeLengthExtension(out, matchLength - MIN_MATCH);
+        }
+    }
+
+    return out;
+}
+
+// Keep the last BLACKBOX_COMPRESSION_WINDOW_SIZE bytes of the window and block as the new window
+static int slideWindow(uint8_t *buffer, int length)
+{
+    const int shift = MAX(length - BLACKBOX_COMPRESSION_WINDOW_SIZE, 0);
+
+    memmove(buffer, buffer + shift, length - shift);
+    return shift;
+}
+
+void blackboxCompressorInit(blackboxCompressor_t *compressor)
+{
+    compressor->windowLength = 0;
+    compressor->blockLength = 0;
+    compressor->blocksSinceReset = 0;
+    memset(compressor->hashTable, 0xFF, sizeof(compressor->hashTable));
+}
+
+// Copy frames into the block, returns how many bytes fit
+int blackboxCompressorAppend(blackboxCompressor_t *compressor, const uint8_t *data, int count)
+{
+    const int length = MIN(count, BLACKBOX_COMPRESSION_BLOCK_SIZE - compressor->blockLength);
+
+    memcpy(&compressor->buffer[compressor->windowLength + compressor->blockLength], data, length);
+    compressor->blockLength += length;
+
+    return length;
+}
+
+bool blackboxCompressorBlockFull(const blackboxCompressor_t *compressor)
+{
+    return compressor->blockLength == BLACKBOX_COMPRESSION_BLOCK_SIZE;
+}
+
+/*
+ * Compress the frames appended so far into out, which must hold BLACKBOX_COMPRESSION_MAX_OUTPUT bytes.
+ * Returns the number of bytes to write out, 0 if there was nothing to compress.
+ */
+int blackboxCompressBlock(blackboxCompressor_t *compressor, uint8_t *out)
+{
+    if (compressor->blockLength == 0) {
+        return 0;
+    }
+
+    const bool reset = compressor->blocksSinceReset == 0;
+    uint8_t *buffer = compressor->buffer;
+
+    if (reset) {
+        // Forget the window so that the block decodes on its own
+        memmove(buffer, buffer + compressor->windowLength, compressor->blockLength);
+        compressor->windowLength = 0;
+        memset(compressor->hashTable, 0xFF, sizeof(compressor->hashTable));
+    }
+
+    const int start = compressor->windowLength;
+    const int end = start + compressor->blockLength;
+    uint8_t *op = out + MAX_HEADER_LENGTH;
+    int anchor = start;
+    int ip = start;
+
+    while (ip + MIN_MATCH <= end) {
+        const uint32_t sequence = read32(buffer + ip);
+        const unsigned hash = hash32(sequence);
+        const int ref = compressor->hashTable[hash];
+
+        compressor->hashTable[hash] = ip;
+
+        if (ref == HASH_EMPTY || ip - ref > BLACKBOX_COMPRESSION_WINDOW_SIZE || read32(buffer + ref) != sequence) {
+            ip++;
+            continue;
+        }
+
+        int matchLength = MIN_MATCH;
+        while (ip + matchLength < end && buffer[ref + matchLength] == buffer[ip + matchLength]) {
+            matchLength++;
+        }
+
+        op = writeSequence(op, buffer + anchor, ip - anchor, ip - ref, matchLength);
+        ip += matchLength;
+        anchor = ip;
+
+        // Frames repeat with the frame length, index the end of the match to find the next one
+        if (ip - 2 + MIN_MATCH <= end) {
+            compressor->hashTable[hash32(read32(buffer + ip - 2))] = ip - 2;
+        }
+    }
+
+    op = writeSequence(op, buffer + anchor, end - anchor, 0, 0);
+
+    // Header in front of the compressed data
+    const int compressedLength = op - out - MAX_HEADER_LENGTH;
+    uint8_t header[MAX_HEADER_LENGTH];
+    uint8_t *hp = header;
+
+    *hp++ = reset ? BLACKBOX_COMPRESSION_RESET_BLOCK_TAG : BLACKBOX_COMPRESSION_BLOCK_TAG;
+    *hp++ = compressor->blocksSinceReset;
+    hp = writeUnsignedVB(hp, compressor->blockLength);
+    hp = writeUnsignedVB(hp, compressedLength);
+
+    const int headerLength = hp - header;
+    memmove(out + headerLength, out + MAX_HEADER_LENGTH, compressedLength);
+    memcpy(out, header, headerLength);
+
+    // Move on to the next block
+    const int shift = slideWindow(buffer, end);
+    for (int i = 0; i < (1 << BLACKBOX_COMPRESSION_HASH_BITS); i++) {
+        const uint16_t position = compressor->hashTable[i];
+        compressor->hashTable[i] = (position != HASH_EMPTY && position >= shift) ? position - shift : HASH_EMPTY;
+    }
+    compressor->windowLength = end - shift;
+    compressor->blockLength = 0;
+    compressor->blocksSinceReset = (compressor->blocksSinceReset + 1) % BLACKBOX_COMPRESSION_RESET_INTERVAL;
+
+    return headerLength + compressedLength;
+}
+
+// Compress what is left and mark the end of the stream, out must hold BLACKBOX_COMPRESSION_MAX_OUTPUT + 4 bytes
+int blackboxCompressorEnd(blackboxCompressor_t *compressor, uint8_t *out)
+{
+    uint8_t *op = out + blackboxCompressBlock(compressor, out);
+
+    *op++ = BLACKBOX_COMPRESSION_BLOCK_TAG;
+    *op++ = compressor->blocksSinceReset;
+    *op++ = 0;
+    *op++ = 0;
+
+    return op - out;
+}
+
+void blackboxDecompressorInit(blackboxDecompressor_t *decompressor)
+{
+    decompressor->windowLength = 0;
+    decompressor->blockLength = 0;
+    decompressor->nextSequence = 0;
+    decompressor->synced = false;
+    decompressor->ended = false;
+}
+
+static int readLengthExtension(const uint8_t **ip, const uint8_t *ipEnd, int length)
+{
+    if (length != 15) {
+        return length;
+    }
+
+    while (*ip < ipEnd) {
+        const uint8_t extension = *(*ip)++;
+        length += extension;
+        if (extension != 255) {
+            return length;
+        }
+    }
+
+    return -1;
+}
+
+static bool decodeSequences(uint8_t *buffer, int windowLength, const uint8_t *ip, const uint8_t *ipEnd, int rawLength)
+{
+    uint8_t *op = buffer + windowLength;
+    uint8_t * const opEnd = op + rawLength;
+
+    while (ip < ipEnd) {
+        const uint8_t token = *ip++;
+
+        const int literalCount = readLengthExtension(&ip, ipEnd, token >> 4);
+        if (literalCount < 0 || literalCount > ipEnd - ip || literalCount > opEnd - op) {
+            return false;
+        }
+        memcpy(op, ip, literalCount);
+        op += literalCount;
+        ip += literalCount;
+
+        if (ip == ipEnd) {
+            break;
+        }
+
+        if (ipEnd - ip < 2) {
+            return false;
+        }
+        const int offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        int matchLength = readLengthExtension(&ip, ipEnd, token & 0x0F);
+        if (matchLength < 0) {
+            return false;
+        }
+        matchLength += MIN_MATCH;
+
+        if (offset == 0 || offset > BLACKBOX_COMPRESSION_WINDOW_SIZE || offset > op - buffer || matchLength > opEnd - op) {
+            return false;
+        }
+
+        // Copies may overlap their own output
+        const uint8_t *ref = op - offset;
+        while (matchLength--) {
+            *op++ = *ref++;
+        }
+    }
+
+    return op == opEnd;
+}
+
+/*
+ * Decode one block from count bytes of stream. Returns the number of bytes used, 0 if more input is needed
+ * for the block, -1 if in doesn't start a valid block. On -1 skip a byte and try again, decoding starts over
+ * at the next window reset. Decoded frames are in *out until the next call, *outCount is 0 for blocks that
+ * were skipped and at the end of the stream.
+ */
+int blackboxDecompressBlock(blackboxDecompressor_t *decompressor, const uint8_t *in, int count, const uint8_t **out, int *outCount)
+{
+    *out = NULL;
+    *outCount = 0;
+
+    if (count < 1) {
+        return 0;
+    }
+
+    const uint8_t tag = in[0];
+    if (tag != BLACKBOX_COMPRESSION_RESET_BLOCK_TAG && tag != BLACKBOX_COMPRESSION_BLOCK_TAG) {
+        decompressor->synced = false;
+        return -1;
+    }
+    if (count < 2) {
+        return 0;
+    }
+
+    const uint8_t sequence = in[1];
+    uint32_t rawLength, compressedLength;
+    int headerLength = 2;
+    int length = readUnsignedVB(in + headerLength, count - headerLength, &rawLength);
+    if (length == 0) {
+        return count - headerLength >= 3 ? -1 : 0;
+    }
+    headerLength += length;
+    length = readUnsignedVB(in + headerLength, count - headerLength, &compressedLength);
+    if (length == 0) {
+        return count - headerLength >= 3 ? -1 : 0;
+    }
+    headerLength += length;
+
+    if (rawLength > BLACKBOX_COMPRESSION_BLOCK_SIZE || compressedLength > BLACKBOX_COMPRESSION_MAX_OUTPUT
+        || (rawLength == 0) != (compressedLength == 0) || (rawLength == 0 && tag != BLACKBOX_COMPRESSION_BLOCK_TAG)) {
+        decompressor->synced = false;
+        return -1;
+    }
+
+    if (rawLength == 0) {
+        decompressor->ended = true;
+        return headerLength;
+    }
+
+    // A 'Z' block only decodes right after the block before it, 'K' blocks always do
+    const bool inSequence = tag == BLACKBOX_COMPRESSION_RESET_BLOCK_TAG
+        ? sequence == 0
+        : decompressor->synced && sequence == decompressor->nextSequence;
+    if (!inSequence) {
+        decompressor->synced = false;
+        return -1;
+    }
+
+    if ((uint32_t)(count - headerLength) < compressedLength) {
+        return 0;
+    }
+
+    // The previous block joins the window
+    const int shift = slideWindow(decompressor->buffer, decompressor->windowLength + decompressor->blockLength);
+    decompressor->windowLength = decompressor->windowLength + decompressor->blockLength - shift;
+    decompressor->blockLength = 0;
+
+    if (tag == BLACKBOX_COMPRESSION_RESET_BLOCK_TAG) {
+        decompressor->windowLength = 0;
+    }
+
+    if (!decodeSequences(decompressor->buffer, decompressor->windowLength, in + headerLength, in + headerLength + compressedLength, rawLength)) {
+        decompressor->synced = false;
+        return -1;
+    }
+
+    decompressor->synced = true;
+    decompressor->nextSequence = (sequence + 1) % BLACKBOX_COMPRESSION_RESET_INTERVAL;
+    decompressor->ended = false;
+    decompressor->blockLength = rawLength;
+    *out = decompressor->buffer + decompressor->windowLength;
+    *outCount = rawLength;
+
+    return headerLength + compressedLength;
+}
+
+#endif
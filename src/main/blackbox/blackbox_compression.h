@@ -0,0 +1,85 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Streaming LZ compression of the encoded blackbox frames.
+ *
+ * The stream is a sequence of blocks, each holding up to BLACKBOX_COMPRESSION_BLOCK_SIZE
+ * bytes of frames:
+ *
+ *   tag, sequence, unsigned VB raw length, unsigned VB compressed length, compressed data
+ *
+ * Tag 'K' starts with an empty window, tag 'Z' may copy from the previous
+ * BLACKBOX_COMPRESSION_WINDOW_SIZE bytes of frames. The sequence counts blocks
+ * since the last 'K', a reader that finds a gap skips ahead to the next 'K' block.
+ * A 'Z' block with zero lengths ends the stream.
+ *
+ * Compressed data is a sequence of LZ4 style sequences:
+ *
+ *   token: literal count in the high nibble, match length - 4 in the low nibble,
+ *          15 means more count follows as bytes of 255 ended by a byte below 255
+ *   literals
+ *   match offset, 16 bit little endian, 1 .. BLACKBOX_COMPRESSION_WINDOW_SIZE
+ *   more match length
+ *
+ * The last sequence of a block has only literals.
+ */
+
+#define BLACKBOX_COMPRESSION_BLOCK_SIZE     512
+#define BLACKBOX_COMPRESSION_WINDOW_SIZE    1024
+#define BLACKBOX_COMPRESSION_HASH_BITS      9
+// Blocks between window resets, bounds what is lost after a dropped block
+#define BLACKBOX_COMPRESSION_RESET_INTERVAL 16
+
+#define BLACKBOX_COMPRESSION_BLOCK_TAG          'Z'
+#define BLACKBOX_COMPRESSION_RESET_BLOCK_TAG    'K'
+
+// Largest compressed block including its tag and lengths
+#define BLACKBOX_COMPRESSION_MAX_OUTPUT     (BLACKBOX_COMPRESSION_BLOCK_SIZE + BLACKBOX_COMPRESSION_BLOCK_SIZE / 255 + 16)
+
+typedef struct blackboxCompressor_s {
+    // Window of previous frames followed by the block being filled
+    uint8_t buffer[BLACKBOX_COMPRESSION_WINDOW_SIZE + BLACKBOX_COMPRESSION_BLOCK_SIZE];
+    uint16_t hashTable[1 << BLACKBOX_COMPRESSION_HASH_BITS];
+    uint16_t windowLength;
+    uint16_t blockLength;
+    uint8_t blocksSinceReset;
+} blackboxCompressor_t;
+
+typedef struct blackboxDecompressor_s {
+    uint8_t buffer[BLACKBOX_COMPRESSION_WINDOW_SIZE + BLACKBOX_COMPRESSION_BLOCK_SIZE];
+    uint16_t windowLength;
+    uint16_t blockLength;   // Last decoded block, follows the window
+    uint8_t nextSequence;
+    bool synced;
+    bool ended;
+} blackboxDecompressor_t;
+
+void blackboxCompressorInit(blackboxCompressor_t *compressor);
+int blackboxCompressorAppend(blackboxCompressor_t *compressor, const uint8_t *data, int count);
+bool blackboxCompressorBlockFull(const blackboxCompressor_t *compressor);
+int blackboxCompressBlock(blackboxCompressor_t *compressor, uint8_t *out);
+int blackboxCompressorEnd(blackboxCompressor_t *compressor, uint8_t *out);
+
+void blackboxDecompressorInit(blackboxDecompressor_t *decompressor);
+int blackboxDecompressBlock(blackboxDecompressor_t *decompressor, const uint8_t *in, int count, const uint8_t **out, int *outCount);
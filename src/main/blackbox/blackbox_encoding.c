@@ -102,14 +102,14 @@ void blackboxWriteSignedVB(int32_t value)
     blackboxWriteUnsignedVB(zigzagEncode(value));
 }
 
-void blackboxWriteSignedVBArray(int32_t *array, int count)
+void blackboxWriteSignedVBArray(const int32_t *array, int count)
 {
     for (int i = 0; i < count; i++) {
         blackboxWriteSignedVB(array[i]);
     }
 }
 
-void blackboxWriteSigned16VBArray(int16_t *array, int count)
+void blackboxWriteSigned16VBArray(const int16_t *array, int count)
 {
     for (int i = 0; i < count; i++) {
         blackboxWriteSignedVB(array[i]);
@@ -23,8 +23,8 @@ int blackboxPrint(const char *s);
 
 void blackboxWriteUnsignedVB(uint32_t value);
 void blackboxWriteSignedVB(int32_t value);
-void blackboxWriteSignedVBArray(int32_t *array, int count);
-void blackboxWriteSigned16VBArray(int16_t *array, int count);
+void blackboxWriteSignedVBArray(const int32_t *array, int count);
+void blackboxWriteSigned16VBArray(const int16_t *array, int count);
 void blackboxWriteS16(int16_t value);
 void blackboxWriteTag2_3S32(int32_t *values);
 void blackboxWriteTag8_4S16(int32_t *values);
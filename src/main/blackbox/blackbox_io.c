@@ -24,6 +24,7 @@
 #ifdef USE_BLACKBOX
 
 #include "blackbox.h"
+#include "blackbox_compression.h"
 #include "blackbox_io.h"
 
 #include "common/axis.h"
@@ -91,59 +92,407 @@ void blackboxOpen(void)
 }
 #endif // UNIT_TEST
 
-void blackboxWrite(uint8_t value)
+blackboxWriteBuffer_t blackboxWriteBuffer;
+
+#ifdef USE_BLACKBOX_COMPRESSION
+static blackboxCompressor_t blackboxCompressor;
+static uint8_t blackboxCompressedBlock[BLACKBOX_COMPRESSION_MAX_OUTPUT + 4];
+static bool blackboxCompressionActive;
+#endif
+
+#ifdef USE_BLACKBOX_PRETRIGGER
+#define BLACKBOX_PRETRIGGER_SYNC_POINT_COUNT    16
+// Bounds the time spent copying out of the buffer per call
+#define BLACKBOX_PRETRIGGER_MAX_DRAIN           1024
+
+STATIC_ASSERT((BLACKBOX_PRETRIGGER_BUFFER_SIZE & (BLACKBOX_PRETRIGGER_BUFFER_SIZE - 1)) == 0, pretrigger_buffer_size_not_power_of_2);
+
+/*
+ * Pre-trigger recording keeps the frames in a RAM ring instead of writing them to the device. Positions
+ * count every byte ever written to the ring, only [read, commitEnd) goes out to the device. A commit
+ * starts at a sync point, an I-frame with the slow and GPS home state in front that a decoder can start from.
+ * Committed bytes are never overwritten, new frames are dropped instead when the device can't keep up.
+ */
+// Only read back after it was written, so it can sit in the large uninitialised DMA_RAM section of H7 and AT32
+static DMA_RAM uint8_t blackboxPretriggerBuffer[BLACKBOX_PRETRIGGER_BUFFER_SIZE];
+
+static struct {
+    uint32_t syncPoints[BLACKBOX_PRETRIGGER_SYNC_POINT_COUNT];
+    uint32_t written;
+    uint32_t read;
+    uint32_t commitEnd;
+    uint8_t syncPointHead;      // Next slot, older sync points precede it
+    uint8_t syncPointCount;
+    bool active;
+    bool suspended;             // Writes go straight to the device, the buffer is kept as is
+    bool committing;            // Frames written now are committed as well
+    bool dropping;              // The device fell behind, frames are dropped until the next sync point
+} blackboxPretrigger;
+#endif
+
+static int32_t blackboxDeviceGetFreeSpace(void)
 {
     switch (blackboxConfig()->device) {
+    case BLACKBOX_DEVICE_SERIAL:
+        return serialTxBytesFree(blackboxPort);
 #ifdef USE_FLASHFS
     case BLACKBOX_DEVICE_FLASH:
-        flashfsWriteByte(value); // Write byte asynchronously
-        break;
+        return flashfsGetWriteBufferFreeSpace();
 #endif
 #ifdef USE_SDCARD
     case BLACKBOX_DEVICE_SDCARD:
-        afatfs_fputc(blackboxSDCard.logFile, value);
-        break;
+        return afatfs_getFreeBufferSpace();
 #endif
-    case BLACKBOX_DEVICE_SERIAL:
     default:
-        serialWrite(blackboxPort, value);
-        break;
+        return 0;
     }
 }
 
-// Print the null-terminated string 's' to the blackbox device and return the number of bytes written
-int blackboxPrint(const char *s)
+static void blackboxDeviceWrite(const uint8_t *data, int count)
 {
-    int length;
-    const uint8_t *pos;
-
     switch (blackboxConfig()->device) {
-
 #ifdef USE_FLASHFS
     case BLACKBOX_DEVICE_FLASH:
-        length = strlen(s);
-        flashfsWrite((const uint8_t*) s, length, false); // Write asynchronously
+        flashfsWrite(data, count, false); // Write asynchronously
         break;
 #endif
-
 #ifdef USE_SDCARD
     case BLACKBOX_DEVICE_SDCARD:
-        length = strlen(s);
-        afatfs_fwrite(blackboxSDCard.logFile, (const uint8_t*) s, length); // Ignore failures due to buffers filling up
+        afatfs_fwrite(blackboxSDCard.logFile, data, count); // Ignore failures due to buffers filling up
         break;
 #endif
-
     case BLACKBOX_DEVICE_SERIAL:
     default:
-        pos = (uint8_t*) s;
-        while (*pos) {
-            serialWrite(blackboxPort, *pos);
-            pos++;
+        /*
+         * serialWriteBuf() waits for Tx buffer space on ports without a bulk write (UARTs), which
+         * must not happen in the PID task. Keep the non-blocking per byte write for those.
+         */
+        if (blackboxPort->vTable->writeBuf) {
+            serialWriteBuf(blackboxPort, data, count);
+        } else {
+            for (int i = 0; i < count; i++) {
+                serialWrite(blackboxPort, data[i]);
+            }
         }
-
-        length = pos - (uint8_t*) s;
         break;
     }
+}
+
+#ifdef USE_BLACKBOX_PRETRIGGER
+static bool pretriggerPositionBefore(uint32_t position, uint32_t other)
+{
+    return (int32_t)(position - other) < 0;
+}
+
+// The oldest sync point at or after position, fallback if there is none
+static uint32_t pretriggerSyncPointFrom(uint32_t position, uint32_t fallback)
+{
+    for (int i = 0; i < blackboxPretrigger.syncPointCount; i++) {
+        const int index = (blackboxPretrigger.syncPointHead - blackboxPretrigger.syncPointCount + i + BLACKBOX_PRETRIGGER_SYNC_POINT_COUNT) % BLACKBOX_PRETRIGGER_SYNC_POINT_COUNT;
+        const uint32_t syncPoint = blackboxPretrigger.syncPoints[index];
+
+        if (!pretriggerPositionBefore(syncPoint, position) && pretriggerPositionBefore(syncPoint, fallback)) {
+            return syncPoint;
+        }
+    }
+
+    return fallback;
+}
+
+// Oldest position still held by the ring
+static uint32_t pretriggerOldestPosition(void)
+{
+    return blackboxPretrigger.written > BLACKBOX_PRETRIGGER_BUFFER_SIZE ? blackboxPretrigger.written - BLACKBOX_PRETRIGGER_BUFFER_SIZE : 0;
+}
+
+static void pretriggerWrite(const uint8_t *data, int count)
+{
+    if (blackboxPretrigger.dropping) {
+        return;
+    }
+
+    // Committed frames that didn't reach the device yet are kept, drop frames until there is room again
+    if (blackboxPretrigger.read != blackboxPretrigger.commitEnd
+        && blackboxPretrigger.written + count - blackboxPretrigger.read > BLACKBOX_PRETRIGGER_BUFFER_SIZE) {
+        blackboxPretrigger.dropping = true;
+
+        // A sync point marked for these frames doesn't exist
+        while (blackboxPretrigger.syncPointCount > 0) {
+            const int newest = (blackboxPretrigger.syncPointHead + BLACKBOX_PRETRIGGER_SYNC_POINT_COUNT - 1) % BLACKBOX_PRETRIGGER_SYNC_POINT_COUNT;
+            if (pretriggerPositionBefore(blackboxPretrigger.syncPoints[newest], blackboxPretrigger.written)) {
+                break;
+            }
+            blackboxPretrigger.syncPointHead = newest;
+            blackboxPretrigger.syncPointCount--;
+        }
+        return;
+    }
+
+    while (count > 0) {
+        const uint32_t offset = blackboxPretrigger.written & (BLACKBOX_PRETRIGGER_BUFFER_SIZE - 1);
+        const int chunk = MIN(count, (int)(BLACKBOX_PRETRIGGER_BUFFER_SIZE - offset));
+
+        memcpy(&blackboxPretriggerBuffer[offset], data, chunk);
+        blackboxPretrigger.written += chunk;
+        data += chunk;
+        count -= chunk;
+    }
+
+    if (blackboxPretrigger.committing) {
+        blackboxPretrigger.commitEnd = blackboxPretrigger.written;
+    }
+}
+#endif
+
+/**
+ * Hand everything staged by blackboxWrite() and blackboxPrint() over to the device with a single write.
+ */
+void blackboxWriteBufferFlush(void)
+{
+    const uint8_t *data = blackboxWriteBuffer.data;
+    const int count = blackboxWriteBuffer.count;
+
+    if (count == 0) {
+        return;
+    }
+
+#ifdef USE_BLACKBOX_PRETRIGGER
+    if (blackboxPretrigger.active && !blackboxPretrigger.suspended) {
+        pretriggerWrite(data, count);
+        blackboxWriteBuffer.count = 0;
+        return;
+    }
+#endif
+
+#ifdef USE_BLACKBOX_COMPRESSION
+    if (blackboxCompressionActive) {
+        // Only whole blocks reach the device
+        for (int appended = 0; appended < count; ) {
+            appended += blackboxCompressorAppend(&blackboxCompressor, data + appended, count - appended);
+
+            if (blackboxCompressorBlockFull(&blackboxCompressor)) {
+                blackboxDeviceWrite(blackboxCompressedBlock, blackboxCompressBlock(&blackboxCompressor, blackboxCompressedBlock));
+            }
+        }
+
+        blackboxWriteBuffer.count = 0;
+        return;
+    }
+#endif
+
+    blackboxDeviceWrite(data, count);
+    blackboxWriteBuffer.count = 0;
+}
+
+#ifdef USE_BLACKBOX_COMPRESSION
+/**
+ * Everything written from now on goes through the compressor, see blackbox_compression.h for the stream format.
+ */
+void blackboxDeviceBeginCompression(void)
+{
+    blackboxWriteBufferFlush();
+
+    blackboxCompressorInit(&blackboxCompressor);
+    blackboxCompressionActive = true;
+}
+
+// Write out the last partial block and the end of stream marker
+void blackboxDeviceEndCompression(void)
+{
+    if (!blackboxCompressionActive) {
+        return;
+    }
+
+    blackboxWriteBufferFlush();
+    blackboxDeviceWrite(blackboxCompressedBlock, blackboxCompressorEnd(&blackboxCompressor, blackboxCompressedBlock));
+    blackboxCompressionActive = false;
+}
+#endif
+
+#ifdef USE_BLACKBOX_PRETRIGGER
+/**
+ * Frames written from now on are kept in the pre-trigger buffer until blackboxDeviceCommitPretrigger().
+ */
+void blackboxDeviceBeginPretrigger(void)
+{
+    blackboxWriteBufferFlush();
+
+    blackboxPretrigger.written = 0;
+    blackboxPretrigger.read = 0;
+    blackboxPretrigger.commitEnd = 0;
+    blackboxPretrigger.syncPointHead = 0;
+    blackboxPretrigger.syncPointCount = 0;
+    blackboxPretrigger.committing = false;
+    blackboxPretrigger.dropping = false;
+    blackboxPretrigger.suspended = false;
+    blackboxPretrigger.active = true;
+}
+
+/**
+ * Writes bypass the pre-trigger buffer until blackboxDeviceResumePretrigger() and nothing is drained from it,
+ * used to write the log headers in front of the buffered frames.
+ */
+void blackboxDeviceSuspendPretrigger(void)
+{
+    blackboxWriteBufferFlush();
+    blackboxPretrigger.suspended = true;
+}
+
+void blackboxDeviceResumePretrigger(void)
+{
+    blackboxWriteBufferFlush();
+    blackboxPretrigger.suspended = false;
+}
+
+/**
+ * Call before writing an I-frame. Returns true if a commit may start at this frame, the caller must then
+ * write the state a decoder needs to start there (slow and GPS home frames) before the I-frame.
+ */
+bool blackboxDeviceMarkPretriggerSyncPoint(void)
+{
+    if (!blackboxPretrigger.active) {
+        return false;
+    }
+
+    // Staged bytes are still to go into the ring
+    const uint32_t position = blackboxPretrigger.written + blackboxWriteBuffer.count;
+
+    if (blackboxPretrigger.dropping) {
+        // Resume once the device made room for more than an I-frame
+        const uint32_t unread = blackboxPretrigger.written - blackboxPretrigger.read;
+        if (blackboxPretrigger.read != blackboxPretrigger.commitEnd
+            && unread > BLACKBOX_PRETRIGGER_BUFFER_SIZE - BLACKBOX_PRETRIGGER_BUFFER_SIZE / BLACKBOX_PRETRIGGER_SYNC_POINT_COUNT) {
+            return false;
+        }
+        blackboxPretrigger.dropping = false;
+    } else if (blackboxPretrigger.syncPointCount > 0) {
+        // Spread the sync points over the buffer
+        const int newest = (blackboxPretrigger.syncPointHead + BLACKBOX_PRETRIGGER_SYNC_POINT_COUNT - 1) % BLACKBOX_PRETRIGGER_SYNC_POINT_COUNT;
+        if (position - blackboxPretrigger.syncPoints[newest] < BLACKBOX_PRETRIGGER_BUFFER_SIZE / BLACKBOX_PRETRIGGER_SYNC_POINT_COUNT) {
+            return false;
+        }
+    }
+
+    blackboxPretrigger.syncPoints[blackboxPretrigger.syncPointHead] = position;
+    blackboxPretrigger.syncPointHead = (blackboxPretrigger.syncPointHead + 1) % BLACKBOX_PRETRIGGER_SYNC_POINT_COUNT;
+    blackboxPretrigger.syncPointCount = MIN(blackboxPretrigger.syncPointCount + 1, BLACKBOX_PRETRIGGER_SYNC_POINT_COUNT);
+
+    return true;
+}
+
+/**
+ * Send the buffered frames from the oldest sync point on to the device, and all frames written until
+ * blackboxDeviceReleasePretrigger().
+ */
+void blackboxDeviceCommitPretrigger(void)
+{
+    if (!blackboxPretrigger.active || blackboxPretrigger.committing) {
+        return;
+    }
+
+    blackboxWriteBufferFlush();
+
+    // While the last commit is still on its way out the new one follows it without a gap
+    if (blackboxPretrigger.read == blackboxPretrigger.commitEnd) {
+        uint32_t start = pretriggerOldestPosition();
+        if (pretriggerPositionBefore(start, blackboxPretrigger.commitEnd)) {
+            start = blackboxPretrigger.commitEnd;
+        }
+
+        blackboxPretrigger.read = pretriggerSyncPointFrom(start, blackboxPretrigger.written);
+    }
+
+    blackboxPretrigger.committing = true;
+    blackboxPretrigger.commitEnd = blackboxPretrigger.written;
+}
+
+// Frames written from now on stay in the buffer again, what was committed still goes out
+void blackboxDeviceReleasePretrigger(void)
+{
+    if (!blackboxPretrigger.committing) {
+        return;
+    }
+
+    blackboxWriteBufferFlush();
+
+    blackboxPretrigger.commitEnd = blackboxPretrigger.written;
+    blackboxPretrigger.committing = false;
+}
+
+/**
+ * Call before the end of log event. Commits the buffer if requested, otherwise drops the frames that
+ * weren't committed. Everything written after this follows the committed frames to the device.
+ */
+void blackboxDeviceEndPretrigger(bool commit)
+{
+    if (!blackboxPretrigger.active) {
+        return;
+    }
+
+    if (commit) {
+        blackboxDeviceCommitPretrigger();
+    }
+
+    blackboxWriteBufferFlush();
+
+    // The end of log event doesn't need a sync point in front
+    blackboxPretrigger.dropping = false;
+
+    if (blackboxPretrigger.read == blackboxPretrigger.commitEnd) {
+        blackboxPretrigger.read = blackboxPretrigger.written;
+    }
+
+    blackboxPretrigger.committing = true;
+    blackboxPretrigger.commitEnd = blackboxPretrigger.written;
+}
+
+// Write as many committed bytes as the device takes now, returns the number of bytes written
+int blackboxDeviceDrainPretrigger(void)
+{
+    int drained = 0;
+
+    if (blackboxPretrigger.suspended) {
+        return 0;
+    }
+
+    while (blackboxPretrigger.read != blackboxPretrigger.commitEnd && drained < BLACKBOX_PRETRIGGER_MAX_DRAIN) {
+        const uint32_t offset = blackboxPretrigger.read & (BLACKBOX_PRETRIGGER_BUFFER_SIZE - 1);
+        const int chunk = MIN(MIN((int)(blackboxPretrigger.commitEnd - blackboxPretrigger.read), (int)(BLACKBOX_PRETRIGGER_BUFFER_SIZE - offset)),
+            MIN(blackboxDeviceGetFreeSpace(), BLACKBOX_PRETRIGGER_MAX_DRAIN - drained));
+
+        if (chunk <= 0) {
+            break;
+        }
+
+        blackboxDeviceWrite(&blackboxPretriggerBuffer[offset], chunk);
+        blackboxPretrigger.read += chunk;
+        drained += chunk;
+    }
+
+    return drained;
+}
+
+bool blackboxDevicePretriggerPending(void)
+{
+    return !blackboxPretrigger.suspended && blackboxPretrigger.read != blackboxPretrigger.commitEnd;
+}
+#endif
+
+// Print the null-terminated string 's' to the blackbox device and return the number of bytes written
+int blackboxPrint(const char *s)
+{
+    const int length = strlen(s);
+
+    for (int written = 0; written < length; ) {
+        if (blackboxWriteBuffer.count >= BLACKBOX_WRITE_BUFFER_SIZE) {
+            blackboxWriteBufferFlush();
+        }
+
+        const int chunk = MIN(length - written, BLACKBOX_WRITE_BUFFER_SIZE - blackboxWriteBuffer.count);
+        memcpy(&blackboxWriteBuffer.data[blackboxWriteBuffer.count], s + written, chunk);
+        blackboxWriteBuffer.count += chunk;
+        written += chunk;
+    }
 
     return length;
 }
@@ -155,6 +504,11 @@ int blackboxPrint(const char *s)
  */
 void blackboxDeviceFlush(void)
 {
+    blackboxWriteBufferFlush();
+#ifdef USE_BLACKBOX_PRETRIGGER
+    blackboxDeviceDrainPretrigger();
+#endif
+
     switch (blackboxConfig()->device) {
 #ifdef USE_FLASHFS
         /*
@@ -178,6 +532,8 @@ void blackboxDeviceFlush(void)
  */
 bool blackboxDeviceFlushForce(void)
 {
+    blackboxWriteBufferFlush();
+
     switch (blackboxConfig()->device) {
     case BLACKBOX_DEVICE_SERIAL:
         // Nothing to speed up flushing on serial, as serial is continuously being drained out of its buffer
@@ -283,6 +639,18 @@ bool blackboxDeviceOpen(void)
 #ifndef UNIT_TEST
 void blackboxDeviceClose(void)
 {
+    // Staged bytes are dropped as the close is immediate
+    blackboxWriteBuffer.count = 0;
+#ifdef USE_BLACKBOX_COMPRESSION
+    blackboxCompressionActive = false;
+#endif
+#ifdef USE_BLACKBOX_PRETRIGGER
+    blackboxPretrigger.active = false;
+    blackboxPretrigger.committing = false;
+    blackboxPretrigger.dropping = false;
+    blackboxPretrigger.read = blackboxPretrigger.commitEnd = 0;
+#endif
+
     switch (blackboxConfig()->device) {
     case BLACKBOX_DEVICE_SERIAL:
         // Since the serial port could be shared with other processes, we have to give it back here
@@ -470,6 +838,11 @@ bool blackboxDeviceEndLog(bool retainLog)
     (void) retainLog;
 #endif
 
+#ifdef USE_BLACKBOX_COMPRESSION
+    blackboxDeviceEndCompression();
+#endif
+    blackboxWriteBufferFlush();
+
     switch (blackboxConfig()->device) {
 #ifdef USE_SDCARD
     case BLACKBOX_DEVICE_SDCARD:
@@ -547,25 +920,7 @@ int32_t blackboxGetLogNumber(void)
  */
 void blackboxReplenishHeaderBudget(void)
 {
-    int32_t freeSpace;
-
-    switch (blackboxConfig()->device) {
-    case BLACKBOX_DEVICE_SERIAL:
-        freeSpace = serialTxBytesFree(blackboxPort);
-        break;
-#ifdef USE_FLASHFS
-    case BLACKBOX_DEVICE_FLASH:
-        freeSpace = flashfsGetWriteBufferFreeSpace();
-        break;
-#endif
-#ifdef USE_SDCARD
-    case BLACKBOX_DEVICE_SDCARD:
-        freeSpace = afatfs_getFreeBufferSpace();
-        break;
-#endif
-    default:
-        freeSpace = 0;
-    }
+    const int32_t freeSpace = blackboxDeviceGetFreeSpace();
 
     blackboxHeaderBudget = MIN(MIN(freeSpace, blackboxHeaderBudget + blackboxMaxHeaderBytesPerIteration), BLACKBOX_MAX_ACCUMULATED_HEADER_BUDGET);
 }
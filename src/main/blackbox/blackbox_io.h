@@ -53,10 +53,52 @@ typedef enum {
  */
 #define BLACKBOX_TARGET_HEADER_BUDGET_PER_ITERATION 64
 
+// Holds at least one main frame, larger writes are split into several device writes
+#define BLACKBOX_WRITE_BUFFER_SIZE 256
+
+typedef struct blackboxWriteBuffer_s {
+    uint8_t data[BLACKBOX_WRITE_BUFFER_SIZE];
+    uint16_t count;
+} blackboxWriteBuffer_t;
+
 extern int32_t blackboxHeaderBudget;
+extern blackboxWriteBuffer_t blackboxWriteBuffer;
 
 void blackboxOpen(void);
-void blackboxWrite(uint8_t value);
+void blackboxWriteBufferFlush(void);
+
+/*
+ * Encoders append to the staging buffer, the device gets what was staged in one
+ * bulk write from blackboxWriteBufferFlush() once per frame
+ */
+static inline void blackboxWrite(uint8_t value)
+{
+    if (blackboxWriteBuffer.count >= BLACKBOX_WRITE_BUFFER_SIZE) {
+        blackboxWriteBufferFlush();
+    }
+    blackboxWriteBuffer.data[blackboxWriteBuffer.count++] = value;
+}
+
+#ifdef USE_BLACKBOX_COMPRESSION
+void blackboxDeviceBeginCompression(void);
+void blackboxDeviceEndCompression(void);
+#endif
+
+#ifdef USE_BLACKBOX_PRETRIGGER
+#ifndef BLACKBOX_PRETRIGGER_BUFFER_SIZE
+#define BLACKBOX_PRETRIGGER_BUFFER_SIZE (16 * 1024)
+#endif
+
+void blackboxDeviceBeginPretrigger(void);
+void blackboxDeviceSuspendPretrigger(void);
+void blackboxDeviceResumePretrigger(void);
+bool blackboxDeviceMarkPretriggerSyncPoint(void);
+void blackboxDeviceCommitPretrigger(void);
+void blackboxDeviceReleasePretrigger(void);
+void blackboxDeviceEndPretrigger(bool commit);
+int blackboxDeviceDrainPretrigger(void);
+bool blackboxDevicePretriggerPending(void);
+#endif
 
 void blackboxDeviceFlush(void);
 bool blackboxDeviceFlushForce(void);
@@ -72,5 +72,7 @@ typedef enum {
     DEBUG_RATE_DYNAMICS,
     DEBUG_LANDING,
     DEBUG_POS_EST,
+    DEBUG_POS_EST_EKF,
+    DEBUG_SMITH_PREDICTOR,
     DEBUG_COUNT
 } debugType_e;
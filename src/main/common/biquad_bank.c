@@ -0,0 +1,139 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#include "common/biquad_bank.h"
+
+#ifdef USE_BIQUAD_BANK_SSE
+#include <xmmintrin.h>
+#endif
+
+void biquadBankInit(biquadBank_t *bank)
+{
+    memset(bank, 0, sizeof(*bank));
+}
+
+/*
+ * Appends a stage with coefficients of the given filter, returns its index or -1 if the bank is full
+ */
+int biquadBankAddStage(biquadBank_t *bank, const biquadFilter_t *filter)
+{
+    if (bank->stageCount >= BIQUAD_BANK_MAX_STAGES) {
+        return -1;
+    }
+
+    const int stage = bank->stageCount++;
+
+    memset(&bank->state[stage], 0, sizeof(bank->state[stage]));
+    biquadBankSetCoefficients(bank, stage, filter);
+
+    return stage;
+}
+
+/*
+ * Only coefficients are replaced, state is kept so this can be used for runtime updates
+ */
+void biquadBankSetCoefficients(biquadBank_t *bank, int stage, const biquadFilter_t *filter)
+{
+    bank->b0[stage] = filter->b0;
+    bank->b1[stage] = filter->b1;
+    bank->b2[stage] = filter->b2;
+    bank->a1[stage] = filter->a1;
+    bank->a2[stage] = filter->a2;
+}
+
+/*
+ * Same operation order as biquadFilterApplyDF1(), so both kernels give the same result
+ */
+void FAST_CODE biquadBankApplyScalar(biquadBank_t *bank, float sample[XYZ_AXIS_COUNT])
+{
+    float input[XYZ_AXIS_COUNT] = { sample[X], sample[Y], sample[Z] };
+
+    for (int stage = 0; stage < bank->stageCount; stage++) {
+        biquadBankState_t *state = &bank->state[stage];
+        const float b0 = bank->b0[stage];
+        const float b1 = bank->b1[stage];
+        const float b2 = bank->b2[stage];
+        const float a1 = bank->a1[stage];
+        const float a2 = bank->a2[stage];
+
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            const float result = b0 * input[axis] + b1 * state->x1[axis] + b2 * state->x2[axis] - a1 * state->y1[axis] - a2 * state->y2[axis];
+
+            state->x2[axis] = state->x1[axis];
+            state->x1[axis] = input[axis];
+            state->y2[axis] = state->y1[axis];
+            state->y1[axis] = result;
+
+            input[axis] = result;
+        }
+    }
+
+    sample[X] = input[X];
+    sample[Y] = input[Y];
+    sample[Z] = input[Z];
+}
+
+#ifdef USE_BIQUAD_BANK_SSE
+static void biquadBankApplySse(biquadBank_t *bank, float sample[XYZ_AXIS_COUNT])
+{
+    __m128 input = _mm_set_ps(0.0f, sample[Z], sample[Y], sample[X]);
+
+    for (int stage = 0; stage < bank->stageCount; stage++) {
+        biquadBankState_t *state = &bank->state[stage];
+        const __m128 x1 = _mm_load_ps(state->x1);
+        const __m128 x2 = _mm_load_ps(state->x2);
+        const __m128 y1 = _mm_load_ps(state->y1);
+        const __m128 y2 = _mm_load_ps(state->y2);
+
+        __m128 result = _mm_mul_ps(_mm_set1_ps(bank->b0[stage]), input);
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(bank->b1[stage]), x1));
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(bank->b2[stage]), x2));
+        result = _mm_sub_ps(result, _mm_mul_ps(_mm_set1_ps(bank->a1[stage]), y1));
+        result = _mm_sub_ps(result, _mm_mul_ps(_mm_set1_ps(bank->a2[stage]), y2));
+
+        _mm_store_ps(state->x2, x1);
+        _mm_store_ps(state->x1, input);
+        _mm_store_ps(state->y2, y1);
+        _mm_store_ps(state->y1, result);
+
+        input = result;
+    }
+
+    float output[BIQUAD_BANK_LANES] ALIGNED(16);
+    _mm_store_ps(output, input);
+
+    sample[X] = output[X];
+    sample[Y] = output[Y];
+    sample[Z] = output[Z];
+}
+#endif
+
+void FAST_CODE NOINLINE biquadBankApply(biquadBank_t *bank, float sample[XYZ_AXIS_COUNT])
+{
+#ifdef USE_BIQUAD_BANK_SSE
+    biquadBankApplySse(bank, sample);
+#else
+    // Cortex-M DSP SIMD instructions work on 8 and 16 bit integers only, float math stays scalar
+    biquadBankApplyScalar(bank, sample);
+#endif
+}
@@ -0,0 +1,66 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "common/axis.h"
+#include "common/filter.h"
+#include "common/utils.h"
+
+/*
+ * Bank of DF1 biquads applied in series to the three gyro axes, with one set of
+ * coefficients per stage shared by all axes (as RPM notches are).
+ *
+ * Coefficients are stored structure-of-arrays and the state of each stage holds
+ * one lane per axis, padded to 4 lanes, so a stage maps to a single SIMD register
+ * on hosts with SSE. Other targets use the scalar kernel over the same layout.
+ */
+#ifndef BIQUAD_BANK_MAX_STAGES
+#define BIQUAD_BANK_MAX_STAGES 36   // 12 motors with 3 harmonics each
+#endif
+
+#define BIQUAD_BANK_LANES 4
+
+#if defined(__SSE__) && !defined(BIQUAD_BANK_NO_SIMD)
+#define USE_BIQUAD_BANK_SSE
+#endif
+
+typedef struct biquadBankState_s {
+    float x1[BIQUAD_BANK_LANES];
+    float x2[BIQUAD_BANK_LANES];
+    float y1[BIQUAD_BANK_LANES];
+    float y2[BIQUAD_BANK_LANES];
+} ALIGNED(16) biquadBankState_t;
+
+typedef struct biquadBank_s {
+    biquadBankState_t state[BIQUAD_BANK_MAX_STAGES];
+    float b0[BIQUAD_BANK_MAX_STAGES];
+    float b1[BIQUAD_BANK_MAX_STAGES];
+    float b2[BIQUAD_BANK_MAX_STAGES];
+    float a1[BIQUAD_BANK_MAX_STAGES];
+    float a2[BIQUAD_BANK_MAX_STAGES];
+    uint8_t stageCount;
+} biquadBank_t;
+
+void biquadBankInit(biquadBank_t *bank);
+int biquadBankAddStage(biquadBank_t *bank, const biquadFilter_t *filter);
+void biquadBankSetCoefficients(biquadBank_t *bank, int stage, const biquadFilter_t *filter);
+void biquadBankApply(biquadBank_t *bank, float sample[XYZ_AXIS_COUNT]);
+void biquadBankApplyScalar(biquadBank_t *bank, float sample[XYZ_AXIS_COUNT]);
@@ -316,6 +316,80 @@ FAST_CODE void biquadFilterUpdate(biquadFilter_t *filter, float filterFreq, uint
     filter->y2 = y2;
 }
 
+/*
+ * Sine and cosine of omega = 2 * pi * f / fs over normalised frequency f / fs in [0, 0.5].
+ * Values between entries come from the angle sum with the offset from the nearest entry,
+ * |delta| <= pi / 256 and the second order terms keep sin and cos within 1e-9 of the
+ * table. Linear interpolation is not enough: its ~7.5e-5 cos error moves a 30Hz notch
+ * by ~1Hz at 4kHz, as the centre frequency follows from cos(omega) where sin(omega) is small
+ */
+#define BIQUAD_NOTCH_TABLE_SIZE 128
+
+static float biquadNotchTableCos[BIQUAD_NOTCH_TABLE_SIZE + 1];
+static float biquadNotchTableSin[BIQUAD_NOTCH_TABLE_SIZE + 1];
+static bool biquadNotchTableReady = false;
+
+static void biquadNotchTableInit(void)
+{
+    for (int i = 0; i <= BIQUAD_NOTCH_TABLE_SIZE; i++) {
+        const float omega = M_PIf * i / BIQUAD_NOTCH_TABLE_SIZE;
+        biquadNotchTableCos[i] = cos_approx(omega);
+        biquadNotchTableSin[i] = sin_approx(omega);
+    }
+    biquadNotchTableReady = true;
+}
+
+/*
+ * Same coefficients as biquadFilterInit() with FILTER_NOTCH, but sine and cosine come from
+ * an interpolated table and the filter state is kept. Frequency is not rounded to whole Hz
+ */
+FAST_CODE void biquadFilterUpdateNotchFast(biquadFilter_t *filter, float filterFreq, uint32_t samplingIntervalUs, float Q)
+{
+    if (!biquadNotchTableReady) {
+        biquadNotchTableInit();
+    }
+
+    const float normalisedFreq = filterFreq * samplingIntervalUs * 1e-6f;
+
+    if (normalisedFreq <= 0.0f || normalisedFreq >= 0.5f) {
+        biquadFilterSetupPassthrough(filter);
+        return;
+    }
+
+    const float position = normalisedFreq * (2 * BIQUAD_NOTCH_TABLE_SIZE);
+    const int index = (int)(position + 0.5f);
+    const float delta = (position - index) * (M_PIf / BIQUAD_NOTCH_TABLE_SIZE);
+    const float cosDelta = 1.0f - 0.5f * delta * delta;
+    const float sinDelta = delta * (1.0f - delta * delta / 6.0f);
+
+    const float cs = biquadNotchTableCos[index] * cosDelta - biquadNotchTableSin[index] * sinDelta;
+    const float sn = biquadNotchTableSin[index] * cosDelta + biquadNotchTableCos[index] * sinDelta;
+    const float alpha = sn / (2 * Q);
+    const float a0Inv = 1.0f / (1 + alpha);
+
+    filter->b0 = a0Inv;
+    filter->b1 = -2 * cs * a0Inv;
+    filter->b2 = a0Inv;
+    filter->a1 = filter->b1;
+    filter->a2 = (1 - alpha) * a0Inv;
+}
+
+/*
+ * Recomputes notch coefficients only when the centre frequency moved by at least hysteresisHz
+ * from the last applied one. Returns true if coefficients were updated
+ */
+FAST_CODE bool biquadFilterUpdateNotchCached(biquadFilter_t *filter, float *appliedFreq, float filterFreq, uint32_t samplingIntervalUs, float Q, float hysteresisHz)
+{
+    if (fabsf(filterFreq - *appliedFreq) < hysteresisHz) {
+        return false;
+    }
+
+    *appliedFreq = filterFreq;
+    biquadFilterUpdateNotchFast(filter, filterFreq, samplingIntervalUs, Q);
+
+    return true;
+}
+
 void initFilter(const uint8_t filterType, filter_t *filter, const float cutoffFrequency, const uint32_t refreshRate) {
     const float dT = US2S(refreshRate);
 
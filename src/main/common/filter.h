@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
+
 typedef struct rateLimitFilter_s {
     float state;
 } rateLimitFilter_t;
@@ -129,6 +132,8 @@ float biquadFilterReset(biquadFilter_t *filter, float value);
 float biquadFilterApplyDF1(biquadFilter_t *filter, float input);
 float filterGetNotchQ(float centerFrequencyHz, float cutoffFrequencyHz);
 void biquadFilterUpdate(biquadFilter_t *filter, float filterFreq, uint32_t refreshRate, float Q, biquadFilterType_e filterType);
+void biquadFilterUpdateNotchFast(biquadFilter_t *filter, float filterFreq, uint32_t samplingIntervalUs, float Q);
+bool biquadFilterUpdateNotchCached(biquadFilter_t *filter, float *appliedFreq, float filterFreq, uint32_t samplingIntervalUs, float Q, float hysteresisHz);
 
 void alphaBetaGammaFilterInit(alphaBetaGammaFilter_t *filter, float alpha, float boostGain, float halfLife, float dT);
 float alphaBetaGammaFilterApply(alphaBetaGammaFilter_t *filter, float input);
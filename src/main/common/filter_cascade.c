@@ -0,0 +1,126 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#include "common/filter_cascade.h"
+
+void filterCascadeInit(filterCascade_t *cascade)
+{
+    memset(cascade, 0, sizeof(*cascade));
+}
+
+/*
+ * Appends a pass-through stage and returns its index, -1 if the cascade is full
+ */
+int filterCascadeAddStage(filterCascade_t *cascade)
+{
+    if (cascade->stageCount >= FILTER_CASCADE_MAX_STAGES) {
+        return -1;
+    }
+
+    const int stage = cascade->stageCount++;
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        biquadFilter_t *filter = &cascade->stages[stage][axis];
+        memset(filter, 0, sizeof(*filter));
+        filter->b0 = 1.0f;
+    }
+
+    return stage;
+}
+
+/*
+ * Output of all stages added so far will be reported through the tap
+ */
+void filterCascadeSetTap(filterCascade_t *cascade)
+{
+    cascade->tapStage = cascade->stageCount;
+}
+
+/*
+ * Coefficient setters keep the stage state, so they can be used for runtime updates
+ */
+void filterCascadeSetBiquad(filterCascade_t *cascade, int stage, int axis, const biquadFilter_t *filter)
+{
+    biquadFilter_t *dst = &cascade->stages[stage][axis];
+
+    dst->b0 = filter->b0;
+    dst->b1 = filter->b1;
+    dst->b2 = filter->b2;
+    dst->a1 = filter->a1;
+    dst->a2 = filter->a2;
+}
+
+void filterCascadeSetPt1(filterCascade_t *cascade, int stage, int axis, const pt1Filter_t *filter)
+{
+    biquadFilter_t *dst = &cascade->stages[stage][axis];
+
+    // y[n] = y[n-1] + alpha * (x[n] - y[n-1]) = alpha * x[n] + (1 - alpha) * y[n-1]
+    dst->b0 = filter->alpha;
+    dst->b1 = 0.0f;
+    dst->b2 = 0.0f;
+    dst->a1 = filter->alpha - 1.0f;
+    dst->a2 = 0.0f;
+}
+
+static inline float filterCascadeStageApply(biquadFilter_t *filter, float input)
+{
+    const float result = filter->b0 * input + filter->b1 * filter->x1 + filter->b2 * filter->x2 - filter->a1 * filter->y1 - filter->a2 * filter->y2;
+
+    filter->x2 = filter->x1;
+    filter->x1 = input;
+    filter->y2 = filter->y1;
+    filter->y1 = result;
+
+    return result;
+}
+
+void FAST_CODE NOINLINE filterCascadeApply(filterCascade_t *cascade, float sample[XYZ_AXIS_COUNT], float tap[XYZ_AXIS_COUNT])
+{
+    biquadFilter_t (*stage)[XYZ_AXIS_COUNT] = cascade->stages;
+    biquadFilter_t (* const tapStage)[XYZ_AXIS_COUNT] = cascade->stages + cascade->tapStage;
+    biquadFilter_t (* const lastStage)[XYZ_AXIS_COUNT] = cascade->stages + cascade->stageCount;
+
+    float x = sample[X];
+    float y = sample[Y];
+    float z = sample[Z];
+
+    for (; stage < tapStage; stage++) {
+        x = filterCascadeStageApply(&(*stage)[X], x);
+        y = filterCascadeStageApply(&(*stage)[Y], y);
+        z = filterCascadeStageApply(&(*stage)[Z], z);
+    }
+
+    tap[X] = x;
+    tap[Y] = y;
+    tap[Z] = z;
+
+    for (; stage < lastStage; stage++) {
+        x = filterCascadeStageApply(&(*stage)[X], x);
+        y = filterCascadeStageApply(&(*stage)[Y], y);
+        z = filterCascadeStageApply(&(*stage)[Z], z);
+    }
+
+    sample[X] = x;
+    sample[Y] = y;
+    sample[Z] = z;
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "common/axis.h"
+#include "common/filter.h"
+
+/*
+ * Chain of filters applied to all three axes in a single pass.
+ *
+ * Every stage is kept as a DF1 biquad, PT1 stages are converted when their
+ * coefficients are set. States of the three axes of a stage are stored next to
+ * each other, so the whole chain is one contiguous block and the three axes are
+ * processed as independent chains in the same loop, without indirect calls.
+ */
+#ifndef FILTER_CASCADE_MAX_STAGES
+#define FILTER_CASCADE_MAX_STAGES 8
+#endif
+
+typedef struct filterCascade_s {
+    uint8_t stageCount;
+    uint8_t tapStage;   // output of the first tapStage stages is copied to the tap
+    biquadFilter_t stages[FILTER_CASCADE_MAX_STAGES][XYZ_AXIS_COUNT];
+} filterCascade_t;
+
+void filterCascadeInit(filterCascade_t *cascade);
+int filterCascadeAddStage(filterCascade_t *cascade);
+void filterCascadeSetTap(filterCascade_t *cascade);
+void filterCascadeSetBiquad(filterCascade_t *cascade, int stage, int axis, const biquadFilter_t *filter);
+void filterCascadeSetPt1(filterCascade_t *cascade, int stage, int axis, const pt1Filter_t *filter);
+void filterCascadeApply(filterCascade_t *cascade, float sample[XYZ_AXIS_COUNT], float tap[XYZ_AXIS_COUNT]);
@@ -0,0 +1,92 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#include "common/fir_decimator.h"
+#include "common/maths.h"
+#include "common/utils.h"
+
+/*
+ * Hamming windowed sinc lowpass with unity DC gain. Cutoff is limited to the input Nyquist frequency
+ */
+void firDecimatorInit(firDecimator_t *decimator, uint8_t tapCount, float cutoffHz, uint32_t inputIntervalUs)
+{
+    memset(decimator, 0, sizeof(*decimator));
+
+    decimator->tapCount = constrain(tapCount, 1, FIR_DECIMATOR_MAX_TAPS);
+
+    const float normalisedCutoff = constrainf(cutoffHz * inputIntervalUs * 1e-6f, 0.0f, 0.5f);
+    const float center = (decimator->tapCount - 1) / 2.0f;
+    float sum = 0.0f;
+
+    for (int i = 0; i < decimator->tapCount; i++) {
+        const float x = i - center;
+        float sinc = 2.0f * normalisedCutoff;
+        if (x != 0.0f) {
+            sinc = sin_approx(2.0f * M_PIf * normalisedCutoff * x) / (M_PIf * x);
+        }
+
+        float window = 1.0f;
+        if (decimator->tapCount > 1) {
+            window = 0.54f - 0.46f * cos_approx(2.0f * M_PIf * i / (decimator->tapCount - 1));
+        }
+
+        decimator->coefficients[i] = sinc * window;
+        sum += decimator->coefficients[i];
+    }
+
+    for (int i = 0; i < decimator->tapCount; i++) {
+        decimator->coefficients[i] = sum != 0.0f ? decimator->coefficients[i] / sum : 1.0f / decimator->tapCount;
+    }
+}
+
+FAST_CODE void firDecimatorPush(firDecimator_t *decimator, const float sample[XYZ_AXIS_COUNT])
+{
+    const int index = decimator->index;
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        decimator->history[axis][index] = sample[axis];
+        decimator->history[axis][index + decimator->tapCount] = sample[axis];
+    }
+
+    decimator->index = (index + 1 == decimator->tapCount) ? 0 : index + 1;
+}
+
+/*
+ * Filter output for the most recently pushed sample
+ */
+FAST_CODE NOINLINE void firDecimatorApply(const firDecimator_t *decimator, float output[XYZ_AXIS_COUNT])
+{
+    const int tapCount = decimator->tapCount;
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        // Oldest sample first, coefficients are symmetric
+        const float *window = &decimator->history[axis][decimator->index];
+        float acc = 0.0f;
+
+        for (int i = 0; i < tapCount; i++) {
+            acc += decimator->coefficients[i] * window[i];
+        }
+
+        output[axis] = acc;
+    }
+}
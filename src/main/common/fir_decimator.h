@@ -0,0 +1,46 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "common/axis.h"
+
+/*
+ * Decimating linear phase FIR lowpass for three axes.
+ *
+ * Samples are pushed at the input rate and only stored. The FIR is evaluated
+ * only when a decimated output is read, so the cost is tapCount multiplications
+ * per axis and output sample, as with a polyphase decimator, while the output
+ * phase follows the reader instead of a fixed input sample count.
+ *
+ * History is stored twice, so the last tapCount samples are always contiguous.
+ */
+#define FIR_DECIMATOR_MAX_TAPS 32
+
+typedef struct firDecimator_s {
+    float coefficients[FIR_DECIMATOR_MAX_TAPS];
+    float history[XYZ_AXIS_COUNT][2 * FIR_DECIMATOR_MAX_TAPS];
+    uint8_t tapCount;
+    uint8_t index;
+} firDecimator_t;
+
+void firDecimatorInit(firDecimator_t *decimator, uint8_t tapCount, float cutoffHz, uint32_t inputIntervalUs);
+void firDecimatorPush(firDecimator_t *decimator, const float sample[XYZ_AXIS_COUNT]);
+void firDecimatorApply(const firDecimator_t *decimator, float output[XYZ_AXIS_COUNT]);
@@ -0,0 +1,82 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+#include "platform.h"
+
+#include "common/linalg.h"
+
+void mat3Multiply(fpMat3_t *result, const fpMat3_t *a, const fpMat3_t *b)
+{
+    fpMat3_t r;
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            r.m[i][j] = a->m[i][0] * b->m[0][j] + a->m[i][1] * b->m[1][j] + a->m[i][2] * b->m[2][j];
+        }
+    }
+
+    *result = r;
+}
+
+void mat4Multiply(fpMat4_t *result, const fpMat4_t *a, const fpMat4_t *b)
+{
+    fpMat4_t r;
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            r.m[i][j] = a->m[i][0] * b->m[0][j] + a->m[i][1] * b->m[1][j] + a->m[i][2] * b->m[2][j] + a->m[i][3] * b->m[3][j];
+        }
+    }
+
+    *result = r;
+}
+
+void FAST_CODE rotationMatrixRotateVectors(fpVector3_t *result, const fpVector3_t *src, int count, const fpMat3_t *rmat)
+{
+    for (int i = 0; i < count; i++) {
+        rotationMatrixRotateVector(&result[i], &src[i], rmat);
+    }
+}
+
+void FAST_CODE rotationMatrixFromQuaternion(float rmat[3][3], const fpQuaternion_t *q)
+{
+    const float q1q1 = q->q1 * q->q1;
+    const float q2q2 = q->q2 * q->q2;
+    const float q3q3 = q->q3 * q->q3;
+
+    const float q0q1 = q->q0 * q->q1;
+    const float q0q2 = q->q0 * q->q2;
+    const float q0q3 = q->q0 * q->q3;
+    const float q1q2 = q->q1 * q->q2;
+    const float q1q3 = q->q1 * q->q3;
+    const float q2q3 = q->q2 * q->q3;
+
+    rmat[0][0] = 1.0f - 2.0f * q2q2 - 2.0f * q3q3;
+    rmat[0][1] = 2.0f * (q1q2 - q0q3);
+    rmat[0][2] = 2.0f * (q1q3 + q0q2);
+
+    rmat[1][0] = 2.0f * (q1q2 + q0q3);
+    rmat[1][1] = 1.0f - 2.0f * q1q1 - 2.0f * q3q3;
+    rmat[1][2] = 2.0f * (q2q3 - q0q1);
+
+    rmat[2][0] = 2.0f * (q1q3 - q0q2);
+    rmat[2][1] = 2.0f * (q2q3 + q0q1);
+    rmat[2][2] = 1.0f - 2.0f * q1q1 - 2.0f * q2q2;
+}
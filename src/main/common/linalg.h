@@ -0,0 +1,54 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "common/quaternion.h"
+#include "common/vector.h"
+
+/*
+ * Fixed size matrix kernels for the attitude and alignment code.
+ *
+ * Matrices are row major. Rotation matrices follow rotationMatrixRotateVector(),
+ * a vector is rotated by the transpose of the stored matrix, so rotating by
+ * A and then by B is the same as rotating once by A * B.
+ *
+ * Flight targets have no float SIMD, the kernels are plain unrolled loops.
+ * CMSIS-DSP arm_mat_mult_f32() spends more on instance setup than on a 3x3
+ * product. Quaternion multiply and normalise are short enough to stay inline in
+ * common/quaternion.h.
+ */
+
+typedef struct {
+    float m[4][4];
+} fpMat4_t;
+
+// result = a * b, result may alias either argument
+void mat3Multiply(fpMat3_t *result, const fpMat3_t *a, const fpMat3_t *b);
+void mat4Multiply(fpMat4_t *result, const fpMat4_t *a, const fpMat4_t *b);
+
+// Same as rotationMatrixRotateVector() on count vectors, result may alias src
+void rotationMatrixRotateVectors(fpVector3_t *result, const fpVector3_t *src, int count, const fpMat3_t *rmat);
+
+/*
+ * Body to earth DCM of a normalised quaternion: rmat * v matches quaternionRotateVectorInv(),
+ * rotationMatrixRotateVector() with the same matrix matches quaternionRotateVector()
+ */
+void rotationMatrixFromQuaternion(float rmat[3][3], const fpQuaternion_t *q);
@@ -103,6 +103,53 @@ float acos_approx(float x)
     else
         return result;
 }
+
+/*
+ * Fast tier: lower order polynomials and a range reduction without loops.
+ * Good enough for OSD, RTH estimates and navigation geometry, not for the IMU.
+ */
+#define sinFastPolyCoef3 -1.666568107e-1f
+#define sinFastPolyCoef5  8.312366210e-3f
+#define sinFastPolyCoef7 -1.849218155e-4f
+
+// Max absolute error 1.1e-6
+float sin_approx_fast(float x)
+{
+    const float halfTurns = x * (1.0f / M_PIf);
+    if (fabsf(halfTurns) > 1e6f) return 0.0f;                                  // Stop here on error input
+    const int32_t n = (int32_t)(halfTurns + (halfTurns >= 0.0f ? 0.5f : -0.5f));
+    x = (halfTurns - n) * M_PIf;                                               // -90..+90 Degree, sin(x + n * PI) = (-1)^n * sin(x)
+    const float x2 = x * x;
+    const float result = x + x * x2 * (sinFastPolyCoef3 + x2 * (sinFastPolyCoef5 + x2 * sinFastPolyCoef7));
+    return (n & 1) ? -result : result;
+}
+
+float cos_approx_fast(float x)
+{
+    return sin_approx_fast(x + (0.5f * M_PIf));
+}
+
+// atan(r) ~ PI/4 * r + r * (1 - r) * (0.2447 + 0.0663 * r) on 0..1, max absolute error 1.5e-3 (0.09 deg)
+float atan2_approx_fast(float y, float x)
+{
+    const float absX = fabsf(x);
+    const float absY = fabsf(y);
+    const float maxXY = MAX(absX, absY);
+    const float r = maxXY ? MIN(absX, absY) / maxXY : 0.0f;
+    float res = (M_PIf / 4.0f) * r + r * (1.0f - r) * (0.2447f + 0.0663f * r);
+    if (absY > absX) res = (M_PIf / 2.0f) - res;
+    if (x < 0) res = M_PIf - res;
+    if (y < 0) res = -res;
+    return res;
+}
+
+// acos(x) ~ sqrt(1 - x) * (a0 + a1 * x + a2 * x^2), minimax fit on 0..1, max absolute error 3.3e-4
+float acos_approx_fast(float x)
+{
+    const float xa = fabsf(x);
+    const float result = fast_fsqrtf(1.0f - xa) * (1.5704687f + xa * (-0.2054885f + xa * 0.0513801f));
+    return (x < 0.0f) ? M_PIf - result : result;
+}
 #endif
 
 int gcd(int num, int denom)
@@ -535,6 +582,12 @@ float fast_fsqrtf(const float value) {
     return ret;
 }
 
+float fast_invsqrtf(const float value)
+{
+    const float root = fast_fsqrtf(value);
+    return (root > 0.0f) ? 1.0f / root : 0.0f;
+}
+
 // function to calculate the normalization (pythagoras) of a 2-dimensional vector
 float NOINLINE calc_length_pythagorean_2D(const float firstElement, const float secondElement)
 {
@@ -31,7 +31,10 @@
 // Use floating point M_PI instead explicitly.
 #define M_PIf   3.14159265358979323846f
 #define M_LN2f  0.69314718055994530942f
-#define M_Ef    2.71828182845904523536f
+// Same digits as the GNU libc definition, so the two agree whichever header comes first
+#ifndef M_Ef
+#define M_Ef    2.7182818284590452354f
+#endif
 
 #define RAD (M_PIf / 180.0f)
 
@@ -176,6 +179,12 @@ int32_t quickMedianFilter9(int32_t * v);
 int16_t quickMedianFilter3_16(int16_t * v);
 int16_t quickMedianFilter5_16(int16_t * v);
 
+/*
+ * Accuracy tiers, pick one per call site:
+ *  *_approx        - default, order 9 polynomials, error close to float resolution. IMU and control loops
+ *  *_approx_fast   - lower order polynomials, error 1e-6 (sin/cos) to 1.5e-3 (atan2). OSD, RTH estimates, navigation geometry
+ * Without FAST_MATH every tier maps to libm.
+ */
 #if defined(FAST_MATH) || defined(VERY_FAST_MATH)
 float sin_approx(float x);
 float cos_approx(float x);
@@ -183,6 +192,11 @@ float atan2_approx(float y, float x);
 float acos_approx(float x);
 #define tan_approx(x)       (sin_approx(x) / cos_approx(x))
 #define asin_approx(x)      (M_PIf / 2 - acos_approx(x))
+
+float sin_approx_fast(float x);
+float cos_approx_fast(float x);
+float atan2_approx_fast(float y, float x);
+float acos_approx_fast(float x);
 #else
 #define asin_approx(x)      asinf(x)
 #define sin_approx(x)       sinf(x)
@@ -190,12 +204,18 @@ float acos_approx(float x);
 #define atan2_approx(y,x)   atan2f(y,x)
 #define acos_approx(x)      acosf(x)
 #define tan_approx(x)       tanf(x)
+
+#define sin_approx_fast(x)      sinf(x)
+#define cos_approx_fast(x)      cosf(x)
+#define atan2_approx_fast(y,x)  atan2f(y,x)
+#define acos_approx_fast(x)     acosf(x)
 #endif
 
 void arraySubInt32(int32_t *dest, int32_t *array1, int32_t *array2, int count);
 
 float bellCurve(const float x, const float curveWidth);
 float fast_fsqrtf(const float value);
+float fast_invsqrtf(const float value);
 float calc_length_pythagorean_2D(const float firstElement, const float secondElement);
 float calc_length_pythagorean_3D(const float firstElement, const float secondElement, const float thirdElement);
 
@@ -67,11 +67,11 @@ static inline float vectorNormSquared(const fpVector3_t * v)
 
 static inline fpVector3_t * vectorNormalize(fpVector3_t * result, const fpVector3_t * v)
 {
-    float length = fast_fsqrtf(vectorNormSquared(v));
-    if (length != 0) {
-        result->x = v->x / length;
-        result->y = v->y / length;
-        result->z = v->z / length;
+    const float invLength = fast_invsqrtf(vectorNormSquared(v));
+    if (invLength != 0) {
+        result->x = v->x * invLength;
+        result->y = v->y * invLength;
+        result->z = v->z * invLength;
     }
     else {
         result->x = 0;
@@ -30,6 +30,9 @@
 #define GYRO_LPF_5HZ        6
 #define GYRO_LPF_NONE       7
 
+// Largest number of samples drained from the sensor FIFO in one bus transaction
+#define GYRO_FIFO_MAX_SAMPLES   8
+
 typedef struct {
     uint8_t gyroLpf;
     uint16_t gyroRateHz;
@@ -43,12 +46,14 @@ typedef struct gyroDev_s {
     sensorGyroReadDataFuncPtr temperatureFn;            // read temperature if available
     sensorGyroInterruptStatusFuncPtr intStatusFn;
     sensorGyroUpdateFuncPtr updateFn;
+    sensorGyroReadFifoFuncPtr readFifoFn;               // read all pending samples, set by initFn only if FIFO streaming was requested and enabled
     float scale;                                        // scalefactor
     float gyroADCRaw[XYZ_AXIS_COUNT];
     float gyroZero[XYZ_AXIS_COUNT];
     uint8_t imuSensorToUse;
     uint8_t lpf;                                        // Configuration value: Hardware LPF setting
     uint32_t requestedSampleIntervalUs;                 // Requested sample interval
+    uint8_t requestedFifoBurstSamples;                  // Requested samples per FIFO read, 0 to read single samples
     volatile bool dataReady;
     uint32_t sampleRateIntervalUs;                      // Gyro driver should set this to actual sampling rate as signaled by IRQ
     sensor_align_e gyroAlign;
@@ -93,6 +93,7 @@ typedef enum {
 #define BMI270_CHIP_ID 0x24
 
 #define BMI270_CMD_SOFTRESET 0xB6
+#define BMI270_CMD_FIFO_FLUSH 0xB0
 
 #define BMI270_PWR_CONF_HP 0x00
 #define BMI270_PWR_CTRL_GYR_EN 0x02
@@ -120,9 +121,16 @@ typedef enum {
 #define BMI270_BWP_OSR2 0x10
 #define BMI270_BWP_NORM 0x20
 
+#define BMI270_FIFO_CONFIG_0_STREAM 0x00
+#define BMI270_FIFO_CONFIG_1_GYR_EN 0x80        // headerless, gyro only frames
+#define BMI270_FIFO_DOWNS_GYR_FILT_DATA 0x08    // same filtered data as the data registers
+#define BMI270_FIFO_FRAME_SIZE 6
+#define BMI270_FIFO_OVERREAD_VALUE ((int16_t)0x8000)  // headerless frames read past the fill level
+
 typedef struct __attribute__ ((__packed__)) bmi270ContextData_s {
     uint16_t    chipMagicNumber;
     uint8_t     lastReadStatus;
+    uint8_t     fifoEnabled;                // gyro is read from FIFO, acc data has to be read separately
     uint8_t     __padding_dummy;
     uint8_t     accRaw[6];
     uint8_t     gyroRaw[6];
@@ -130,6 +138,14 @@ typedef struct __attribute__ ((__packed__)) bmi270ContextData_s {
 
 STATIC_ASSERT(sizeof(bmi270ContextData_t) < BUS_SCRATCHPAD_MEMORY_SIZE, busDevice_scratchpad_memory_too_small);
 
+/*
+ * FIFO burst: dummy byte and FIFO_DATA frames in one transaction. Two extra frames absorb gyro task jitter.
+ * Reading past the fill level does not pop anything and returns 0x8000 frames, which end the burst.
+ * Every real frame that was read is handed to the caller, so the burst never exceeds maxSamples
+ */
+static uint8_t bmi270FifoBuffer[1 + GYRO_FIFO_MAX_SAMPLES * BMI270_FIFO_FRAME_SIZE];
+static uint8_t bmi270FifoBurstFrames;
+
 static const gyroFilterAndRateConfig_t gyroConfigs[] = {
     { GYRO_LPF_256HZ,   3200,   { BMI270_BWP_OSR4 | BMI270_ODR_3200} },
     { GYRO_LPF_256HZ,   1600,   { BMI270_BWP_OSR2 | BMI270_ODR_1600} },
@@ -183,6 +199,67 @@ static void bmi270UploadConfig(busDevice_t * busDev)
     delay(1);
 }
 
+static uint8_t bmi270GyroReadFifo(gyroDev_t *gyro, float samples[][XYZ_AXIS_COUNT], uint8_t maxSamples)
+{
+    const uint8_t reg = BMI270_REG_FIFO_DATA | 0x80;
+    const uint8_t burstFrames = MIN(bmi270FifoBurstFrames, maxSamples);
+    busTransferDescriptor_t burst[] = {
+        { .rxBuf = NULL, .txBuf = &reg, .length = 1 },
+        { .rxBuf = bmi270FifoBuffer, .txBuf = NULL, .length = 1 + burstFrames * BMI270_FIFO_FRAME_SIZE },
+    };
+
+    if (!busTransferMultiple(gyro->busDev, burst, ARRAYLEN(burst))) {
+        return 0;
+    }
+
+    const uint8_t *frames = &bmi270FifoBuffer[1];
+    uint8_t frameCount = 0;
+
+    for (; frameCount < burstFrames; frameCount++) {
+        const uint8_t *frame = &frames[frameCount * BMI270_FIFO_FRAME_SIZE];
+        if (int16_val_little_endian(frame, 0) == BMI270_FIFO_OVERREAD_VALUE) {
+            break;
+        }
+    }
+
+    for (int i = 0; i < frameCount; i++) {
+        const uint8_t *frame = &frames[i * BMI270_FIFO_FRAME_SIZE];
+        samples[i][X] = (float) int16_val_little_endian(frame, 0);
+        samples[i][Y] = (float) int16_val_little_endian(frame, 1);
+        samples[i][Z] = (float) int16_val_little_endian(frame, 2);
+    }
+
+    if (frameCount > 0) {
+        gyro->gyroADCRaw[X] = samples[frameCount - 1][X];
+        gyro->gyroADCRaw[Y] = samples[frameCount - 1][Y];
+        gyro->gyroADCRaw[Z] = samples[frameCount - 1][Z];
+    }
+
+    return frameCount;
+}
+
+static void bmi270FifoInit(gyroDev_t *gyro)
+{
+    busDevice_t * busDev = gyro->busDev;
+    bmi270ContextData_t * ctx = busDeviceGetScratchpadMemory(busDev);
+
+    busWrite(busDev, BMI270_REG_FIFO_DOWNS, BMI270_FIFO_DOWNS_GYR_FILT_DATA);
+    delay(1);
+
+    busWrite(busDev, BMI270_REG_FIFO_CONFIG_0, BMI270_FIFO_CONFIG_0_STREAM);
+    delay(1);
+
+    busWrite(busDev, BMI270_REG_FIFO_CONFIG_1, BMI270_FIFO_CONFIG_1_GYR_EN);
+    delay(1);
+
+    busWrite(busDev, BMI270_REG_CMD, BMI270_CMD_FIFO_FLUSH);
+    delay(1);
+
+    bmi270FifoBurstFrames = MIN(gyro->requestedFifoBurstSamples + 2, GYRO_FIFO_MAX_SAMPLES);
+    ctx->fifoEnabled = true;
+    gyro->readFifoFn = bmi270GyroReadFifo;
+}
+
 static void bmi270AccAndGyroInit(gyroDev_t *gyro)
 {
     busDevice_t * busDev = gyro->busDev;
@@ -236,6 +313,10 @@ static void bmi270AccAndGyroInit(gyroDev_t *gyro)
     // Enable the gyro and accelerometer
     busWrite(busDev, BMI270_REG_PWR_CTRL, BMI270_PWR_CTRL_GYR_EN | BMI270_PWR_CTRL_ACC_EN);
     delay(1);
+
+    if (gyro->requestedFifoBurstSamples > 0) {
+        bmi270FifoInit(gyro);
+    }
 }
 
 
@@ -259,6 +340,11 @@ static bool bmi270AccReadScratchpad(accDev_t *acc)
 {
     bmi270ContextData_t * ctx = busDeviceGetScratchpadMemory(acc->busDev);
 
+    // Gyro reads do not refresh acc data in FIFO mode
+    if (ctx->fifoEnabled) {
+        ctx->lastReadStatus = busReadBuf(acc->busDev, BMI270_REG_ACC_DATA_X_LSB, &ctx->__padding_dummy, 6 + 1);
+    }
+
     if (ctx->lastReadStatus) {
         acc->ADCRaw[X] = (float) int16_val_little_endian(ctx->accRaw, 0);
         acc->ADCRaw[Y] = (float) int16_val_little_endian(ctx->accRaw, 1);
@@ -330,6 +416,7 @@ bool bmi270GyroDetect(gyroDev_t *gyro)
     // Magic number for ACC detection to indicate that we have detected BMI270 gyro
     bmi270ContextData_t * ctx = busDeviceGetScratchpadMemory(gyro->busDev);
     ctx->chipMagicNumber = 0xB270;
+    ctx->fifoEnabled = false;
 
     gyro->initFn = bmi270GyroInit;
     gyro->readFn = bmi270yroReadScratchpad;
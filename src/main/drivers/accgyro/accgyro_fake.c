@@ -34,9 +34,60 @@
 
 static float fakeGyroADC[XYZ_AXIS_COUNT];
 
+/*
+ * Fake FIFO, every fakeGyroSet() call queues one sample. Written by the simulator thread
+ * and read by the gyro task, so only the writer moves the head and only the reader the tail.
+ * The threads can run on different host cores: the head is published with release semantics
+ * after the sample is stored and loaded with acquire semantics before it is read, the tail likewise.
+ * Samples set while the FIFO is full are dropped
+ */
+#define FAKE_GYRO_FIFO_SIZE     (4 * GYRO_FIFO_MAX_SAMPLES)
+
+static int16_t fakeGyroFifo[FAKE_GYRO_FIFO_SIZE][XYZ_AXIS_COUNT];
+static uint8_t fakeGyroFifoHead;
+static uint8_t fakeGyroFifoTail;
+static bool fakeGyroFifoEnabled;
+
+static uint8_t fakeGyroReadFifo(gyroDev_t *gyro, float samples[][XYZ_AXIS_COUNT], uint8_t maxSamples)
+{
+    uint8_t count = 0;
+    uint8_t tail = fakeGyroFifoTail;
+    const uint8_t head = __atomic_load_n(&fakeGyroFifoHead, __ATOMIC_ACQUIRE);
+
+    while (count < maxSamples && tail != head) {
+        samples[count][X] = fakeGyroFifo[tail][X];
+        samples[count][Y] = fakeGyroFifo[tail][Y];
+        samples[count][Z] = fakeGyroFifo[tail][Z];
+        tail = (tail + 1) % FAKE_GYRO_FIFO_SIZE;
+        count++;
+    }
+
+    __atomic_store_n(&fakeGyroFifoTail, tail, __ATOMIC_RELEASE);
+
+    // Keep the single sample interface consistent with the last drained sample
+    if (count > 0) {
+        gyro->gyroADCRaw[X] = samples[count - 1][X];
+        gyro->gyroADCRaw[Y] = samples[count - 1][Y];
+        gyro->gyroADCRaw[Z] = samples[count - 1][Z];
+    }
+
+    return count;
+}
+
+uint8_t fakeGyroFifoLevel(void)
+{
+    const uint8_t head = __atomic_load_n(&fakeGyroFifoHead, __ATOMIC_ACQUIRE);
+    const uint8_t tail = __atomic_load_n(&fakeGyroFifoTail, __ATOMIC_ACQUIRE);
+
+    return (head + FAKE_GYRO_FIFO_SIZE - tail) % FAKE_GYRO_FIFO_SIZE;
+}
+
 static void fakeGyroInit(gyroDev_t *gyro)
 {
-    UNUSED(gyro);
+    fakeGyroFifoHead = 0;
+    fakeGyroFifoTail = 0;
+    fakeGyroFifoEnabled = gyro->requestedFifoBurstSamples > 0;
+    gyro->readFifoFn = fakeGyroFifoEnabled ? fakeGyroReadFifo : NULL;
 }
 
 void fakeGyroSet(int16_t x, int16_t y, int16_t z)
@@ -44,6 +95,18 @@ void fakeGyroSet(int16_t x, int16_t y, int16_t z)
     fakeGyroADC[X] = x;
     fakeGyroADC[Y] = y;
     fakeGyroADC[Z] = z;
+
+    if (fakeGyroFifoEnabled) {
+        const uint8_t head = fakeGyroFifoHead;
+        const uint8_t nextHead = (head + 1) % FAKE_GYRO_FIFO_SIZE;
+
+        if (nextHead != __atomic_load_n(&fakeGyroFifoTail, __ATOMIC_ACQUIRE)) {
+            fakeGyroFifo[head][X] = x;
+            fakeGyroFifo[head][Y] = y;
+            fakeGyroFifo[head][Z] = z;
+            __atomic_store_n(&fakeGyroFifoHead, nextHead, __ATOMIC_RELEASE);
+        }
+    }
 }
 
 static bool fakeGyroRead(gyroDev_t *gyro)
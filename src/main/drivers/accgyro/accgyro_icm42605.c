@@ -94,6 +94,28 @@
 #define ICM42605_INTF_CONFIG1_AFSR_MASK             0xC0
 #define ICM42605_INTF_CONFIG1_AFSR_DISABLE          0x40
 
+#define ICM42605_RA_SIGNAL_PATH_RESET               0x4B
+#define ICM42605_FIFO_FLUSH                         (1 << 1)
+
+#define ICM42605_RA_INTF_CONFIG0                    0x4C
+#define ICM42605_INTF_CONFIG0_DEFAULT               0x30    // big endian count and sensor data
+#define ICM42605_FIFO_COUNT_REC                     (1 << 6)
+
+#define ICM42605_RA_FIFO_CONFIG                     0x16
+#define ICM42605_FIFO_MODE_STREAM                   (1 << 6)
+
+#define ICM42605_RA_FIFO_CONFIG1                    0x5F
+#define ICM42605_FIFO_GYRO_EN                       (1 << 1)
+#define ICM42605_FIFO_TEMP_EN                       (1 << 2)
+
+#define ICM42605_RA_FIFO_COUNTH                     0x2E
+#define ICM42605_RA_FIFO_DATA                       0x30
+
+// Gyro only packet: header, gyro X/Y/Z big endian, temperature
+#define ICM42605_FIFO_PACKET_SIZE                   8
+#define ICM42605_FIFO_HEADER_EMPTY                  (1 << 7)
+#define ICM42605_FIFO_HEADER_GYRO                   (1 << 5)
+
 // --- Registers for gyro and acc Anti-Alias Filter ---------
 #define ICM426XX_RA_GYRO_CONFIG_STATIC3             0x0C  // User Bank 1
 #define ICM426XX_RA_GYRO_CONFIG_STATIC4             0x0D  // User Bank 1
@@ -200,6 +222,81 @@ static const gyroFilterAndRateConfig_t icm42605GyroConfigs[] = {
     { GYRO_LPF_256HZ,    500,   { 0,    15 } }, /* 250 Hz LPF */
 };
 
+/*
+ * FIFO_COUNTH, FIFO_COUNTL and FIFO_DATA are consecutive and the address does not advance past
+ * FIFO_DATA, so one burst returns the fill level in packets followed by the packets. The burst
+ * is sized for the expected packets plus margin, packets past the fill level are discarded
+ */
+#define ICM42605_FIFO_COUNT_SIZE                    2
+
+static uint8_t icm42605FifoBuffer[ICM42605_FIFO_COUNT_SIZE + GYRO_FIFO_MAX_SAMPLES * ICM42605_FIFO_PACKET_SIZE];
+static uint8_t icm42605FifoBurstPackets;
+
+static uint8_t icm42605GyroReadFifo(gyroDev_t *gyro, float samples[][XYZ_AXIS_COUNT], uint8_t maxSamples)
+{
+    const uint8_t reg = ICM42605_RA_FIFO_COUNTH | 0x80;
+    const uint8_t burstPackets = MIN(icm42605FifoBurstPackets, maxSamples);
+    busTransferDescriptor_t burst[] = {
+        { .rxBuf = NULL, .txBuf = &reg, .length = 1 },
+        { .rxBuf = icm42605FifoBuffer, .txBuf = NULL, .length = ICM42605_FIFO_COUNT_SIZE + burstPackets * ICM42605_FIFO_PACKET_SIZE },
+    };
+
+    if (!busTransferMultiple(gyro->busDev, burst, ARRAYLEN(burst))) {
+        return 0;
+    }
+
+    const uint16_t packetCount = (icm42605FifoBuffer[0] << 8) | icm42605FifoBuffer[1];
+    const uint8_t readCount = MIN(packetCount, burstPackets);
+    const uint8_t *packets = &icm42605FifoBuffer[ICM42605_FIFO_COUNT_SIZE];
+
+    uint8_t sampleCount = 0;
+    for (int i = 0; i < readCount; i++) {
+        const uint8_t *packet = &packets[i * ICM42605_FIFO_PACKET_SIZE];
+        const uint8_t header = packet[0];
+
+        if ((header & ICM42605_FIFO_HEADER_EMPTY) || !(header & ICM42605_FIFO_HEADER_GYRO)) {
+            break;
+        }
+
+        const uint8_t *gyroData = &packet[1];
+        samples[sampleCount][X] = (float) int16_val_big_endian(gyroData, 0);
+        samples[sampleCount][Y] = (float) int16_val_big_endian(gyroData, 1);
+        samples[sampleCount][Z] = (float) int16_val_big_endian(gyroData, 2);
+        sampleCount++;
+    }
+
+    if (sampleCount > 0) {
+        gyro->gyroADCRaw[X] = samples[sampleCount - 1][X];
+        gyro->gyroADCRaw[Y] = samples[sampleCount - 1][Y];
+        gyro->gyroADCRaw[Z] = samples[sampleCount - 1][Z];
+    }
+
+    return sampleCount;
+}
+
+static void icm42605FifoInit(gyroDev_t *gyro)
+{
+    busDevice_t * dev = gyro->busDev;
+
+    setUserBank(dev, ICM426XX_BANK_SELECT0);
+
+    // FIFO_COUNT reports packets instead of bytes
+    busWrite(dev, ICM42605_RA_INTF_CONFIG0, ICM42605_INTF_CONFIG0_DEFAULT | ICM42605_FIFO_COUNT_REC);
+    delay(1);
+
+    busWrite(dev, ICM42605_RA_FIFO_CONFIG1, ICM42605_FIFO_GYRO_EN | ICM42605_FIFO_TEMP_EN);
+    delay(1);
+
+    busWrite(dev, ICM42605_RA_FIFO_CONFIG, ICM42605_FIFO_MODE_STREAM);
+    delay(1);
+
+    busWrite(dev, ICM42605_RA_SIGNAL_PATH_RESET, ICM42605_FIFO_FLUSH);
+    delay(1);
+
+    icm42605FifoBurstPackets = MIN(gyro->requestedFifoBurstSamples + 2, GYRO_FIFO_MAX_SAMPLES);
+    gyro->readFifoFn = icm42605GyroReadFifo;
+}
+
 static void icm42605AccAndGyroInit(gyroDev_t *gyro)
 {
     busDevice_t * dev = gyro->busDev;
@@ -270,6 +367,11 @@ static void icm42605AccAndGyroInit(gyroDev_t *gyro)
 
     delay(15);
 
+    // The FIFO burst needs busTransferMultiple, which is SPI only
+    if (gyro->requestedFifoBurstSamples > 0 && dev->busType == BUSTYPE_SPI) {
+        icm42605FifoInit(gyro);
+    }
+
     busSetSpeed(dev, BUS_SPEED_FAST);
 }
 
@@ -140,7 +140,7 @@ typedef struct mpuConfiguration_s {
 typedef struct __attribute__ ((__packed__)) mpuContextData_s {
     uint16_t    chipMagicNumber;
     uint8_t     lastReadStatus;
-    uint8_t     __padding;
+    uint8_t     fifoEnabled;    // gyro is read from FIFO, acc and temperature have to be read separately
     uint8_t     accRaw[6];  // MPU_RA_ACCEL_XOUT_H
     uint8_t     tempRaw[2]; // MPU_RA_TEMP_OUT_H
     uint8_t     gyroRaw[6]; // MPU_RA_GYRO_XOUT_H
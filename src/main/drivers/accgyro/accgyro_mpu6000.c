@@ -51,6 +51,12 @@
 #define BIT_GYRO                    3
 #define BIT_ACC                     2
 #define BIT_TEMP                    1
+#define BIT_USER_CTRL_FIFO_EN       0x40
+#define BIT_USER_CTRL_FIFO_RESET    0x04
+#define BIT_FIFO_EN_GYRO_XYZ        0x70    // XG, YG and ZG, 6 byte big endian frames
+
+#define MPU6000_FIFO_SIZE           1024
+#define MPU6000_FIFO_FRAME_SIZE     6
 
 // Product ID Description for MPU6000
 // high 4 bits low 4 bits
@@ -68,6 +74,91 @@
 #define MPU6000_REV_D9 0x59
 #define MPU6000_REV_D10 0x5A
 
+/*
+ * FIFO_COUNTH, FIFO_COUNTL and FIFO_R_W are consecutive and the address does not advance past
+ * FIFO_R_W, so one burst returns the fill level followed by the frames. The burst is sized for
+ * the expected frames plus margin, bytes past the reported fill level are discarded
+ */
+#define MPU6000_FIFO_COUNT_SIZE     2
+
+static uint8_t mpu6000FifoBuffer[MPU6000_FIFO_COUNT_SIZE + GYRO_FIFO_MAX_SAMPLES * MPU6000_FIFO_FRAME_SIZE];
+static uint8_t mpu6000FifoBurstFrames;
+
+static void mpu6000FifoReset(busDevice_t * busDev)
+{
+    busWrite(busDev, MPU_RA_USER_CTRL, BIT_I2C_IF_DIS | BIT_USER_CTRL_FIFO_RESET);
+    busWrite(busDev, MPU_RA_USER_CTRL, BIT_I2C_IF_DIS | BIT_USER_CTRL_FIFO_EN);
+}
+
+static uint8_t mpu6000GyroReadFifo(gyroDev_t *gyro, float samples[][XYZ_AXIS_COUNT], uint8_t maxSamples)
+{
+    busDevice_t * busDev = gyro->busDev;
+    const uint8_t reg = MPU_RA_FIFO_COUNTH | 0x80;
+    const uint8_t burstFrames = MIN(mpu6000FifoBurstFrames, maxSamples);
+    busTransferDescriptor_t burst[] = {
+        { .rxBuf = NULL, .txBuf = &reg, .length = 1 },
+        { .rxBuf = mpu6000FifoBuffer, .txBuf = NULL, .length = MPU6000_FIFO_COUNT_SIZE + burstFrames * MPU6000_FIFO_FRAME_SIZE },
+    };
+
+    if (!busTransferMultiple(busDev, burst, ARRAYLEN(burst))) {
+        return 0;
+    }
+
+    const uint16_t fifoCount = (mpu6000FifoBuffer[0] << 8) | mpu6000FifoBuffer[1];
+
+    // An overflowed FIFO, or a frame written while the burst ended, loses frame alignment. Start over
+    if (fifoCount >= MPU6000_FIFO_SIZE || (fifoCount % MPU6000_FIFO_FRAME_SIZE) != 0) {
+        mpu6000FifoReset(busDev);
+        return 0;
+    }
+
+    const uint8_t frameCount = MIN(fifoCount / MPU6000_FIFO_FRAME_SIZE, burstFrames);
+    if (frameCount == 0) {
+        return 0;
+    }
+
+    const uint8_t *frames = &mpu6000FifoBuffer[MPU6000_FIFO_COUNT_SIZE];
+    for (int i = 0; i < frameCount; i++) {
+        const uint8_t *frame = &frames[i * MPU6000_FIFO_FRAME_SIZE];
+        samples[i][X] = (float) int16_val_big_endian(frame, 0);
+        samples[i][Y] = (float) int16_val_big_endian(frame, 1);
+        samples[i][Z] = (float) int16_val_big_endian(frame, 2);
+    }
+
+    gyro->gyroADCRaw[X] = samples[frameCount - 1][X];
+    gyro->gyroADCRaw[Y] = samples[frameCount - 1][Y];
+    gyro->gyroADCRaw[Z] = samples[frameCount - 1][Z];
+
+    return frameCount;
+}
+
+static void mpu6000FifoInit(gyroDev_t *gyro)
+{
+    busDevice_t * busDev = gyro->busDev;
+    mpuContextData_t * ctx = busDeviceGetScratchpadMemory(busDev);
+
+    // Frames are written at the gyro sample rate set by SMPLRT_DIV
+    busWrite(busDev, MPU_RA_FIFO_EN, BIT_FIFO_EN_GYRO_XYZ);
+    delayMicroseconds(15);
+
+    mpu6000FifoReset(busDev);
+    delayMicroseconds(15);
+
+    mpu6000FifoBurstFrames = MIN(gyro->requestedFifoBurstSamples + 2, GYRO_FIFO_MAX_SAMPLES);
+    ctx->fifoEnabled = true;
+    gyro->readFifoFn = mpu6000GyroReadFifo;
+}
+
+static bool mpu6000AccReadFifoMode(accDev_t *acc)
+{
+    mpuContextData_t * ctx = busDeviceGetScratchpadMemory(acc->busDev);
+
+    // Gyro FIFO reads do not refresh the scratchpad, acc and temperature are read here
+    ctx->lastReadStatus = busReadBuf(acc->busDev, MPU_RA_ACCEL_XOUT_H, ctx->accRaw, 6 + 2);
+
+    return mpuAccReadScratchpad(acc);
+}
+
 static void mpu6000AccAndGyroInit(gyroDev_t *gyro)
 {
     busDevice_t * busDev = gyro->busDev;
@@ -118,6 +209,10 @@ static void mpu6000AccAndGyroInit(gyroDev_t *gyro)
     if (((int8_t)gyro->gyroADCRaw[1]) == -1 && ((int8_t)gyro->gyroADCRaw[0]) == -1) {
         failureMode(FAILURE_GYRO_INIT_FAILED);
     }
+
+    if (gyro->requestedFifoBurstSamples > 0) {
+        mpu6000FifoInit(gyro);
+    }
 }
 
 static void mpu6000AccInit(accDev_t *acc)
@@ -138,7 +233,7 @@ bool mpu6000AccDetect(accDev_t *acc)
     }
 
     acc->initFn = mpu6000AccInit;
-    acc->readFn = mpuAccReadScratchpad;
+    acc->readFn = ctx->fifoEnabled ? mpu6000AccReadFifoMode : mpuAccReadScratchpad;
     acc->accAlign = acc->busDev->param;
 
     return true;
@@ -202,6 +297,7 @@ bool mpu6000GyroDetect(gyroDev_t *gyro)
     // Magic number for ACC detection to indicate that we have detected MPU6000 gyro
     mpuContextData_t * ctx = busDeviceGetScratchpadMemory(gyro->busDev);
     ctx->chipMagicNumber = 0x6860;
+    ctx->fifoEnabled = false;
 
     gyro->initFn = mpu6000AccAndGyroInit;
     gyro->readFn = mpuGyroReadScratchpad;
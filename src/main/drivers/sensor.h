@@ -47,6 +47,7 @@ typedef bool (*sensorGyroReadFuncPtr)(struct gyroDev_s *gyro);
 typedef bool (*sensorGyroUpdateFuncPtr)(struct gyroDev_s *gyro);
 typedef bool (*sensorGyroReadDataFuncPtr)(struct gyroDev_s *gyro, int16_t *data);
 typedef bool (*sensorGyroInterruptStatusFuncPtr)(struct gyroDev_s *gyro);
+typedef uint8_t (*sensorGyroReadFifoFuncPtr)(struct gyroDev_s *gyro, float samples[][3], uint8_t maxSamples);
 struct magDev_s;
 typedef bool (*sensorMagInitFuncPtr)(struct magDev_s *mag);
 typedef bool (*sensorMagReadFuncPtr)(struct magDev_s *mag);
@@ -3626,6 +3626,8 @@ static void cliSet(char *cmdline)
 
                 if (changeValue) {
                     cliSetIntFloatVar(val, tmp);
+                    // The PID controller caches its gains, the setting may be one of them
+                    schedulePidGainsUpdate();
 
                     cliPrintf("%s set to ", name);
                     cliPrintVar(val, 0);
@@ -3870,9 +3872,40 @@ static void cliStatus(char *cmdline)
     }
 }
 
+#ifdef USE_SCHEDULER_TASK_HISTOGRAM
+static void cliTasksHistogram(void)
+{
+    cliPrintLinef("Task histogram     exec/us p50   p90   p99  latency/us p50   p90   p99");
+    for (cfTaskId_e taskId = 0; taskId < TASK_COUNT; taskId++) {
+        cfTaskInfo_t taskInfo;
+        getTaskInfo(taskId, &taskInfo);
+        if (taskInfo.isEnabled) {
+            cfTaskHistogram_t histogram;
+            getTaskHistogram(taskId, &histogram);
+            cliPrintLinef("%2d - %12s  %8d %5d %5d  %13d %5d %5d",
+                    taskId, taskInfo.taskName,
+                    (uint32_t)taskHistogramPercentile(histogram.executionTime, 50),
+                    (uint32_t)taskHistogramPercentile(histogram.executionTime, 90),
+                    (uint32_t)taskHistogramPercentile(histogram.executionTime, 99),
+                    (uint32_t)taskHistogramPercentile(histogram.startLatency, 50),
+                    (uint32_t)taskHistogramPercentile(histogram.startLatency, 90),
+                    (uint32_t)taskHistogramPercentile(histogram.startLatency, 99));
+        }
+    }
+    cliPrintLinef("Values are upper bounds of log2 buckets");
+}
+#endif
+
 static void cliTasks(char *cmdline)
 {
+#ifdef USE_SCHEDULER_TASK_HISTOGRAM
+    if (sl_strcasecmp(cmdline, "hist") == 0) {
+        cliTasksHistogram();
+        return;
+    }
+#else
     UNUSED(cmdline);
+#endif
     int maxLoadSum = 0;
     int averageLoadSum = 0;
     cfCheckFuncInfo_t checkFuncInfo;
@@ -3897,6 +3930,9 @@ static void cliTasks(char *cmdline)
     getCheckFuncInfo(&checkFuncInfo);
     cliPrintLinef("Task check function %13d %7d %25d", (uint32_t)checkFuncInfo.maxExecutionTime, (uint32_t)checkFuncInfo.averageExecutionTime, (uint32_t)checkFuncInfo.totalExecutionTime / 1000);
     cliPrintLinef("Total (excluding SERIAL) %21d.%1d%% %4d.%1d%%", maxLoadSum/10, maxLoadSum%10, averageLoadSum/10, averageLoadSum%10);
+    if (systemConfig()->schedulerDeadlineMode != SCHEDULER_DEADLINE_OFF) {
+        cliPrintLinef("Tasks deferred by deadline mode: %u", schedulerGetDeferredTaskCount());
+    }
 }
 
 static void cliVersion(char *cmdline)
@@ -4361,7 +4397,11 @@ const clicmd_t cmdTable[] = {
     CLI_COMMAND_DEF("sd_info", "sdcard info", NULL, cliSdInfo),
 #endif
     CLI_COMMAND_DEF("status", "show status", NULL, cliStatus),
+#ifdef USE_SCHEDULER_TASK_HISTOGRAM
+    CLI_COMMAND_DEF("tasks", "show task stats", "[hist]", cliTasks),
+#else
     CLI_COMMAND_DEF("tasks", "show task stats", NULL, cliTasks),
+#endif
 #ifdef USE_TEMPERATURE_SENSOR
     CLI_COMMAND_DEF("temp_sensor", "change temp sensor settings", NULL, cliTempSensor),
 #endif
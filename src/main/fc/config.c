@@ -103,7 +103,7 @@ PG_RESET_TEMPLATE(featureConfig_t, featureConfig,
     .enabledFeatures = DEFAULT_FEATURES | COMMON_DEFAULT_FEATURES
 );
 
-PG_REGISTER_WITH_RESET_TEMPLATE(systemConfig_t, systemConfig, PG_SYSTEM_CONFIG, 7);
+PG_REGISTER_WITH_RESET_TEMPLATE(systemConfig_t, systemConfig, PG_SYSTEM_CONFIG, 9);
 
 PG_RESET_TEMPLATE(systemConfig_t, systemConfig,
     .current_profile_index = 0,
@@ -117,6 +117,10 @@ PG_RESET_TEMPLATE(systemConfig_t, systemConfig,
     .i2c_speed = SETTING_I2C_SPEED_DEFAULT,
 #endif
     .throttle_tilt_compensation_strength = SETTING_THROTTLE_TILT_COMP_STR_DEFAULT,      // 0-100, 0 - disabled
+    .schedulerDeadlineMode = SETTING_SCHEDULER_DEADLINE_MODE_DEFAULT,
+#ifdef USE_PID_OUTER_LOOP
+    .pidOuterLoopDenom = SETTING_PID_OUTER_LOOP_DENOM_DEFAULT,
+#endif
     .craftName = SETTING_NAME_DEFAULT,
     .pilotName = SETTING_NAME_DEFAULT
 );
@@ -188,6 +192,12 @@ uint32_t getGyroLooptime(void)
     return gyro.targetLooptime;
 }
 
+// Gyro task period, sensors read through FIFO deliver more than one sample per run
+uint32_t getGyroUpdateInterval(void)
+{
+    return gyro.targetLooptime * MAX(gyro.samplesPerUpdate, 1);
+}
+
 void validateAndFixConfig(void)
 {
     if (accelerometerConfig()->acc_notch_cutoff >= accelerometerConfig()->acc_notch_hz) {
@@ -78,6 +78,10 @@ typedef struct systemConfig_s {
     uint8_t i2c_speed;
 #endif
     uint8_t throttle_tilt_compensation_strength;    // the correction that will be applied at throttle_correction_angle.
+    uint8_t schedulerDeadlineMode;
+#ifdef USE_PID_OUTER_LOOP
+    uint8_t pidOuterLoopDenom;              // outer control loop (attitude, navigation, levelling) runs every N PID loops
+#endif
     char craftName[MAX_NAME_LENGTH + 1];
     char pilotName[MAX_NAME_LENGTH + 1];
 } systemConfig_t;
@@ -152,3 +156,4 @@ void targetConfiguration(void);
 
 uint32_t getLooptime(void);
 uint32_t getGyroLooptime(void);
+uint32_t getGyroUpdateInterval(void);
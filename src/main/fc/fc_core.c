@@ -17,6 +17,7 @@
 
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 
 #include "platform.h"
@@ -870,6 +871,77 @@ static void applyThrottleTiltCompensation(void)
     }
 }
 
+bool isPidOuterLoopDecoupled(void)
+{
+#ifdef USE_PID_OUTER_LOOP
+    return systemConfig()->pidOuterLoopDenom > 1;
+#else
+    return false;
+#endif
+}
+
+#ifdef USE_PID_OUTER_LOOP
+// rcCommand hand-over when the outer loop runs as its own task: pilot and failsafe
+// input of the last PID loop in, setpoint of the last outer loop out
+static int16_t outerLoopPilotCommand[4];
+static int16_t outerLoopRcCommand[4];
+#if defined(SITL_BUILD)
+// Set when the PID task got the simulator lock, the attitude update follows the same sensor data
+static volatile bool outerLoopSensorUpdatePending;
+#endif
+#endif
+
+/*
+ * Setpoint side of the flight control loop: rc interpolation, navigation and the outer PID loop.
+ * Runs inline in the PID task or as TASK_PID_OUTER, hands over rcCommand and the rate targets
+ * to the inner loop. dT is the outer loop period
+ */
+static void outerControlLoop(timeUs_t currentTimeUs, float dT)
+{
+    if (rxConfig()->rcFilterFrequency) {
+        rcInterpolationApply(isRXDataNew, currentTimeUs);
+    }
+
+    if (isRXDataNew) {
+        updateWaypointsAndNavigationMode();
+    }
+    isRXDataNew = false;
+
+    updatePositionEstimator();
+    applyWaypointNavigationAndAltitudeHold();
+
+    // Apply throttle tilt compensation
+    applyThrottleTiltCompensation();
+
+#ifdef USE_POWER_LIMITS
+    powerLimiterApply(&rcCommand[THROTTLE]);
+#endif
+
+    pidControllerOuter(dT);
+}
+
+#ifdef USE_PID_OUTER_LOOP
+void taskPidOuterLoop(timeUs_t currentTimeUs)
+{
+    const float outerDT = getTaskDeltaTime(TASK_SELF) * 0.000001f;
+
+#if defined(SITL_BUILD)
+    if (outerLoopSensorUpdatePending) {
+        outerLoopSensorUpdatePending = false;
+#endif
+
+    imuUpdateAttitude(currentTimeUs);
+
+#if defined(SITL_BUILD)
+    }
+#endif
+
+    memcpy(rcCommand, outerLoopPilotCommand, sizeof(rcCommand));
+    outerControlLoop(currentTimeUs, outerDT);
+    memcpy(outerLoopRcCommand, rcCommand, sizeof(rcCommand));
+}
+#endif
+
 void taskMainPidLoop(timeUs_t currentTimeUs)
 {
 
@@ -895,6 +967,8 @@ void taskMainPidLoop(timeUs_t currentTimeUs)
         DISABLE_STATE(IN_FLIGHT_EMERG_REARM);
     }
 
+    const bool outerLoopInline = !isPidOuterLoopDecoupled();
+
 #if defined(SITL_BUILD)
     if (lockMainPID()) {
 #endif
@@ -902,7 +976,14 @@ void taskMainPidLoop(timeUs_t currentTimeUs)
     gyroFilter();
 
     imuUpdateAccelerometer();
-    imuUpdateAttitude(currentTimeUs);
+    if (outerLoopInline) {
+        imuUpdateAttitude(currentTimeUs);
+    }
+#if defined(SITL_BUILD) && defined(USE_PID_OUTER_LOOP)
+    else {
+        outerLoopSensorUpdatePending = true;
+    }
+#endif
 
 #if defined(SITL_BUILD)
     }
@@ -912,27 +993,19 @@ void taskMainPidLoop(timeUs_t currentTimeUs)
 
     updateArmingStatus();
 
-    if (rxConfig()->rcFilterFrequency) {
-        rcInterpolationApply(isRXDataNew, currentTimeUs);
+    if (outerLoopInline) {
+        outerControlLoop(currentTimeUs, dT);
     }
-
-    if (isRXDataNew) {
-        updateWaypointsAndNavigationMode();
+#ifdef USE_PID_OUTER_LOOP
+    else {
+        // Pilot and failsafe input goes to the next outer loop, the motors follow the setpoint of the last one
+        memcpy(outerLoopPilotCommand, rcCommand, sizeof(rcCommand));
+        memcpy(rcCommand, outerLoopRcCommand, sizeof(rcCommand));
     }
-    isRXDataNew = false;
-
-    updatePositionEstimator();
-    applyWaypointNavigationAndAltitudeHold();
-
-    // Apply throttle tilt compensation
-    applyThrottleTiltCompensation();
-
-#ifdef USE_POWER_LIMITS
-    powerLimiterApply(&rcCommand[THROTTLE]);
 #endif
 
     // Calculate stabilisation
-    pidController(dT);
+    pidControllerInner(dT);
 
     mixTable();
 
@@ -962,6 +1035,7 @@ void taskMainPidLoop(timeUs_t currentTimeUs)
         writeMotors();
     }
 #endif
+
     // Check if landed, FW and MR
     if (STATE(ALTITUDE_CONTROL)) {
         updateLandingStatus(US2MS(currentTimeUs));
@@ -48,4 +48,6 @@ float getFlightTime(void);
 void resetFlightTime(void);
 float getArmTime(void);
 
+bool isPidOuterLoopDecoupled(void);
+
 void fcReboot(bool bootLoader);
\ No newline at end of file
@@ -1683,6 +1683,29 @@ static mspResult_e mspFcLogicConditionCommand(sbuf_t *dst, sbuf_t *src) {
     }
 }
 
+#ifdef USE_SCHEDULER_TASK_HISTOGRAM
+static mspResult_e mspFcTaskHistogramCommand(sbuf_t *dst, sbuf_t *src)
+{
+    uint8_t taskId;
+    if (!sbufReadU8Safe(&taskId, src) || taskId >= TASK_COUNT) {
+        return MSP_RESULT_ERROR;
+    }
+
+    cfTaskHistogram_t histogram;
+    getTaskHistogram(taskId, &histogram);
+
+    sbufWriteU8(dst, taskId);
+    sbufWriteU8(dst, TASK_HISTOGRAM_BUCKETS);
+    for (int i = 0; i < TASK_HISTOGRAM_BUCKETS; i++) {
+        sbufWriteU16(dst, histogram.executionTime[i]);
+    }
+    for (int i = 0; i < TASK_HISTOGRAM_BUCKETS; i++) {
+        sbufWriteU16(dst, histogram.startLatency[i]);
+    }
+    return MSP_RESULT_ACK;
+}
+#endif
+
 static void mspFcWaypointOutCommand(sbuf_t *dst, sbuf_t *src)
 {
     const uint8_t msp_wp_no = sbufReadU8(src);    // get the wp number
@@ -3318,6 +3341,9 @@ static bool mspSetSettingCommand(sbuf_t *dst, sbuf_t *src)
             break;
     }
 
+    // The PID controller caches its gains, the setting may be one of them
+    schedulePidGainsUpdate();
+
     return true;
 }
 
@@ -3638,6 +3664,11 @@ bool mspFCProcessInOutCommand(uint16_t cmdMSP, sbuf_t *dst, sbuf_t *src, mspResu
         *ret = mspFcLogicConditionCommand(dst, src);
         break;
 #endif
+#ifdef USE_SCHEDULER_TASK_HISTOGRAM
+    case MSP2_INAV_TASK_HISTOGRAM:
+        *ret = mspFcTaskHistogramCommand(dst, src);
+        break;
+#endif
 #ifdef USE_SAFE_HOME
     case MSP2_INAV_SAFEHOME:
         *ret = mspFcSafeHomeOutCommand(dst, src);
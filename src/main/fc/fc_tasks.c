@@ -21,6 +21,8 @@
 
 #include "platform.h"
 
+#include "blackbox/blackbox.h"
+
 #include "cms/cms.h"
 
 #include "common/axis.h"
@@ -334,13 +336,25 @@ void taskUpdateAux(timeUs_t currentTimeUs)
 void fcTasksInit(void)
 {
     schedulerInit();
+    schedulerSetDeadlineMode(systemConfig()->schedulerDeadlineMode);
 
     rescheduleTask(TASK_PID, getLooptime());
     setTaskEnabled(TASK_PID, true);
 
-    rescheduleTask(TASK_GYRO, getGyroLooptime());
+    rescheduleTask(TASK_GYRO, getGyroUpdateInterval());
     setTaskEnabled(TASK_GYRO, true);
 
+#ifdef USE_PID_OUTER_LOOP
+    rescheduleTask(TASK_PID_OUTER, getLooptime() * systemConfig()->pidOuterLoopDenom);
+    setTaskEnabled(TASK_PID_OUTER, isPidOuterLoopDecoupled());
+#endif
+
+#if defined(USE_BLACKBOX) && defined(USE_BLACKBOX_DEFERRED)
+    // Runs at the logging rate, the queue absorbs the odd late run
+    rescheduleTask(TASK_BLACKBOX, getLooptime() * blackboxConfig()->rate_denom / blackboxConfig()->rate_num);
+    setTaskEnabled(TASK_BLACKBOX, feature(FEATURE_BLACKBOX) && blackboxConfig()->deferred);
+#endif
+
     setTaskEnabled(TASK_AUX, true);
 
     setTaskEnabled(TASK_SERIAL, true);
@@ -442,6 +456,22 @@ cfTask_t cfTasks[TASK_COUNT] = {
         .desiredPeriod = TASK_PERIOD_US(TASK_GYRO_LOOPTIME),
         .staticPriority = TASK_PRIORITY_REALTIME,
     },
+#ifdef USE_PID_OUTER_LOOP
+    [TASK_PID_OUTER] = {
+        .taskName = "PID_OUTER",
+        .taskFunc = taskPidOuterLoop,
+        .desiredPeriod = TASK_PERIOD_US(2000),
+        .staticPriority = TASK_PRIORITY_HIGH,
+    },
+#endif
+#if defined(USE_BLACKBOX) && defined(USE_BLACKBOX_DEFERRED)
+    [TASK_BLACKBOX] = {
+        .taskName = "BLACKBOX",
+        .taskFunc = blackboxUpdateDeferred,
+        .desiredPeriod = TASK_PERIOD_US(1000),
+        .staticPriority = TASK_PRIORITY_MEDIUM_HIGH,
+    },
+#endif
     [TASK_SERIAL] = {
         .taskName = "SERIAL",
         .taskFunc = taskHandleSerial,
@@ -26,6 +26,7 @@ bool taskUpdateRxCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTime);
 void taskUpdateRxMain(timeUs_t currentTimeUs);
 
 void taskMainPidLoop(timeUs_t currentTimeUs);
+void taskPidOuterLoop(timeUs_t currentTimeUs);
 void taskGyro(timeUs_t currentTimeUs);
 
 void fcTasksInit(void);
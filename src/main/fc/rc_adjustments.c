@@ -395,8 +395,8 @@ static void applyStepAdjustment(controlRateConfig_t *controlRateConfig, uint8_t
         case ADJUSTMENT_PITCH_ROLL_RATE:
         case ADJUSTMENT_PITCH_RATE:
             applyAdjustmentU8(ADJUSTMENT_PITCH_RATE, &controlRateConfig->stabilized.rates[FD_PITCH], delta, SETTING_PITCH_RATE_MIN, SETTING_PITCH_RATE_MAX);
+            schedulePidAxisGainsUpdate(FD_PITCH);
             if (adjustmentFunction == ADJUSTMENT_PITCH_RATE) {
-                schedulePidGainsUpdate();
                 break;
             }
             // follow though for combined ADJUSTMENT_PITCH_ROLL_RATE
@@ -404,7 +404,7 @@ static void applyStepAdjustment(controlRateConfig_t *controlRateConfig, uint8_t
 
         case ADJUSTMENT_ROLL_RATE:
             applyAdjustmentU8(ADJUSTMENT_ROLL_RATE, &controlRateConfig->stabilized.rates[FD_ROLL], delta, SETTING_CONSTANT_ROLL_PITCH_RATE_MIN, SETTING_CONSTANT_ROLL_PITCH_RATE_MAX);
-            schedulePidGainsUpdate();
+            schedulePidAxisGainsUpdate(FD_ROLL);
             break;
         case ADJUSTMENT_MANUAL_PITCH_ROLL_RATE:
         case ADJUSTMENT_MANUAL_ROLL_RATE:
@@ -418,7 +418,7 @@ static void applyStepAdjustment(controlRateConfig_t *controlRateConfig, uint8_t
             break;
         case ADJUSTMENT_YAW_RATE:
             applyAdjustmentU8(ADJUSTMENT_YAW_RATE, &controlRateConfig->stabilized.rates[FD_YAW], delta, SETTING_YAW_RATE_MIN, SETTING_YAW_RATE_MAX);
-            schedulePidGainsUpdate();
+            schedulePidAxisGainsUpdate(FD_YAW);
             break;
         case ADJUSTMENT_MANUAL_YAW_RATE:
             applyAdjustmentManualRate(ADJUSTMENT_MANUAL_YAW_RATE, &controlRateConfig->manual.rates[FD_YAW], delta);
@@ -426,8 +426,8 @@ static void applyStepAdjustment(controlRateConfig_t *controlRateConfig, uint8_t
         case ADJUSTMENT_PITCH_ROLL_P:
         case ADJUSTMENT_PITCH_P:
             applyAdjustmentPID(ADJUSTMENT_PITCH_P, &pidBankMutable()->pid[PID_PITCH].P, delta);
+            schedulePidAxisGainsUpdate(FD_PITCH);
             if (adjustmentFunction == ADJUSTMENT_PITCH_P) {
-                schedulePidGainsUpdate();
                 break;
             }
             // follow though for combined ADJUSTMENT_PITCH_ROLL_P
@@ -435,13 +435,13 @@ static void applyStepAdjustment(controlRateConfig_t *controlRateConfig, uint8_t
 
         case ADJUSTMENT_ROLL_P:
             applyAdjustmentPID(ADJUSTMENT_ROLL_P, &pidBankMutable()->pid[PID_ROLL].P, delta);
-            schedulePidGainsUpdate();
+            schedulePidAxisGainsUpdate(FD_ROLL);
             break;
         case ADJUSTMENT_PITCH_ROLL_I:
         case ADJUSTMENT_PITCH_I:
             applyAdjustmentPID(ADJUSTMENT_PITCH_I, &pidBankMutable()->pid[PID_PITCH].I, delta);
+            schedulePidAxisGainsUpdate(FD_PITCH);
             if (adjustmentFunction == ADJUSTMENT_PITCH_I) {
-                schedulePidGainsUpdate();
                 break;
             }
             // follow though for combined ADJUSTMENT_PITCH_ROLL_I
@@ -449,13 +449,13 @@ static void applyStepAdjustment(controlRateConfig_t *controlRateConfig, uint8_t
 
         case ADJUSTMENT_ROLL_I:
             applyAdjustmentPID(ADJUSTMENT_ROLL_I, &pidBankMutable()->pid[PID_ROLL].I, delta);
-            schedulePidGainsUpdate();
+            schedulePidAxisGainsUpdate(FD_ROLL);
             break;
         case ADJUSTMENT_PITCH_ROLL_D:
         case ADJUSTMENT_PITCH_D:
             applyAdjustmentPID(ADJUSTMENT_PITCH_D, &pidBankMutable()->pid[PID_PITCH].D, delta);
+            schedulePidAxisGainsUpdate(FD_PITCH);
             if (adjustmentFunction == ADJUSTMENT_PITCH_D) {
-                schedulePidGainsUpdate();
                 break;
             }
             // follow though for combined ADJUSTMENT_PITCH_ROLL_D
@@ -463,13 +463,13 @@ static void applyStepAdjustment(controlRateConfig_t *controlRateConfig, uint8_t
 
         case ADJUSTMENT_ROLL_D:
             applyAdjustmentPID(ADJUSTMENT_ROLL_D, &pidBankMutable()->pid[PID_ROLL].D, delta);
-            schedulePidGainsUpdate();
+            schedulePidAxisGainsUpdate(FD_ROLL);
             break;
         case ADJUSTMENT_PITCH_ROLL_FF:
         case ADJUSTMENT_PITCH_FF:
             applyAdjustmentPID(ADJUSTMENT_PITCH_FF, &pidBankMutable()->pid[PID_PITCH].FF, delta);
+            schedulePidAxisGainsUpdate(FD_PITCH);
             if (adjustmentFunction == ADJUSTMENT_PITCH_FF) {
-                schedulePidGainsUpdate();
                 break;
             }
             // follow though for combined ADJUSTMENT_PITCH_ROLL_FF
@@ -477,23 +477,23 @@ static void applyStepAdjustment(controlRateConfig_t *controlRateConfig, uint8_t
 
         case ADJUSTMENT_ROLL_FF:
             applyAdjustmentPID(ADJUSTMENT_ROLL_FF, &pidBankMutable()->pid[PID_ROLL].FF, delta);
-            schedulePidGainsUpdate();
+            schedulePidAxisGainsUpdate(FD_ROLL);
             break;
         case ADJUSTMENT_YAW_P:
             applyAdjustmentPID(ADJUSTMENT_YAW_P, &pidBankMutable()->pid[PID_YAW].P, delta);
-            schedulePidGainsUpdate();
+            schedulePidAxisGainsUpdate(FD_YAW);
             break;
         case ADJUSTMENT_YAW_I:
             applyAdjustmentPID(ADJUSTMENT_YAW_I, &pidBankMutable()->pid[PID_YAW].I, delta);
-            schedulePidGainsUpdate();
+            schedulePidAxisGainsUpdate(FD_YAW);
             break;
         case ADJUSTMENT_YAW_D:
             applyAdjustmentPID(ADJUSTMENT_YAW_D, &pidBankMutable()->pid[PID_YAW].D, delta);
-            schedulePidGainsUpdate();
+            schedulePidAxisGainsUpdate(FD_YAW);
             break;
         case ADJUSTMENT_YAW_FF:
             applyAdjustmentPID(ADJUSTMENT_YAW_FF, &pidBankMutable()->pid[PID_YAW].FF, delta);
-            schedulePidGainsUpdate();
+            schedulePidAxisGainsUpdate(FD_YAW);
             break;
         case ADJUSTMENT_NAV_FW_CRUISE_THR:
             applyAdjustmentU16(ADJUSTMENT_NAV_FW_CRUISE_THR, &currentBatteryProfileMutable->nav.fw.cruise_throttle, delta, SETTING_NAV_FW_CRUISE_THR_MIN, SETTING_NAV_FW_CRUISE_THR_MAX);
@@ -41,6 +41,7 @@ void dynamicGyroNotchFiltersInit(dynamicGyroNotchState_t *state) {
     }
 
     state->dynNotchQ = gyroConfig()->dynamicGyroNotchQ / 100.0f;
+    state->hysteresisHz = gyroConfig()->notchUpdateHysteresis / 10.0f;
     state->enabled = gyroConfig()->dynamicGyroNotchEnabled;
     state->looptime = getLooptime();
 
@@ -53,6 +54,7 @@ void dynamicGyroNotchFiltersInit(dynamicGyroNotchState_t *state) {
             for (int i = 0; i < DYN_NOTCH_PEAK_COUNT; i++) {
                 biquadFilterInit(&state->filters[axis][i], DYNAMIC_NOTCH_DEFAULT_CENTER_HZ, state->looptime, 1.0f, FILTER_NOTCH);
                 state->filtersApplyFn[axis][i] = (filterApplyFnPtr)biquadFilterApplyDF1;
+                state->appliedFrequency[axis][i] = 0.0f;
             }
         
         }
@@ -67,9 +69,9 @@ void dynamicGyroNotchFiltersUpdate(dynamicGyroNotchState_t *state, int axis, flo
 
             state->frequency[axis][i] = frequency[i];
 
-            // Filter update happens only if peak was detected 
+            // Filter update happens only if peak was detected and moved far enough from the current notch
             if (frequency[i] > 0.0f) {
-                biquadFilterUpdate(&state->filters[axis][i], frequency[i], state->looptime, state->dynNotchQ, FILTER_NOTCH);
+                biquadFilterUpdateNotchCached(&state->filters[axis][i], &state->appliedFrequency[axis][i], frequency[i], state->looptime, state->dynNotchQ, state->hysteresisHz);
             }
         }
     }
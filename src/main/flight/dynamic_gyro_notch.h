@@ -36,7 +36,9 @@
 #define DYN_NOTCH_PEAK_COUNT 3
 typedef struct dynamicGyroNotchState_s {
     uint16_t frequency[XYZ_AXIS_COUNT][DYN_NOTCH_PEAK_COUNT];
+    float appliedFrequency[XYZ_AXIS_COUNT][DYN_NOTCH_PEAK_COUNT];
     float dynNotchQ;
+    float hysteresisHz;
     uint32_t looptime;
     uint8_t enabled;
     
@@ -137,5 +137,7 @@ void ezTuneUpdate(void) {
         ((controlRateConfig_t*)currentControlRateProfile)->stabilized.rcExpo8 = scaleRange(ezTune()->rate, 0, 200, 40, 100);
         ((controlRateConfig_t*)currentControlRateProfile)->stabilized.rcYawExpo8 = scaleRange(ezTune()->rate, 0, 200, 40, 100);
 
+        schedulePidGainsUpdate();
+
     }
 }
\ No newline at end of file
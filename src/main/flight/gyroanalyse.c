@@ -47,18 +47,19 @@
 
 enum {
     STEP_ARM_CFFT_F32,
-    STEP_BITREVERSAL_AND_STAGE_RFFT_F32,
-    STEP_MAGNITUDE_AND_FREQUENCY,
-    STEP_UPDATE_FILTERS_AND_HANNING,
+    STEP_BITREVERSAL,
+    STEP_STAGE_RFFT_F32,
+    STEP_ARM_CMPLX_MAG_F32,
+    STEP_CALC_FREQUENCIES,
+    STEP_UPDATE_FILTERS,
+    STEP_HANNING,
     STEP_COUNT
 };
 
 // The FFT splits the frequency domain into an number of bins
-// A sampling frequency of 1000 and max frequency of 500 at a window size of 32 gives 16 frequency bins each 31.25Hz wide
-// Eg [0,31), [31,62), [62, 93) etc
-// for gyro loop >= 4KHz, sample rate 2000 defines FFT range to 1000Hz, 16 bins each 62.5 Hz wide
-// NB  FFT_WINDOW_SIZE is set to 32 in gyroanalyse.h
-#define FFT_BIN_COUNT             (FFT_WINDOW_SIZE / 2)
+// A sampling frequency of 1000 and max frequency of 500 at a window size of 64 gives 32 frequency bins each 15.6Hz wide
+// Eg [0,15.6), [15.6,31.2), [31.2, 46.8) etc
+// 128 and 256 sample windows give 7.8Hz and 3.9Hz wide bins at the cost of a longer window
 // smoothing frequency for FFT centre frequency
 #define DYN_NOTCH_SMOOTH_FREQ_HZ  25
 
@@ -69,27 +70,105 @@ enum {
  */
 #define FFT_SAMPLING_DENOMINATOR 2
 
+/*
+ * Samples taken from the full rate gyro stream are averaged down to at most this rate,
+ * which still covers motor noise up to 1kHz
+ */
+#define FFT_SAMPLING_RATE_MAX_HZ 2000
+
+// Notches running at PID rate can not be placed above this fraction of the PID rate
+#define FFT_NOTCH_MAX_NORMALISED_FREQ 0.48f
+
+static uint8_t fftSamplingDenominator(uint32_t sampleIntervalUs, uint32_t targetLooptimeUs)
+{
+    if (sampleIntervalUs >= targetLooptimeUs) {
+        return FFT_SAMPLING_DENOMINATOR;
+    }
+
+    const uint32_t samplingRateHz = 1000000 / sampleIntervalUs;
+    const uint8_t denominator = (samplingRateHz + FFT_SAMPLING_RATE_MAX_HZ - 1) / FFT_SAMPLING_RATE_MAX_HZ;
+    return MAX(denominator, 1);
+}
+
+static uint16_t fftWindowSizeFromConfig(uint8_t fftWindow)
+{
+    switch (fftWindow) {
+        case DYNAMIC_NOTCH_FFT_WINDOW_128:
+            return 128;
+        case DYNAMIC_NOTCH_FFT_WINDOW_256:
+            return 256;
+        case DYNAMIC_NOTCH_FFT_WINDOW_64:
+        default:
+            return 64;
+    }
+}
+
+/*
+ * Number of new samples between the starts of two consecutive analysis rounds.
+ * 0 means analysis runs back to back, limited only by the state machine length
+ */
+static uint16_t fftHopSamplesFromConfig(uint8_t fftOverlap, uint16_t fftWindowSize)
+{
+    switch (fftOverlap) {
+        case DYNAMIC_NOTCH_FFT_OVERLAP_NONE:
+            return fftWindowSize;
+        case DYNAMIC_NOTCH_FFT_OVERLAP_50:
+            return fftWindowSize / 2;
+        case DYNAMIC_NOTCH_FFT_OVERLAP_75:
+            return fftWindowSize / 4;
+        case DYNAMIC_NOTCH_FFT_OVERLAP_MAX:
+        default:
+            return 0;
+    }
+}
+
 void gyroDataAnalyseStateInit(
     gyroAnalyseState_t *state, 
     uint16_t minFrequency,
-    uint32_t targetLooptimeUs
+    uint32_t targetLooptimeUs,
+    uint32_t sampleIntervalUs,
+    uint8_t fftWindow,
+    uint8_t fftOverlap
 ) {
     state->minFrequency = minFrequency;
 
-    state->fftSamplingRateHz = 1e6f / targetLooptimeUs / FFT_SAMPLING_DENOMINATOR;
+    state->fftWindowSize = fftWindowSizeFromConfig(fftWindow);
+    state->fftBinCount = state->fftWindowSize / 2;
+    state->fftHopSamples = fftHopSamplesFromConfig(fftOverlap, state->fftWindowSize);
+    state->samplesSinceLastWindow = 0;
+    state->circularBufferIdx = 0;
+    state->samplingIndex = 0;
+    state->samplingDenominator = fftSamplingDenominator(sampleIntervalUs, targetLooptimeUs);
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        state->sampleAccumulator[axis] = 0.0f;
+    }
+
+    state->fftSamplingRateHz = 1e6f / sampleIntervalUs / state->samplingDenominator;
     state->maxFrequency = state->fftSamplingRateHz / 2; //max possible frequency is half the sampling rate
-    state->fftResolution = (float)state->maxFrequency / FFT_BIN_COUNT;
+    state->fftResolution = (float)state->maxFrequency / state->fftBinCount;
 
     state->fftStartBin = state->minFrequency / lrintf(state->fftResolution);
 
-    for (int i = 0; i < FFT_WINDOW_SIZE; i++) {
-        state->hanningWindow[i] = (0.5f - 0.5f * cos_approx(2 * M_PIf * i / (FFT_WINDOW_SIZE - 1)));
+    // With samples taken faster than the PID loop, peaks the notches can not follow are not reported
+    const float notchMaxFrequency = FFT_NOTCH_MAX_NORMALISED_FREQ * 1e6f / targetLooptimeUs;
+    state->fftEndBin = MIN(state->fftBinCount - 1, (int)(notchMaxFrequency / state->fftResolution));
+
+    for (int i = 0; i < state->fftWindowSize; i++) {
+        state->hanningWindow[i] = (0.5f - 0.5f * cos_approx(2 * M_PIf * i / (state->fftWindowSize - 1)));
     }
 
-    arm_rfft_fast_init_f32(&state->fftInstance, FFT_WINDOW_SIZE);
+    arm_rfft_fast_init_f32(&state->fftInstance, state->fftWindowSize);
 
-    // Frequency filter is executed every 12 cycles. 4 steps per cycle, 3 axises
-    const uint32_t filterUpdateUs = targetLooptimeUs * STEP_COUNT * XYZ_AXIS_COUNT;
+    // The 256 sample window spreads its CFFT over 3 cycles, see STEP_ARM_CFFT_F32
+    state->cfftStep = 0;
+    state->cfftStepCount = (state->fftWindowSize == 256) ? 3 : 1;
+
+    // Each axis is analysed once per (STEP_COUNT + cfftStepCount - 1) cycles, so all 3 axes take 3 times as many.
+    // With overlap limited, a new round does not start before fftHopSamples new samples arrived
+    const uint32_t roundUs = targetLooptimeUs * (STEP_COUNT + state->cfftStepCount - 1) * XYZ_AXIS_COUNT;
+    const uint32_t hopUs = sampleIntervalUs * state->samplingDenominator * state->fftHopSamples;
+    const uint32_t filterUpdateUs = MAX(roundUs, hopUs);
 
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
         
@@ -103,45 +182,85 @@ void gyroDataAnalyseStateInit(
 
 void gyroDataAnalysePush(gyroAnalyseState_t *state, const int axis, const float sample)
 {
-    state->currentSample[axis] = sample;
+    state->sampleAccumulator[axis] += sample;
 }
 
-static void gyroDataAnalyseUpdate(gyroAnalyseState_t *state);
-
 /*
- * Collect gyro data, to be analysed in gyroDataAnalyseUpdate function
+ * Has to be called once samples of all axes were pushed. Every samplingDenominator
+ * calls the mean of accumulated samples is stored for analysis
  */
-void gyroDataAnalyse(gyroAnalyseState_t *state)
+void gyroDataAnalyseCollect(gyroAnalyseState_t *state)
 {
-    state->filterUpdateExecute = false; //This will be changed to true only if new data is present
+    state->samplingIndex++;
 
-    static uint8_t samplingIndex = 0;
+    if (state->samplingIndex < state->samplingDenominator) {
+        return;
+    }
 
-    if (samplingIndex == 0) {
-        // calculate mean value of accumulated samples
-        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-            state->downsampledGyroData[axis][state->circularBufferIdx] = state->currentSample[axis];
-        }
+    state->samplingIndex = 0;
 
-        state->circularBufferIdx = (state->circularBufferIdx + 1) % FFT_WINDOW_SIZE;
+    // calculate mean value of accumulated samples
+    const float sampleScale = 1.0f / state->samplingDenominator;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        state->downsampledGyroData[axis][state->circularBufferIdx] = state->sampleAccumulator[axis] * sampleScale;
+        state->sampleAccumulator[axis] = 0.0f;
     }
 
-    samplingIndex = (samplingIndex + 1) % FFT_SAMPLING_DENOMINATOR;
+    state->circularBufferIdx = (state->circularBufferIdx + 1) % state->fftWindowSize;
+
+    if (state->samplesSinceLastWindow < state->fftWindowSize) {
+        state->samplesSinceLastWindow++;
+    }
+}
+
+static void gyroDataAnalyseUpdate(gyroAnalyseState_t *state);
+
+/*
+ * Run one step of the analysis of collected gyro data, has to be called at PID rate
+ */
+void gyroDataAnalyse(gyroAnalyseState_t *state)
+{
+    state->filterUpdateExecute = false; //This will be changed to true only if new data is present
 
     gyroDataAnalyseUpdate(state);
 }
 
 void stage_rfft_f32(arm_rfft_fast_instance_f32 *S, float32_t *p, float32_t *pOut);
 void arm_cfft_radix8by4_f32(arm_cfft_instance_f32 *S, float32_t *p1);
+void arm_radix8_butterfly_f32(float32_t *pSrc, uint16_t fftLen, const float32_t *pCoef, uint16_t twidCoefModifier);
 void arm_bitreversal_32(uint32_t *pSrc, const uint16_t bitRevLen, const uint16_t *pBitRevTable);
 
-static float computeParabolaMean(gyroAnalyseState_t *state, uint8_t peakBinIndex) {
+/*
+ * First stage of a radix-2 decimation in frequency CFFT. Leaves the two halves of the
+ * data as independent CFFTs of fftLen / 2 points each, in place
+ */
+static void cfftRadix2Stage(const arm_cfft_instance_f32 *S, float32_t *data)
+{
+    const uint16_t halfLength = S->fftLen / 2;
+    float32_t *upper = &data[S->fftLen];
+
+    for (int k = 0; k < halfLength; k++) {
+        const float32_t twR = S->pTwiddle[2 * k];
+        const float32_t twI = S->pTwiddle[2 * k + 1];
+        const float32_t diffR = data[2 * k] - upper[2 * k];
+        const float32_t diffI = data[2 * k + 1] - upper[2 * k + 1];
+
+        data[2 * k] += upper[2 * k];
+        data[2 * k + 1] += upper[2 * k + 1];
+
+        // Multiply by the conjugate twiddle factor
+        upper[2 * k] = diffR * twR + diffI * twI;
+        upper[2 * k + 1] = diffI * twR - diffR * twI;
+    }
+}
+
+static float computeParabolaMean(gyroAnalyseState_t *state, int peakBinIndex) {
     float preciseBin = peakBinIndex;
 
     // Height of peak bin (y1) and shoulder bins (y0, y2)
     const float y0 = state->fftData[peakBinIndex - 1];
     const float y1 = state->fftData[peakBinIndex];
-    const float y2 = state->fftData[peakBinIndex - 1];
+    const float y2 = state->fftData[peakBinIndex + 1];
 
     // Estimate true peak position aka. preciseBin (fit parabola y(x) over y0, y1 and y2, solve dy/dx=0 for x)
     const float denom = 2.0f * (y0 - 2 * y1 + y2);
@@ -154,7 +273,7 @@ static float computeParabolaMean(gyroAnalyseState_t *state, uint8_t peakBinIndex
 }
 
 /*
- * Analyse last gyro data from the last FFT_WINDOW_SIZE milliseconds
+ * Analyse last fftWindowSize downsampled gyro samples
  */
 static NOINLINE void gyroDataAnalyseUpdate(gyroAnalyseState_t *state)
 {
@@ -164,21 +283,51 @@ static NOINLINE void gyroDataAnalyseUpdate(gyroAnalyseState_t *state)
     switch (state->updateStep) {
         case STEP_ARM_CFFT_F32:
         {
-            // Important this works only with FFT windows size of 64 elements!
-            arm_cfft_radix8by4_f32(Sint, state->fftData);
+            // Real FFT of N samples is computed as complex FFT of N/2 points, each size has its own kernel
+            switch (state->fftWindowSize) {
+                case 64:
+                    arm_cfft_radix8by4_f32(Sint, state->fftData);
+                    break;
+                case 128:
+                    arm_radix8_butterfly_f32(state->fftData, Sint->fftLen, Sint->pTwiddle, 1);
+                    break;
+                case 256:
+                    /*
+                     * Same as arm_cfft_radix8by2_f32, split in three steps: the radix-2 stage and
+                     * one 64 point butterfly per half. No step costs more than the 128 sample window
+                     */
+                    if (state->cfftStep == 0) {
+                        cfftRadix2Stage(Sint, state->fftData);
+                    } else {
+                        arm_radix8_butterfly_f32(&state->fftData[(state->cfftStep - 1) * Sint->fftLen], Sint->fftLen / 2, Sint->pTwiddle, 2);
+                    }
+                    break;
+            }
+
+            state->cfftStep++;
+            if (state->cfftStep < state->cfftStepCount) {
+                return;
+            }
+            state->cfftStep = 0;
             break;
         }
-        case STEP_BITREVERSAL_AND_STAGE_RFFT_F32:
+        case STEP_BITREVERSAL:
         {
             arm_bitreversal_32((uint32_t*) state->fftData, Sint->bitRevLength, Sint->pBitRevTable);
+            break;
+        }
+        case STEP_STAGE_RFFT_F32:
+        {
             stage_rfft_f32(&state->fftInstance, state->fftData, state->rfftData);
             break;
         }
-        case STEP_MAGNITUDE_AND_FREQUENCY:
+        case STEP_ARM_CMPLX_MAG_F32:
+        {
+            arm_cmplx_mag_f32(state->rfftData, state->fftData, state->fftBinCount);
+            break;
+        }
+        case STEP_CALC_FREQUENCIES:
         {
-            // 8us
-            arm_cmplx_mag_f32(state->rfftData, state->fftData, FFT_BIN_COUNT);
-
             //Zero the data structure
             for (int i = 0; i < DYN_NOTCH_PEAK_COUNT; i++) {
                 state->peaks[i].bin = 0;
@@ -186,7 +335,7 @@ static NOINLINE void gyroDataAnalyseUpdate(gyroAnalyseState_t *state)
             }
 
             // Find peaks
-            for (int bin = (state->fftStartBin + 1); bin < FFT_BIN_COUNT - 1; bin++) {
+            for (int bin = (state->fftStartBin + 1); bin < state->fftEndBin; bin++) {
                 /*
                  * Peak is defined if the current bin is greater than the previous bin and the next bin
                  */
@@ -227,7 +376,7 @@ static NOINLINE void gyroDataAnalyseUpdate(gyroAnalyseState_t *state)
 
             break;
         }
-        case STEP_UPDATE_FILTERS_AND_HANNING:
+        case STEP_UPDATE_FILTERS:
         {
 
             /*
@@ -236,7 +385,7 @@ static NOINLINE void gyroDataAnalyseUpdate(gyroAnalyseState_t *state)
             for (int i = 0; i < DYN_NOTCH_PEAK_COUNT; i++) {
 
                 if (state->peaks[i].bin > 0) {
-                    const int bin = constrain(state->peaks[i].bin, state->fftStartBin, FFT_BIN_COUNT - 1);
+                    const int bin = constrain(state->peaks[i].bin, state->fftStartBin, state->fftBinCount - 2);
                     float frequency = computeParabolaMean(state, bin) * state->fftResolution;
 
                     state->centerFrequency[state->updateAxis][i] = pt1FilterApply(&state->detectedFrequencyFilter[state->updateAxis][i], frequency);
@@ -253,10 +402,32 @@ static NOINLINE void gyroDataAnalyseUpdate(gyroAnalyseState_t *state)
 
             //Switch to the next axis
             state->updateAxis = (state->updateAxis + 1) % XYZ_AXIS_COUNT;
-            
+            break;
+        }
+        case STEP_HANNING:
+        {
+            /*
+             * A new round over all axes starts only when enough new samples arrived since the
+             * previous one. Consecutive windows then overlap by (window - hop) samples, so the
+             * estimate refresh rate is set by the hop and not by the window length
+             */
+            if (state->updateAxis == 0) {
+                if (state->samplesSinceLastWindow < state->fftHopSamples) {
+                    return;
+                }
+                state->samplesSinceLastWindow = 0;
+            }
+
             // apply hanning window to gyro samples and store result in fftData
-            // hanning starts and ends with 0, could be skipped for minor speed improvement
-            arm_mult_f32(state->downsampledGyroData[state->updateAxis], state->hanningWindow, state->fftData, FFT_WINDOW_SIZE);
+            // circular buffer is unrolled so the window starts at the oldest sample
+            const float *gyroData = state->downsampledGyroData[state->updateAxis];
+            const uint16_t tailLength = state->fftWindowSize - state->circularBufferIdx;
+
+            arm_mult_f32((float32_t *) &gyroData[state->circularBufferIdx], state->hanningWindow, state->fftData, tailLength);
+            if (state->circularBufferIdx > 0) {
+                arm_mult_f32((float32_t *) gyroData, &state->hanningWindow[tailLength], &state->fftData[tailLength], state->circularBufferIdx);
+            }
+            break;
         }
     }
 
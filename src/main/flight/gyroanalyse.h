@@ -26,10 +26,11 @@
 #include "common/filter.h"
 
 /*
- * Current code works only with 64 window size. Changing it do a different size would require
- * adapting the gyroDataAnalyseUpdate in STEP_ARM_CFFT_F32 step
+ * Buffers are sized for the largest supported window. Selected window size has to be
+ * one of 64, 128 or 256 samples, each of them has its own CFFT kernel in STEP_ARM_CFFT_F32
  */
-#define FFT_WINDOW_SIZE 64
+#define FFT_WINDOW_SIZE_MAX 256
+#define FFT_BIN_COUNT_MAX   (FFT_WINDOW_SIZE_MAX / 2)
 
 typedef struct peak_s {
     int bin;
@@ -38,19 +39,29 @@ typedef struct peak_s {
 
 typedef struct gyroAnalyseState_s {
     // accumulator for oversampled data => no aliasing and less noise
-    float currentSample[XYZ_AXIS_COUNT];
+    float sampleAccumulator[XYZ_AXIS_COUNT];
 
     // downsampled gyro data circular buffer for frequency analysis
-    uint8_t circularBufferIdx;
-    float downsampledGyroData[XYZ_AXIS_COUNT][FFT_WINDOW_SIZE];
+    uint16_t circularBufferIdx;
+    uint8_t samplingIndex;
+    uint8_t samplingDenominator;
+    float downsampledGyroData[XYZ_AXIS_COUNT][FFT_WINDOW_SIZE_MAX];
 
     // update state machine step information
     uint8_t updateStep;
     uint8_t updateAxis;
+    uint8_t cfftStep;
+    uint8_t cfftStepCount;
+
+    // window size and hop between consecutive analysed windows (Welch-style overlap)
+    uint16_t fftWindowSize;
+    uint16_t fftBinCount;
+    uint16_t fftHopSamples;
+    uint16_t samplesSinceLastWindow;
 
     arm_rfft_fast_instance_f32 fftInstance;
-    float fftData[FFT_WINDOW_SIZE];
-    float rfftData[FFT_WINDOW_SIZE];
+    float fftData[FFT_WINDOW_SIZE_MAX];
+    float rfftData[FFT_WINDOW_SIZE_MAX];
 
     pt1Filter_t detectedFrequencyFilter[XYZ_AXIS_COUNT][DYN_NOTCH_PEAK_COUNT];
     float centerFrequency[XYZ_AXIS_COUNT][DYN_NOTCH_PEAK_COUNT];
@@ -63,21 +74,26 @@ typedef struct gyroAnalyseState_s {
 
     uint16_t fftSamplingRateHz;
     uint8_t fftStartBin;
+    uint8_t fftEndBin;
     float fftResolution;
     uint16_t minFrequency;
     uint16_t maxFrequency;
 
     // Hanning window, see https://en.wikipedia.org/wiki/Window_function#Hann_.28Hanning.29_window
-    float hanningWindow[FFT_WINDOW_SIZE];
+    float hanningWindow[FFT_WINDOW_SIZE_MAX];
 } gyroAnalyseState_t;
 
-STATIC_ASSERT(FFT_WINDOW_SIZE <= (uint8_t) -1, window_size_greater_than_underlying_type);
+STATIC_ASSERT(FFT_WINDOW_SIZE_MAX <= (uint16_t) -1, window_size_greater_than_underlying_type);
 
 void gyroDataAnalyseStateInit(
     gyroAnalyseState_t *state, 
     uint16_t minFrequency,
-    uint32_t targetLooptimeUs
+    uint32_t targetLooptimeUs,
+    uint32_t sampleIntervalUs,
+    uint8_t fftWindow,
+    uint8_t fftOverlap
 );
 void gyroDataAnalysePush(gyroAnalyseState_t *gyroAnalyse, int axis, float sample);
+void gyroDataAnalyseCollect(gyroAnalyseState_t *gyroAnalyse);
 void gyroDataAnalyse(gyroAnalyseState_t *gyroAnalyse);
 #endif
\ No newline at end of file
@@ -30,6 +30,7 @@
 
 #include "common/axis.h"
 #include "common/filter.h"
+#include "common/linalg.h"
 #include "common/log.h"
 #include "common/maths.h"
 #include "common/vector.h"
@@ -134,28 +135,7 @@ PG_RESET_TEMPLATE(imuConfig_t, imuConfig,
 
 STATIC_UNIT_TESTED void imuComputeRotationMatrix(void)
 {
-    float q1q1 = orientation.q1 * orientation.q1;
-    float q2q2 = orientation.q2 * orientation.q2;
-    float q3q3 = orientation.q3 * orientation.q3;
-
-    float q0q1 = orientation.q0 * orientation.q1;
-    float q0q2 = orientation.q0 * orientation.q2;
-    float q0q3 = orientation.q0 * orientation.q3;
-    float q1q2 = orientation.q1 * orientation.q2;
-    float q1q3 = orientation.q1 * orientation.q3;
-    float q2q3 = orientation.q2 * orientation.q3;
-
-    rMat[0][0] = 1.0f - 2.0f * q2q2 - 2.0f * q3q3;
-    rMat[0][1] = 2.0f * (q1q2 + -q0q3);
-    rMat[0][2] = 2.0f * (q1q3 - -q0q2);
-
-    rMat[1][0] = 2.0f * (q1q2 - -q0q3);
-    rMat[1][1] = 1.0f - 2.0f * q1q1 - 2.0f * q3q3;
-    rMat[1][2] = 2.0f * (q2q3 + -q0q1);
-
-    rMat[2][0] = 2.0f * (q1q3 + -q0q2);
-    rMat[2][1] = 2.0f * (q2q3 - -q0q1);
-    rMat[2][2] = 1.0f - 2.0f * q1q1 - 2.0f * q2q2;
+    rotationMatrixFromQuaternion(rMat, &orientation);
 }
 
 void imuConfigure(void)
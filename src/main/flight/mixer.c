@@ -48,6 +48,7 @@
 #include "flight/failsafe.h"
 #include "flight/imu.h"
 #include "flight/mixer.h"
+#include "flight/mixer_matrix.h"
 #include "flight/pid.h"
 #include "flight/servos.h"
 
@@ -62,6 +63,8 @@ FASTRAM int16_t motor_disarmed[MAX_SUPPORTED_MOTORS];
 static float motorMixRange;
 static float mixerScale = 1.0f;
 static EXTENDED_FASTRAM motorMixer_t currentMixer[MAX_SUPPORTED_MOTORS];
+static EXTENDED_FASTRAM mixerMatrix_t mixerMatrix;
+static EXTENDED_FASTRAM thrustLinearization_t thrustLinearization;
 static EXTENDED_FASTRAM uint8_t motorCount = 0;
 EXTENDED_FASTRAM int mixerThrottleCommand;
 static EXTENDED_FASTRAM int throttleIdleValue = 0;
@@ -83,7 +86,7 @@ PG_RESET_TEMPLATE(reversibleMotorsConfig_t, reversibleMotorsConfig,
     .neutral = SETTING_3D_NEUTRAL_DEFAULT
 );
 
-PG_REGISTER_WITH_RESET_TEMPLATE(motorConfig_t, motorConfig, PG_MOTOR_CONFIG, 10);
+PG_REGISTER_WITH_RESET_TEMPLATE(motorConfig_t, motorConfig, PG_MOTOR_CONFIG, 11);
 
 PG_RESET_TEMPLATE(motorConfig_t, motorConfig,
     .motorPwmProtocol = SETTING_MOTOR_PWM_PROTOCOL_DEFAULT,
@@ -91,6 +94,8 @@ PG_RESET_TEMPLATE(motorConfig_t, motorConfig,
     .maxthrottle = SETTING_MAX_THROTTLE_DEFAULT,
     .mincommand = SETTING_MIN_COMMAND_DEFAULT,
     .motorPoleCount = SETTING_MOTOR_POLES_DEFAULT,            // Most brushless motors that we use are 14 poles
+    .thrustLinearization = SETTING_MOTOR_THRUST_LINEARIZATION_DEFAULT,
+    .throttleCompensationOnOutput = SETTING_THR_COMP_MOTOR_OUTPUT_DEFAULT,
 );
 PG_REGISTER_ARRAY_WITH_RESET_FN(timerOverride_t, HARDWARE_TIMER_DEFINITION_COUNT, timerOverrides, PG_TIMER_OVERRIDE_CONFIG, 0);
 
@@ -214,10 +219,15 @@ void nullMotorRateLimiting(const float dT)
     UNUSED(dT);
 }
 
+static void mixerUpdateMatrix(void)
+{
+    // Yaw PID output is inverted relative to the mixer yaw factors
+    mixerMatrixInit(&mixerMatrix, currentMixer, motorCount, mixerScale, -motorYawMultiplier);
+}
+
 void mixerInit(void)
 {
     computeMotorCount();
-    loadPrimaryMotorMixer();
     // in 3D mode, mixer gain has to be halved
     if (feature(FEATURE_REVERSIBLE_MOTORS)) {
         mixerScale = 0.5f;
@@ -233,6 +243,9 @@ void mixerInit(void)
     } else {
         motorYawMultiplier = 1;
     }
+
+    loadPrimaryMotorMixer();
+    thrustLinearizationInit(&thrustLinearization, motorConfig()->thrustLinearization / 100.0f);
 }
 
 void mixerResetDisarmedMotors(void)
@@ -513,7 +526,7 @@ void FAST_CODE mixTable(void)
         return;
     }
 
-    int16_t input[3];   // RPY, range [-500:+500]
+    float input[3];     // RPY, range [-500:+500]
     // Allow direct stick input to motors in passthrough mode on airplanes
     if (STATE(FIXED_WING_LEGACY) && FLIGHT_MODE(MANUAL_MODE)) {
         // Direct passthru from RX
@@ -528,24 +541,19 @@ void FAST_CODE mixTable(void)
     }
 
     // Initial mixer concept by bdoiron74 reused and optimized for Air Mode
-    int16_t rpyMix[MAX_SUPPORTED_MOTORS];
-    int16_t rpyMixMax = 0; // assumption: symetrical about zero.
-    int16_t rpyMixMin = 0;
+    float rpyMix[MAX_SUPPORTED_MOTORS];
+    float rpyMixMax; // assumption: symetrical about zero.
+    float rpyMixMin;
 
     // motors for non-servo mixes
-    for (int i = 0; i < motorCount; i++) {
-        rpyMix[i] =
-            (input[PITCH] * currentMixer[i].pitch +
-            input[ROLL] * currentMixer[i].roll +
-            -motorYawMultiplier * input[YAW] * currentMixer[i].yaw) * mixerScale;
+    mixerMatrixApplyRpy(&mixerMatrix, input, rpyMix, &rpyMixMin, &rpyMixMax);
 
-        if (rpyMix[i] > rpyMixMax) rpyMixMax = rpyMix[i];
-        if (rpyMix[i] < rpyMixMin) rpyMixMin = rpyMix[i];
-    }
+    const float rpyMixRange = rpyMixMax - rpyMixMin;
+    float throttleRange;
+    float throttleMin, throttleMax;
 
-    int16_t rpyMixRange = rpyMixMax - rpyMixMin;
-    int16_t throttleRange;
-    int16_t throttleMin, throttleMax;
+    // Battery voltage compensation factor of the output stage, 1 when compensating the throttle command
+    float outputCompensation = 1.0f;
 
     // Find min and max throttle based on condition.
 #ifdef USE_PROGRAMMING_FRAMEWORK
@@ -601,7 +609,11 @@ void FAST_CODE mixTable(void)
 #endif
         // Throttle compensation based on battery voltage
         if (feature(FEATURE_THR_VBAT_COMP) && isAmperageConfigured() && feature(FEATURE_VBAT)) {
-            mixerThrottleCommand = MIN(throttleRangeMin + (mixerThrottleCommand - throttleRangeMin) * calculateThrottleCompensationFactor(), throttleRangeMax);
+            if (motorConfig()->throttleCompensationOnOutput) {
+                outputCompensation = calculateThrottleCompensationFactor();
+            } else {
+                mixerThrottleCommand = MIN(throttleRangeMin + (mixerThrottleCommand - throttleRangeMin) * calculateThrottleCompensationFactor(), throttleRangeMax);
+            }
         }
     }
 
@@ -610,11 +622,9 @@ void FAST_CODE mixTable(void)
     throttleRange = throttleMax - throttleMin;
 
     #define THROTTLE_CLIPPING_FACTOR    0.33f
-    motorMixRange = (float)rpyMixRange / (float)throttleRange;
+    motorMixRange = rpyMixRange / throttleRange;
     if (motorMixRange > 1.0f) {
-        for (int i = 0; i < motorCount; i++) {
-            rpyMix[i] /= motorMixRange;
-        }
+        mixerMatrixScale(&mixerMatrix, rpyMix, 1.0f / motorMixRange);
 
         // Allow some clipping on edges to soften correction response
         throttleMin = throttleMin + (throttleRange / 2) - (throttleRange * THROTTLE_CLIPPING_FACTOR / 2);
@@ -624,25 +634,49 @@ void FAST_CODE mixTable(void)
         throttleMax = MAX(throttleMax - (rpyMixRange / 2), throttleMin + (throttleRange / 2) + (throttleRange * THROTTLE_CLIPPING_FACTOR / 2));
     }
 
+    float outputMin, outputMax;
+    if (failsafeIsActive()) {
+        outputMin = motorConfig()->mincommand;
+        outputMax = motorConfig()->maxthrottle;
+    } else {
+        outputMin = throttleRangeMin;
+        outputMax = throttleRangeMax;
+    }
+
     // Now add in the desired throttle, but keep in a range that doesn't clip adjusted
     // roll/pitch/yaw. This could move throttle down, but also up for those low throttle flips.
+    float motorOutput[MAX_SUPPORTED_MOTORS];
     for (int i = 0; i < motorCount; i++) {
-        motor[i] = rpyMix[i] + constrain(mixerThrottleCommand * currentMixer[i].throttle, throttleMin, throttleMax);
+        motorOutput[i] = constrainf(rpyMix[i] + constrainf(mixerThrottleCommand * mixerMatrix.throttle[i], throttleMin, throttleMax), outputMin, outputMax);
+    }
 
-        if (failsafeIsActive()) {
-            motor[i] = constrain(motor[i], motorConfig()->mincommand, motorConfig()->maxthrottle);
-        } else {
-            motor[i] = constrain(motor[i], throttleRangeMin, throttleRangeMax);
-        }
-        
-        //stop motors
-        if (currentMixer[i].throttle <= 0.0f) {
-            motor[i] = motorZeroCommand;
+    // Thrust linearization and battery sag compensation on the output range, forward direction only
+    if ((thrustLinearization.enabled || outputCompensation != 1.0f) && !feature(FEATURE_REVERSIBLE_MOTORS)) {
+        const float outputRange = throttleRangeMax - throttleRangeMin;
+        for (int i = 0; i < motorCount; i++) {
+            const float output = (motorOutput[i] - throttleRangeMin) / outputRange;
+            if (output > 0.0f) {
+                const float compensated = MIN(thrustLinearizationApply(&thrustLinearization, output) * outputCompensation, 1.0f);
+                motorOutput[i] = throttleRangeMin + compensated * outputRange;
+            }
         }
-        //spin stopped motors only in mixer transition mode
-        if (isMixerTransitionMixing && currentMixer[i].throttle <= -1.05f && currentMixer[i].throttle >= -2.0f && (!feature(FEATURE_REVERSIBLE_MOTORS))) {
-            motor[i] = -currentMixer[i].throttle * 1000;
-            motor[i] = constrain(motor[i], throttleRangeMin, throttleRangeMax);
+    }
+
+    for (int i = 0; i < motorCount; i++) {
+        motor[i] = lrintf(motorOutput[i]);
+    }
+
+    if (mixerMatrix.hasInactiveMotors) {
+        for (int i = 0; i < motorCount; i++) {
+            //stop motors
+            if (currentMixer[i].throttle <= 0.0f) {
+                motor[i] = motorZeroCommand;
+            }
+            //spin stopped motors only in mixer transition mode
+            if (isMixerTransitionMixing && currentMixer[i].throttle <= -1.05f && currentMixer[i].throttle >= -2.0f && (!feature(FEATURE_REVERSIBLE_MOTORS))) {
+                motor[i] = -currentMixer[i].throttle * 1000;
+                motor[i] = constrain(motor[i], throttleRangeMin, throttleRangeMax);
+            }
         }
     }
 }
@@ -709,6 +743,7 @@ void loadPrimaryMotorMixer(void) {
     for (int i = 0; i < MAX_SUPPORTED_MOTORS; i++) {
         currentMixer[i] = *primaryMotorMixer(i);
     }
+    mixerUpdateMatrix();
 }
 
 bool areMotorsRunning(void)
@@ -87,6 +87,8 @@ typedef struct motorConfig_s {
     uint8_t  motorPwmProtocol;
     uint16_t digitalIdleOffsetValue;
     uint8_t motorPoleCount;                 // Magnetic poles in the motors for calculating actual RPM from eRPM provided by ESC telemetry
+    uint8_t thrustLinearization;            // Quadratic share of the thrust curve in percent, 0 disables linearization
+    bool throttleCompensationOnOutput;      // Apply battery voltage compensation per motor after mixing
 } motorConfig_t;
 
 PG_DECLARE(motorConfig_t, motorConfig);
@@ -0,0 +1,105 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "platform.h"
+
+#include "common/maths.h"
+#include "common/utils.h"
+
+#include "flight/mixer_matrix.h"
+
+void mixerMatrixInit(mixerMatrix_t *matrix, const motorMixer_t *mixers, uint8_t motorCount, float rpyScale, float yawScale)
+{
+    memset(matrix, 0, sizeof(*matrix));
+
+    matrix->motorCount = MIN(motorCount, MAX_SUPPORTED_MOTORS);
+
+    for (int i = 0; i < matrix->motorCount; i++) {
+        matrix->throttle[i] = mixers[i].throttle;
+        matrix->roll[i] = mixers[i].roll * rpyScale;
+        matrix->pitch[i] = mixers[i].pitch * rpyScale;
+        matrix->yaw[i] = mixers[i].yaw * rpyScale * yawScale;
+
+        if (mixers[i].throttle <= 0.0f) {
+            matrix->hasInactiveMotors = true;
+        }
+    }
+}
+
+/*
+ * Roll, pitch and yaw part of every motor output. Min and max include zero,
+ * the mix is assumed to be symmetrical about zero
+ */
+FAST_CODE void mixerMatrixApplyRpy(const mixerMatrix_t *matrix, const float input[XYZ_AXIS_COUNT], float rpyMix[MAX_SUPPORTED_MOTORS], float *rpyMixMin, float *rpyMixMax)
+{
+    const float roll = input[FD_ROLL];
+    const float pitch = input[FD_PITCH];
+    const float yaw = input[FD_YAW];
+    float mixMin = 0.0f;
+    float mixMax = 0.0f;
+
+    for (int i = 0; i < matrix->motorCount; i++) {
+        const float mix = pitch * matrix->pitch[i] + roll * matrix->roll[i] + yaw * matrix->yaw[i];
+        rpyMix[i] = mix;
+        mixMin = MIN(mixMin, mix);
+        mixMax = MAX(mixMax, mix);
+    }
+
+    *rpyMixMin = mixMin;
+    *rpyMixMax = mixMax;
+}
+
+FAST_CODE void mixerMatrixScale(const mixerMatrix_t *matrix, float mix[MAX_SUPPORTED_MOTORS], float scale)
+{
+    for (int i = 0; i < matrix->motorCount; i++) {
+        mix[i] *= scale;
+    }
+}
+
+/*
+ * Factor is the quadratic share k of the thrust curve in [0, 1], 0 disables linearization
+ */
+void thrustLinearizationInit(thrustLinearization_t *linearization, float factor)
+{
+    linearization->enabled = factor > 0.0f;
+
+    if (linearization->enabled) {
+        const float k = MIN(factor, 1.0f);
+        linearization->reciprocal = 1.0f / k;
+        linearization->offset = (1.0f - k) / (2.0f * k);
+    } else {
+        linearization->reciprocal = 0.0f;
+        linearization->offset = 0.0f;
+    }
+}
+
+/*
+ * Output is the normalised motor output in [0, 1], returns the output producing the requested share of thrust
+ */
+FAST_CODE float thrustLinearizationApply(const thrustLinearization_t *linearization, float output)
+{
+    if (!linearization->enabled || output <= 0.0f) {
+        return output;
+    }
+
+    return fast_fsqrtf(output * linearization->reciprocal + linearization->offset * linearization->offset) - linearization->offset;
+}
@@ -0,0 +1,56 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "common/axis.h"
+
+#include "flight/mixer.h"
+
+/*
+ * Active motor mixer as a motors x 4 matrix stored by columns, so every
+ * column is a contiguous array and mixing is a branch free loop over motors.
+ * Roll, pitch and yaw columns already include the mixer scale and yaw direction.
+ */
+typedef struct mixerMatrix_s {
+    float throttle[MAX_SUPPORTED_MOTORS];
+    float roll[MAX_SUPPORTED_MOTORS];
+    float pitch[MAX_SUPPORTED_MOTORS];
+    float yaw[MAX_SUPPORTED_MOTORS];
+    uint8_t motorCount;
+    bool hasInactiveMotors;     // some motors have throttle <= 0 and are stopped or only spun in transition mixing
+} mixerMatrix_t;
+
+/*
+ * Inverse of the thrust curve thrust = (1 - k) * u + k * u^2 over normalised motor output u
+ */
+typedef struct thrustLinearization_s {
+    bool enabled;
+    float reciprocal;           // 1 / k
+    float offset;               // (1 - k) / (2 * k)
+} thrustLinearization_t;
+
+void mixerMatrixInit(mixerMatrix_t *matrix, const motorMixer_t *mixers, uint8_t motorCount, float rpyScale, float yawScale);
+void mixerMatrixApplyRpy(const mixerMatrix_t *matrix, const float input[XYZ_AXIS_COUNT], float rpyMix[MAX_SUPPORTED_MOTORS], float *rpyMixMin, float *rpyMixMax);
+void mixerMatrixScale(const mixerMatrix_t *matrix, float mix[MAX_SUPPORTED_MOTORS], float scale);
+
+void thrustLinearizationInit(thrustLinearization_t *linearization, float factor);
+float thrustLinearizationApply(const thrustLinearization_t *linearization, float output);
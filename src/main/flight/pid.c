@@ -106,7 +106,10 @@ typedef struct {
 
     pt3Filter_t rateTargetFilter;
 
+#ifdef USE_SMITH_PREDICTOR
     smithPredictor_t smithPredictor;
+    smithDelayEstimator_t smithDelayEstimator;
+#endif
 } pidState_t;
 
 STATIC_FASTRAM bool pidFiltersConfigured = false;
@@ -115,8 +118,42 @@ static EXTENDED_FASTRAM int16_t headingHoldTarget;
 static EXTENDED_FASTRAM pt1Filter_t headingHoldRateFilter;
 static EXTENDED_FASTRAM pt1Filter_t fixedWingTpaFilter;
 
+// Axes whose gains have to be recomputed from the PID bank, one bit per flight dynamics axis
+#define PID_GAINS_UPDATE_ALL_AXES   ((1 << XYZ_AXIS_COUNT) - 1)
+STATIC_FASTRAM uint8_t pidGainsUpdateAxes;
+
+#ifdef USE_SMITH_PREDICTOR
+static EXTENDED_FASTRAM bool smithDelayEstimatorEnabled;
+static EXTENDED_FASTRAM uint8_t smithDelayEstimatorAxis;
+#endif
+
+STATIC_UNIT_TESTED EXTENDED_FASTRAM pidBaseGains_t pidBaseGains[XYZ_AXIS_COUNT];
+
 // Thrust PID Attenuation factor. 0.0f means fully attenuated, 1.0f no attenuation is applied
-STATIC_FASTRAM bool pidGainsUpdateRequired;
+STATIC_UNIT_TESTED EXTENDED_FASTRAM float pidAppliedTPAFactor[XYZ_AXIS_COUNT];
+
+/*
+ * TPA curve sampled between the throttle where it starts to change and the top of its range,
+ * rebuilt when any of its inputs change. The curve is flat outside, so its corners are table nodes.
+ * The multirotor curve is linear in between and is reproduced exactly. The fixed wing hyperbola is
+ * approximated, the error is largest at the low end: below 0.005 with tpa_breakpoint 300us above
+ * idle throttle, 0.03 with 100us at full tpa_rate
+ */
+#define TPA_TABLE_SIZE  65
+
+typedef struct tpaTable_s {
+    float factor[TPA_TABLE_SIZE];
+    float start;
+    float step;
+    bool valid;
+    pidType_e controllerType;
+    uint8_t rate;
+    uint16_t breakpoint;
+    uint16_t throttleIdle;
+    uint16_t maxThrottle;
+} tpaTable_t;
+
+static EXTENDED_FASTRAM tpaTable_t tpaTable;
 FASTRAM int16_t axisPID[FLIGHT_DYNAMICS_INDEX_COUNT];
 
 #ifdef USE_BLACKBOX
@@ -153,7 +190,7 @@ static EXTENDED_FASTRAM float antiWindupScaler;
 #ifdef USE_ANTIGRAVITY
 static EXTENDED_FASTRAM float iTermAntigravityGain;
 #endif
-static EXTENDED_FASTRAM uint8_t usedPidControllerType;
+STATIC_UNIT_TESTED EXTENDED_FASTRAM uint8_t usedPidControllerType;
 
 typedef void (*pidControllerFnPtr)(pidState_t *pidState, flight_dynamics_index_t axis, float dT, float dT_inv);
 static EXTENDED_FASTRAM pidControllerFnPtr pidControllerApplyFn;
@@ -162,6 +199,9 @@ static EXTENDED_FASTRAM bool levelingEnabled = false;
 static EXTENDED_FASTRAM bool restartAngleHoldMode = true;
 static EXTENDED_FASTRAM bool angleHoldIsLevel = false;
 
+// Hand-off from the outer (setpoint) loop to the inner (rate) loop
+static EXTENDED_FASTRAM float outerLoopRateTarget[XYZ_AXIS_COUNT];
+
 #define FIXED_WING_LEVEL_TRIM_MAX_ANGLE 10.0f // Max angle auto trimming can demand
 #define FIXED_WING_LEVEL_TRIM_DIVIDER 50.0f
 #define FIXED_WING_LEVEL_TRIM_MULTIPLIER 1.0f / FIXED_WING_LEVEL_TRIM_DIVIDER
@@ -170,7 +210,7 @@ static EXTENDED_FASTRAM bool angleHoldIsLevel = false;
 static EXTENDED_FASTRAM float fixedWingLevelTrim;
 static EXTENDED_FASTRAM pidController_t fixedWingLevelTrimController;
 
-PG_REGISTER_PROFILE_WITH_RESET_TEMPLATE(pidProfile_t, pidProfile, PG_PID_PROFILE, 6);
+PG_REGISTER_PROFILE_WITH_RESET_TEMPLATE(pidProfile_t, pidProfile, PG_PID_PROFILE, 7);
 
 PG_RESET_TEMPLATE(pidProfile_t, pidProfile,
         .bank_mc = {
@@ -305,6 +345,7 @@ PG_RESET_TEMPLATE(pidProfile_t, pidProfile,
         .smithPredictorStrength = SETTING_SMITH_PREDICTOR_STRENGTH_DEFAULT,
         .smithPredictorDelay = SETTING_SMITH_PREDICTOR_DELAY_DEFAULT,
         .smithPredictorFilterHz = SETTING_SMITH_PREDICTOR_LPF_HZ_DEFAULT,
+        .smithPredictorAutoDelay = SETTING_SMITH_PREDICTOR_AUTO_DELAY_DEFAULT,
 #endif
 );
 
@@ -341,27 +382,19 @@ bool pidInitFilters(void)
     }
 
 #ifdef USE_SMITH_PREDICTOR
-    smithPredictorInit(
-        &pidState[FD_ROLL].smithPredictor,
-        pidProfile()->smithPredictorDelay,
-        pidProfile()->smithPredictorStrength,
-        pidProfile()->smithPredictorFilterHz,
-        getLooptime()
-    );
-    smithPredictorInit(
-        &pidState[FD_PITCH].smithPredictor,
-        pidProfile()->smithPredictorDelay,
-        pidProfile()->smithPredictorStrength,
-        pidProfile()->smithPredictorFilterHz,
-        getLooptime()
-    );
-    smithPredictorInit(
-        &pidState[FD_YAW].smithPredictor,
-        pidProfile()->smithPredictorDelay,
-        pidProfile()->smithPredictorStrength,
-        pidProfile()->smithPredictorFilterHz,
-        getLooptime()
-    );
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        smithPredictorInit(
+            &pidState[axis].smithPredictor,
+            pidProfile()->smithPredictorDelay,
+            pidProfile()->smithPredictorStrength,
+            pidProfile()->smithPredictorFilterHz,
+            getLooptime()
+        );
+        smithDelayEstimatorInit(&pidState[axis].smithDelayEstimator, SETTING_SMITH_PREDICTOR_DELAY_MAX, getLooptime());
+    }
+    // Auto delay only tunes a predictor enabled by smith_predictor_delay, it never turns one on
+    smithDelayEstimatorEnabled = pidProfile()->smithPredictorAutoDelay && pidState[FD_ROLL].smithPredictor.enabled;
+    smithDelayEstimatorAxis = 0;
 #endif
 
     pidFiltersConfigured = true;
@@ -431,71 +464,184 @@ float pidRcCommandToRate(int16_t stick, uint8_t rate)
     return scaleRangef((float) stick, -500.0f, 500.0f, -maxRateDPS, maxRateDPS);
 }
 
-static float calculateFixedWingTPAFactor(uint16_t throttle)
+static float fixedWingTPACurve(float throttle)
 {
     float tpaFactor;
 
     // tpa_rate is amount of curve TPA applied to PIDs
     // tpa_breakpoint for fixed wing is cruise throttle value (value at which PIDs were tuned)
-    if (currentControlRateProfile->throttle.dynPID != 0 && currentControlRateProfile->throttle.pa_breakpoint > getThrottleIdleValue() && !FLIGHT_MODE(AUTO_TUNE) && ARMING_FLAG(ARMED)) {
-        if (throttle > getThrottleIdleValue()) {
-            // Calculate TPA according to throttle
-            tpaFactor = 0.5f + ((float)(currentControlRateProfile->throttle.pa_breakpoint - getThrottleIdleValue()) / (throttle - getThrottleIdleValue()) / 2.0f);
+    if (throttle > getThrottleIdleValue()) {
+        // Calculate TPA according to throttle
+        tpaFactor = 0.5f + ((float)(currentControlRateProfile->throttle.pa_breakpoint - getThrottleIdleValue()) / (throttle - getThrottleIdleValue()) / 2.0f);
 
-            // Limit to [0.5; 2] range
-            tpaFactor = constrainf(tpaFactor, 0.5f, 2.0f);
-        }
-        else {
-            tpaFactor = 2.0f;
-        }
-
-        // Attenuate TPA curve according to configured amount
-        tpaFactor = 1.0f + (tpaFactor - 1.0f) * (currentControlRateProfile->throttle.dynPID / 100.0f);
+        // Limit to [0.5; 2] range
+        tpaFactor = constrainf(tpaFactor, 0.5f, 2.0f);
     }
     else {
-        tpaFactor = 1.0f;
+        tpaFactor = 2.0f;
     }
 
-    return tpaFactor;
+    // Attenuate TPA curve according to configured amount
+    return 1.0f + (tpaFactor - 1.0f) * (currentControlRateProfile->throttle.dynPID / 100.0f);
 }
 
-static float calculateMultirotorTPAFactor(void)
+static float multirotorTPACurve(float throttle)
 {
-    float tpaFactor;
+    if (throttle < currentControlRateProfile->throttle.pa_breakpoint) {
+        return 1.0f;
+    } else if (throttle < motorConfig()->maxthrottle) {
+        return (100 - (uint16_t)currentControlRateProfile->throttle.dynPID * (throttle - currentControlRateProfile->throttle.pa_breakpoint) / (float)(motorConfig()->maxthrottle - currentControlRateProfile->throttle.pa_breakpoint)) / 100.0f;
+    } else {
+        return (100 - currentControlRateProfile->throttle.dynPID) / 100.0f;
+    }
+}
 
-    // TPA should be updated only when TPA is actually set
-    if (currentControlRateProfile->throttle.dynPID == 0 || rcCommand[THROTTLE] < currentControlRateProfile->throttle.pa_breakpoint) {
-        tpaFactor = 1.0f;
-    } else if (rcCommand[THROTTLE] < motorConfig()->maxthrottle) {
-        tpaFactor = (100 - (uint16_t)currentControlRateProfile->throttle.dynPID * (rcCommand[THROTTLE] - currentControlRateProfile->throttle.pa_breakpoint) / (float)(motorConfig()->maxthrottle - currentControlRateProfile->throttle.pa_breakpoint)) / 100.0f;
+/*
+ * Rebuilds the TPA table when the controller type, TPA settings or throttle range changed.
+ * Returns true if the table was rebuilt
+ */
+static bool updateTPATable(void)
+{
+    const uint16_t throttleIdle = getThrottleIdleValue();
+
+    if (tpaTable.valid &&
+        tpaTable.controllerType == usedPidControllerType &&
+        tpaTable.rate == currentControlRateProfile->throttle.dynPID &&
+        tpaTable.breakpoint == currentControlRateProfile->throttle.pa_breakpoint &&
+        tpaTable.throttleIdle == throttleIdle &&
+        tpaTable.maxThrottle == motorConfig()->maxthrottle) {
+        return false;
+    }
+
+    tpaTable.valid = true;
+    tpaTable.controllerType = usedPidControllerType;
+    tpaTable.rate = currentControlRateProfile->throttle.dynPID;
+    tpaTable.breakpoint = currentControlRateProfile->throttle.pa_breakpoint;
+    tpaTable.throttleIdle = throttleIdle;
+    tpaTable.maxThrottle = motorConfig()->maxthrottle;
+
+    float end;
+    if (usedPidControllerType == PID_TYPE_PIFF) {
+        // Below this throttle the hyperbola is limited to 2
+        tpaTable.start = throttleIdle + MAX(tpaTable.breakpoint - throttleIdle, 0) / 3.0f;
+        end = PWM_RANGE_MAX;
     } else {
-        tpaFactor = (100 - currentControlRateProfile->throttle.dynPID) / 100.0f;
+        tpaTable.start = tpaTable.breakpoint;
+        end = tpaTable.maxThrottle;
+    }
+    tpaTable.step = MAX(end - tpaTable.start, 1.0f) / (TPA_TABLE_SIZE - 1);
+
+    for (int i = 0; i < TPA_TABLE_SIZE; i++) {
+        const float throttle = tpaTable.start + i * tpaTable.step;
+        tpaTable.factor[i] = usedPidControllerType == PID_TYPE_PIFF ? fixedWingTPACurve(throttle) : multirotorTPACurve(throttle);
+    }
+
+    return true;
+}
+
+static float lookupTPAFactor(uint16_t throttle)
+{
+    const float position = constrainf((throttle - tpaTable.start) / tpaTable.step, 0.0f, TPA_TABLE_SIZE - 1);
+    const int index = MIN((int)position, TPA_TABLE_SIZE - 2);
+    const float fraction = position - index;
+
+    return tpaTable.factor[index] + (tpaTable.factor[index + 1] - tpaTable.factor[index]) * fraction;
+}
+
+static float calculateFixedWingTPAFactor(uint16_t throttle)
+{
+    if (currentControlRateProfile->throttle.dynPID != 0 && currentControlRateProfile->throttle.pa_breakpoint > getThrottleIdleValue() && !FLIGHT_MODE(AUTO_TUNE) && ARMING_FLAG(ARMED)) {
+        return lookupTPAFactor(throttle);
+    }
+
+    return 1.0f;
+}
+
+static float calculateMultirotorTPAFactor(uint16_t throttle)
+{
+    // TPA should be updated only when TPA is actually set
+    if (currentControlRateProfile->throttle.dynPID == 0 || throttle < currentControlRateProfile->throttle.pa_breakpoint) {
+        return 1.0f;
     }
 
-    return tpaFactor;
+    return lookupTPAFactor(throttle);
 }
 
 void schedulePidGainsUpdate(void)
 {
-    pidGainsUpdateRequired = true;
+    pidGainsUpdateAxes = PID_GAINS_UPDATE_ALL_AXES;
+}
+
+void schedulePidAxisGainsUpdate(flight_dynamics_index_t axis)
+{
+    pidGainsUpdateAxes |= 1 << axis;
+}
+
+static void pidUpdateBaseGains(flight_dynamics_index_t axis)
+{
+    pidBaseGains[axis].P = pidBank()->pid[axis].P / FP_PID_RATE_P_MULTIPLIER;
+    pidBaseGains[axis].I = pidBank()->pid[axis].I / FP_PID_RATE_I_MULTIPLIER;
+    pidBaseGains[axis].D = pidBank()->pid[axis].D / FP_PID_RATE_D_MULTIPLIER;
+
+    if (usedPidControllerType == PID_TYPE_PIFF) {
+        pidBaseGains[axis].FF = pidBank()->pid[axis].FF / FP_PID_RATE_FF_MULTIPLIER;
+    } else {
+        pidBaseGains[axis].FF = (pidBank()->pid[axis].FF / FP_PID_RATE_D_FF_MULTIPLIER) / (getLooptime() * 0.000001f);
+    }
+}
+
+static void pidApplyAxisGains(flight_dynamics_index_t axis, float tpaFactor)
+{
+    const pidBaseGains_t *gains = &pidBaseGains[axis];
+
+    if (usedPidControllerType == PID_TYPE_PIFF) {
+        // Airplanes - scale all PIDs according to TPA
+        pidState[axis].kP  = gains->P * tpaFactor;
+        pidState[axis].kI  = gains->I * tpaFactor;
+        pidState[axis].kD  = gains->D * tpaFactor;
+        pidState[axis].kFF = gains->FF * tpaFactor;
+        pidState[axis].kCD = 0.0f;
+        pidState[axis].kT  = 0.0f;
+    }
+    else {
+        pidState[axis].kP  = gains->P * tpaFactor;
+        pidState[axis].kI  = gains->I;
+        pidState[axis].kD  = gains->D * tpaFactor;
+        pidState[axis].kCD = gains->FF * tpaFactor;
+        pidState[axis].kFF = 0.0f;
+
+        // Tracking anti-windup requires P/I/D to be all defined which is only true for MC
+        if ((pidBank()->pid[axis].P != 0) && (pidBank()->pid[axis].I != 0) && (usedPidControllerType == PID_TYPE_PID)) {
+            pidState[axis].kT = 2.0f / ((pidState[axis].kP / pidState[axis].kI) + (pidState[axis].kD / pidState[axis].kP));
+        } else {
+            pidState[axis].kT = 0;
+        }
+    }
+
+    pidAppliedTPAFactor[axis] = tpaFactor;
 }
 
+/*
+ * Gains are recomputed from the PID bank only for axes flagged by schedulePidGainsUpdate() or
+ * schedulePidAxisGainsUpdate(). Throttle changes only rescale the axes whose TPA factor moved
+ */
 void updatePIDCoefficients(void)
 {
     STATIC_FASTRAM uint16_t prevThrottle = 0;
+    bool tpaUpdateRequired = false;
 
     // Check if throttle changed. Different logic for fixed wing vs multirotor
     if (usedPidControllerType == PID_TYPE_PIFF && (currentControlRateProfile->throttle.fixedWingTauMs > 0)) {
         uint16_t filteredThrottle = pt1FilterApply(&fixedWingTpaFilter, rcCommand[THROTTLE]);
         if (filteredThrottle != prevThrottle) {
             prevThrottle = filteredThrottle;
-            pidGainsUpdateRequired = true;
+            tpaUpdateRequired = true;
         }
     }
     else {
         if (rcCommand[THROTTLE] != prevThrottle) {
             prevThrottle = rcCommand[THROTTLE];
-            pidGainsUpdateRequired = true;
+            tpaUpdateRequired = true;
         }
     }
 
@@ -513,43 +659,32 @@ void updatePIDCoefficients(void)
         pidState[axis].stickPosition = constrain(rxGetChannelValue(axis) - PWM_RANGE_MIDDLE, -500, 500) / 500.0f;
     }
 
+    // TPA settings may be changed in flight by adjustments or MSP
+    if (updateTPATable()) {
+        tpaUpdateRequired = true;
+    }
+
     // If nothing changed - don't waste time recalculating coefficients
-    if (!pidGainsUpdateRequired) {
+    if (!pidGainsUpdateAxes && !tpaUpdateRequired) {
         return;
     }
 
-    const float tpaFactor = usedPidControllerType == PID_TYPE_PIFF ? calculateFixedWingTPAFactor(prevThrottle) : calculateMultirotorTPAFactor();
+    const float tpaFactor = usedPidControllerType == PID_TYPE_PIFF ? calculateFixedWingTPAFactor(prevThrottle) : calculateMultirotorTPAFactor(prevThrottle);
 
-    // PID coefficients can be update only with THROTTLE and TPA or inflight PID adjustments
-    //TODO: Next step would be to update those only at THROTTLE or inflight adjustments change
     for (int axis = 0; axis < 3; axis++) {
-        if (usedPidControllerType == PID_TYPE_PIFF) {
-            // Airplanes - scale all PIDs according to TPA
-            pidState[axis].kP  = pidBank()->pid[axis].P / FP_PID_RATE_P_MULTIPLIER  * tpaFactor;
-            pidState[axis].kI  = pidBank()->pid[axis].I / FP_PID_RATE_I_MULTIPLIER  * tpaFactor;
-            pidState[axis].kD  = pidBank()->pid[axis].D / FP_PID_RATE_D_MULTIPLIER * tpaFactor;
-            pidState[axis].kFF = pidBank()->pid[axis].FF / FP_PID_RATE_FF_MULTIPLIER * tpaFactor;
-            pidState[axis].kCD = 0.0f;
-            pidState[axis].kT  = 0.0f;
+        const bool gainsChanged = pidGainsUpdateAxes & (1 << axis);
+        const float axisTPA = (usedPidControllerType != PID_TYPE_PIFF && axis == FD_YAW && (!currentControlRateProfile->throttle.dynPID_on_YAW)) ? 1.0f : tpaFactor;
+
+        if (gainsChanged) {
+            pidUpdateBaseGains(axis);
         }
-        else {
-            const float axisTPA = (axis == FD_YAW && (!currentControlRateProfile->throttle.dynPID_on_YAW)) ? 1.0f : tpaFactor;
-            pidState[axis].kP  = pidBank()->pid[axis].P / FP_PID_RATE_P_MULTIPLIER * axisTPA;
-            pidState[axis].kI  = pidBank()->pid[axis].I / FP_PID_RATE_I_MULTIPLIER;
-            pidState[axis].kD  = pidBank()->pid[axis].D / FP_PID_RATE_D_MULTIPLIER * axisTPA;
-            pidState[axis].kCD = (pidBank()->pid[axis].FF / FP_PID_RATE_D_FF_MULTIPLIER * axisTPA) / (getLooptime() * 0.000001f);
-            pidState[axis].kFF = 0.0f;
-
-            // Tracking anti-windup requires P/I/D to be all defined which is only true for MC
-            if ((pidBank()->pid[axis].P != 0) && (pidBank()->pid[axis].I != 0) && (usedPidControllerType == PID_TYPE_PID)) {
-                pidState[axis].kT = 2.0f / ((pidState[axis].kP / pidState[axis].kI) + (pidState[axis].kD / pidState[axis].kP));
-            } else {
-                pidState[axis].kT = 0;
-            }
+
+        if (gainsChanged || axisTPA != pidAppliedTPAFactor[axis]) {
+            pidApplyAxisGains(axis, axisTPA);
         }
     }
 
-    pidGainsUpdateRequired = false;
+    pidGainsUpdateAxes = 0;
 }
 
 static float calcHorizonRateMagnitude(void)
@@ -1128,10 +1263,13 @@ void updateAngleHold(float *angleTarget, uint8_t axis)
     }
 }
 
-void FAST_CODE pidController(float dT)
+/*
+ * Setpoint part of the PID controller: stick to rate conversion, heading hold, ANGLE/HORIZON
+ * levelling and turn assistance. Result is handed to pidControllerInner() through outerLoopRateTarget.
+ * dT is the period of the outer loop, may be a multiple of the PID loop period
+ */
+void pidControllerOuter(float dT)
 {
-    const float dT_inv = 1.0f / dT;
-
     if (!pidFiltersConfigured) {
         return;
     }
@@ -1150,8 +1288,6 @@ void FAST_CODE pidController(float dT)
     }
 
     for (int axis = 0; axis < 3; axis++) {
-        pidState[axis].gyroRate = gyro.gyroADCf[axis];
-
         // Step 2: Read target
         float rateTarget;
 
@@ -1171,10 +1307,6 @@ void FAST_CODE pidController(float dT)
 #ifdef USE_GYRO_KALMAN
         gyroKalmanUpdateSetpoint(axis, pidState[axis].rateTarget);
 #endif
-
-#ifdef USE_SMITH_PREDICTOR
-        pidState[axis].gyroRate = applySmithPredictor(axis, &pidState[axis].smithPredictor, pidState[axis].gyroRate);
-#endif
     }
 
     // Step 3: Run control for ANGLE_MODE, HORIZON_MODE and ANGLEHOLD_MODE
@@ -1218,10 +1350,57 @@ void FAST_CODE pidController(float dT)
         pidApplyFpvCameraAngleMix(pidState, currentControlRateProfile->misc.fpvCamAngleDegrees);
     }
 
+    for (int axis = 0; axis < 3; axis++) {
+        outerLoopRateTarget[axis] = pidState[axis].rateTarget;
+    }
+}
+
+#ifdef USE_SMITH_PREDICTOR
+/*
+ * Correlation is accumulated for one axis per loop to bound the cost, the
+ * Smith predictor takes the identified delay as soon as it is confident
+ */
+static void updateSmithPredictorDelay(void)
+{
+    pidState_t *state = &pidState[smithDelayEstimatorAxis];
+
+    if (smithDelayEstimatorUpdate(&state->smithDelayEstimator)) {
+        smithPredictorSetDelaySamples(&state->smithPredictor, lrintf(state->smithDelayEstimator.delaySamples));
+    }
+
+    DEBUG_SET(DEBUG_SMITH_PREDICTOR, smithDelayEstimatorAxis, lrintf(state->smithDelayEstimator.delaySamples * getLooptime()));
+
+    smithDelayEstimatorAxis = (smithDelayEstimatorAxis + 1) % XYZ_AXIS_COUNT;
+}
+#endif
+
+/*
+ * Rate part of the PID controller, runs every PID loop on the latest gyro data
+ * and the rate targets of the last pidControllerOuter() run
+ */
+void FAST_CODE pidControllerInner(float dT)
+{
+    const float dT_inv = 1.0f / dT;
+
+    if (!pidFiltersConfigured) {
+        return;
+    }
+
     // Prevent strong Iterm accumulation during stick inputs
     antiWindupScaler = constrainf((1.0f - getMotorMixRange()) * motorItermWindupPoint, 0.0f, 1.0f);
 
     for (int axis = 0; axis < 3; axis++) {
+        pidState[axis].gyroRate = gyro.gyroADCf[axis];
+        pidState[axis].rateTarget = outerLoopRateTarget[axis];
+
+#ifdef USE_SMITH_PREDICTOR
+        if (smithDelayEstimatorEnabled) {
+            // axisPID still holds the output of the previous loop
+            smithDelayEstimatorPush(&pidState[axis].smithDelayEstimator, axisPID[axis], pidState[axis].gyroRate);
+        }
+        pidState[axis].gyroRate = applySmithPredictor(axis, &pidState[axis].smithPredictor, pidState[axis].gyroRate);
+#endif
+
         // Apply setpoint rate of change limits
         pidApplySetpointRateLimiting(&pidState[axis], axis, dT);
 
@@ -1231,6 +1410,12 @@ void FAST_CODE pidController(float dT)
 
         pidControllerApplyFn(&pidState[axis], axis, dT, dT_inv);
     }
+
+#ifdef USE_SMITH_PREDICTOR
+    if (smithDelayEstimatorEnabled && ARMING_FLAG(ARMED)) {
+        updateSmithPredictorDelay();
+    }
+#endif
 }
 
 pidType_e pidIndexGetType(pidIndex_e pidIndex)
@@ -1256,7 +1441,9 @@ void pidInit(void)
     headingHoldCosZLimit = cos_approx(DECIDEGREES_TO_RADIANS(pidProfile()->max_angle_inclination[FD_ROLL])) *
                            cos_approx(DECIDEGREES_TO_RADIANS(pidProfile()->max_angle_inclination[FD_PITCH]));
 
-    pidGainsUpdateRequired = false;
+    // Profile or controller may have changed, recompute everything on the next update
+    pidGainsUpdateAxes = PID_GAINS_UPDATE_ALL_AXES;
+    tpaTable.valid = false;
 
     itermRelax = pidProfile()->iterm_relax;
 
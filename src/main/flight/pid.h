@@ -90,6 +90,14 @@ typedef struct pidBank_s {
     pid8_t  pid[PID_ITEM_COUNT];
 } pidBank_t;
 
+// PID bank gains scaled to controller units, without TPA
+typedef struct pidBaseGains_s {
+    float P;
+    float I;
+    float D;
+    float FF;
+} pidBaseGains_t;
+
 typedef enum {
     ITERM_RELAX_OFF = 0,
     ITERM_RELAX_RP,
@@ -155,6 +163,7 @@ typedef struct pidProfile_s {
     float smithPredictorStrength;
     float smithPredictorDelay;
     uint16_t smithPredictorFilterHz;
+    uint8_t smithPredictorAutoDelay;
 #endif
 } pidProfile_t;
 
@@ -196,8 +205,10 @@ struct motorConfig_s;
 struct rxConfig_s;
 
 void schedulePidGainsUpdate(void);
+void schedulePidAxisGainsUpdate(flight_dynamics_index_t axis);
 void updatePIDCoefficients(void);
-void pidController(float dT);
+void pidControllerOuter(float dT);
+void pidControllerInner(float dT);
 
 float pidRateToRcCommand(float rateDPS, uint8_t rate);
 int16_t pidAngleToRcCommand(float angleDeciDegrees, int16_t maxInclination);
@@ -34,11 +34,13 @@
 #include "common/axis.h"
 #include "common/utils.h"
 #include "common/maths.h"
+#include "common/biquad_bank.h"
 #include "common/filter.h"
 #include "flight/mixer.h"
 #include "sensors/esc_sensor.h"
 #include "fc/config.h"
 #include "fc/settings.h"
+#include "sensors/gyro.h"
 
 #ifdef USE_RPM_FILTER
 
@@ -60,10 +62,15 @@ typedef struct
     float minHz;
     float maxHz;
     uint8_t harmonics;
-    biquadFilter_t filters[XYZ_AXIS_COUNT][MAX_SUPPORTED_MOTORS][RPM_FILTER_HARMONICS];
+    float hysteresisHz;
+    float appliedFrequency[MAX_SUPPORTED_MOTORS][RPM_FILTER_HARMONICS];
+    // One stage per motor and harmonic, stage index is motor * harmonics + harmonicIndex
+    biquadBank_t filters;
 } rpmFilterBank_t;
 
-typedef float (*rpmFilterApplyFnPtr)(rpmFilterBank_t *filter, uint8_t axis, float input);
+STATIC_ASSERT(MAX_SUPPORTED_MOTORS * RPM_FILTER_HARMONICS <= BIQUAD_BANK_MAX_STAGES, rpm_filter_bank_too_small);
+
+typedef void (*rpmFilterApplyFnPtr)(rpmFilterBank_t *filter, float input[XYZ_AXIS_COUNT]);
 typedef void (*rpmFilterUpdateFnPtr)(rpmFilterBank_t *filterBank, uint8_t motor, float baseFrequency);
 
 static EXTENDED_FASTRAM pt1Filter_t motorFrequencyFilter[MAX_SUPPORTED_MOTORS];
@@ -71,11 +78,10 @@ static EXTENDED_FASTRAM rpmFilterBank_t gyroRpmFilters;
 static EXTENDED_FASTRAM rpmFilterApplyFnPtr rpmGyroApplyFn;
 static EXTENDED_FASTRAM rpmFilterUpdateFnPtr rpmGyroUpdateFn;
 
-float nullRpmFilterApply(rpmFilterBank_t *filter, uint8_t axis, float input)
+void nullRpmFilterApply(rpmFilterBank_t *filter, float input[XYZ_AXIS_COUNT])
 {
     UNUSED(filter);
-    UNUSED(axis);
-    return input;
+    UNUSED(input);
 }
 
 void nullRpmFilterUpdate(rpmFilterBank_t *filterBank, uint8_t motor, float baseFrequency) {
@@ -84,22 +90,9 @@ void nullRpmFilterUpdate(rpmFilterBank_t *filterBank, uint8_t motor, float baseF
     UNUSED(baseFrequency);
 }
 
-float rpmFilterApply(rpmFilterBank_t *filterBank, uint8_t axis, float input)
+void rpmFilterApply(rpmFilterBank_t *filterBank, float input[XYZ_AXIS_COUNT])
 {
-    float output = input;
-
-    for (uint8_t motor = 0; motor < getMotorCount(); motor++)
-    {
-        for (int harmonicIndex = 0; harmonicIndex < filterBank->harmonics; harmonicIndex++)
-        {
-            output = biquadFilterApplyDF1(
-                &filterBank->filters[axis][motor][harmonicIndex],
-                output
-            );
-        }
-    }
-
-    return output;
+    biquadBankApply(&filterBank->filters, input);
 }
 
 static void rpmFilterInit(rpmFilterBank_t *filter, uint16_t q, uint8_t minHz, uint8_t harmonics)
@@ -111,25 +104,27 @@ static void rpmFilterInit(rpmFilterBank_t *filter, uint16_t q, uint8_t minHz, ui
      * Max frequency has to be lower than Nyquist frequency for looptime
      */
     filter->maxHz = 0.48f * 1000000.0f / getLooptime();
+    filter->hysteresisHz = gyroConfig()->notchUpdateHysteresis / 10.0f;
 
-    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++)
+    biquadBankInit(&filter->filters);
+
+    for (int motor = 0; motor < getMotorCount(); motor++)
     {
-        for (int motor = 0; motor < getMotorCount(); motor++)
+        /*
+         * Harmonics are indexed from 1 where 1 means base frequency
+         * C indexes arrays from 0, so we need to shift
+         */
+        for (int harmonicIndex = 0; harmonicIndex < harmonics; harmonicIndex++)
         {
-
-            /*
-             * Harmonics are indexed from 1 where 1 means base frequency
-             * C indexes arrays from 0, so we need to shift
-             */
-            for (int harmonicIndex = 0; harmonicIndex < harmonics; harmonicIndex++)
-            {
-                biquadFilterInit(
-                    &filter->filters[axis][motor][harmonicIndex],
-                    filter->minHz * (harmonicIndex + 1),
-                    getLooptime(),
-                    filter->q,
-                    FILTER_NOTCH);
-            }
+            biquadFilter_t notch;
+            biquadFilterInit(
+                &notch,
+                filter->minHz * (harmonicIndex + 1),
+                getLooptime(),
+                filter->q,
+                FILTER_NOTCH);
+            biquadBankAddStage(&filter->filters, &notch);
+            filter->appliedFrequency[motor][harmonicIndex] = filter->minHz * (harmonicIndex + 1);
         }
     }
 }
@@ -140,19 +135,24 @@ void disableRpmFilters(void) {
 
 void rpmFilterUpdate(rpmFilterBank_t *filterBank, uint8_t motor, float baseFrequency)
 {
-    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++)
+    /*
+     * All axes share the same notch frequencies, so coefficients are computed once per harmonic,
+     * and only when the frequency moved by more than the hysteresis
+     */
+    for (int harmonicIndex = 0; harmonicIndex < filterBank->harmonics; harmonicIndex++)
     {
-        for (int harmonicIndex = 0; harmonicIndex < filterBank->harmonics; harmonicIndex++)
-        {
-            float harmonicFrequency = baseFrequency * (harmonicIndex + 1);
-            harmonicFrequency = constrainf(harmonicFrequency, filterBank->minHz, filterBank->maxHz);
+        float harmonicFrequency = baseFrequency * (harmonicIndex + 1);
+        harmonicFrequency = constrainf(harmonicFrequency, filterBank->minHz, filterBank->maxHz);
 
-            biquadFilterUpdate(
-                &filterBank->filters[axis][motor][harmonicIndex],
+        biquadFilter_t notch;
+        if (biquadFilterUpdateNotchCached(
+                &notch,
+                &filterBank->appliedFrequency[motor][harmonicIndex],
                 harmonicFrequency,
                 getLooptime(),
                 filterBank->q,
-                FILTER_NOTCH);
+                filterBank->hysteresisHz)) {
+            biquadBankSetCoefficients(&filterBank->filters, motor * filterBank->harmonics + harmonicIndex, &notch);
         }
     }
 }
@@ -195,9 +195,12 @@ void rpmFilterUpdateTask(timeUs_t currentTimeUs)
     }
 }
 
-float rpmFilterGyroApply(uint8_t axis, float input)
+/*
+ * Filters all three gyro axes in place
+ */
+void rpmFilterGyroApply(float gyroADCf[XYZ_AXIS_COUNT])
 {
-    return rpmGyroApplyFn(&gyroRpmFilters, axis, input);
+    rpmGyroApplyFn(&gyroRpmFilters, gyroADCf);
 }
 
 #endif
@@ -25,6 +25,7 @@
 #pragma once
 
 #include "config/parameter_group.h"
+#include "common/axis.h"
 #include "common/time.h"
 
 typedef struct rpmFilterConfig_s {
@@ -49,4 +50,4 @@ PG_DECLARE(rpmFilterConfig_t, rpmFilterConfig);
 void disableRpmFilters(void);
 void rpmFiltersInit(void);
 void rpmFilterUpdateTask(timeUs_t currentTimeUs);
-float rpmFilterGyroApply(uint8_t axis, float input);
\ No newline at end of file
+void rpmFilterGyroApply(float gyroADCf[XYZ_AXIS_COUNT]);
\ No newline at end of file
@@ -28,7 +28,7 @@
  *   returns same unit as horizontalWindSpeed
  */
 static float forwardWindSpeed(float heading, float horizontalWindSpeed, float windHeading) {
-    return horizontalWindSpeed * cos_approx(DEGREES_TO_RADIANS(windHeading - heading));
+    return horizontalWindSpeed * cos_approx_fast(DEGREES_TO_RADIANS(windHeading - heading));
 }
 
 #ifdef USE_WIND_ESTIMATOR
@@ -41,7 +41,7 @@ static float forwardWindSpeed(float heading, float horizontalWindSpeed, float wi
  *   returns degrees
  */
 static float windDriftCompensationAngle(float forwardSpeed, float heading, float horizontalWindSpeed, float windHeading) {
-    return RADIANS_TO_DEGREES(asin_approx(-horizontalWindSpeed * sin_approx(DEGREES_TO_RADIANS(windHeading - heading)) / forwardSpeed));
+    return RADIANS_TO_DEGREES(asin_approx(-horizontalWindSpeed * sin_approx_fast(DEGREES_TO_RADIANS(windHeading - heading)) / forwardSpeed));
 }
 
 /* INPUTS:
@@ -53,7 +53,7 @@ static float windDriftCompensationAngle(float forwardSpeed, float heading, float
  *   returns (same unit as forwardSpeed and horizontalWindSpeed)
  */
 static float windDriftCorrectedForwardSpeed(float forwardSpeed, float heading, float horizontalWindSpeed, float windHeading) {
-    return forwardSpeed * cos_approx(DEGREES_TO_RADIANS(windDriftCompensationAngle(forwardSpeed, heading, horizontalWindSpeed, windHeading)));
+    return forwardSpeed * cos_approx_fast(DEGREES_TO_RADIANS(windDriftCompensationAngle(forwardSpeed, heading, horizontalWindSpeed, windHeading)));
 }
 
 /* INPUTS:
@@ -89,7 +89,7 @@ static float estimatePitchPower(float pitch) {
 // output is in seconds
 static float estimateRTHAltitudeChangeTime(float altitudeChange, float verticalWindSpeed) {
     // Assuming increase in throttle keeps air speed at cruise speed
-    const float estimatedVerticalSpeed = (float)navConfig()->fw.cruise_speed / 100 * sin_approx(DEGREES_TO_RADIANS(RTHInitialAltitudeChangePitchAngle(altitudeChange))) + verticalWindSpeed;
+    const float estimatedVerticalSpeed = (float)navConfig()->fw.cruise_speed / 100 * sin_approx_fast(DEGREES_TO_RADIANS(RTHInitialAltitudeChangePitchAngle(altitudeChange))) + verticalWindSpeed;
     return altitudeChange / estimatedVerticalSpeed;
 }
 
@@ -101,7 +101,7 @@ static float estimateRTHAltitudeChangeTime(float altitudeChange, float verticalW
 // output is in meters
 static float estimateRTHAltitudeChangeGroundDistance(float altitudeChange, float horizontalWindSpeed, float windHeading, float verticalWindSpeed) {
     // Assuming increase in throttle keeps air speed at cruise speed
-    const float estimatedHorizontalSpeed = (float)navConfig()->fw.cruise_speed / 100 * cos_approx(DEGREES_TO_RADIANS(RTHInitialAltitudeChangePitchAngle(altitudeChange))) + forwardWindSpeed(DECIDEGREES_TO_DEGREES((float)attitude.values.yaw), horizontalWindSpeed, windHeading);
+    const float estimatedHorizontalSpeed = (float)navConfig()->fw.cruise_speed / 100 * cos_approx_fast(DEGREES_TO_RADIANS(RTHInitialAltitudeChangePitchAngle(altitudeChange))) + forwardWindSpeed(DECIDEGREES_TO_DEGREES((float)attitude.values.yaw), horizontalWindSpeed, windHeading);
     return estimateRTHAltitudeChangeTime(altitudeChange, verticalWindSpeed) * estimatedHorizontalSpeed;
 }
 
@@ -123,9 +123,9 @@ static float estimateRTHDistanceAndHeadingAfterAltitudeChange(float altitudeChan
     float estimatedAltitudeChangeGroundDistance = estimateRTHAltitudeChangeGroundDistance(altitudeChange, horizontalWindSpeed, windHeading, verticalWindSpeed);
     if (navConfig()->general.flags.rth_climb_first && (altitudeChange > 0)) {
         float headingDiff = DEGREES_TO_RADIANS(DECIDEGREES_TO_DEGREES((float)attitude.values.yaw) - GPS_directionToHome);
-        float triangleAltitude = GPS_distanceToHome * sin_approx(headingDiff);
-        float triangleAltitudeToReturnStart = estimatedAltitudeChangeGroundDistance - GPS_distanceToHome * cos_approx(headingDiff);
-        const float reverseHeadingDiff = RADIANS_TO_DEGREES(atan2_approx(triangleAltitude, triangleAltitudeToReturnStart));
+        float triangleAltitude = GPS_distanceToHome * sin_approx_fast(headingDiff);
+        float triangleAltitudeToReturnStart = estimatedAltitudeChangeGroundDistance - GPS_distanceToHome * cos_approx_fast(headingDiff);
+        const float reverseHeadingDiff = RADIANS_TO_DEGREES(atan2_approx_fast(triangleAltitude, triangleAltitudeToReturnStart));
         *heading = CENTIDEGREES_TO_DEGREES(wrap_36000(DEGREES_TO_CENTIDEGREES(180 + reverseHeadingDiff + DECIDEGREES_TO_DEGREES((float)attitude.values.yaw))));
         return calc_length_pythagorean_2D(triangleAltitude, triangleAltitudeToReturnStart);
     } else {
@@ -139,7 +139,7 @@ static float estimateRTHDistanceAndHeadingAfterAltitudeChange(float altitudeChan
 static float estimateRTHEnergyAfterInitialClimb(float distanceToHome, float speedToHome) {
     const float timeToHome = distanceToHome / speedToHome; // seconds
     const float altitudeChangeDescentToHome = CENTIMETERS_TO_METERS(navConfig()->general.flags.rth_alt_control_mode == NAV_RTH_AT_LEAST_ALT_LINEAR_DESCENT ? MAX(0, getEstimatedActualPosition(Z) - getFinalRTHAltitude()) : 0);
-    const float pitchToHome = MIN(RADIANS_TO_DEGREES(atan2_approx(altitudeChangeDescentToHome, distanceToHome)), navConfig()->fw.max_dive_angle);
+    const float pitchToHome = MIN(RADIANS_TO_DEGREES(atan2_approx_fast(altitudeChangeDescentToHome, distanceToHome)), navConfig()->fw.max_dive_angle);
     return estimatePitchPower(pitchToHome) * timeToHome / 3600;
 }
 
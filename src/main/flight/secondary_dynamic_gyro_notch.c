@@ -38,9 +38,11 @@ void secondaryDynamicGyroNotchFiltersInit(secondaryDynamicGyroNotchState_t *stat
 
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
         state->filtersApplyFn[axis] = nullFilterApply;
+        state->appliedFrequency[axis] = 0.0f;
     }
 
     state->dynNotchQ = gyroConfig()->dynamicGyroNotch3dQ / 100.0f;
+    state->hysteresisHz = gyroConfig()->notchUpdateHysteresis / 10.0f;
     state->enabled = gyroConfig()->dynamicGyroNotchMode != DYNAMIC_NOTCH_MODE_2D;
     state->looptime = getLooptime();
 
@@ -75,9 +77,9 @@ void secondaryDynamicGyroNotchFiltersUpdate(secondaryDynamicGyroNotchState_t *st
          */
         state->frequency[axis] = frequency[0];
 
-        // Filter update happens only if peak was detected 
+        // Filter update happens only if peak was detected and moved far enough from the current notch
         if (frequency[0] > 0.0f) {
-            biquadFilterUpdate(&state->filters[axis], state->frequency[axis], state->looptime, state->dynNotchQ, FILTER_NOTCH);
+            biquadFilterUpdateNotchCached(&state->filters[axis], &state->appliedFrequency[axis], frequency[0], state->looptime, state->dynNotchQ, state->hysteresisHz);
         }
     }
 }
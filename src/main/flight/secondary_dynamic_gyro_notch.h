@@ -30,7 +30,9 @@
 
 typedef struct secondaryDynamicGyroNotchState_s {
     uint16_t frequency[XYZ_AXIS_COUNT];
+    float appliedFrequency[XYZ_AXIS_COUNT];
     float dynNotchQ;
+    float hysteresisHz;
     uint32_t looptime;
     uint8_t enabled;
     
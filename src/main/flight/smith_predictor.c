@@ -29,23 +29,48 @@
 #ifdef USE_SMITH_PREDICTOR
 
 #include <stdbool.h>
+#include <math.h>
+#include <string.h>
 #include "common/axis.h"
+#include "common/maths.h"
 #include "common/utils.h"
 #include "flight/smith_predictor.h"
 #include "build/debug.h"
 
+#define SMITH_DELAY_CORRELATION_GAIN    (1.0f / 256)
+#define SMITH_DELAY_EVALUATE_UPDATES    512
+#define SMITH_DELAY_MIN_PEAK_RATIO      2.0f    // Correlation peak over the mean of all lags
+#define SMITH_DELAY_SMOOTHING           0.25f
+#define SMITH_DELAY_RESPONSE_THRESHOLD  0.1f    // Part of the peak a lag needs to count as response
+#define SMITH_DELAY_MIN_CORRELATION     0.2f    // Normalised correlation of the peak
+
+/*
+ * Gyro noise reaches the PID output through P and D in the same loop. The output change
+ * pushed with a gyro sample holds the noise of the two samples before it, so it correlates
+ * with the change of angular acceleration at lags 0 and 1 whatever the real delay is.
+ * Those lags are left out, the shortest delay that can be identified is 3 loops. A shorter
+ * one leaves little correlation at the remaining lags and gives no estimate.
+ */
+#define SMITH_DELAY_FEEDBACK_LAGS       2
+
 float applySmithPredictor(uint8_t axis, smithPredictor_t *predictor, float sample) {
     UNUSED(axis);
     if (predictor->enabled) {
         predictor->data[predictor->idx] = sample;
 
+        // Ring is sized for the longest delay so the delay can change without a reset
+        int delayedIdx = predictor->idx - predictor->samples;
+        if (delayedIdx < 0) {
+            delayedIdx += MAX_SMITH_SAMPLES + 1;
+        }
+
         predictor->idx++;
-        if (predictor->idx > predictor->samples) {
+        if (predictor->idx > MAX_SMITH_SAMPLES) {
             predictor->idx = 0;
         }
 
         // filter the delayed data to help reduce the overall noise this prediction adds
-        float delayed = pt1FilterApply(&predictor->smithPredictorFilter, predictor->data[predictor->idx]);
+        float delayed = pt1FilterApply(&predictor->smithPredictorFilter, predictor->data[delayedIdx]);
         float delayCompensatedSample = predictor->smithPredictorStrength * (sample - delayed);
 
         sample += delayCompensatedSample;
@@ -54,15 +79,117 @@ float applySmithPredictor(uint8_t axis, smithPredictor_t *predictor, float sampl
 }
 
 void smithPredictorInit(smithPredictor_t *predictor, float delay, float strength, uint16_t filterLpfHz, uint32_t looptime) {
+    predictor->idx = 0;
+    predictor->smithPredictorStrength = strength;
+    pt1FilterInit(&predictor->smithPredictorFilter, filterLpfHz, US2S(looptime));
+
     if (delay > 0.1f) {
+        smithPredictorSetDelaySamples(predictor, (delay * 1000) / looptime);
         predictor->enabled = true;
-        predictor->samples = (delay * 1000) / looptime;
-        predictor->idx = 0;
-        predictor->smithPredictorStrength = strength;
-        pt1FilterInit(&predictor->smithPredictorFilter, filterLpfHz, US2S(looptime));
     } else {
         predictor->enabled = false;
     }
 }
 
+// Changes the delay only, a predictor disabled by a zero delay stays disabled
+void smithPredictorSetDelaySamples(smithPredictor_t *predictor, uint8_t samples) {
+    predictor->samples = constrain(samples, 1, MAX_SMITH_SAMPLES);
+}
+
+void smithDelayEstimatorInit(smithDelayEstimator_t *estimator, float maxDelayMs, uint32_t looptime) {
+    memset(estimator, 0, sizeof(*estimator));
+    estimator->lags = constrain((maxDelayMs * 1000) / looptime, SMITH_DELAY_FEEDBACK_LAGS + 2, SMITH_DELAY_ESTIMATOR_LAGS);
+}
+
+/*
+ * Called every PID loop with the output of the previous loop and the new gyro rate
+ */
+void smithDelayEstimatorPush(smithDelayEstimator_t *estimator, float pidOutput, float gyroRate) {
+    estimator->idx++;
+    if (estimator->idx >= SMITH_DELAY_ESTIMATOR_LAGS) {
+        estimator->idx = 0;
+    }
+
+    // Differencing whitens both signals so the correlation peak is narrow
+    estimator->outputDelta[estimator->idx] = pidOutput - estimator->previousOutput;
+    estimator->previousOutput = pidOutput;
+
+    const float rateDelta = gyroRate - estimator->previousRate;
+    estimator->rateDelta2 = rateDelta - estimator->previousRateDelta;
+    estimator->previousRate = gyroRate;
+    estimator->previousRateDelta = rateDelta;
+}
+
+/*
+ * Accumulates the correlation for the latest sample, does not have to be called every loop.
+ * Returns true when delaySamples got a new value.
+ */
+bool smithDelayEstimatorUpdate(smithDelayEstimator_t *estimator) {
+    for (int lag = SMITH_DELAY_FEEDBACK_LAGS; lag < estimator->lags; lag++) {
+        int idx = estimator->idx - lag;
+        if (idx < 0) {
+            idx += SMITH_DELAY_ESTIMATOR_LAGS;
+        }
+        estimator->correlation[lag] += SMITH_DELAY_CORRELATION_GAIN * (estimator->outputDelta[idx] * estimator->rateDelta2 - estimator->correlation[lag]);
+    }
+
+    estimator->outputDeltaPower += SMITH_DELAY_CORRELATION_GAIN * (sq(estimator->outputDelta[estimator->idx]) - estimator->outputDeltaPower);
+    estimator->rateDelta2Power += SMITH_DELAY_CORRELATION_GAIN * (sq(estimator->rateDelta2) - estimator->rateDelta2Power);
+
+    if (++estimator->updates < SMITH_DELAY_EVALUATE_UPDATES) {
+        return false;
+    }
+    estimator->updates = 0;
+
+    // Sign of the response depends on the axis and mixer, only the magnitude is used
+    int peak = SMITH_DELAY_FEEDBACK_LAGS;
+    float peakValue = 0;
+    float sum = 0;
+    for (int lag = SMITH_DELAY_FEEDBACK_LAGS; lag < estimator->lags; lag++) {
+        const float value = fabsf(estimator->correlation[lag]);
+        sum += value;
+        if (value > peakValue) {
+            peakValue = value;
+            peak = lag;
+        }
+    }
+
+    // Not enough excitation, hovering without stick input or on the ground
+    if (peakValue <= 0.0f || peakValue * (estimator->lags - SMITH_DELAY_FEEDBACK_LAGS) < SMITH_DELAY_MIN_PEAK_RATIO * sum) {
+        return false;
+    }
+
+    // Weak response at every lag left, the delay is shorter than the shortest one that can be identified
+    if (sq(peakValue) < sq(SMITH_DELAY_MIN_CORRELATION) * estimator->outputDeltaPower * estimator->rateDelta2Power) {
+        return false;
+    }
+
+    /*
+     * With both signals whitened the correlation is the impulse response of the rate loop.
+     * Its centroid is the transport delay plus the group delay of the gyro filters, which
+     * is what the Smith predictor has to cover. Lags in the noise floor are left out.
+     */
+    const float sign = estimator->correlation[peak] > 0.0f ? 1.0f : -1.0f;
+    float weightSum = 0;
+    float momentSum = 0;
+    for (int lag = SMITH_DELAY_FEEDBACK_LAGS; lag < estimator->lags; lag++) {
+        const float weight = sign * estimator->correlation[lag];
+        if (weight > SMITH_DELAY_RESPONSE_THRESHOLD * peakValue) {
+            weightSum += weight;
+            momentSum += weight * lag;
+        }
+    }
+    const float lag = momentSum / weightSum;
+
+    // PID output in the ring is one loop older than the gyro sample it is correlated with
+    const float delay = lag + 1;
+    if (estimator->delaySamples > 0.0f) {
+        estimator->delaySamples += SMITH_DELAY_SMOOTHING * (delay - estimator->delaySamples);
+    } else {
+        estimator->delaySamples = delay;
+    }
+
+    return true;
+}
+
 #endif
\ No newline at end of file
@@ -31,6 +31,7 @@
 #include "common/filter.h"
 
 #define MAX_SMITH_SAMPLES 64
+#define SMITH_DELAY_ESTIMATOR_LAGS 32
 
 typedef struct smithPredictor_s {
     bool enabled;
@@ -41,5 +42,30 @@ typedef struct smithPredictor_s {
     float smithPredictorStrength;
 } smithPredictor_t;
 
+/*
+ * Online estimate of the delay between PID output and the filtered gyro response.
+ * Correlates PID output changes with changes of angular acceleration over a range
+ * of lags, the lag of the correlation peak is the actuator plus filter delay.
+ */
+typedef struct smithDelayEstimator_s {
+    float outputDelta[SMITH_DELAY_ESTIMATOR_LAGS];      // Ring of PID output changes, newest at idx
+    float correlation[SMITH_DELAY_ESTIMATOR_LAGS];
+    float previousOutput;
+    float previousRate;
+    float previousRateDelta;
+    float rateDelta2;                                   // Latest change of angular acceleration
+    float outputDeltaPower;                             // Mean squares, to normalise the correlation
+    float rateDelta2Power;
+    float delaySamples;                                 // Smoothed estimate, 0 until identified
+    uint16_t updates;
+    uint8_t idx;
+    uint8_t lags;
+} smithDelayEstimator_t;
+
 float applySmithPredictor(uint8_t axis, smithPredictor_t *predictor, float sample);
-void smithPredictorInit(smithPredictor_t *predictor, float delay, float strength, uint16_t filterLpfHz, uint32_t looptime);
\ No newline at end of file
+void smithPredictorInit(smithPredictor_t *predictor, float delay, float strength, uint16_t filterLpfHz, uint32_t looptime);
+void smithPredictorSetDelaySamples(smithPredictor_t *predictor, uint8_t samples);
+
+void smithDelayEstimatorInit(smithDelayEstimator_t *estimator, float maxDelayMs, uint32_t looptime);
+void smithDelayEstimatorPush(smithDelayEstimator_t *estimator, float pidOutput, float gyroRate);
+bool smithDelayEstimatorUpdate(smithDelayEstimator_t *estimator);
\ No newline at end of file
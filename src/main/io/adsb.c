@@ -122,12 +122,12 @@ adsbVehicleStatus_t* getAdsbStatus(void){
 }
 
 void gpsDistanceCmBearing(int32_t currentLat1, int32_t currentLon1, int32_t destinationLat2, int32_t destinationLon2, uint32_t *dist, int32_t *bearing) {
-    float GPS_scaleLonDown = cos_approx((fabsf((float) gpsSol.llh.lat) / 10000000.0f) * 0.0174532925f);
+    float GPS_scaleLonDown = cos_approx_fast((fabsf((float) gpsSol.llh.lat) / 10000000.0f) * 0.0174532925f);
     const float dLat = destinationLat2 - currentLat1; // difference of latitude in 1/10 000 000 degrees
     const float dLon = (float) (destinationLon2 - currentLon1) * GPS_scaleLonDown;
 
     *dist = sqrtf(sq(dLat) + sq(dLon)) * DISTANCE_BETWEEN_TWO_LONGITUDE_POINTS_AT_EQUATOR;
-    *bearing = 9000.0f + RADIANS_TO_CENTIDEGREES(atan2_approx(-dLat, dLon));      // Convert the output radians to 100xdeg
+    *bearing = 9000.0f + RADIANS_TO_CENTIDEGREES(atan2_approx_fast(-dLat, dLon));      // Convert the output radians to 100xdeg
     *bearing = wrap_36000(*bearing);
 };
 
@@ -1375,8 +1375,8 @@ static void osdDrawMap(int referenceHeading, uint16_t referenceSym, uint16_t cen
 
         int directionToPoi = osdGetHeadingAngle(poiDirection - referenceHeading);
         float poiAngle = DEGREES_TO_RADIANS(directionToPoi);
-        float poiSin = sin_approx(poiAngle);
-        float poiCos = cos_approx(poiAngle);
+        float poiSin = sin_approx_fast(poiAngle);
+        float poiCos = cos_approx_fast(poiAngle);
 
         // Now start looking for a valid scale that lets us draw everything
         int ii;
@@ -267,8 +267,8 @@ static void osdDrawArtificialHorizonShapes(displayCanvas_t *canvas, float pitchA
     displayCanvasCtmScale(canvas, 0.5f, 0.5f);
 
     // Draw line labels
-    float sx = sin_approx(rollAngle);
-    float sy = cos_approx(-rollAngle);
+    float sx = sin_approx_fast(rollAngle);
+    float sy = cos_approx_fast(-rollAngle);
     for (int ii = pitchCenter - 2; ii <= pitchCenter + 2; ii++) {
         if (ii == 0) {
             continue;
@@ -144,18 +144,18 @@ void osdHudDrawPoi(uint32_t poiDistance, int16_t poiDirection, int32_t poiAltitu
     int16_t error_x = hudWrap180(poiDirection - DECIDEGREES_TO_DEGREES(osdGetHeading()));
 
     if ((error_x > -(osdConfig()->camera_fov_h / 2)) && (error_x < osdConfig()->camera_fov_h / 2)) { // POI might be in sight, extra geometry needed
-        float scaled_x = sin_approx(DEGREES_TO_RADIANS(error_x)) / sin_approx(DEGREES_TO_RADIANS(osdConfig()->camera_fov_h / 2));
+        float scaled_x = sin_approx_fast(DEGREES_TO_RADIANS(error_x)) / sin_approx_fast(DEGREES_TO_RADIANS(osdConfig()->camera_fov_h / 2));
         poi_x = center_x + 15 * scaled_x;
 
         if (poi_x < minX || poi_x > maxX ) { // In camera view, but out of the hud area
             poi_is_oos = 1;
         } else { // POI is on sight, compute the vertical
-            float poi_angle = atan2_approx(-poiAltitude, poiDistance);
+            float poi_angle = atan2_approx_fast(-poiAltitude, poiDistance);
             poi_angle = RADIANS_TO_DEGREES(poi_angle);
             int16_t plane_angle = attitude.values.pitch / 10;
             int camera_angle = osdConfig()->camera_uptilt;
             int16_t error_y = poi_angle - plane_angle + camera_angle;
-            float scaled_y = sin_approx(DEGREES_TO_RADIANS(error_y)) / sin_approx(DEGREES_TO_RADIANS(osdConfig()->camera_fov_v / 2));
+            float scaled_y = sin_approx_fast(DEGREES_TO_RADIANS(error_y)) / sin_approx_fast(DEGREES_TO_RADIANS(osdConfig()->camera_fov_v / 2));
             poi_y = constrain(center_y + (osdGetDisplayPort()->rows / 2) * scaled_y, minY, maxY - 1);
         }
     } else {
@@ -380,7 +380,7 @@ void osdHudDrawHoming(uint8_t px, uint8_t py)
         int32_t crh_altitude = osdGetAltitude() / 100;
         int32_t crh_distance = GPS_distanceToHome;
 
-        float crh_home_angle = atan2_approx(crh_altitude, crh_distance);
+        float crh_home_angle = atan2_approx_fast(crh_altitude, crh_distance);
         crh_home_angle = RADIANS_TO_DEGREES(crh_home_angle);
         int crh_plane_angle = attitude.values.pitch / 10;
         int crh_camera_angle = osdConfig()->camera_uptilt;
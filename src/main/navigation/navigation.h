@@ -160,6 +160,11 @@ typedef enum {
     NAV_RESET_ON_EACH_ARM,
 } nav_reset_type_e;
 
+typedef enum {
+    NAV_ESTIMATOR_COMPLEMENTARY = 0,
+    NAV_ESTIMATOR_EKF,
+} navPosEstimatorType_e;
+
 typedef enum {
     NAV_RTH_ALLOW_LANDING_NEVER = 0,
     NAV_RTH_ALLOW_LANDING_ALWAYS = 1,
@@ -260,11 +265,21 @@ typedef struct positionEstimationConfig_s {
     float max_eph_epv;  // Max estimated position error acceptable for estimation (cm)
     float baro_epv;     // Baro position error
 
+    uint16_t gps_delay_ms;  // Age of a GPS fix when it is received
+    uint16_t baro_delay_ms; // Baro sample delay
+
     uint8_t use_gps_no_baro;
 
 #ifdef USE_GPS_FIX_ESTIMATION
     uint8_t allow_gps_fix_estimation;
-#endif    
+#endif
+
+#ifdef USE_NAV_EKF
+    uint8_t estimator_type;     // navPosEstimatorType_e
+    uint8_t ekf_innov_gate;     // Innovation gate (standard deviations), 0 to disable
+    uint16_t ekf_acc_noise;     // Accelerometer noise (cm/s/s)
+    uint16_t ekf_gps_vel_noise; // GPS velocity noise (cm/s)
+#endif
 } positionEstimationConfig_t;
 
 PG_DECLARE(positionEstimationConfig_t, positionEstimationConfig);
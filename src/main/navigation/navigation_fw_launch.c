@@ -261,7 +261,7 @@ static bool hasIdleWakeWiggleSucceeded(timeUs_t currentTimeUs) {
     static timeMs_t wigglesTime = 0;
     static int8_t   wiggleStageOne = 0;
     static uint8_t  wiggleCount = 0;  
-    const bool      isAircraftWithinLaunchAngle = (calculateCosTiltAngle() >= cos_approx(DEGREES_TO_RADIANS(navConfig()->fw.launch_max_angle)));
+    const bool      isAircraftWithinLaunchAngle = (calculateCosTiltAngle() >= cos_approx_fast(DEGREES_TO_RADIANS(navConfig()->fw.launch_max_angle)));
     const uint8_t   wiggleStrength = (navConfig()->fw.launch_wiggle_wake_idle == 1) ? 50 : 40;
     int8_t wiggleDirection = 0;
     int16_t yawRate = (int16_t)(gyroRateDps(YAW) * (4 / 16.4));
@@ -419,7 +419,7 @@ static fixedWingLaunchEvent_t fwLaunchState_FW_LAUNCH_STATE_WAIT_DETECTION(timeU
 
     const float swingVelocity = (fabsf(imuMeasuredRotationBF.z) > SWING_LAUNCH_MIN_ROTATION_RATE) ? (imuMeasuredAccelBF.y / imuMeasuredRotationBF.z) : 0;
     const bool isForwardAccelerationHigh = (imuMeasuredAccelBF.x > navConfig()->fw.launch_accel_thresh);
-    const bool isAircraftAlmostLevel = (calculateCosTiltAngle() >= cos_approx(DEGREES_TO_RADIANS(navConfig()->fw.launch_max_angle)));
+    const bool isAircraftAlmostLevel = (calculateCosTiltAngle() >= cos_approx_fast(DEGREES_TO_RADIANS(navConfig()->fw.launch_max_angle)));
 
     const bool isBungeeLaunched = isForwardAccelerationHigh && isAircraftAlmostLevel;
     const bool isSwingLaunched = (swingVelocity > navConfig()->fw.launch_velocity_thresh) && (imuMeasuredAccelBF.x > 0);
@@ -112,7 +112,7 @@ void geoSetOrigin(gpsOrigin_t *origin, const gpsLocation_t *llh, geoOriginResetM
         origin->lat = llh->lat;
         origin->lon = llh->lon;
         origin->alt = llh->alt;
-        origin->scale = constrainf(cos_approx((ABS(origin->lat) / 10000000.0f) * 0.0174532925f), 0.01f, 1.0f);
+        origin->scale = constrainf(cos_approx_fast((ABS(origin->lat) / 10000000.0f) * 0.0174532925f), 0.01f, 1.0f);
     }
     else if (origin->valid && (resetMode == GEO_ORIGIN_RESET_ALTITUDE)) {
         origin->alt = llh->alt;
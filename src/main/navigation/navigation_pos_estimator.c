@@ -56,7 +56,7 @@
 navigationPosEstimator_t posEstimator;
 static float initialBaroAltitudeOffset = 0.0f;
 
-PG_REGISTER_WITH_RESET_TEMPLATE(positionEstimationConfig_t, positionEstimationConfig, PG_POSITION_ESTIMATION_CONFIG, 6);
+PG_REGISTER_WITH_RESET_TEMPLATE(positionEstimationConfig_t, positionEstimationConfig, PG_POSITION_ESTIMATION_CONFIG, 8);
 
 PG_RESET_TEMPLATE(positionEstimationConfig_t, positionEstimationConfig,
         // Inertial position estimator parameters
@@ -90,8 +90,17 @@ PG_RESET_TEMPLATE(positionEstimationConfig_t, positionEstimationConfig,
 
         .max_eph_epv = SETTING_INAV_MAX_EPH_EPV_DEFAULT,
         .baro_epv = SETTING_INAV_BARO_EPV_DEFAULT,
+
+        .gps_delay_ms = SETTING_INAV_GPS_DELAY_DEFAULT,
+        .baro_delay_ms = SETTING_INAV_BARO_DELAY_DEFAULT,
 #ifdef USE_GPS_FIX_ESTIMATION
-        .allow_gps_fix_estimation = SETTING_INAV_ALLOW_GPS_FIX_ESTIMATION_DEFAULT
+        .allow_gps_fix_estimation = SETTING_INAV_ALLOW_GPS_FIX_ESTIMATION_DEFAULT,
+#endif
+#ifdef USE_NAV_EKF
+        .estimator_type = SETTING_INAV_ESTIMATOR_DEFAULT,
+        .ekf_innov_gate = SETTING_INAV_EKF_INNOV_GATE_DEFAULT,
+        .ekf_acc_noise = SETTING_INAV_EKF_ACC_NOISE_DEFAULT,
+        .ekf_gps_vel_noise = SETTING_INAV_EKF_GPS_VEL_NOISE_DEFAULT,
 #endif
 );
 
@@ -256,6 +265,7 @@ void onNewGPSData(void)
 
                 /* Indicate a last valid reading of Pos/Vel */
                 posEstimator.gps.lastUpdateTime = currentTimeUs;
+                posEstimator.gps.measurementTime = currentTimeUs - MS2US(positionEstimationConfig()->gps_delay_ms);
             }
 
             previousLat = gpsSol.llh.lat;
@@ -292,6 +302,7 @@ void updatePositionEstimator_BaroTopic(timeUs_t currentTimeUs)
         posEstimator.baro.alt = newBaroAlt - initialBaroAltitudeOffset;
         posEstimator.baro.epv = positionEstimationConfig()->baro_epv;
         posEstimator.baro.lastUpdateTime = currentTimeUs;
+        posEstimator.baro.measurementTime = currentTimeUs - MS2US(positionEstimationConfig()->baro_delay_ms);
 
         if (baroDtUs <= MS2US(INAV_BARO_TIMEOUT_MS)) {
             posEstimator.baro.alt = pt1FilterApply3(&posEstimator.baro.avgFilter, posEstimator.baro.alt, US2S(baroDtUs));
@@ -456,7 +467,7 @@ static bool navIsAccelerationUsable(void)
     return true;
 }
 
-static bool navIsHeadingUsable(void)
+bool navIsHeadingUsable(void)
 {
     if (sensors(SENSOR_GPS)
 #ifdef USE_GPS_FIX_ESTIMATION
@@ -541,6 +552,51 @@ static void estimationPredict(estimationContext_t * ctx)
     }
 }
 
+/*
+ * Baro altitude to correct the estimate with. During takeoff the air cushion
+ * pushes baro altitude down, the baro ground altitude is used instead then.
+ */
+float estimationGetBaroAltitude(estimationContext_t * ctx, bool * isAirCushionEffectDetected)
+{
+    timeUs_t currentTimeUs = micros();
+
+    if (!ARMING_FLAG(ARMED)) {
+        posEstimator.state.baroGroundAlt = posEstimator.est.pos.z;
+        posEstimator.state.isBaroGroundValid = true;
+        posEstimator.state.baroGroundTimeout = currentTimeUs + 250000;   // 0.25 sec
+    }
+    else {
+        if (posEstimator.est.vel.z > 15) {
+            posEstimator.state.isBaroGroundValid = currentTimeUs > posEstimator.state.baroGroundTimeout ? false: true;
+        }
+        else {
+            posEstimator.state.baroGroundTimeout = currentTimeUs + 250000;   // 0.25 sec
+        }
+    }
+
+    // We might be experiencing air cushion effect during takeoff - use sonar or baro ground altitude to detect it
+    *isAirCushionEffectDetected = ARMING_FLAG(ARMED) &&
+                                    (((ctx->newFlags & EST_SURFACE_VALID) && posEstimator.surface.alt < 20.0f && posEstimator.state.isBaroGroundValid) ||
+                                     ((ctx->newFlags & EST_BARO_VALID) && posEstimator.state.isBaroGroundValid && posEstimator.baro.alt < posEstimator.state.baroGroundAlt));
+
+    return *isAirCushionEffectDetected ? posEstimator.state.baroGroundAlt : posEstimator.baro.alt;
+}
+
+/*
+ * Time a GPS or baro sample is compared with the estimate at. Without a configured delay the sample
+ * is taken as current, its arrival time would already be older than the estimate and pick an
+ * interpolated past state from the history
+ */
+timeUs_t estimationGetGpsMeasurementTime(void)
+{
+    return positionEstimationConfig()->gps_delay_ms ? posEstimator.gps.measurementTime : posEstimator.est.lastUpdateTime;
+}
+
+timeUs_t estimationGetBaroMeasurementTime(void)
+{
+    return positionEstimationConfig()->baro_delay_ms ? posEstimator.baro.measurementTime : posEstimator.est.lastUpdateTime;
+}
+
 static bool estimationCalculateCorrection_Z(estimationContext_t * ctx)
 {
     DEBUG_SET(DEBUG_ALTITUDE, 0, posEstimator.est.pos.z);       // Position estimate
@@ -553,6 +609,8 @@ static bool estimationCalculateCorrection_Z(estimationContext_t * ctx)
     DEBUG_SET(DEBUG_ALTITUDE, 7, accGetClipCount());            // Clip count
 
     bool correctOK = false;
+    fpVector3_t pastPos;
+    fpVector3_t pastVel;
     
     //ignore baro if difference is too big, baro is probably wrong
     const float gpsBaroResidual = ctx->newFlags & EST_GPS_Z_VALID ? fabsf(posEstimator.gps.pos.z - posEstimator.baro.alt) : 0.0f;
@@ -562,52 +620,39 @@ static bool estimationCalculateCorrection_Z(estimationContext_t * ctx)
     const float wBaro = scaleRangef(constrainf(gpsBaroResidual, start_epv, end_epv), start_epv, end_epv, 1.0f, 0.0f);
     //use both baro and gps
     if ((ctx->newFlags & EST_BARO_VALID) && (!positionEstimationConfig()->use_gps_no_baro) && (wBaro > 0.01f)) {
-        timeUs_t currentTimeUs = micros();
+        bool isAirCushionEffectDetected;
 
-        if (!ARMING_FLAG(ARMED)) {
-            posEstimator.state.baroGroundAlt = posEstimator.est.pos.z;
-            posEstimator.state.isBaroGroundValid = true;
-            posEstimator.state.baroGroundTimeout = currentTimeUs + 250000;   // 0.25 sec
-        }
-        else {
-            if (posEstimator.est.vel.z > 15) {
-                posEstimator.state.isBaroGroundValid = currentTimeUs > posEstimator.state.baroGroundTimeout ? false: true;
-            }
-            else {
-                posEstimator.state.baroGroundTimeout = currentTimeUs + 250000;   // 0.25 sec
+        // Altitude
+        const float baroAlt = estimationGetBaroAltitude(ctx, &isAirCushionEffectDetected);
+        if (estimationHistoryGetState(estimationGetBaroMeasurementTime(), &pastPos, &pastVel)) {
+            const float baroAltResidual = baroAlt - pastPos.z;
+            ctx->estBaroPosCorrZ += wBaro * baroAltResidual * positionEstimationConfig()->w_z_baro_p * ctx->dt;
+            ctx->estBaroVelCorrZ += wBaro * baroAltResidual * sq(positionEstimationConfig()->w_z_baro_p) * ctx->dt;
+
+            // Accelerometer bias
+            if (!isAirCushionEffectDetected) {
+                ctx->accBiasCorr.z -= wBaro * baroAltResidual * sq(positionEstimationConfig()->w_z_baro_p);
             }
         }
 
-        // We might be experiencing air cushion effect during takeoff - use sonar or baro ground altitude to detect it
-        bool isAirCushionEffectDetected = ARMING_FLAG(ARMED) &&
-                                            (((ctx->newFlags & EST_SURFACE_VALID) && posEstimator.surface.alt < 20.0f && posEstimator.state.isBaroGroundValid) ||
-                                             ((ctx->newFlags & EST_BARO_VALID) && posEstimator.state.isBaroGroundValid && posEstimator.baro.alt < posEstimator.state.baroGroundAlt));
-
-        // Altitude
-        const float baroAltResidual = (isAirCushionEffectDetected ? posEstimator.state.baroGroundAlt : posEstimator.baro.alt) - posEstimator.est.pos.z;
-        ctx->estPosCorr.z += wBaro * baroAltResidual * positionEstimationConfig()->w_z_baro_p * ctx->dt;
-        ctx->estVelCorr.z += wBaro * baroAltResidual * sq(positionEstimationConfig()->w_z_baro_p) * ctx->dt;
-
         ctx->newEPV = updateEPE(posEstimator.est.epv, ctx->dt, posEstimator.baro.epv, positionEstimationConfig()->w_z_baro_p);
 
-        // Accelerometer bias
-        if (!isAirCushionEffectDetected) {
-            ctx->accBiasCorr.z -= wBaro * baroAltResidual * sq(positionEstimationConfig()->w_z_baro_p);
-        }
-
         correctOK = true;
     }
     if (ctx->newFlags & EST_GPS_Z_VALID) {
+        // A fix older than the stored history is only used to reset the estimate
+        const bool isGpsInHistory = estimationHistoryGetState(estimationGetGpsMeasurementTime(), &pastPos, &pastVel);
+
         // Reset current estimate to GPS altitude if estimate not valid
         if (!(ctx->newFlags & EST_Z_VALID)) {
-            ctx->estPosCorr.z += posEstimator.gps.pos.z - posEstimator.est.pos.z;
-            ctx->estVelCorr.z += posEstimator.gps.vel.z - posEstimator.est.vel.z;
+            ctx->estPosCorr.z += posEstimator.gps.pos.z - pastPos.z;
+            ctx->estVelCorr.z += posEstimator.gps.vel.z - pastVel.z;
             ctx->newEPV = posEstimator.gps.epv;
         }
-        else {
+        else if (isGpsInHistory) {
             // Altitude
-            const float gpsAltResudual = posEstimator.gps.pos.z - posEstimator.est.pos.z;
-            const float gpsVelZResudual = posEstimator.gps.vel.z - posEstimator.est.vel.z;
+            const float gpsAltResudual = posEstimator.gps.pos.z - pastPos.z;
+            const float gpsVelZResudual = posEstimator.gps.vel.z - pastVel.z;
 
             ctx->estPosCorr.z += gpsAltResudual * positionEstimationConfig()->w_z_gps_p * ctx->dt;
             ctx->estVelCorr.z += gpsAltResudual * sq(positionEstimationConfig()->w_z_gps_p) * ctx->dt;
@@ -627,19 +672,24 @@ static bool estimationCalculateCorrection_Z(estimationContext_t * ctx)
 static bool estimationCalculateCorrection_XY_GPS(estimationContext_t * ctx)
 {
     if (ctx->newFlags & EST_GPS_XY_VALID) {
+        /* GPS fix is delayed - compare it with the estimate from the time it was taken */
+        fpVector3_t pastPos;
+        fpVector3_t pastVel;
+        const bool isGpsInHistory = estimationHistoryGetState(estimationGetGpsMeasurementTime(), &pastPos, &pastVel);
+
         /* If GPS is valid and our estimate is NOT valid - reset it to GPS coordinates and velocity */
         if (!(ctx->newFlags & EST_XY_VALID)) {
-            ctx->estPosCorr.x += posEstimator.gps.pos.x - posEstimator.est.pos.x;
-            ctx->estPosCorr.y += posEstimator.gps.pos.y - posEstimator.est.pos.y;
-            ctx->estVelCorr.x += posEstimator.gps.vel.x - posEstimator.est.vel.x;
-            ctx->estVelCorr.y += posEstimator.gps.vel.y - posEstimator.est.vel.y;
+            ctx->estPosCorr.x += posEstimator.gps.pos.x - pastPos.x;
+            ctx->estPosCorr.y += posEstimator.gps.pos.y - pastPos.y;
+            ctx->estVelCorr.x += posEstimator.gps.vel.x - pastVel.x;
+            ctx->estVelCorr.y += posEstimator.gps.vel.y - pastVel.y;
             ctx->newEPH = posEstimator.gps.eph;
         }
-        else {
-            const float gpsPosXResidual = posEstimator.gps.pos.x - posEstimator.est.pos.x;
-            const float gpsPosYResidual = posEstimator.gps.pos.y - posEstimator.est.pos.y;
-            const float gpsVelXResidual = posEstimator.gps.vel.x - posEstimator.est.vel.x;
-            const float gpsVelYResidual = posEstimator.gps.vel.y - posEstimator.est.vel.y;
+        else if (isGpsInHistory) {
+            const float gpsPosXResidual = posEstimator.gps.pos.x - pastPos.x;
+            const float gpsPosYResidual = posEstimator.gps.pos.y - pastPos.y;
+            const float gpsVelXResidual = posEstimator.gps.vel.x - pastVel.x;
+            const float gpsVelYResidual = posEstimator.gps.vel.y - pastVel.y;
             const float gpsPosResidualMag = calc_length_pythagorean_2D(gpsPosXResidual, gpsPosYResidual);
 
             //const float gpsWeightScaler = scaleRangef(bellCurve(gpsPosResidualMag, INAV_GPS_ACCEPTANCE_EPE), 0.0f, 1.0f, 0.1f, 1.0f);
@@ -687,6 +737,64 @@ static void estimationCalculateGroundCourse(timeUs_t currentTimeUs)
     }
 }
 
+/**
+ * Complementary filter: predict from IMU, correct position and velocity with fixed weights
+ */
+static void estimationComplementaryUpdate(estimationContext_t * ctx, timeUs_t currentTimeUs)
+{
+    /* Prediction stage: X,Y,Z */
+    estimationPredict(ctx);
+    estimationHistoryPush(currentTimeUs);
+
+    /* Correction stage: Z */
+    const bool estZCorrectOk =
+        estimationCalculateCorrection_Z(ctx);
+
+    /* Correction stage: XY: GPS, FLOW */
+    // FIXME: Handle transition from FLOW to GPS and back - seamlessly fly indoor/outdoor
+    const bool estXYCorrectOk =
+        estimationCalculateCorrection_XY_GPS(ctx) ||
+        estimationCalculateCorrection_XY_FLOW(ctx);
+
+    // If we can't apply correction or accuracy is off the charts - decay velocity to zero
+    if (!estXYCorrectOk || ctx->newEPH > positionEstimationConfig()->max_eph_epv) {
+        ctx->estVelCorr.x = (0.0f - posEstimator.est.vel.x) * positionEstimationConfig()->w_xy_res_v * ctx->dt;
+        ctx->estVelCorr.y = (0.0f - posEstimator.est.vel.y) * positionEstimationConfig()->w_xy_res_v * ctx->dt;
+    }
+
+    if (!estZCorrectOk || ctx->newEPV > positionEstimationConfig()->max_eph_epv) {
+        ctx->estVelCorr.z = (0.0f - posEstimator.est.vel.z) * positionEstimationConfig()->w_z_res_v * ctx->dt;
+        ctx->estBaroVelCorrZ = 0.0f;
+    }
+    // Boost the corrections based on accWeight
+    const float accWeight = navGetAccelerometerWeight();
+    vectorScale(&ctx->estPosCorr, &ctx->estPosCorr, 1.0f/accWeight);
+    vectorScale(&ctx->estVelCorr, &ctx->estVelCorr, 1.0f/accWeight);
+    ctx->estBaroPosCorrZ /= accWeight;
+    ctx->estBaroVelCorrZ /= accWeight;
+    // Apply corrections, each one from the time its residual was calculated at
+    const timeUs_t xyMeasurementTime = (ctx->newFlags & EST_GPS_XY_VALID) ? estimationGetGpsMeasurementTime() : currentTimeUs;
+    const timeUs_t zMeasurementTime = (ctx->newFlags & EST_GPS_Z_VALID) ? estimationGetGpsMeasurementTime() : currentTimeUs;
+    estimationHistoryApplyCorrection(X, ctx->estPosCorr.x, ctx->estVelCorr.x, xyMeasurementTime);
+    estimationHistoryApplyCorrection(Y, ctx->estPosCorr.y, ctx->estVelCorr.y, xyMeasurementTime);
+    estimationHistoryApplyCorrection(Z, ctx->estPosCorr.z, ctx->estVelCorr.z, zMeasurementTime);
+    estimationHistoryApplyCorrection(Z, ctx->estBaroPosCorrZ, ctx->estBaroVelCorrZ, estimationGetBaroMeasurementTime());
+
+    /* Correct accelerometer bias */
+    if (positionEstimationConfig()->w_acc_bias > 0.0f) {
+        const float accelBiasCorrMagnitudeSq = sq(ctx->accBiasCorr.x) + sq(ctx->accBiasCorr.y) + sq(ctx->accBiasCorr.z);
+        if (accelBiasCorrMagnitudeSq < sq(INAV_ACC_BIAS_ACCEPTANCE_VALUE)) {
+            /* transform error vector from NEU frame to body frame */
+            imuTransformVectorEarthToBody(&ctx->accBiasCorr);
+
+            /* Correct accel bias */
+            posEstimator.imu.accelBias.x += ctx->accBiasCorr.x * positionEstimationConfig()->w_acc_bias * ctx->dt;
+            posEstimator.imu.accelBias.y += ctx->accBiasCorr.y * positionEstimationConfig()->w_acc_bias * ctx->dt;
+            posEstimator.imu.accelBias.z += ctx->accBiasCorr.z * positionEstimationConfig()->w_acc_bias * ctx->dt;
+        }
+    }
+}
+
 /**
  * Calculate next estimate using IMU and apply corrections from reference sensors (GPS, BARO etc)
  *  Function is called at main loop rate
@@ -713,53 +821,21 @@ static void updateEstimatedTopic(timeUs_t currentTimeUs)
     ctx.newFlags = calculateCurrentValidityFlags(currentTimeUs);
     vectorZero(&ctx.estPosCorr);
     vectorZero(&ctx.estVelCorr);
+    ctx.estBaroPosCorrZ = 0.0f;
+    ctx.estBaroVelCorrZ = 0.0f;
     vectorZero(&ctx.accBiasCorr);
 
     /* AGL estimation - separate process, decouples from Z coordinate */
     estimationCalculateAGL(&ctx);
 
-    /* Prediction stage: X,Y,Z */
-    estimationPredict(&ctx);
-
-    /* Correction stage: Z */
-    const bool estZCorrectOk =
-        estimationCalculateCorrection_Z(&ctx);
-
-    /* Correction stage: XY: GPS, FLOW */
-    // FIXME: Handle transition from FLOW to GPS and back - seamlessly fly indoor/outdoor
-    const bool estXYCorrectOk =
-        estimationCalculateCorrection_XY_GPS(&ctx) ||
-        estimationCalculateCorrection_XY_FLOW(&ctx);
-
-    // If we can't apply correction or accuracy is off the charts - decay velocity to zero
-    if (!estXYCorrectOk || ctx.newEPH > positionEstimationConfig()->max_eph_epv) {
-        ctx.estVelCorr.x = (0.0f - posEstimator.est.vel.x) * positionEstimationConfig()->w_xy_res_v * ctx.dt;
-        ctx.estVelCorr.y = (0.0f - posEstimator.est.vel.y) * positionEstimationConfig()->w_xy_res_v * ctx.dt;
-    }
-
-    if (!estZCorrectOk || ctx.newEPV > positionEstimationConfig()->max_eph_epv) {
-        ctx.estVelCorr.z = (0.0f - posEstimator.est.vel.z) * positionEstimationConfig()->w_z_res_v * ctx.dt;
+#ifdef USE_NAV_EKF
+    if (positionEstimationConfig()->estimator_type == NAV_ESTIMATOR_EKF) {
+        estimationEkfUpdate(&ctx, currentTimeUs);
     }
-    // Boost the corrections based on accWeight
-    const float accWeight = navGetAccelerometerWeight();
-    vectorScale(&ctx.estPosCorr, &ctx.estPosCorr, 1.0f/accWeight);
-    vectorScale(&ctx.estVelCorr, &ctx.estVelCorr, 1.0f/accWeight);
-    // Apply corrections
-    vectorAdd(&posEstimator.est.pos, &posEstimator.est.pos, &ctx.estPosCorr);
-    vectorAdd(&posEstimator.est.vel, &posEstimator.est.vel, &ctx.estVelCorr);
-
-    /* Correct accelerometer bias */
-    if (positionEstimationConfig()->w_acc_bias > 0.0f) {
-        const float accelBiasCorrMagnitudeSq = sq(ctx.accBiasCorr.x) + sq(ctx.accBiasCorr.y) + sq(ctx.accBiasCorr.z);
-        if (accelBiasCorrMagnitudeSq < sq(INAV_ACC_BIAS_ACCEPTANCE_VALUE)) {
-            /* transform error vector from NEU frame to body frame */
-            imuTransformVectorEarthToBody(&ctx.accBiasCorr);
-
-            /* Correct accel bias */
-            posEstimator.imu.accelBias.x += ctx.accBiasCorr.x * positionEstimationConfig()->w_acc_bias * ctx.dt;
-            posEstimator.imu.accelBias.y += ctx.accBiasCorr.y * positionEstimationConfig()->w_acc_bias * ctx.dt;
-            posEstimator.imu.accelBias.z += ctx.accBiasCorr.z * positionEstimationConfig()->w_acc_bias * ctx.dt;
-        }
+    else
+#endif
+    {
+        estimationComplementaryUpdate(&ctx, currentTimeUs);
     }
 
     /* Update ground course */
@@ -871,8 +947,14 @@ void initializePositionEstimator(void)
         posEstimator.est.vel.v[axis] = 0;
     }
 
+    estimationHistoryReset();
+
     pt1FilterInit(&posEstimator.baro.avgFilter, INAV_BARO_AVERAGE_HZ, 0.0f);
     pt1FilterInit(&posEstimator.surface.avgFilter, INAV_SURFACE_AVERAGE_HZ, 0.0f);
+
+#ifdef USE_NAV_EKF
+    estimationEkfReset();
+#endif
 }
 
 /**
@@ -0,0 +1,428 @@
+/*
+ * This file is part of INAV Project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 3, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+
+#include "platform.h"
+
+#include "build/build_config.h"
+#include "build/debug.h"
+
+#include "common/maths.h"
+#include "common/utils.h"
+
+#include "fc/runtime_config.h"
+
+#include "flight/imu.h"
+
+#include "navigation/navigation.h"
+#include "navigation/navigation_private.h"
+#include "navigation/navigation_pos_estimator_private.h"
+
+#include "sensors/pitotmeter.h"
+
+extern navigationPosEstimator_t posEstimator;
+
+#ifdef USE_NAV_EKF
+
+/*
+ * Error state Kalman filter for position, velocity and accelerometer bias.
+ *
+ * Attitude comes from the IMU, so acceleration is already rotated to NEU and the
+ * axes are independent. Every axis carries a 3 state filter (pos, vel, accBias) with
+ * a symmetric 3x3 covariance, prediction and the scalar position/velocity updates are
+ * written out element by element. No matrix library, no allocation, ~100 flops per axis.
+ *
+ * Position and velocity live in posEstimator.est, so switching estimators keeps the
+ * current estimate. Delayed measurements (GPS) are compared with the estimate from the
+ * time they were taken, see estimationHistoryGetState().
+ */
+
+typedef struct {
+    float accBias;                      // cm/s/s, NEU
+    float p00, p01, p02, p11, p12, p22; // Covariance of (pos, vel, accBias)
+} navEkfAxis_t;
+
+typedef struct {
+    bool                    initialized;
+    navEkfAxis_t            axis[XYZ_AXIS_COUNT];
+
+    timeUs_t                lastGpsUpdateTime;
+    timeUs_t                lastBaroUpdateTime;
+    timeUs_t                lastSurfaceUpdateTime;
+    timeUs_t                lastPitotUpdateTime;
+    timeUs_t                gpsRejectStartTime;
+} navEkf_t;
+
+static navEkf_t ekf;
+
+static void ekfAxisReset(navEkfAxis_t * axis, float posVariance, float velVariance)
+{
+    axis->p00 = posVariance;
+    axis->p01 = 0.0f;
+    axis->p02 = 0.0f;
+    axis->p11 = velVariance;
+    axis->p12 = 0.0f;
+    axis->p22 = sq(INAV_EKF_ACC_BIAS_INITIAL);
+}
+
+/*
+ * P = F * P * F' + Q with F = [1 dt -dt^2/2; 0 1 -dt; 0 0 1]
+ * Acceleration noise enters through G = [dt^2/2; dt; 0], bias follows a random walk
+ */
+static void ekfAxisPredict(navEkfAxis_t * axis, float * pos, float * vel, float acc, float dt, float accVariance)
+{
+    const float h = sq(dt) / 2.0f;
+    const float accCorrected = acc - axis->accBias;
+
+    *pos += *vel * dt + accCorrected * h;
+    *vel += accCorrected * dt;
+
+    const float a00 = axis->p00 + dt * axis->p01 - h * axis->p02;
+    const float a01 = axis->p01 + dt * axis->p11 - h * axis->p12;
+    const float a02 = axis->p02 + dt * axis->p12 - h * axis->p22;
+    const float a11 = axis->p11 - dt * axis->p12;
+    const float a12 = axis->p12 - dt * axis->p22;
+
+    axis->p00 = a00 + dt * a01 - h * a02 + accVariance * sq(h);
+    axis->p01 = a01 - dt * a02 + accVariance * h * dt;
+    axis->p02 = a02;
+    axis->p11 = a11 - dt * a12 + accVariance * sq(dt);
+    axis->p12 = a12;
+    axis->p22 += sq(INAV_EKF_ACC_BIAS_NOISE) * dt;
+}
+
+/*
+ * Scalar update with H = [1 0 0] (position) or H = [0 1 0] (velocity).
+ * Returns false if the innovation fails the gate, gate <= 0 accepts everything.
+ */
+static bool ekfAxisCorrect(navEkfAxis_t * axis, bool isVelocity, float innovation, float variance, float gate, float * posCorr, float * velCorr)
+{
+    const float ph0 = isVelocity ? axis->p01 : axis->p00;
+    const float ph1 = isVelocity ? axis->p11 : axis->p01;
+    const float ph2 = isVelocity ? axis->p12 : axis->p02;
+    const float s = (isVelocity ? axis->p11 : axis->p00) + variance;
+
+    if (gate > 0.0f && sq(innovation) > sq(gate) * s) {
+        return false;
+    }
+
+    const float k0 = ph0 / s;
+    const float k1 = ph1 / s;
+    const float k2 = ph2 / s;
+
+    *posCorr += k0 * innovation;
+    *velCorr += k1 * innovation;
+    axis->accBias += k2 * innovation;
+
+    axis->p00 -= k0 * ph0;
+    axis->p01 -= k0 * ph1;
+    axis->p02 -= k0 * ph2;
+    axis->p11 -= k1 * ph1;
+    axis->p12 -= k1 * ph2;
+    axis->p22 -= k2 * ph2;
+
+    return true;
+}
+
+static bool ekfCorrectDelayed(int axis, bool isVelocity, float measurement, timeUs_t measurementTime, float variance, float gate)
+{
+    fpVector3_t pastPos;
+    fpVector3_t pastVel;
+    float posCorr = 0.0f;
+    float velCorr = 0.0f;
+
+    // Too old for the stored history, the innovation would be against the wrong state
+    if (!estimationHistoryGetState(measurementTime, &pastPos, &pastVel)) {
+        return false;
+    }
+
+    const float reference = isVelocity ? pastVel.v[axis] : pastPos.v[axis];
+
+    if (!ekfAxisCorrect(&ekf.axis[axis], isVelocity, measurement - reference, variance, gate, &posCorr, &velCorr)) {
+        return false;
+    }
+
+    estimationHistoryApplyCorrection(axis, posCorr, velCorr, measurementTime);
+    return true;
+}
+
+static void ekfResetAxisTo(int axis, float pos, float vel, timeUs_t measurementTime, float posVariance, float velVariance)
+{
+    fpVector3_t pastPos;
+    fpVector3_t pastVel;
+
+    estimationHistoryGetState(measurementTime, &pastPos, &pastVel);
+    estimationHistoryApplyCorrection(axis, pos - pastPos.v[axis], vel - pastVel.v[axis], measurementTime);
+    ekfAxisReset(&ekf.axis[axis], posVariance, velVariance);
+}
+
+void estimationEkfReset(void)
+{
+    const float variance = sq(positionEstimationConfig()->max_eph_epv * 2.0f);
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        ekf.axis[axis].accBias = 0.0f;
+        ekfAxisReset(&ekf.axis[axis], variance, variance);
+    }
+
+    ekf.gpsRejectStartTime = 0;
+    ekf.initialized = true;
+}
+
+static bool ekfCorrectZ(estimationContext_t * ctx)
+{
+    bool correctOK = false;
+    const float gate = positionEstimationConfig()->ekf_innov_gate;
+
+#if defined(USE_BARO)
+    if ((ctx->newFlags & EST_BARO_VALID) && !positionEstimationConfig()->use_gps_no_baro) {
+        if (posEstimator.baro.lastUpdateTime != ekf.lastBaroUpdateTime) {
+            ekf.lastBaroUpdateTime = posEstimator.baro.lastUpdateTime;
+
+            bool isAirCushionEffectDetected;
+            const float baroAlt = estimationGetBaroAltitude(ctx, &isAirCushionEffectDetected);
+            const float baroVariance = sq(posEstimator.baro.epv);
+
+            if (!(ctx->newFlags & EST_Z_VALID) && !(ctx->newFlags & EST_GPS_Z_VALID)) {
+                ekfResetAxisTo(Z, baroAlt, posEstimator.est.vel.z, posEstimator.est.lastUpdateTime, baroVariance, sq(INAV_EKF_VEL_INITIAL));
+            }
+            else {
+                const float biasBackup = ekf.axis[Z].accBias;
+                ekfCorrectDelayed(Z, false, baroAlt, estimationGetBaroMeasurementTime(), baroVariance, 0.0f);
+
+                // Ground effect pushes baro altitude down, don't learn it as accelerometer bias
+                if (isAirCushionEffectDetected) {
+                    ekf.axis[Z].accBias = biasBackup;
+                }
+            }
+        }
+
+        correctOK = true;
+    }
+#endif
+
+#if defined(USE_GPS)
+    if ((ctx->newFlags & EST_GPS_Z_VALID) && posEstimator.gps.lastUpdateTime != ekf.lastGpsUpdateTime) {
+        const timeUs_t measurementTime = estimationGetGpsMeasurementTime();
+        const float gpsPosVariance = sq(posEstimator.gps.epv);
+        const float gpsVelVariance = sq(positionEstimationConfig()->ekf_gps_vel_noise * 2.0f);
+
+        if (!(ctx->newFlags & EST_Z_VALID)) {
+            ekfResetAxisTo(Z, posEstimator.gps.pos.z, posEstimator.gps.vel.z, measurementTime, gpsPosVariance, gpsVelVariance);
+        }
+        else {
+            ekfCorrectDelayed(Z, false, posEstimator.gps.pos.z, measurementTime, gpsPosVariance, gate);
+            ekfCorrectDelayed(Z, true, posEstimator.gps.vel.z, measurementTime, gpsVelVariance, gate);
+        }
+    }
+
+    if (ctx->newFlags & EST_GPS_Z_VALID) {
+        correctOK = true;
+    }
+#endif
+
+#if defined(USE_RANGEFINDER)
+    // No absolute altitude reference (indoors) - hold altitude on the surface estimate instead
+    if (!correctOK && (ctx->newFlags & EST_SURFACE_VALID) && posEstimator.est.aglQual == SURFACE_QUAL_HIGH) {
+        if (posEstimator.surface.lastUpdateTime != ekf.lastSurfaceUpdateTime) {
+            ekf.lastSurfaceUpdateTime = posEstimator.surface.lastUpdateTime;
+            ekfCorrectDelayed(Z, false, posEstimator.surface.alt + posEstimator.est.aglOffset, posEstimator.surface.lastUpdateTime, sq(INAV_EKF_SURFACE_NOISE), gate);
+        }
+        correctOK = true;
+    }
+#endif
+
+    return correctOK;
+}
+
+static bool ekfCorrectXY(estimationContext_t * ctx, timeUs_t currentTimeUs)
+{
+#if defined(USE_GPS)
+    if (ctx->newFlags & EST_GPS_XY_VALID) {
+        if (posEstimator.gps.lastUpdateTime != ekf.lastGpsUpdateTime) {
+            const timeUs_t measurementTime = estimationGetGpsMeasurementTime();
+            const float gpsPosVariance = sq(posEstimator.gps.eph);
+            const float gpsVelVariance = sq(positionEstimationConfig()->ekf_gps_vel_noise);
+            fpVector3_t pastPos;
+            fpVector3_t pastVel;
+
+            if (!(ctx->newFlags & EST_XY_VALID)) {
+                ekfResetAxisTo(X, posEstimator.gps.pos.x, posEstimator.gps.vel.x, measurementTime, gpsPosVariance, gpsVelVariance);
+                ekfResetAxisTo(Y, posEstimator.gps.pos.y, posEstimator.gps.vel.y, measurementTime, gpsPosVariance, gpsVelVariance);
+                ekf.gpsRejectStartTime = 0;
+            }
+            else if (estimationHistoryGetState(measurementTime, &pastPos, &pastVel)) {
+                // A fix older than the stored history is dropped, it can't be compared with the estimate
+                const float gate = positionEstimationConfig()->ekf_innov_gate;
+                bool accepted = true;
+
+                // Position is gated as a whole, a glitch moves both axes
+                for (int axis = X; axis <= Y; axis++) {
+                    const float innovation = posEstimator.gps.pos.v[axis] - pastPos.v[axis];
+                    accepted = accepted && (gate <= 0.0f || sq(innovation) <= sq(gate) * (ekf.axis[axis].p00 + gpsPosVariance));
+                }
+
+                if (accepted) {
+                    ekf.gpsRejectStartTime = 0;
+                    for (int axis = X; axis <= Y; axis++) {
+                        ekfCorrectDelayed(axis, false, posEstimator.gps.pos.v[axis], measurementTime, gpsPosVariance, 0.0f);
+                        ekfCorrectDelayed(axis, true, posEstimator.gps.vel.v[axis], measurementTime, gpsVelVariance, gate);
+                    }
+                }
+                else if (ekf.gpsRejectStartTime == 0) {
+                    ekf.gpsRejectStartTime = currentTimeUs;
+                }
+                else if ((currentTimeUs - ekf.gpsRejectStartTime) > MS2US(INAV_EKF_GPS_GLITCH_TIMEOUT_MS)) {
+                    // GPS disagrees for too long, it is the estimate that is wrong
+                    ekfResetAxisTo(X, posEstimator.gps.pos.x, posEstimator.gps.vel.x, measurementTime, gpsPosVariance, gpsVelVariance);
+                    ekfResetAxisTo(Y, posEstimator.gps.pos.y, posEstimator.gps.vel.y, measurementTime, gpsPosVariance, gpsVelVariance);
+                    ekf.gpsRejectStartTime = 0;
+                }
+                else {
+                    // Keep using GPS velocity while the position is rejected
+                    for (int axis = X; axis <= Y; axis++) {
+                        ekfCorrectDelayed(axis, true, posEstimator.gps.vel.v[axis], measurementTime, gpsVelVariance, gate);
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+#else
+    UNUSED(currentTimeUs);
+#endif
+
+    UNUSED(ctx);
+    return false;
+}
+
+#if defined(USE_PITOT)
+// No GPS on an airplane - airspeed along the heading is the best velocity we have, unknown wind makes it coarse
+static bool ekfCorrectXY_Pitot(estimationContext_t * ctx)
+{
+    if (!STATE(AIRPLANE) || !sensors(SENSOR_PITOT) || !pitotIsHealthy() || !isImuHeadingValid() || !(ctx->newFlags & EST_XY_VALID)) {
+        return false;
+    }
+
+    if (posEstimator.pitot.lastUpdateTime == ekf.lastPitotUpdateTime) {
+        return true;
+    }
+    ekf.lastPitotUpdateTime = posEstimator.pitot.lastUpdateTime;
+
+    // Forward axis of the body frame in NEU
+    fpVector3_t forward = { .v = { 1.0f, 0.0f, 0.0f } };
+    imuTransformVectorBodyToEarth(&forward);
+    const float horizontalNorm = calc_length_pythagorean_2D(forward.x, forward.y);
+    if (horizontalNorm < 0.1f) {
+        return true;
+    }
+
+    const float airspeed = posEstimator.pitot.airspeed;
+    const float velVariance = sq(INAV_EKF_PITOT_WIND_NOISE + airspeed * 0.1f);
+
+    for (int axis = X; axis <= Y; axis++) {
+        ekfCorrectDelayed(axis, true, airspeed * forward.v[axis] / horizontalNorm, posEstimator.pitot.lastUpdateTime, velVariance, 0.0f);
+    }
+
+    return true;
+}
+#endif
+
+/*
+ * Prediction and all corrections of the EKF estimator, replaces estimationPredict() and
+ * the complementary corrections. Updates posEstimator.est and the EPH/EPV in ctx.
+ */
+void estimationEkfUpdate(estimationContext_t * ctx, timeUs_t currentTimeUs)
+{
+    if (!ekf.initialized) {
+        estimationEkfReset();
+    }
+
+    // Vibration and clipping make acceleration less trustworthy
+    const float accWeight = MAX(navGetAccelerometerWeight(), 0.1f);
+    const float accVariance = sq(positionEstimationConfig()->ekf_acc_noise / accWeight);
+
+    /* Prediction */
+    const bool useHorizontalAcc = navIsHeadingUsable();
+    ekfAxisPredict(&ekf.axis[X], &posEstimator.est.pos.x, &posEstimator.est.vel.x, useHorizontalAcc ? posEstimator.imu.accelNEU.x : 0.0f, ctx->dt, accVariance);
+    ekfAxisPredict(&ekf.axis[Y], &posEstimator.est.pos.y, &posEstimator.est.vel.y, useHorizontalAcc ? posEstimator.imu.accelNEU.y : 0.0f, ctx->dt, accVariance);
+    ekfAxisPredict(&ekf.axis[Z], &posEstimator.est.pos.z, &posEstimator.est.vel.z, posEstimator.imu.accelNEU.z, ctx->dt, accVariance);
+
+    estimationHistoryPush(currentTimeUs);
+
+    /* Corrections */
+    const bool estZCorrectOk = ekfCorrectZ(ctx);
+    bool estXYCorrectOk = ekfCorrectXY(ctx, currentTimeUs);
+
+#if defined(USE_GPS)
+    ekf.lastGpsUpdateTime = posEstimator.gps.lastUpdateTime;
+#endif
+
+    ctx->newEPH = fast_fsqrtf(MAX(ekf.axis[X].p00, ekf.axis[Y].p00));
+    ctx->newEPV = fast_fsqrtf(ekf.axis[Z].p00);
+
+    if (!estXYCorrectOk) {
+        // Optical flow keeps its complementary corrections, fold them into the state
+        vectorZero(&ctx->estPosCorr);
+        vectorZero(&ctx->estVelCorr);
+        if (estimationCalculateCorrection_XY_FLOW(ctx)) {
+            for (int axis = X; axis <= Y; axis++) {
+                estimationHistoryApplyCorrection(axis, ctx->estPosCorr.v[axis], ctx->estVelCorr.v[axis], currentTimeUs);
+                ekf.axis[axis].p00 = MIN(ekf.axis[axis].p00, sq(ctx->newEPH));
+            }
+            estXYCorrectOk = true;
+        }
+    }
+
+#if defined(USE_PITOT)
+    if (!estXYCorrectOk && ekfCorrectXY_Pitot(ctx)) {
+        // Bounds velocity, position keeps drifting
+        ctx->newEPH = fast_fsqrtf(MAX(ekf.axis[X].p00, ekf.axis[Y].p00));
+    }
+#endif
+
+    // No reference - decay velocity to zero like the complementary filter does
+    if (!estXYCorrectOk && ctx->newEPH > positionEstimationConfig()->max_eph_epv) {
+        posEstimator.est.vel.x -= posEstimator.est.vel.x * positionEstimationConfig()->w_xy_res_v * ctx->dt;
+        posEstimator.est.vel.y -= posEstimator.est.vel.y * positionEstimationConfig()->w_xy_res_v * ctx->dt;
+    }
+
+    if (!estZCorrectOk && ctx->newEPV > positionEstimationConfig()->max_eph_epv) {
+        posEstimator.est.vel.z -= posEstimator.est.vel.z * positionEstimationConfig()->w_z_res_v * ctx->dt;
+    }
+
+    DEBUG_SET(DEBUG_POS_EST_EKF, 0, ekf.axis[X].accBias);
+    DEBUG_SET(DEBUG_POS_EST_EKF, 1, ekf.axis[Y].accBias);
+    DEBUG_SET(DEBUG_POS_EST_EKF, 2, ekf.axis[Z].accBias);
+    DEBUG_SET(DEBUG_POS_EST_EKF, 3, fast_fsqrtf(ekf.axis[X].p11));
+    DEBUG_SET(DEBUG_POS_EST_EKF, 4, fast_fsqrtf(ekf.axis[Z].p11));
+    DEBUG_SET(DEBUG_POS_EST_EKF, 5, ekf.gpsRejectStartTime ? US2MS(currentTimeUs - ekf.gpsRejectStartTime) : 0);
+}
+
+#endif
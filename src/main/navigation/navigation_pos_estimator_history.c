@@ -0,0 +1,130 @@
+/*
+ * This file is part of INAV Project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * Alternatively, the contents of this file may be used under the terms
+ * of the GNU General Public License Version 3, as described below:
+ *
+ * This file is free software: you may copy, redistribute and/or modify
+ * it under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+#include "common/axis.h"
+#include "common/maths.h"
+#include "common/time.h"
+
+#include "navigation/navigation.h"
+#include "navigation/navigation_private.h"
+#include "navigation/navigation_pos_estimator_private.h"
+
+extern navigationPosEstimator_t posEstimator;
+
+/*
+ * State history for delayed measurements. The predicted state is stored every
+ * INAV_POSITION_HISTORY_INTERVAL_US, a measurement taken at some time in the past is
+ * compared with the estimate interpolated to that time instead of the current one.
+ */
+void estimationHistoryReset(void)
+{
+    posEstimator.history.head = 0;
+    posEstimator.history.count = 0;
+}
+
+void estimationHistoryPush(timeUs_t currentTimeUs)
+{
+    navPositionEstimatorHISTORY_t * history = &posEstimator.history;
+
+    if (history->count) {
+        const navPositionEstimatorHistoryEntry_t * last = &history->entry[(history->head + INAV_POSITION_HISTORY_SIZE - 1) % INAV_POSITION_HISTORY_SIZE];
+        if (cmpTimeUs(currentTimeUs, last->time) < INAV_POSITION_HISTORY_INTERVAL_US) {
+            return;
+        }
+    }
+
+    navPositionEstimatorHistoryEntry_t * entry = &history->entry[history->head];
+    entry->time = currentTimeUs;
+    entry->pos = posEstimator.est.pos;
+    entry->vel = posEstimator.est.vel;
+
+    history->head = (history->head + 1) % INAV_POSITION_HISTORY_SIZE;
+    history->count = MIN(history->count + 1, INAV_POSITION_HISTORY_SIZE);
+}
+
+/*
+ * Estimate at the given time, the current one for recent measurements. Returns false if the time
+ * is older than the stored history, pos and vel are then the oldest known state and should not be
+ * used for a correction.
+ */
+bool estimationHistoryGetState(timeUs_t time, fpVector3_t * pos, fpVector3_t * vel)
+{
+    const navPositionEstimatorHISTORY_t * history = &posEstimator.history;
+    const navPositionEstimatorHistoryEntry_t current = { .time = posEstimator.est.lastUpdateTime, .pos = posEstimator.est.pos, .vel = posEstimator.est.vel };
+    const navPositionEstimatorHistoryEntry_t * newer = &current;
+
+    if (cmpTimeUs(time, current.time) >= 0) {
+        *pos = current.pos;
+        *vel = current.vel;
+        return true;
+    }
+
+    for (int i = 1; i <= history->count; i++) {
+        const navPositionEstimatorHistoryEntry_t * older = &history->entry[(history->head + INAV_POSITION_HISTORY_SIZE - i) % INAV_POSITION_HISTORY_SIZE];
+
+        if (cmpTimeUs(time, older->time) >= 0) {
+            const timeDelta_t span = cmpTimeUs(newer->time, older->time);
+            const float k = (span > 0) ? (float)cmpTimeUs(time, older->time) / span : 0.0f;
+
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                pos->v[axis] = older->pos.v[axis] + (newer->pos.v[axis] - older->pos.v[axis]) * k;
+                vel->v[axis] = older->vel.v[axis] + (newer->vel.v[axis] - older->vel.v[axis]) * k;
+            }
+            return true;
+        }
+
+        newer = older;
+    }
+
+    *pos = newer->pos;
+    *vel = newer->vel;
+    return false;
+}
+
+/*
+ * Apply a correction calculated for measurementTime to the current estimate. The velocity
+ * correction is propagated forward from the measurement time, the stored history is shifted
+ * the same way so the next delayed measurement doesn't see the same error again.
+ */
+void estimationHistoryApplyCorrection(int axis, float posCorr, float velCorr, timeUs_t measurementTime)
+{
+    navPositionEstimatorHISTORY_t * history = &posEstimator.history;
+
+    for (int i = 0; i < history->count; i++) {
+        navPositionEstimatorHistoryEntry_t * entry = &history->entry[i];
+        const timeDelta_t age = cmpTimeUs(entry->time, measurementTime);
+
+        entry->pos.v[axis] += posCorr + ((age > 0) ? velCorr * US2S(age) : 0.0f);
+        entry->vel.v[axis] += velCorr;
+    }
+
+    const timeDelta_t age = cmpTimeUs(posEstimator.est.lastUpdateTime, measurementTime);
+    posEstimator.est.pos.v[axis] += posCorr + ((age > 0) ? velCorr * US2S(age) : 0.0f);
+    posEstimator.est.vel.v[axis] += velCorr;
+}
@@ -53,6 +53,19 @@
 
 #define INAV_ACC_CLIPPING_RC_CONSTANT           (0.010f)    // Reduce acc weight for ~10ms after clipping
 
+// State history for delayed measurements. A GPS fix is used until the next one arrives, the history
+// must cover the max inav_gps_delay plus the interval between fixes at the lowest supported 5Hz rate
+#define INAV_POSITION_HISTORY_SIZE          32
+#define INAV_POSITION_HISTORY_INTERVAL_US   20000   // 640ms of state history
+
+// EKF estimator, see navigation_pos_estimator_ekf.c
+#define INAV_EKF_GPS_GLITCH_TIMEOUT_MS      3000    // Reset to GPS position if it is rejected for this long
+#define INAV_EKF_ACC_BIAS_INITIAL           20.0f   // cm/s/s
+#define INAV_EKF_ACC_BIAS_NOISE             1.0f    // cm/s/s per sqrt(s)
+#define INAV_EKF_VEL_INITIAL                100.0f  // cm/s
+#define INAV_EKF_SURFACE_NOISE              10.0f   // cm
+#define INAV_EKF_PITOT_WIND_NOISE           500.0f  // cm/s, unknown wind
+
 #define RANGEFINDER_RELIABILITY_RC_CONSTANT     (0.47802f)
 #define RANGEFINDER_RELIABILITY_LIGHT_THRESHOLD (0.15f)
 #define RANGEFINDER_RELIABILITY_LOW_THRESHOLD   (0.33f)
@@ -65,6 +78,7 @@ typedef struct {
 
 typedef struct {
     timeUs_t    lastUpdateTime; // Last update time (us)
+    timeUs_t    measurementTime;    // Time the fix was taken, lastUpdateTime minus the configured latency (us)
     fpVector3_t pos;            // GPS position in NEU coordinate system (cm)
     fpVector3_t vel;            // GPS velocity (cms)
     float       eph;
@@ -73,6 +87,7 @@ typedef struct {
 
 typedef struct {
     timeUs_t    lastUpdateTime; // Last update time (us)
+    timeUs_t    measurementTime;    // Time the pressure was sampled (us)
     pt1Filter_t avgFilter;
     float       alt;            // Raw barometric altitude (cm)
     float       epv;
@@ -146,6 +161,19 @@ typedef enum {
     EST_Z_VALID                 = (1 << 6),
 } navPositionEstimationFlags_e;
 
+typedef struct {
+    timeUs_t    time;
+    fpVector3_t pos;
+    fpVector3_t vel;
+} navPositionEstimatorHistoryEntry_t;
+
+// Predicted states of the recent past, delayed measurements are compared with the estimate from the time they were taken
+typedef struct {
+    navPositionEstimatorHistoryEntry_t entry[INAV_POSITION_HISTORY_SIZE];
+    uint8_t     head;
+    uint8_t     count;
+} navPositionEstimatorHISTORY_t;
+
 typedef struct {
     timeUs_t    baroGroundTimeout;
     float       baroGroundAlt;
@@ -168,6 +196,7 @@ typedef struct {
 
     // Estimate
     navPositionEstimatorESTIMATE_t  est;
+    navPositionEstimatorHISTORY_t   history;
 
     // Extra state variables
     navPositionEstimatorSTATE_t state;
@@ -180,6 +209,8 @@ typedef struct {
     float newEPH;
     fpVector3_t estPosCorr;
     fpVector3_t estVelCorr;
+    float estBaroPosCorrZ;      // Baro part of the Z correction, applied at the baro measurement time
+    float estBaroVelCorrZ;
     fpVector3_t accBiasCorr;
 } estimationContext_t;
 
@@ -189,4 +220,17 @@ extern float updateEPE(const float oldEPE, const float dt, const float newEPE, c
 extern void estimationCalculateAGL(estimationContext_t * ctx);
 extern bool estimationCalculateCorrection_XY_FLOW(estimationContext_t * ctx);
 extern float navGetAccelerometerWeight(void);
+extern bool navIsHeadingUsable(void);
+extern float estimationGetBaroAltitude(estimationContext_t * ctx, bool * isAirCushionEffectDetected);
+extern timeUs_t estimationGetGpsMeasurementTime(void);
+extern timeUs_t estimationGetBaroMeasurementTime(void);
+extern void estimationHistoryReset(void);
+extern void estimationHistoryPush(timeUs_t currentTimeUs);
+extern bool estimationHistoryGetState(timeUs_t time, fpVector3_t * pos, fpVector3_t * vel);
+extern void estimationHistoryApplyCorrection(int axis, float posCorr, float velCorr, timeUs_t measurementTime);
+
+#ifdef USE_NAV_EKF
+extern void estimationEkfReset(void);
+extern void estimationEkfUpdate(estimationContext_t * ctx, timeUs_t currentTimeUs);
+#endif
 
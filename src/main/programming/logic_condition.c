@@ -58,6 +58,8 @@
 #include "drivers/vtx_common.h"
 #include "drivers/light_ws2811strip.h"
 
+#include "blackbox/blackbox.h"
+
 PG_REGISTER_ARRAY_WITH_RESET_FN(logicCondition_t, MAX_LOGIC_CONDITIONS, logicConditions, PG_LOGIC_CONDITIONS, 4);
 
 EXTENDED_FASTRAM uint64_t logicConditionsGlobalFlags;
@@ -293,6 +295,12 @@ static int logicConditionCompute(
             ENABLE_STATE(CALIBRATE_MAG);
             return true;
             break;
+#endif
+#ifdef USE_BLACKBOX_PRETRIGGER
+        case LOGIC_CONDITION_BLACKBOX_TRIGGER:
+            blackboxTrigger();
+            return true;
+            break;
 #endif  
         case LOGIC_CONDITION_SET_VTX_POWER_LEVEL:
 #if defined(USE_VTX_CONTROL) 
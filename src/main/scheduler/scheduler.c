@@ -32,13 +32,16 @@
 
 #include "drivers/time.h"
 
-STATIC_FASTRAM cfTask_t *currentTask = NULL;
+STATIC_FASTRAM_UNIT_TESTED cfTask_t *currentTask = NULL;
 
 STATIC_FASTRAM uint32_t totalWaitingTasks;
 STATIC_FASTRAM uint32_t totalWaitingTasksSamples;
 
 FASTRAM uint16_t averageSystemLoadPercent = 0;
 
+STATIC_FASTRAM schedulerDeadlineMode_e schedulerDeadlineMode = SCHEDULER_DEADLINE_OFF;
+STATIC_FASTRAM uint32_t schedulerDeferredTaskCount = 0;
+
 
 STATIC_FASTRAM int taskQueuePos = 0;
 STATIC_FASTRAM int taskQueueSize = 0;
@@ -48,11 +51,135 @@ STATIC_FASTRAM_UNIT_TESTED cfTask_t* taskQueueArray[TASK_COUNT + 2]; // 1 extra
 #else
 STATIC_FASTRAM cfTask_t* taskQueueArray[TASK_COUNT + 1]; // extra item for NULL pointer at end of queue
 #endif
+
+/*
+ * Time-driven tasks are additionally kept in a binary min-heap keyed on the time they become due,
+ * so the dispatcher only has to visit tasks which are actually due. Event-driven tasks (with checkFunc)
+ * have to be polled on every cycle and are kept in a separate list.
+ */
+STATIC_FASTRAM_UNIT_TESTED cfTask_t* taskDueHeap[TASK_COUNT];
+STATIC_FASTRAM_UNIT_TESTED int taskDueHeapSize = 0;
+STATIC_FASTRAM cfTask_t* taskEventArray[TASK_COUNT];
+STATIC_FASTRAM int taskEventArraySize = 0;
+
+static inline timeUs_t taskDueAt(const cfTask_t *task)
+{
+    // Realtime tasks are forced only when they are strictly overdue
+    return task->lastExecutedAt + task->desiredPeriod + (task->staticPriority == TASK_PRIORITY_REALTIME ? 1 : 0);
+}
+
+static inline bool taskDueBefore(const cfTask_t *a, const cfTask_t *b)
+{
+    return (timeDelta_t)(taskDueAt(a) - taskDueAt(b)) < 0;
+}
+
+static inline void dueHeapSet(int pos, cfTask_t *task)
+{
+    taskDueHeap[pos] = task;
+    task->dueHeapPos = pos;
+}
+
+static bool dueHeapContains(const cfTask_t *task)
+{
+    return task->dueHeapPos < taskDueHeapSize && taskDueHeap[task->dueHeapPos] == task;
+}
+
+static void dueHeapSiftUp(int pos)
+{
+    cfTask_t *task = taskDueHeap[pos];
+    while (pos > 0) {
+        const int parent = (pos - 1) / 2;
+        if (!taskDueBefore(task, taskDueHeap[parent])) {
+            break;
+        }
+        dueHeapSet(pos, taskDueHeap[parent]);
+        pos = parent;
+    }
+    dueHeapSet(pos, task);
+}
+
+static void dueHeapSiftDown(int pos)
+{
+    cfTask_t *task = taskDueHeap[pos];
+    for (;;) {
+        int child = 2 * pos + 1;
+        if (child >= taskDueHeapSize) {
+            break;
+        }
+        if (child + 1 < taskDueHeapSize && taskDueBefore(taskDueHeap[child + 1], taskDueHeap[child])) {
+            child++;
+        }
+        if (!taskDueBefore(taskDueHeap[child], task)) {
+            break;
+        }
+        dueHeapSet(pos, taskDueHeap[child]);
+        pos = child;
+    }
+    dueHeapSet(pos, task);
+}
+
+/*
+ * Restores heap order after lastExecutedAt or desiredPeriod of a task has changed
+ */
+static void dueHeapUpdate(cfTask_t *task)
+{
+    if (dueHeapContains(task)) {
+        dueHeapSiftUp(task->dueHeapPos);
+        dueHeapSiftDown(task->dueHeapPos);
+    }
+}
+
+static void dueHeapAdd(cfTask_t *task)
+{
+    dueHeapSet(taskDueHeapSize++, task);
+    dueHeapSiftUp(taskDueHeapSize - 1);
+}
+
+static void dueHeapRemove(cfTask_t *task)
+{
+    if (!dueHeapContains(task)) {
+        return;
+    }
+    const int pos = task->dueHeapPos;
+    cfTask_t *last = taskDueHeap[--taskDueHeapSize];
+    taskDueHeap[taskDueHeapSize] = NULL;
+    if (last != task) {
+        dueHeapSet(pos, last);
+        dueHeapUpdate(last);
+    }
+}
+
+static void eventArrayAdd(cfTask_t *task)
+{
+    taskEventArray[taskEventArraySize++] = task;
+}
+
+static void eventArrayRemove(cfTask_t *task)
+{
+    for (int ii = 0; ii < taskEventArraySize; ++ii) {
+        if (taskEventArray[ii] == task) {
+            memmove(&taskEventArray[ii], &taskEventArray[ii+1], sizeof(task) * (taskEventArraySize - ii - 1));
+            --taskEventArraySize;
+            return;
+        }
+    }
+}
+
+static void queueUpdatePositions(int fromPos)
+{
+    for (int ii = fromPos; ii < taskQueueSize; ++ii) {
+        taskQueueArray[ii]->queuePos = ii;
+    }
+}
+
 STATIC_UNIT_TESTED void queueClear(void)
 {
     memset(taskQueueArray, 0, sizeof(taskQueueArray));
     taskQueuePos = 0;
     taskQueueSize = 0;
+    memset(taskDueHeap, 0, sizeof(taskDueHeap));
+    taskDueHeapSize = 0;
+    taskEventArraySize = 0;
 }
 
 #ifdef UNIT_TEST
@@ -82,6 +209,12 @@ STATIC_UNIT_TESTED bool queueAdd(cfTask_t *task)
             memmove(&taskQueueArray[ii+1], &taskQueueArray[ii], sizeof(task) * (taskQueueSize - ii));
             taskQueueArray[ii] = task;
             ++taskQueueSize;
+            queueUpdatePositions(ii);
+            if (task->checkFunc) {
+                eventArrayAdd(task);
+            } else {
+                dueHeapAdd(task);
+            }
             return true;
         }
     }
@@ -94,6 +227,12 @@ STATIC_UNIT_TESTED bool queueRemove(cfTask_t *task)
         if (taskQueueArray[ii] == task) {
             memmove(&taskQueueArray[ii], &taskQueueArray[ii+1], sizeof(task) * (taskQueueSize - ii));
             --taskQueueSize;
+            queueUpdatePositions(ii);
+            if (task->checkFunc) {
+                eventArrayRemove(task);
+            } else {
+                dueHeapRemove(task);
+            }
             return true;
         }
     }
@@ -153,14 +292,60 @@ void getTaskInfo(cfTaskId_e taskId, cfTaskInfo_t * taskInfo)
     taskInfo->latestDeltaTime = cfTasks[taskId].taskLatestDeltaTime;
 }
 
+#ifdef USE_SCHEDULER_TASK_HISTOGRAM
+static void taskHistogramAdd(uint16_t *buckets, timeDelta_t value)
+{
+    const unsigned bucket = value <= 0 ? 0 : MIN(32 - __builtin_clz((uint32_t)value), TASK_HISTOGRAM_BUCKETS - 1);
+
+    if (buckets[bucket] == UINT16_MAX) {
+        // Halve all buckets to keep the shape of the distribution instead of saturating
+        for (int ii = 0; ii < TASK_HISTOGRAM_BUCKETS; ii++) {
+            buckets[ii] >>= 1;
+        }
+    }
+    buckets[bucket]++;
+}
+
+void getTaskHistogram(cfTaskId_e taskId, cfTaskHistogram_t *histogram)
+{
+    if (taskId < TASK_COUNT) {
+        *histogram = cfTasks[taskId].histogram;
+    } else {
+        memset(histogram, 0, sizeof(*histogram));
+    }
+}
+
+/*
+ * Returns upper bound (in us) of the bucket holding the given percentile, 0 if there are no samples
+ */
+timeUs_t taskHistogramPercentile(const uint16_t *buckets, uint8_t percentile)
+{
+    uint32_t total = 0;
+    for (int ii = 0; ii < TASK_HISTOGRAM_BUCKETS; ii++) {
+        total += buckets[ii];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    const uint32_t threshold = (total * MIN(percentile, 100u) + 99) / 100;
+    uint32_t sum = 0;
+    for (int ii = 0; ii < TASK_HISTOGRAM_BUCKETS; ii++) {
+        sum += buckets[ii];
+        if (sum >= MAX(threshold, 1u)) {
+            return ii == 0 ? 0 : (1 << ii) - 1;
+        }
+    }
+    return (1 << (TASK_HISTOGRAM_BUCKETS - 1)) - 1;
+}
+#endif
+
 void rescheduleTask(cfTaskId_e taskId, timeDelta_t newPeriodUs)
 {
-    if (taskId == TASK_SELF) {
-        cfTask_t *task = currentTask;
-        task->desiredPeriod = MAX(SCHEDULER_DELAY_LIMIT, newPeriodUs);  // Limit delay to 100us (10 kHz) to prevent scheduler clogging
-    } else if (taskId < TASK_COUNT) {
-        cfTask_t *task = &cfTasks[taskId];
+    if (taskId == TASK_SELF || taskId < TASK_COUNT) {
+        cfTask_t *task = taskId == TASK_SELF ? currentTask : &cfTasks[taskId];
         task->desiredPeriod = MAX(SCHEDULER_DELAY_LIMIT, newPeriodUs);  // Limit delay to 100us (10 kHz) to prevent scheduler clogging
+        dueHeapUpdate(task);
     }
 }
 
@@ -193,18 +378,102 @@ void schedulerResetTaskStatistics(cfTaskId_e taskId)
         currentTask->movingSumExecutionTime = 0;
         currentTask->totalExecutionTime = 0;
         currentTask->maxExecutionTime = 0;
+#ifdef USE_SCHEDULER_TASK_HISTOGRAM
+        memset(&currentTask->histogram, 0, sizeof(currentTask->histogram));
+#endif
     } else if (taskId < TASK_COUNT) {
         cfTasks[taskId].movingSumExecutionTime = 0;
         cfTasks[taskId].totalExecutionTime = 0;
+#ifdef USE_SCHEDULER_TASK_HISTOGRAM
+        memset(&cfTasks[taskId].histogram, 0, sizeof(cfTasks[taskId].histogram));
+#endif
     }
 }
 
+void schedulerSetDeadlineMode(schedulerDeadlineMode_e mode)
+{
+    schedulerDeadlineMode = mode;
+}
+
+uint32_t schedulerGetDeferredTaskCount(void)
+{
+    return schedulerDeferredTaskCount;
+}
+
 void schedulerInit(void)
 {
     queueClear();
     queueAdd(&cfTasks[TASK_SYSTEM]);
 }
 
+/*
+ * Same selection order as a linear scan of the priority sorted task queue:
+ * highest dynamic priority wins, on equal priority the task queued first wins
+ */
+static inline bool isTaskPreferred(const cfTask_t *task, const cfTask_t *selectedTask, uint16_t selectedTaskDynamicPriority)
+{
+    return task->dynamicPriority > selectedTaskDynamicPriority ||
+        (selectedTask && task->dynamicPriority == selectedTaskDynamicPriority && task->queuePos < selectedTask->queuePos);
+}
+
+// A task which is overdue by more than this number of periods is started even if it would delay a realtime task
+#define TASK_DEADLINE_MAX_AGE_CYCLES    2
+
+/*
+ * Checks if the task is predicted to finish before any realtime task becomes due
+ */
+static bool isTaskFittingRealtimeDeadline(const cfTask_t *task, timeUs_t currentTimeUs)
+{
+    if (task->taskAgeCycles > TASK_DEADLINE_MAX_AGE_CYCLES) {
+        return true;
+    }
+
+    const timeUs_t predictedExecutionTime = (schedulerDeadlineMode == SCHEDULER_DEADLINE_MAX) ?
+        task->maxExecutionTime : task->movingSumExecutionTime / TASK_MOVING_SUM_COUNT;
+
+    // Queue is sorted by static priority, realtime tasks are at its head
+    for (int ii = 0; ii < taskQueueSize && taskQueueArray[ii]->staticPriority == TASK_PRIORITY_REALTIME; ii++) {
+        const cfTask_t *realtimeTask = taskQueueArray[ii];
+        if (realtimeTask->checkFunc) {
+            continue;
+        }
+        const timeDelta_t timeToDeadline = (timeDelta_t)(realtimeTask->lastExecutedAt + realtimeTask->desiredPeriod - currentTimeUs);
+        if ((timeDelta_t)predictedExecutionTime > timeToDeadline) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Picks the preferred one of the waiting tasks which is predicted to finish before any realtime
+ * task becomes due. Tasks preferred over it are held back until they fit
+ */
+static cfTask_t *selectDeadlineFittingTask(cfTask_t * const *waitingTaskArray, int waitingTaskCount, timeUs_t currentTimeUs)
+{
+    cfTask_t *selectedTask = NULL;
+    uint16_t selectedTaskDynamicPriority = 0;
+
+    for (int ii = 0; ii < waitingTaskCount; ii++) {
+        cfTask_t *task = waitingTaskArray[ii];
+        if (isTaskPreferred(task, selectedTask, selectedTaskDynamicPriority) && isTaskFittingRealtimeDeadline(task, currentTimeUs)) {
+            selectedTaskDynamicPriority = task->dynamicPriority;
+            selectedTask = task;
+        }
+    }
+
+    // A task waiting for a window is rejected on every pass, count it once until it runs
+    for (int ii = 0; ii < waitingTaskCount; ii++) {
+        cfTask_t *task = waitingTaskArray[ii];
+        if (!task->deadlineDeferred && isTaskPreferred(task, selectedTask, selectedTaskDynamicPriority)) {
+            task->deadlineDeferred = true;
+            schedulerDeferredTaskCount++;
+        }
+    }
+
+    return selectedTask;
+}
+
 void FAST_CODE NOINLINE scheduler(void)
 {
     // Cache currentTime
@@ -217,63 +486,114 @@ void FAST_CODE NOINLINE scheduler(void)
 
     // Update task dynamic priorities
     uint16_t waitingTasks = 0;
-    for (cfTask_t *task = queueFirst(); task != NULL; task = queueNext()) {
-        // Task has checkFunc - event driven
-        if (task->checkFunc) {
-            const timeUs_t currentTimeBeforeCheckFuncCallUs = micros();
-
-            // Increase priority for event driven tasks
-            if (task->dynamicPriority > 0) {
-                task->taskAgeCycles = 1 + ((timeDelta_t)(currentTimeUs - task->lastSignaledAt)) / task->desiredPeriod;
-                task->dynamicPriority = 1 + task->staticPriority * task->taskAgeCycles;
-                waitingTasks++;
-            } else if (task->checkFunc(currentTimeBeforeCheckFuncCallUs, currentTimeBeforeCheckFuncCallUs - task->lastExecutedAt)) {
-                const timeUs_t checkFuncExecutionTime = micros() - currentTimeBeforeCheckFuncCallUs;
-                checkFuncMovingSumExecutionTime -= checkFuncMovingSumExecutionTime / TASK_MOVING_SUM_COUNT;
-                checkFuncMovingSumExecutionTime += checkFuncExecutionTime;
-                checkFuncTotalExecutionTime += checkFuncExecutionTime;   // time consumed by scheduler + task
-                checkFuncMaxExecutionTime = MAX(checkFuncMaxExecutionTime, checkFuncExecutionTime);
-                task->lastSignaledAt = currentTimeBeforeCheckFuncCallUs;
-                task->taskAgeCycles = 1;
-                task->dynamicPriority = 1 + task->staticPriority;
-                waitingTasks++;
-            } else {
-                task->taskAgeCycles = 0;
-            }
-        } else if (task->staticPriority == TASK_PRIORITY_REALTIME) {
+
+    // Waiting tasks other than the time driven realtime ones, the candidates when deadline mode holds back the selected one
+    cfTask_t *waitingTaskArray[TASK_COUNT];
+    int waitingTaskCount = 0;
+
+    // Event driven tasks have to be polled every cycle
+    for (int ii = 0; ii < taskEventArraySize; ++ii) {
+        cfTask_t *task = taskEventArray[ii];
+        const timeUs_t currentTimeBeforeCheckFuncCallUs = micros();
+
+        // Increase priority for event driven tasks
+        if (task->dynamicPriority > 0) {
+            task->taskAgeCycles = 1 + ((timeDelta_t)(currentTimeUs - task->lastSignaledAt)) / task->desiredPeriod;
+            task->dynamicPriority = 1 + task->staticPriority * task->taskAgeCycles;
+            waitingTasks++;
+        } else if (task->checkFunc(currentTimeBeforeCheckFuncCallUs, currentTimeBeforeCheckFuncCallUs - task->lastExecutedAt)) {
+            const timeUs_t checkFuncExecutionTime = micros() - currentTimeBeforeCheckFuncCallUs;
+            checkFuncMovingSumExecutionTime -= checkFuncMovingSumExecutionTime / TASK_MOVING_SUM_COUNT;
+            checkFuncMovingSumExecutionTime += checkFuncExecutionTime;
+            checkFuncTotalExecutionTime += checkFuncExecutionTime;   // time consumed by scheduler + task
+            checkFuncMaxExecutionTime = MAX(checkFuncMaxExecutionTime, checkFuncExecutionTime);
+            task->lastSignaledAt = currentTimeBeforeCheckFuncCallUs;
+            task->taskAgeCycles = 1;
+            task->dynamicPriority = 1 + task->staticPriority;
+            waitingTasks++;
+        } else {
+            task->taskAgeCycles = 0;
+        }
+
+        if (task->dynamicPriority > 0) {
+            waitingTaskArray[waitingTaskCount++] = task;
+        }
+
+        if (isTaskPreferred(task, selectedTask, selectedTaskDynamicPriority)) {
+            selectedTaskDynamicPriority = task->dynamicPriority;
+            selectedTask = task;
+        }
+    }
+
+    // Time driven tasks - walk only the part of the heap which is due. If a node is not due, none of its children are.
+    uint8_t dueStack[TASK_COUNT];
+    int dueStackSize = 0;
+    if (taskDueHeapSize > 0) {
+        dueStack[dueStackSize++] = 0;
+    }
+    while (dueStackSize > 0) {
+        const int pos = dueStack[--dueStackSize];
+        cfTask_t *task = taskDueHeap[pos];
+
+        if ((timeDelta_t)(currentTimeUs - taskDueAt(task)) < 0) {
+            continue;
+        }
+
+        const int child = 2 * pos + 1;
+        if (child < taskDueHeapSize) {
+            dueStack[dueStackSize++] = child;
+        }
+        if (child + 1 < taskDueHeapSize) {
+            dueStack[dueStackSize++] = child + 1;
+        }
+
+        waitingTasks++;
+        if (task->staticPriority == TASK_PRIORITY_REALTIME) {
             //realtime tasks take absolute priority. Any RT tasks that is overdue, should be execute immediately
-            if (((timeDelta_t)(currentTimeUs - task->lastExecutedAt)) > task->desiredPeriod) {
+            //if several RT tasks are overdue, the one queued last wins
+            if (!forcedRealTimeTask || task->queuePos > selectedTask->queuePos) {
                 selectedTaskDynamicPriority = task->dynamicPriority;
                 selectedTask = task;
-                waitingTasks++;
                 forcedRealTimeTask = true;
             }
         } else {
             // Task is time-driven, dynamicPriority is last execution age (measured in desiredPeriods)
             // Task age is calculated from last execution
             task->taskAgeCycles = ((timeDelta_t)(currentTimeUs - task->lastExecutedAt)) / task->desiredPeriod;
-            if (task->taskAgeCycles > 0) {
-                task->dynamicPriority = 1 + task->staticPriority * task->taskAgeCycles;
-                waitingTasks++;
-            }
-        }
+            task->dynamicPriority = 1 + task->staticPriority * task->taskAgeCycles;
+            waitingTaskArray[waitingTaskCount++] = task;
 
-        if (!forcedRealTimeTask && task->dynamicPriority > selectedTaskDynamicPriority) {
-            selectedTaskDynamicPriority = task->dynamicPriority;
-            selectedTask = task;
+            if (!forcedRealTimeTask && isTaskPreferred(task, selectedTask, selectedTaskDynamicPriority)) {
+                selectedTaskDynamicPriority = task->dynamicPriority;
+                selectedTask = task;
+            }
         }
     }
 
     totalWaitingTasksSamples++;
     totalWaitingTasks += waitingTasks;
 
+    // Deadline mode: do not start a task which would delay the next realtime task, start one that fits instead
+    if (selectedTask && !forcedRealTimeTask && schedulerDeadlineMode != SCHEDULER_DEADLINE_OFF && !isTaskFittingRealtimeDeadline(selectedTask, currentTimeUs)) {
+        selectedTask = selectDeadlineFittingTask(waitingTaskArray, waitingTaskCount, currentTimeUs);
+    }
+
     currentTask = selectedTask;
 
     if (selectedTask) {
         // Found a task that should be run
         selectedTask->taskLatestDeltaTime = (timeDelta_t)(currentTimeUs - selectedTask->lastExecutedAt);
+#ifdef USE_SCHEDULER_TASK_HISTOGRAM
+        if (selectedTask->checkFunc) {
+            taskHistogramAdd(selectedTask->histogram.startLatency, (timeDelta_t)(currentTimeUs - selectedTask->lastSignaledAt));
+        } else {
+            taskHistogramAdd(selectedTask->histogram.startLatency, selectedTask->taskLatestDeltaTime - selectedTask->desiredPeriod);
+        }
+#endif
         selectedTask->lastExecutedAt = currentTimeUs;
         selectedTask->dynamicPriority = 0;
+        selectedTask->deadlineDeferred = false;
+        dueHeapUpdate(selectedTask);
 
         // Execute task
         const timeUs_t currentTimeBeforeTaskCall = micros();
@@ -282,6 +602,9 @@ void FAST_CODE NOINLINE scheduler(void)
         selectedTask->movingSumExecutionTime += taskExecutionTime - selectedTask->movingSumExecutionTime / TASK_MOVING_SUM_COUNT;
         selectedTask->totalExecutionTime += taskExecutionTime;   // time consumed by scheduler + task
         selectedTask->maxExecutionTime = MAX(selectedTask->maxExecutionTime, taskExecutionTime);
+#ifdef USE_SCHEDULER_TASK_HISTOGRAM
+        taskHistogramAdd(selectedTask->histogram.executionTime, taskExecutionTime);
+#endif
     } 
     
     if (!selectedTask || forcedRealTimeTask) {
@@ -35,6 +35,20 @@ typedef struct {
     timeUs_t     averageExecutionTime;
 } cfCheckFuncInfo_t;
 
+typedef enum {
+    SCHEDULER_DEADLINE_OFF = 0,
+    SCHEDULER_DEADLINE_AVERAGE,     // predict task duration from its average execution time
+    SCHEDULER_DEADLINE_MAX,         // predict task duration from its maximum execution time
+} schedulerDeadlineMode_e;
+
+// Log2 buckets: bucket 0 holds 0us, bucket N holds [2^(N-1), 2^N) us, the last bucket holds everything above
+#define TASK_HISTOGRAM_BUCKETS  16
+
+typedef struct {
+    uint16_t     executionTime[TASK_HISTOGRAM_BUCKETS];
+    uint16_t     startLatency[TASK_HISTOGRAM_BUCKETS];  // actual start time minus the time the task became due
+} cfTaskHistogram_t;
+
 typedef struct {
     const char * taskName;
     bool         isEnabled;
@@ -51,6 +65,12 @@ typedef enum {
     TASK_SYSTEM = 0,
     TASK_PID,
     TASK_GYRO,
+#ifdef USE_PID_OUTER_LOOP
+    TASK_PID_OUTER,
+#endif
+#if defined(USE_BLACKBOX) && defined(USE_BLACKBOX_DEFERRED)
+    TASK_BLACKBOX,
+#endif
     TASK_RX,
     TASK_SERIAL,
     TASK_BATTERY,
@@ -144,11 +164,17 @@ typedef struct {
     timeUs_t lastExecutedAt;        // last time of invocation
     timeUs_t lastSignaledAt;        // time of invocation event for event-driven tasks
     timeDelta_t taskLatestDeltaTime;
+    uint8_t queuePos;               // position in the priority sorted task queue
+    uint8_t dueHeapPos;             // position in the due time heap of time driven tasks
+    bool deadlineDeferred;          // held back by deadline mode since it last ran
 
     /* Statistics */
     timeUs_t movingSumExecutionTime;  // moving sum over 32 samples
     timeUs_t maxExecutionTime;
     timeUs_t totalExecutionTime;    // total time consumed by task since boot
+#ifdef USE_SCHEDULER_TASK_HISTOGRAM
+    cfTaskHistogram_t histogram;
+#endif
 } cfTask_t;
 
 extern cfTask_t cfTasks[TASK_COUNT];
@@ -160,6 +186,13 @@ void rescheduleTask(cfTaskId_e taskId, timeDelta_t newPeriodUs);
 void setTaskEnabled(cfTaskId_e taskId, bool newEnabledState);
 timeDelta_t getTaskDeltaTime(cfTaskId_e taskId);
 void schedulerResetTaskStatistics(cfTaskId_e taskId);
+#ifdef USE_SCHEDULER_TASK_HISTOGRAM
+void getTaskHistogram(cfTaskId_e taskId, cfTaskHistogram_t *histogram);
+timeUs_t taskHistogramPercentile(const uint16_t *buckets, uint8_t percentile);
+#endif
+
+void schedulerSetDeadlineMode(schedulerDeadlineMode_e mode);
+uint32_t schedulerGetDeferredTaskCount(void);
 
 void schedulerInit(void);
 void scheduler(void);
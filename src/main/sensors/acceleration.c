@@ -85,6 +85,8 @@ static EXTENDED_FASTRAM void *accNotchFilter[XYZ_AXIS_COUNT];
 static EXTENDED_FASTRAM float fAccZero[XYZ_AXIS_COUNT];
 static EXTENDED_FASTRAM float fAccGain[XYZ_AXIS_COUNT];
 
+static sensorAlignment_t accAlignment;
+
 PG_REGISTER_WITH_RESET_FN(accelerometerConfig_t, accelerometerConfig, PG_ACCELEROMETER_CONFIG, 5);
 
 void pgResetFn_accelerometerConfig(accelerometerConfig_t *instance)
@@ -560,8 +562,7 @@ void accUpdate(void)
         applyAccelerationZero();  
     } 
 
-    applySensorAlignment(accADC, accADC, acc.dev.accAlign);
-    applyBoardAlignment(accADC);
+    applySensorAndBoardAlignment(&accAlignment, accADC, acc.dev.accAlign);
 
     // Calculate acceleration readings in G's
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
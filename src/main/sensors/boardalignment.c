@@ -22,6 +22,7 @@
 
 #include "platform.h"
 
+#include "common/linalg.h"
 #include "common/maths.h"
 #include "common/vector.h"
 #include "common/axis.h"
@@ -44,23 +45,18 @@
 
 #include "boardalignment.h"
 
-static bool standardBoardAlignment = true;     // board orientation correction
 static fpMat3_t boardRotMatrix;
 static fpMat3_t tailRotMatrix;
+static fpMat3_t boardTailRotMatrix;            // board alignment followed by tail sitter rotation
+static uint16_t boardAlignmentGeneration;      // bumped on every change, sensorAlignment_t rebuilds on mismatch
 
 // no template required since defaults are zero
 PG_REGISTER(boardAlignment_t, boardAlignment, PG_BOARD_ALIGNMENT, 0);
 
-static bool isBoardAlignmentStandard(const boardAlignment_t *boardAlignment)
-{
-    return !boardAlignment->rollDeciDegrees && !boardAlignment->pitchDeciDegrees && !boardAlignment->yawDeciDegrees;
-}
-
 void initBoardAlignment(void)
 {
-    standardBoardAlignment=isBoardAlignmentStandard(boardAlignment());
     fp_angles_t rotationAngles;
-    
+
     rotationAngles.angles.roll  = DECIDEGREES_TO_RADIANS(boardAlignment()->rollDeciDegrees );
     rotationAngles.angles.pitch = DECIDEGREES_TO_RADIANS(boardAlignment()->pitchDeciDegrees);
     rotationAngles.angles.yaw   = DECIDEGREES_TO_RADIANS(boardAlignment()->yawDeciDegrees  );
@@ -71,6 +67,13 @@ void initBoardAlignment(void)
     tailSitter_rotationAngles.angles.pitch = DECIDEGREES_TO_RADIANS(900);
     tailSitter_rotationAngles.angles.yaw   = DECIDEGREES_TO_RADIANS(0);
     rotationMatrixFromAngles(&tailRotMatrix, &tailSitter_rotationAngles);
+
+    mat3Multiply(&boardTailRotMatrix, &boardRotMatrix, &tailRotMatrix);
+
+    // Zero is left for sensorAlignment_t that were never built
+    if (++boardAlignmentGeneration == 0) {
+        boardAlignmentGeneration = 1;
+    }
 }
 
 void updateBoardAlignment(int16_t roll, int16_t pitch)
@@ -95,21 +98,11 @@ void applyTailSitterAlignment(fpVector3_t *fpVec)
     rotationMatrixRotateVector(fpVec, fpVec, &tailRotMatrix);
 }
 
-void applyBoardAlignment(float *vec)
-{
-    if (standardBoardAlignment && (!STATE(TAILSITTER))) {
-        return;
-    }
-
-    fpVector3_t fpVec = { .v = { vec[X], vec[Y], vec[Z] } };
-    rotationMatrixRotateVector(&fpVec, &fpVec, &boardRotMatrix);
-    applyTailSitterAlignment(&fpVec);
-    vec[X] = lrintf(fpVec.x);
-    vec[Y] = lrintf(fpVec.y);
-    vec[Z] = lrintf(fpVec.z);
-}
-
-void FAST_CODE applySensorAlignment(float * dest, float * src, uint8_t rotation)
+/*
+ * Multiples of 90 deg are axis swaps and sign changes. Inlined with a constant
+ * rotation each case reduces to moves and negations.
+ */
+static inline void alignVector(float * dest, const float * src, uint8_t rotation)
 {
     // Create a copy so we could use the same buffer for src & dest
     const float x = src[X];
@@ -160,3 +153,80 @@ void FAST_CODE applySensorAlignment(float * dest, float * src, uint8_t rotation)
         break;
     }
 }
+
+void FAST_CODE applySensorAlignment(float * dest, float * src, uint8_t rotation)
+{
+    alignVector(dest, src, rotation);
+}
+
+// Same convention as rotationMatrixRotateVector(), row i is the image of axis i
+static void sensorAlignmentMatrix(fpMat3_t *rmat, uint8_t rotation)
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        const float unit[XYZ_AXIS_COUNT] = { axis == X, axis == Y, axis == Z };
+        alignVector(rmat->m[axis], unit, rotation);
+    }
+}
+
+// Finds the sensor_align_e doing the same rotation as rmat, ALIGN_DEFAULT if there is none
+static uint8_t findAlignmentForMatrix(const fpMat3_t *rmat)
+{
+    for (uint8_t rotation = CW0_DEG; rotation <= CW270_DEG_FLIP; rotation++) {
+        fpMat3_t candidate;
+        bool match = true;
+
+        sensorAlignmentMatrix(&candidate, rotation);
+        for (int i = 0; i < 3 && match; i++) {
+            for (int j = 0; j < 3 && match; j++) {
+                match = fabsf(candidate.m[i][j] - rmat->m[i][j]) < 1e-3f;
+            }
+        }
+
+        if (match) {
+            return rotation;
+        }
+    }
+
+    return ALIGN_DEFAULT;
+}
+
+static void initSensorAlignment(sensorAlignment_t *alignment, uint8_t sensorRotation)
+{
+    fpMat3_t sensorRotMatrix;
+
+    sensorAlignmentMatrix(&sensorRotMatrix, sensorRotation);
+
+    mat3Multiply(&alignment->rotation[0].rmat, &sensorRotMatrix, &boardRotMatrix);
+    mat3Multiply(&alignment->rotation[1].rmat, &sensorRotMatrix, &boardTailRotMatrix);
+
+    for (int i = 0; i < 2; i++) {
+        alignment->rotation[i].rotation = findAlignmentForMatrix(&alignment->rotation[i].rmat);
+    }
+
+    alignment->sensorRotation = sensorRotation;
+    alignment->generation = boardAlignmentGeneration;
+}
+
+/*
+ * Sensor alignment followed by board alignment (and tail sitter rotation), same result
+ * as applySensorAlignment() and rotating by the board alignment matrix separately.
+ */
+void FAST_CODE applySensorAndBoardAlignment(sensorAlignment_t *alignment, float *vec, uint8_t sensorRotation)
+{
+    if (alignment->generation != boardAlignmentGeneration || alignment->sensorRotation != sensorRotation) {
+        initSensorAlignment(alignment, sensorRotation);
+    }
+
+    const alignmentRotation_t *rotation = &alignment->rotation[STATE(TAILSITTER) ? 1 : 0];
+
+    if (rotation->rotation != ALIGN_DEFAULT) {
+        alignVector(vec, vec, rotation->rotation);
+        return;
+    }
+
+    fpVector3_t fpVec = { .v = { vec[X], vec[Y], vec[Z] } };
+    rotationMatrixRotateVector(&fpVec, &fpVec, &rotation->rmat);
+    vec[X] = lrintf(fpVec.x);
+    vec[Y] = lrintf(fpVec.y);
+    vec[Z] = lrintf(fpVec.z);
+}
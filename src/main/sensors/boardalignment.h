@@ -28,8 +28,20 @@ typedef struct boardAlignment_s {
 
 PG_DECLARE(boardAlignment_t, boardAlignment);
 
+typedef struct alignmentRotation_s {
+    fpMat3_t rmat;
+    uint8_t rotation;       // sensor_align_e doing the same as rmat, ALIGN_DEFAULT if rmat has to be applied
+} alignmentRotation_t;
+
+// Sensor and board alignment folded into a single rotation, rebuilt when either changes
+typedef struct sensorAlignment_s {
+    alignmentRotation_t rotation[2];    // without and with tail sitter rotation
+    uint16_t generation;
+    uint8_t sensorRotation;
+} sensorAlignment_t;
+
 void initBoardAlignment(void);
 void updateBoardAlignment(int16_t roll, int16_t pitch);
 void applySensorAlignment(float * dest, float * src, uint8_t rotation);
-void applyBoardAlignment(float *vec);
+void applySensorAndBoardAlignment(sensorAlignment_t *alignment, float *vec, uint8_t sensorRotation);
 void applyTailSitterAlignment(fpVector3_t *vec);
\ No newline at end of file
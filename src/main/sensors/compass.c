@@ -81,6 +81,7 @@ PG_RESET_TEMPLATE(compassConfig_t, compassConfig,
 );
 
 static bool magUpdatedAtLeastOnce = false;
+static sensorAlignment_t magAlignment;
 
 bool compassDetect(magDev_t *dev, magSensor_e magHardwareToUse)
 {
@@ -479,8 +480,7 @@ void compassUpdate(timeUs_t currentTimeUs)
 
     } else {
         // On-board compass
-        applySensorAlignment(mag.magADC, mag.magADC, mag.dev.magAlign.onBoard);
-        applyBoardAlignment(mag.magADC);
+        applySensorAndBoardAlignment(&magAlignment, mag.magADC, mag.dev.magAlign.onBoard);
     }
 
     magUpdatedAtLeastOnce = true;
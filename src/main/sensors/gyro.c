@@ -28,6 +28,8 @@
 #include "common/axis.h"
 #include "common/calibration.h"
 #include "common/filter.h"
+#include "common/filter_cascade.h"
+#include "common/fir_decimator.h"
 #include "common/log.h"
 #include "common/maths.h"
 #include "common/utils.h"
@@ -77,9 +79,13 @@ FASTRAM gyro_t gyro; // gyro sensor object
 
 #define MAX_GYRO_COUNT 1
 
+// Decimation FIR cutoff limit as a fraction of the PID rate Nyquist frequency
+#define GYRO_DECIMATION_MAX_CUTOFF 0.9f
+
 STATIC_UNIT_TESTED gyroDev_t gyroDev[MAX_GYRO_COUNT];  // Not in FASTRAM since it may hold DMA buffers
 STATIC_FASTRAM int16_t gyroTemperature[MAX_GYRO_COUNT];
 STATIC_FASTRAM_UNIT_TESTED zeroCalibrationVector_t gyroCalibration[MAX_GYRO_COUNT];
+STATIC_FASTRAM sensorAlignment_t gyroAlignment;
 
 STATIC_FASTRAM filterApplyFnPtr gyroLpfApplyFn;
 STATIC_FASTRAM filter_t gyroLpfState[XYZ_AXIS_COUNT];
@@ -93,12 +99,46 @@ EXTENDED_FASTRAM gyroAnalyseState_t gyroAnalyseState;
 EXTENDED_FASTRAM dynamicGyroNotchState_t dynamicGyroNotchState;
 EXTENDED_FASTRAM secondaryDynamicGyroNotchState_t secondaryDynamicGyroNotchState;
 
+// Analysis is fed from gyroUpdate() with full rate samples instead of the PID rate filter chain
+STATIC_FASTRAM bool gyroAnalyseAtGyroRate;
+
 #endif
 
-PG_REGISTER_WITH_RESET_TEMPLATE(gyroConfig_t, gyroConfig, PG_GYRO_CONFIG, 8);
+#ifdef USE_GYRO_DECIMATION
+// Replaces LPF1 when the gyro is sampled faster than the PID loop runs
+EXTENDED_FASTRAM firDecimator_t gyroDecimator;
+STATIC_FASTRAM bool gyroDecimatorEnabled;
+#endif
+
+#ifdef USE_GYRO_FILTER_CASCADE
+// LPF2 and dynamic notch filters fused into one pass, RPM and Kalman filters are applied separately
+STATIC_FASTRAM filterCascade_t gyroFilterCascade;
+STATIC_FASTRAM bool gyroFilterCascadeEnabled;
+STATIC_FASTRAM int8_t gyroCascadeLpf2Stage;
+#ifdef USE_DYNAMIC_FILTERS
+STATIC_FASTRAM int8_t gyroCascadeDynamicNotchStage;
+STATIC_FASTRAM int8_t gyroCascadeSecondaryNotchStage;
+#endif
+
+static bool gyroBuildFilterCascade(void);
+#endif
+
+#ifdef USE_PID_OUTER_LOOP
+// Filtered gyro summed over the PID loops between two attitude updates when the outer loop runs slower
+STATIC_FASTRAM float gyroRateSum[XYZ_AXIS_COUNT];
+STATIC_FASTRAM uint16_t gyroRateSumCount;
+#endif
+
+PG_REGISTER_WITH_RESET_TEMPLATE(gyroConfig_t, gyroConfig, PG_GYRO_CONFIG, 12);
 
 PG_RESET_TEMPLATE(gyroConfig_t, gyroConfig,
     .gyro_anti_aliasing_lpf_hz = SETTING_GYRO_ANTI_ALIASING_LPF_HZ_DEFAULT,
+#ifdef USE_GYRO_DECIMATION
+    .gyroDecimationTaps = SETTING_GYRO_DECIMATION_TAPS_DEFAULT,
+#endif
+#ifdef USE_GYRO_FIFO
+    .gyroFifoBurst = SETTING_GYRO_FIFO_BURST_DEFAULT,
+#endif
     .looptime = SETTING_LOOPTIME_DEFAULT,
 #ifdef USE_DUAL_GYRO
     .gyro_to_use = SETTING_GYRO_TO_USE_DEFAULT,
@@ -114,7 +154,11 @@ PG_RESET_TEMPLATE(gyroConfig_t, gyroConfig,
     .dynamicGyroNotchEnabled = SETTING_DYNAMIC_GYRO_NOTCH_ENABLED_DEFAULT,
     .dynamicGyroNotchMode = SETTING_DYNAMIC_GYRO_NOTCH_MODE_DEFAULT,
     .dynamicGyroNotch3dQ = SETTING_DYNAMIC_GYRO_NOTCH_3D_Q_DEFAULT,
+    .dynamicGyroNotchFftWindow = SETTING_DYNAMIC_GYRO_NOTCH_FFT_WINDOW_DEFAULT,
+    .dynamicGyroNotchFftOverlap = SETTING_DYNAMIC_GYRO_NOTCH_FFT_OVERLAP_DEFAULT,
+    .dynamicGyroNotchAnalysisRate = SETTING_DYNAMIC_GYRO_NOTCH_ANALYSIS_RATE_DEFAULT,
 #endif
+    .notchUpdateHysteresis = SETTING_GYRO_NOTCH_UPDATE_HYSTERESIS_DEFAULT,
 #ifdef USE_GYRO_KALMAN
     .kalman_q = SETTING_SETPOINT_KALMAN_Q_DEFAULT,
     .kalmanEnabled = SETTING_SETPOINT_KALMAN_ENABLED_DEFAULT,
@@ -246,6 +290,25 @@ static void gyroInitFilters(void)
     //First gyro LPF running at full gyro frequency 8kHz
     initGyroFilter(&gyroLpfApplyFn, gyroLpfState, gyroConfig()->gyro_anti_aliasing_lpf_hz, getGyroLooptime());
 
+#ifdef USE_GYRO_DECIMATION
+    /*
+     * Gyro samples are brought down to the PID rate with a short FIR instead of LPF1.
+     * FIR cutoff is the anti-aliasing LPF cutoff, kept below the PID rate Nyquist frequency
+     */
+    gyroDecimatorEnabled = false;
+    if (gyroConfig()->gyroDecimationTaps > 0 && getGyroLooptime() < getLooptime()) {
+        const float cutoffMaxHz = GYRO_DECIMATION_MAX_CUTOFF * 0.5e6f / getLooptime();
+        float cutoffHz = cutoffMaxHz;
+        if (gyroConfig()->gyro_anti_aliasing_lpf_hz > 0) {
+            cutoffHz = MIN(gyroConfig()->gyro_anti_aliasing_lpf_hz, cutoffMaxHz);
+        }
+
+        firDecimatorInit(&gyroDecimator, gyroConfig()->gyroDecimationTaps, cutoffHz, getGyroLooptime());
+        gyroLpfApplyFn = nullFilterApply;
+        gyroDecimatorEnabled = true;
+    }
+#endif
+
     //Second gyro LPF runnig and PID frequency - this filter is dynamic when gyro_use_dyn_lpf = ON
     initGyroFilter(&gyroLpf2ApplyFn, gyroLpf2State, gyroConfig()->gyro_main_lpf_hz, getLooptime());
 
@@ -259,6 +322,7 @@ static void gyroInitFilters(void)
 bool gyroInit(void)
 {
     memset(&gyro, 0, sizeof(gyro));
+    memset(&gyroAlignment, 0, sizeof(gyroAlignment));
 
     // Set inertial sensor tag (for dual-gyro selection)
 #ifdef USE_DUAL_GYRO
@@ -284,10 +348,21 @@ bool gyroInit(void)
     gyroDev[0].lpf = GYRO_LPF_256HZ;
     gyroDev[0].requestedSampleIntervalUs = TASK_GYRO_LOOPTIME;
     gyroDev[0].sampleRateIntervalUs = TASK_GYRO_LOOPTIME;
+#ifdef USE_GYRO_FIFO
+    gyroDev[0].requestedFifoBurstSamples = MIN(gyroConfig()->gyroFifoBurst, GYRO_FIFO_MAX_SAMPLES);
+#endif
     gyroDev[0].initFn(&gyroDev[0]);
 
     // initFn will initialize sampleRateIntervalUs to actual gyro sampling rate (if driver supports it). Calculate target looptime using that value
     gyro.targetLooptime = gyroDev[0].sampleRateIntervalUs;
+
+    // Drivers without FIFO support leave readFifoFn unset and are read one sample at a time
+    gyro.samplesPerUpdate = 1;
+#ifdef USE_GYRO_FIFO
+    if (gyroDev[0].readFifoFn) {
+        gyro.samplesPerUpdate = gyroDev[0].requestedFifoBurstSamples;
+    }
+#endif
  
     gyroInitFilters();
 
@@ -297,12 +372,22 @@ bool gyroInit(void)
 
     secondaryDynamicGyroNotchFiltersInit(&secondaryDynamicGyroNotchState);
 
+    gyroAnalyseAtGyroRate = gyroConfig()->dynamicGyroNotchAnalysisRate == DYNAMIC_NOTCH_ANALYSIS_RATE_GYRO && getGyroLooptime() < getLooptime();
+
     gyroDataAnalyseStateInit(
         &gyroAnalyseState,
         gyroConfig()->dynamicGyroNotchMinHz,
-        getLooptime()
+        getLooptime(),
+        gyroAnalyseAtGyroRate ? getGyroLooptime() : getLooptime(),
+        gyroConfig()->dynamicGyroNotchFftWindow,
+        gyroConfig()->dynamicGyroNotchFftOverlap
     );
 #endif
+
+#ifdef USE_GYRO_FILTER_CASCADE
+    // Falls back to the per filter chain when the configured filters do not fit the cascade
+    gyroFilterCascadeEnabled = gyroBuildFilterCascade();
+#endif
     return true;
 }
 
@@ -372,17 +457,34 @@ STATIC_UNIT_TESTED void performGyroCalibration(gyroDev_t *dev, zeroCalibrationVe
  */
 void gyroGetMeasuredRotationRate(fpVector3_t *measuredRotationRate)
 {
+#ifdef USE_PID_OUTER_LOOP
+    // Mean rate since the last call, so a slower attitude update still integrates every PID loop sample
+    if (gyroRateSumCount > 1) {
+        const float scale = 1.0f / gyroRateSumCount;
+        for (int axis = 0; axis < 3; axis++) {
+            measuredRotationRate->v[axis] = DEGREES_TO_RADIANS(gyroRateSum[axis] * scale);
+            gyroRateSum[axis] = 0.0f;
+        }
+        gyroRateSumCount = 0;
+        return;
+    }
+
+    gyroRateSumCount = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        gyroRateSum[axis] = 0.0f;
+    }
+#endif
+
     for (int axis = 0; axis < 3; axis++) {
         measuredRotationRate->v[axis] = DEGREES_TO_RADIANS(gyro.gyroADCf[axis]);
     }
 }
 
-static bool FAST_CODE NOINLINE gyroUpdateAndCalibrate(gyroDev_t * gyroDev, zeroCalibrationVector_t * gyroCal, float * gyroADCf)
+/*
+ * Calibrates and converts the sample in gyroDev->gyroADCRaw. Returns false while calibration is in progress
+ */
+static bool FAST_CODE gyroCalibrateAndConvert(gyroDev_t * gyroDev, zeroCalibrationVector_t * gyroCal, float * gyroADCf)
 {
-
-    // range: +/- 8192; +/- 2000 deg/sec
-    if (gyroDev->readFn(gyroDev)) {
-
 #ifndef USE_IMU_FAKE // fixes Test Unit compilation error
     if (!gyroConfig()->init_gyro_cal_enabled) {
         // marks that the gyro calibration has ended
@@ -394,54 +496,58 @@ static bool FAST_CODE NOINLINE gyroUpdateAndCalibrate(gyroDev_t * gyroDev, zeroC
     }
 #endif
 
-        if (zeroCalibrationIsCompleteV(gyroCal)) {
-            float gyroADCtmp[XYZ_AXIS_COUNT];
+    if (zeroCalibrationIsCompleteV(gyroCal)) {
+        float gyroADCtmp[XYZ_AXIS_COUNT];
 
-            //Apply zero calibration with CMSIS DSP
-            arm_sub_f32(gyroDev->gyroADCRaw, gyroDev->gyroZero, gyroADCtmp, 3);
+        //Apply zero calibration with CMSIS DSP
+        arm_sub_f32(gyroDev->gyroADCRaw, gyroDev->gyroZero, gyroADCtmp, 3);
 
-            // Apply sensor alignment
-            applySensorAlignment(gyroADCtmp, gyroADCtmp, gyroDev->gyroAlign);
-            applyBoardAlignment(gyroADCtmp);
+        // Apply sensor alignment
+        applySensorAndBoardAlignment(&gyroAlignment, gyroADCtmp, gyroDev->gyroAlign);
 
-            // Convert to deg/s and store in unified data
-            arm_scale_f32(gyroADCtmp, gyroDev->scale, gyroADCf, 3);
+        // Convert to deg/s and store in unified data
+        arm_scale_f32(gyroADCtmp, gyroDev->scale, gyroADCf, 3);
 
-            return true;
-        } else {
-            performGyroCalibration(gyroDev, gyroCal);
+        return true;
+    } else {
+        performGyroCalibration(gyroDev, gyroCal);
 
-            // Reset gyro values to zero to prevent other code from using uncalibrated data
-            gyroADCf[X] = 0.0f;
-            gyroADCf[Y] = 0.0f;
-            gyroADCf[Z] = 0.0f;
+        // Reset gyro values to zero to prevent other code from using uncalibrated data
+        gyroADCf[X] = 0.0f;
+        gyroADCf[Y] = 0.0f;
+        gyroADCf[Z] = 0.0f;
 
-            return false;
-        }
+        return false;
+    }
+}
+
+static bool FAST_CODE NOINLINE gyroUpdateAndCalibrate(gyroDev_t * gyroDev, zeroCalibrationVector_t * gyroCal, float * gyroADCf)
+{
+    // range: +/- 8192; +/- 2000 deg/sec
+    if (gyroDev->readFn(gyroDev)) {
+        return gyroCalibrateAndConvert(gyroDev, gyroCal, gyroADCf);
     } else {
         // no gyro reading to process
         return false;
     }
 }
 
-void FAST_CODE NOINLINE gyroFilter(void)
+static void FAST_CODE gyroApplyFilterChain(void)
 {
-    if (!gyro.initialized) {
-        return;
-    }
+#ifdef USE_RPM_FILTER
+    rpmFilterGyroApply(gyro.gyroADCf);
+#endif
 
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
         float gyroADCf = gyro.gyroADCf[axis];
 
-#ifdef USE_RPM_FILTER
-        gyroADCf = rpmFilterGyroApply(axis, gyroADCf);
-#endif
-
         gyroADCf = gyroLpf2ApplyFn((filter_t *) &gyroLpf2State[axis], gyroADCf);
 
 #ifdef USE_DYNAMIC_FILTERS
         if (dynamicGyroNotchState.enabled) {
-            gyroDataAnalysePush(&gyroAnalyseState, axis, gyroADCf);
+            if (!gyroAnalyseAtGyroRate) {
+                gyroDataAnalysePush(&gyroAnalyseState, axis, gyroADCf);
+            }
             gyroADCf = dynamicGyroNotchFiltersApply(&dynamicGyroNotchState, axis, gyroADCf);
         }
 
@@ -462,9 +568,137 @@ void FAST_CODE NOINLINE gyroFilter(void)
 
         gyro.gyroADCf[axis] = gyroADCf;
     }
+}
+
+#ifdef USE_GYRO_FILTER_CASCADE
+/*
+ * Same filters in the same order as gyroApplyFilterChain(), the dynamic notch
+ * analysis is fed from the cascade tap placed after LPF2
+ */
+static void FAST_CODE gyroApplyFilterCascade(void)
+{
+    float tap[XYZ_AXIS_COUNT];
+
+#ifdef USE_RPM_FILTER
+    // RPM notches share coefficients between axes and run as a separate SIMD friendly bank
+    rpmFilterGyroApply(gyro.gyroADCf);
+#endif
+
+    filterCascadeApply(&gyroFilterCascade, gyro.gyroADCf, tap);
+
+#ifdef USE_DYNAMIC_FILTERS
+    if (dynamicGyroNotchState.enabled && !gyroAnalyseAtGyroRate) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            gyroDataAnalysePush(&gyroAnalyseState, axis, tap[axis]);
+        }
+    }
+#else
+    UNUSED(tap);
+#endif
+
+#ifdef USE_GYRO_KALMAN
+    if (gyroConfig()->kalmanEnabled) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            gyro.gyroADCf[axis] = gyroKalmanUpdate(axis, gyro.gyroADCf[axis]);
+        }
+    }
+#endif
+}
+
+#ifdef USE_DYNAMIC_FILTERS
+static void gyroFilterCascadeUpdateNotches(int axis)
+{
+    if (gyroCascadeDynamicNotchStage >= 0) {
+        for (int i = 0; i < DYN_NOTCH_PEAK_COUNT; i++) {
+            filterCascadeSetBiquad(&gyroFilterCascade, gyroCascadeDynamicNotchStage + i, axis, &dynamicGyroNotchState.filters[axis][i]);
+        }
+    }
+
+    if (gyroCascadeSecondaryNotchStage >= 0) {
+        filterCascadeSetBiquad(&gyroFilterCascade, gyroCascadeSecondaryNotchStage, axis, &secondaryDynamicGyroNotchState.filters[axis]);
+    }
+}
+#endif
+
+/*
+ * Has to be called once all gyro filters are initialized.
+ * Returns false when the configured filters do not fit the cascade
+ */
+static bool gyroBuildFilterCascade(void)
+{
+    filterCascadeInit(&gyroFilterCascade);
+    gyroCascadeLpf2Stage = -1;
+
+    if (gyroLpf2ApplyFn != nullFilterApply) {
+        gyroCascadeLpf2Stage = filterCascadeAddStage(&gyroFilterCascade);
+        if (gyroCascadeLpf2Stage < 0) {
+            return false;
+        }
+
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            filterCascadeSetPt1(&gyroFilterCascade, gyroCascadeLpf2Stage, axis, &gyroLpf2State[axis].pt1);
+        }
+    }
+
+    filterCascadeSetTap(&gyroFilterCascade);
+
+#ifdef USE_DYNAMIC_FILTERS
+    gyroCascadeDynamicNotchStage = -1;
+    gyroCascadeSecondaryNotchStage = -1;
+
+    if (dynamicGyroNotchState.enabled) {
+        gyroCascadeDynamicNotchStage = gyroFilterCascade.stageCount;
+        for (int i = 0; i < DYN_NOTCH_PEAK_COUNT; i++) {
+            if (filterCascadeAddStage(&gyroFilterCascade) < 0) {
+                return false;
+            }
+        }
+    }
+
+    if (secondaryDynamicGyroNotchState.enabled) {
+        gyroCascadeSecondaryNotchStage = filterCascadeAddStage(&gyroFilterCascade);
+        if (gyroCascadeSecondaryNotchStage < 0) {
+            return false;
+        }
+    }
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gyroFilterCascadeUpdateNotches(axis);
+    }
+#endif
+
+    return true;
+}
+
+#endif
+
+void FAST_CODE NOINLINE gyroFilter(void)
+{
+    if (!gyro.initialized) {
+        return;
+    }
+
+#ifdef USE_GYRO_DECIMATION
+    if (gyroDecimatorEnabled) {
+        firDecimatorApply(&gyroDecimator, gyro.gyroADCf);
+    }
+#endif
+
+#ifdef USE_GYRO_FILTER_CASCADE
+    if (gyroFilterCascadeEnabled) {
+        gyroApplyFilterCascade();
+    } else {
+        gyroApplyFilterChain();
+    }
+#else
+    gyroApplyFilterChain();
+#endif
 
 #ifdef USE_DYNAMIC_FILTERS
     if (dynamicGyroNotchState.enabled) {
+        if (!gyroAnalyseAtGyroRate) {
+            gyroDataAnalyseCollect(&gyroAnalyseState);
+        }
         gyroDataAnalyse(&gyroAnalyseState);
 
         if (gyroAnalyseState.filterUpdateExecute) {
@@ -480,11 +714,84 @@ void FAST_CODE NOINLINE gyroFilter(void)
                 gyroAnalyseState.centerFrequency[gyroAnalyseState.filterUpdateAxis]
             );
 
+#ifdef USE_GYRO_FILTER_CASCADE
+            if (gyroFilterCascadeEnabled) {
+                gyroFilterCascadeUpdateNotches(gyroAnalyseState.filterUpdateAxis);
+            }
+#endif
+
+        }
+    }
+#endif
+
+#ifdef USE_PID_OUTER_LOOP
+    // Samples beyond the counter range are dropped from both sum and count, the mean stays exact
+    if (gyroRateSumCount < UINT16_MAX) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            gyroRateSum[axis] += gyro.gyroADCf[axis];
+        }
+        gyroRateSumCount++;
+    }
+#endif
+}
+
+/*
+ * Processing done for every gyro sample at full gyro rate, input is the calibrated sample in gyro.gyroADCf
+ */
+static void FAST_CODE gyroApplyFirstStage(void)
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        // At this point gyro.gyroADCf contains unfiltered gyro value [deg/s]
+        float gyroADCf = gyro.gyroADCf[axis];
+
+        // Set raw gyro for blackbox purposes
+        gyro.gyroRaw[axis] = gyroADCf;
+
+        /*
+         * First gyro LPF is the only filter applied with the full gyro sampling speed
+         */
+        gyroADCf = gyroLpfApplyFn((filter_t *) &gyroLpfState[axis], gyroADCf);
+
+        gyro.gyroADCf[axis] = gyroADCf;
+    }
+
+#ifdef USE_GYRO_DECIMATION
+    if (gyroDecimatorEnabled) {
+        firDecimatorPush(&gyroDecimator, gyro.gyroADCf);
+    }
+#endif
+
+#ifdef USE_DYNAMIC_FILTERS
+    if (gyroAnalyseAtGyroRate && dynamicGyroNotchState.enabled) {
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            gyroDataAnalysePush(&gyroAnalyseState, axis, gyro.gyroADCf[axis]);
         }
+        gyroDataAnalyseCollect(&gyroAnalyseState);
     }
 #endif
+}
+
+#ifdef USE_GYRO_FIFO
+/*
+ * All samples queued in the sensor FIFO are read in one bus transaction and each of them
+ * goes through calibration and the full rate stage, gyro.gyroADCf ends with the newest one
+ */
+static void FAST_CODE gyroUpdateFromFifo(gyroDev_t *dev, zeroCalibrationVector_t *gyroCal)
+{
+    float samples[GYRO_FIFO_MAX_SAMPLES][XYZ_AXIS_COUNT];
+    const uint8_t sampleCount = dev->readFifoFn(dev, samples, GYRO_FIFO_MAX_SAMPLES);
 
+    for (int i = 0; i < sampleCount; i++) {
+        dev->gyroADCRaw[X] = samples[i][X];
+        dev->gyroADCRaw[Y] = samples[i][Y];
+        dev->gyroADCRaw[Z] = samples[i][Z];
+
+        if (gyroCalibrateAndConvert(dev, gyroCal, gyro.gyroADCf)) {
+            gyroApplyFirstStage();
+        }
+    }
 }
+#endif
 
 void FAST_CODE NOINLINE gyroUpdate(void)
 {
@@ -499,24 +806,18 @@ void FAST_CODE NOINLINE gyroUpdate(void)
         return;
     }
 
-    if (!gyroUpdateAndCalibrate(&gyroDev[0], &gyroCalibration[0], gyro.gyroADCf)) {
+#ifdef USE_GYRO_FIFO
+    if (gyroDev[0].readFifoFn) {
+        gyroUpdateFromFifo(&gyroDev[0], &gyroCalibration[0]);
         return;
     }
+#endif
 
-    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
-        // At this point gyro.gyroADCf contains unfiltered gyro value [deg/s]
-        float gyroADCf = gyro.gyroADCf[axis];
-
-        // Set raw gyro for blackbox purposes
-        gyro.gyroRaw[axis] = gyroADCf;
-
-        /*
-         * First gyro LPF is the only filter applied with the full gyro sampling speed
-         */
-        gyroADCf = gyroLpfApplyFn((filter_t *) &gyroLpfState[axis], gyroADCf);
-
-        gyro.gyroADCf[axis] = gyroADCf;
+    if (!gyroUpdateAndCalibrate(&gyroDev[0], &gyroCalibration[0], gyro.gyroADCf)) {
+        return;
     }
+
+    gyroApplyFirstStage();
 }
 
 bool gyroReadTemperature(void)
@@ -554,6 +855,12 @@ int16_t gyroRateDps(int axis)
 void gyroUpdateDynamicLpf(float cutoffFreq) {
     for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
         pt1FilterUpdateCutoff(&gyroLpf2State[axis].pt1, cutoffFreq);
+
+#ifdef USE_GYRO_FILTER_CASCADE
+        if (gyroFilterCascadeEnabled && gyroCascadeLpf2Stage >= 0) {
+            filterCascadeSetPt1(&gyroFilterCascade, gyroCascadeLpf2Stage, axis, &gyroLpf2State[axis].pt1);
+        }
+#endif
     }
 }
 
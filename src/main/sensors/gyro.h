@@ -52,9 +52,28 @@ typedef enum {
     DYNAMIC_NOTCH_MODE_3D
 } dynamicGyroNotchMode_e;
 
+typedef enum {
+    DYNAMIC_NOTCH_FFT_WINDOW_64 = 0,
+    DYNAMIC_NOTCH_FFT_WINDOW_128,
+    DYNAMIC_NOTCH_FFT_WINDOW_256
+} dynamicGyroNotchFftWindow_e;
+
+typedef enum {
+    DYNAMIC_NOTCH_FFT_OVERLAP_MAX = 0,
+    DYNAMIC_NOTCH_FFT_OVERLAP_75,
+    DYNAMIC_NOTCH_FFT_OVERLAP_50,
+    DYNAMIC_NOTCH_FFT_OVERLAP_NONE
+} dynamicGyroNotchFftOverlap_e;
+
+typedef enum {
+    DYNAMIC_NOTCH_ANALYSIS_RATE_PID = 0,
+    DYNAMIC_NOTCH_ANALYSIS_RATE_GYRO
+} dynamicGyroNotchAnalysisRate_e;
+
 typedef struct gyro_s {
     bool initialized;
     uint32_t targetLooptime;
+    uint8_t samplesPerUpdate;               // sensor samples processed by one gyroUpdate() call
     float gyroADCf[XYZ_AXIS_COUNT];
     float gyroRaw[XYZ_AXIS_COUNT];
 } gyro_t;
@@ -65,6 +84,12 @@ extern dynamicGyroNotchState_t dynamicGyroNotchState;
 typedef struct gyroConfig_s {
     uint16_t looptime;                      // imu loop time in us
     uint16_t  gyro_anti_aliasing_lpf_hz;
+#ifdef USE_GYRO_DECIMATION
+    uint8_t gyroDecimationTaps;             // FIR length of the gyro to PID rate decimation, 0 disables
+#endif
+#ifdef USE_GYRO_FIFO
+    uint8_t gyroFifoBurst;                  // samples drained from the sensor FIFO per gyro task run, 0 disables
+#endif
 #ifdef USE_DUAL_GYRO
     uint8_t  gyro_to_use;
 #endif
@@ -79,7 +104,11 @@ typedef struct gyroConfig_s {
     uint8_t dynamicGyroNotchEnabled;
     uint8_t dynamicGyroNotchMode;
     uint16_t dynamicGyroNotch3dQ;
+    uint8_t dynamicGyroNotchFftWindow;
+    uint8_t dynamicGyroNotchFftOverlap;
+    uint8_t dynamicGyroNotchAnalysisRate;
 #endif
+    uint8_t notchUpdateHysteresis;          // [0.1Hz] shared by dynamic and RPM notches
 #ifdef USE_GYRO_KALMAN
     uint16_t kalman_q;
     uint8_t kalmanEnabled;
@@ -61,6 +61,11 @@
 // This is the shortest period in microseconds that the scheduler will allow
 #define SCHEDULER_DELAY_LIMIT           10
 
+#ifdef USE_DEV_TOOLS
+// Per-task log2 histograms of execution time and start latency, 64 bytes of RAM per task
+#define USE_SCHEDULER_TASK_HISTOGRAM
+#endif
+
 #if defined(MAG_I2C_BUS) || defined(VCM5883_I2C_BUS)
 #define USE_MAG_VCM5883
 #endif
@@ -75,6 +80,15 @@
 #define USE_RATE_DYNAMICS
 #define USE_EXTENDED_CMS_MENUS
 
+// Flight loop extensions, left out where flash and RAM are short
+#if (MCU_FLASH_SIZE > 512)
+#define USE_GYRO_FILTER_CASCADE
+#define USE_GYRO_DECIMATION
+#define USE_GYRO_FIFO
+#define USE_PID_OUTER_LOOP
+#define USE_NAV_EKF
+#endif
+
 // Allow default rangefinders
 #define USE_RANGEFINDER
 #define USE_RANGEFINDER_MSP
@@ -200,6 +214,12 @@
 #define USE_24CHANNELS
 #define MAX_MIXER_PROFILE_COUNT 2
 #define USE_SMARTPORT_MASTER
+#define USE_BLACKBOX_DEFERRED
+#define USE_BLACKBOX_COMPRESSION
+#if !defined(STM32F4)
+// 16KB of RAM for the pre-trigger buffer, F405 can't spare it
+#define USE_BLACKBOX_PRETRIGGER
+#endif
 #elif !defined(STM32F7)
 #define MAX_MIXER_PROFILE_COUNT 1
 #endif
@@ -0,0 +1,269 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Blackbox write throughput: P-frame like records are encoded with the
+ * blackbox_encoding.c writers and handed to a serial port, either one byte at a
+ * time through the device dispatch blackboxWrite() used to do, or through the
+ * staging buffer and blackboxDeviceFlush() once per frame.
+ *
+ * The port is either UART like (no bulk write, bytes go one by one into the Tx
+ * ring) or VCP/TCP like (bulk write into the Tx ring). Reports encoded bytes per
+ * microsecond and cycles per frame, and fails if the byte streams differ.
+ *
+ * Usage: blackbox_write_benchmark [-n frames]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "blackbox/blackbox.h"
+    #include "blackbox/blackbox_encoding.h"
+    #include "blackbox/blackbox_io.h"
+
+    #include "config/parameter_group.h"
+    #include "config/parameter_group_ids.h"
+
+    #include "drivers/serial.h"
+
+    PG_REGISTER(blackboxConfig_t, blackboxConfig, PG_BLACKBOX_CONFIG, 0);
+
+    extern serialPort_t *blackboxPort;
+}
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC
+#endif
+
+#define FRAME_FIELDS        32
+#define TX_BUFFER_SIZE      4096
+
+typedef struct {
+    const char *name;
+    double bytesPerUs;
+    double cyclesPerFrame;
+    uint32_t hash;
+} writeResult_t;
+
+static uint8_t txBuffer[TX_BUFFER_SIZE];
+static uint32_t txHash;
+
+static int32_t (*frames)[FRAME_FIELDS];
+static uint64_t encodedBytes;
+
+// Tx ring of a port that is drained as fast as it is filled, FNV-1a of everything written
+static void txPut(serialPort_t *instance, uint8_t ch)
+{
+    instance->txBuffer[instance->txBufferHead] = ch;
+    instance->txBufferHead = (instance->txBufferHead + 1) % instance->txBufferSize;
+    txHash = (txHash ^ ch) * 16777619u;
+}
+
+static void uartWrite(serialPort_t *instance, uint8_t ch)
+{
+    txPut(instance, ch);
+}
+
+static void bulkWriteBuf(serialPort_t *instance, const void *data, int count)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    while (count > 0) {
+        const int chunk = std::min(count, (int)(instance->txBufferSize - instance->txBufferHead));
+        memcpy((uint8_t *)instance->txBuffer + instance->txBufferHead, p, chunk);
+        for (int i = 0; i < chunk; i++) {
+            txHash = (txHash ^ p[i]) * 16777619u;
+        }
+        instance->txBufferHead = (instance->txBufferHead + chunk) % instance->txBufferSize;
+        p += chunk;
+        count -= chunk;
+    }
+}
+
+static struct serialPortVTable uartVTable;
+static struct serialPortVTable bulkVTable;
+
+// The device dispatch blackboxWrite() did for every byte before staging
+static void __attribute__((noinline)) blackboxWritePerByte(uint8_t value)
+{
+    switch (blackboxConfig()->device) {
+    case BLACKBOX_DEVICE_SERIAL:
+    default:
+        serialWrite(blackboxPort, value);
+        break;
+    }
+}
+
+// Roughly the field mix of writeInterframe()
+static void encodeFrame(int32_t *fields)
+{
+    blackboxWrite('P');
+    blackboxWriteSignedVB(fields[0]);
+    blackboxWriteSignedVBArray(&fields[1], 3);
+    blackboxWriteTag2_3S32(&fields[4]);
+    blackboxWriteSignedVBArray(&fields[7], 3);
+    blackboxWriteTag8_4S16(&fields[10]);
+    blackboxWriteSignedVBArray(&fields[14], 6);
+    blackboxWriteTag8_8SVB(&fields[20], 8);
+    blackboxWriteSignedVBArray(&fields[28], 4);
+}
+
+template <typename Fn>
+static writeResult_t timeWriter(const char *name, const struct serialPortVTable *vTable, Fn fn, int count)
+{
+    static serialPort_t port;
+    writeResult_t result = { name, 0, 0, 0 };
+
+    memset(&port, 0, sizeof(port));
+    port.vTable = vTable;
+    port.txBuffer = txBuffer;
+    port.txBufferSize = TX_BUFFER_SIZE;
+    blackboxPort = &port;
+    blackboxWriteBuffer.count = 0;
+    txHash = 2166136261u;
+
+    const auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+    const uint64_t startCycles = __rdtsc();
+#endif
+
+    for (int i = 0; i < count; i++) {
+        fn(frames[i]);
+    }
+
+#ifdef HAVE_RDTSC
+    result.cyclesPerFrame = (double)(__rdtsc() - startCycles) / count;
+#endif
+    result.bytesPerUs = encodedBytes / std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    result.hash = txHash;
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 200000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            count = std::max(1, atoi(optarg));
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n frames]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    // Deltas as a P-frame sees them, mostly small with the odd large one
+    frames = (int32_t (*)[FRAME_FIELDS])malloc(sizeof(*frames) * count);
+    uint32_t rng = 2463534242u;
+    for (int i = 0; i < count; i++) {
+        for (int f = 0; f < FRAME_FIELDS; f++) {
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            const int32_t range = (rng & 0xF000) == 0 ? 4000 : 60;
+            frames[i][f] = (int32_t)(rng % (2 * range + 1)) - range;
+        }
+    }
+
+    blackboxConfigMutable()->device = BLACKBOX_DEVICE_SERIAL;
+    uartVTable.serialWrite = uartWrite;
+    bulkVTable.serialWrite = uartWrite;
+    bulkVTable.writeBuf = bulkWriteBuf;
+
+    // Frame sizes, also warms up the caches
+    encodedBytes = 0;
+    for (int i = 0; i < count; i++) {
+        blackboxWriteBuffer.count = 0;
+        encodeFrame(frames[i]);
+        encodedBytes += blackboxWriteBuffer.count;
+    }
+    blackboxWriteBuffer.count = 0;
+
+    const auto perByte = [](int32_t *fields) {
+        encodeFrame(fields);
+        for (int i = 0; i < blackboxWriteBuffer.count; i++) {
+            blackboxWritePerByte(blackboxWriteBuffer.data[i]);
+        }
+        blackboxWriteBuffer.count = 0;
+    };
+    const auto staged = [](int32_t *fields) {
+        encodeFrame(fields);
+        blackboxDeviceFlush();
+    };
+
+    writeResult_t results[] = {
+        timeWriter("encode only", &bulkVTable, [](int32_t *fields) { encodeFrame(fields); blackboxWriteBuffer.count = 0; }, count),
+        timeWriter("uart per byte (before)", &uartVTable, perByte, count),
+        timeWriter("uart staged", &uartVTable, staged, count),
+        timeWriter("bulk per byte (before)", &bulkVTable, perByte, count),
+        timeWriter("bulk staged", &bulkVTable, staged, count),
+    };
+
+    printf("%d frames, %.1f bytes per frame\n", count, (double)encodedBytes / count);
+    printf("%-24s %10s %12s\n", "", "bytes/us", "cycles/frame");
+
+    bool sameStream = true;
+    for (const writeResult_t &result : results) {
+        // The encode only row writes nothing to the port
+        const bool ok = &result == &results[0] || result.hash == results[1].hash;
+        printf("%-24s %10.1f %12.1f%s\n", result.name, result.bytesPerUs, result.cyclesPerFrame, ok ? "" : "  STREAM DIFFERS");
+        sameStream = sameStream && ok;
+    }
+
+    free(frames);
+
+    return sameStream ? 0 : 1;
+}
+
+// STUBS
+
+extern "C" {
+void serialWrite(serialPort_t *instance, uint8_t ch)
+{
+    instance->vTable->serialWrite(instance, ch);
+}
+
+void serialWriteBuf(serialPort_t *instance, const uint8_t *data, int count)
+{
+    instance->vTable->writeBuf(instance, data, count);
+}
+
+bool isSerialTransmitBufferEmpty(const serialPort_t *instance)
+{
+    return instance->txBufferHead == instance->txBufferTail;
+}
+
+uint32_t serialTxBytesFree(const serialPort_t *instance)
+{
+    return instance->txBufferSize - 1;
+}
+}
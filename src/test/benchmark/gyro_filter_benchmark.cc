@@ -0,0 +1,275 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the per filter gyro chain (function pointer per stage, as in
+ * gyroApplyFilterChain) with the fused path of gyroApplyFilterCascade (RPM
+ * biquad bank followed by the filter cascade) on the same filter set:
+ * RPM notches, PT1 LPF2, 3 dynamic notches and the secondary notch.
+ *
+ * Reports cycles and nanoseconds per 3 axis gyro sample and the largest output
+ * difference between both implementations.
+ *
+ * Usage: gyro_filter_benchmark [-n samples] [-m motors] [-r rpm_harmonics] [-l looptime_us]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC
+#endif
+
+extern "C" {
+    #include "platform.h"
+    #include "common/axis.h"
+    #include "common/biquad_bank.h"
+    #include "common/filter.h"
+    #include "common/filter_cascade.h"
+}
+
+#define MAX_MOTORS          8
+#define MAX_HARMONICS       3
+#define DYN_NOTCH_COUNT     3
+
+// Mirrors the firmware filter state layout, every stage keeps its own state struct
+static biquadFilter_t rpmFilters[XYZ_AXIS_COUNT][MAX_MOTORS][MAX_HARMONICS];
+static filterApplyFnPtr lpf2ApplyFn;
+static filter_t lpf2State[XYZ_AXIS_COUNT];
+static biquadFilter_t dynNotchFilters[XYZ_AXIS_COUNT][DYN_NOTCH_COUNT];
+static filterApplyFnPtr dynNotchApplyFn[XYZ_AXIS_COUNT][DYN_NOTCH_COUNT];
+static biquadFilter_t secondaryNotchFilters[XYZ_AXIS_COUNT];
+static filterApplyFnPtr secondaryNotchApplyFn[XYZ_AXIS_COUNT];
+
+typedef float (*rpmApplyFnPtr)(uint8_t axis, float input);
+static rpmApplyFnPtr rpmApplyFn;
+
+static int motorCount = 4;
+static int harmonics = 1;
+
+static biquadBank_t rpmBank;
+static filterCascade_t cascade;
+
+static float rpmApply(uint8_t axis, float input)
+{
+    float output = input;
+
+    for (int motor = 0; motor < motorCount; motor++) {
+        for (int harmonicIndex = 0; harmonicIndex < harmonics; harmonicIndex++) {
+            output = biquadFilterApplyDF1(&rpmFilters[axis][motor][harmonicIndex], output);
+        }
+    }
+
+    return output;
+}
+
+static __attribute__((noinline)) void chainApply(float sample[XYZ_AXIS_COUNT], float tap[XYZ_AXIS_COUNT])
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        float value = sample[axis];
+
+        value = rpmApplyFn(axis, value);
+        value = lpf2ApplyFn(&lpf2State[axis], value);
+        tap[axis] = value;
+
+        for (int i = 0; i < DYN_NOTCH_COUNT; i++) {
+            value = dynNotchApplyFn[axis][i](&dynNotchFilters[axis][i], value);
+        }
+
+        value = secondaryNotchApplyFn[axis](&secondaryNotchFilters[axis], value);
+
+        sample[axis] = value;
+    }
+}
+
+static void initFilters(uint32_t looptimeUs)
+{
+    const float dynNotchHz[DYN_NOTCH_COUNT] = { 180, 260, 340 };
+
+    rpmApplyFn = rpmApply;
+    lpf2ApplyFn = (filterApplyFnPtr)pt1FilterApply;
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        for (int motor = 0; motor < motorCount; motor++) {
+            for (int harmonicIndex = 0; harmonicIndex < harmonics; harmonicIndex++) {
+                biquadFilterInit(&rpmFilters[axis][motor][harmonicIndex], (120 + 7 * motor) * (harmonicIndex + 1), looptimeUs, 5.0f, FILTER_NOTCH);
+            }
+        }
+
+        pt1FilterInit(&lpf2State[axis].pt1, 110, looptimeUs * 1e-6f);
+
+        for (int i = 0; i < DYN_NOTCH_COUNT; i++) {
+            biquadFilterInit(&dynNotchFilters[axis][i], dynNotchHz[i] + 10 * axis, looptimeUs, 2.5f, FILTER_NOTCH);
+            dynNotchApplyFn[axis][i] = (filterApplyFnPtr)biquadFilterApplyDF1;
+        }
+
+        biquadFilterInit(&secondaryNotchFilters[axis], 200 + 10 * axis, looptimeUs, 2.0f, FILTER_NOTCH);
+        secondaryNotchApplyFn[axis] = (filterApplyFnPtr)biquadFilterApplyDF1;
+    }
+
+    // RPM notches have the same coefficients on all axes
+    biquadBankInit(&rpmBank);
+    for (int motor = 0; motor < motorCount; motor++) {
+        for (int harmonicIndex = 0; harmonicIndex < harmonics; harmonicIndex++) {
+            biquadBankAddStage(&rpmBank, &rpmFilters[X][motor][harmonicIndex]);
+        }
+    }
+
+    // Same stage order as gyroBuildFilterCascade()
+    filterCascadeInit(&cascade);
+    const int lpf2Stage = filterCascadeAddStage(&cascade);
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        filterCascadeSetPt1(&cascade, lpf2Stage, axis, &lpf2State[axis].pt1);
+    }
+
+    filterCascadeSetTap(&cascade);
+
+    for (int i = 0; i < DYN_NOTCH_COUNT; i++) {
+        const int stage = filterCascadeAddStage(&cascade);
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            filterCascadeSetBiquad(&cascade, stage, axis, &dynNotchFilters[axis][i]);
+        }
+    }
+
+    const int secondaryStage = filterCascadeAddStage(&cascade);
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        filterCascadeSetBiquad(&cascade, secondaryStage, axis, &secondaryNotchFilters[axis]);
+    }
+}
+
+// Gyro like signal: slow stick motion, motor noise lines and broadband noise
+static void generateInput(float *input, int sampleCount, uint32_t looptimeUs)
+{
+    uint32_t rng = 2463534242u;
+    const float dt = looptimeUs * 1e-6f;
+
+    for (int n = 0; n < sampleCount; n++) {
+        const float t = n * dt;
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            rng ^= rng << 13;
+            rng ^= rng >> 17;
+            rng ^= rng << 5;
+            const float noise = ((float)(rng & 0xFFFF) / 0xFFFF - 0.5f) * 20.0f;
+            input[n * XYZ_AXIS_COUNT + axis] = 300.0f * sinf(2 * M_PIf * (1.5f + axis) * t)
+                + 40.0f * sinf(2 * M_PIf * 127.0f * t)
+                + 25.0f * sinf(2 * M_PIf * 265.0f * t)
+                + noise;
+        }
+    }
+}
+
+typedef struct {
+    double cyclesPerSample;
+    double nsPerSample;
+} runResult_t;
+
+template <typename ApplyFn>
+static runResult_t runFilter(ApplyFn apply, const float *input, float *output, int sampleCount)
+{
+    float sample[XYZ_AXIS_COUNT];
+    float tap[XYZ_AXIS_COUNT];
+
+    const auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+    const uint64_t startCycles = __rdtsc();
+#endif
+
+    for (int n = 0; n < sampleCount; n++) {
+        sample[X] = input[n * XYZ_AXIS_COUNT + X];
+        sample[Y] = input[n * XYZ_AXIS_COUNT + Y];
+        sample[Z] = input[n * XYZ_AXIS_COUNT + Z];
+        apply(sample, tap);
+        output[n * XYZ_AXIS_COUNT + X] = sample[X];
+        output[n * XYZ_AXIS_COUNT + Y] = sample[Y];
+        output[n * XYZ_AXIS_COUNT + Z] = sample[Z];
+    }
+
+    runResult_t result = { 0, 0 };
+#ifdef HAVE_RDTSC
+    result.cyclesPerSample = (double)(__rdtsc() - startCycles) / sampleCount;
+#endif
+    result.nsPerSample = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / sampleCount;
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    int sampleCount = 2000000;
+    uint32_t looptimeUs = 500;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:m:r:l:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            sampleCount = std::max(1, atoi(optarg));
+            break;
+        case 'm':
+            motorCount = std::min(std::max(0, atoi(optarg)), MAX_MOTORS);
+            break;
+        case 'r':
+            harmonics = std::min(std::max(1, atoi(optarg)), MAX_HARMONICS);
+            break;
+        case 'l':
+            looptimeUs = std::max(100, atoi(optarg));
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n samples] [-m motors] [-r rpm_harmonics] [-l looptime_us]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    float *input = (float *)malloc(sizeof(float) * XYZ_AXIS_COUNT * sampleCount);
+    float *chainOutput = (float *)malloc(sizeof(float) * XYZ_AXIS_COUNT * sampleCount);
+    float *cascadeOutput = (float *)malloc(sizeof(float) * XYZ_AXIS_COUNT * sampleCount);
+
+    generateInput(input, sampleCount, looptimeUs);
+
+    initFilters(looptimeUs);
+    const runResult_t chain = runFilter(chainApply, input, chainOutput, sampleCount);
+    const runResult_t fused = runFilter([](float *sample, float *tap) {
+        biquadBankApply(&rpmBank, sample);
+        filterCascadeApply(&cascade, sample, tap);
+    }, input, cascadeOutput, sampleCount);
+
+    float maxError = 0;
+    for (int i = 0; i < sampleCount * XYZ_AXIS_COUNT; i++) {
+        maxError = std::max(maxError, fabsf(chainOutput[i] - cascadeOutput[i]));
+    }
+
+    printf("%d samples, %d stages per axis (%d motors x %d harmonics RPM, LPF2, %d dynamic notches, secondary notch)\n",
+        sampleCount, rpmBank.stageCount + cascade.stageCount, motorCount, harmonics, DYN_NOTCH_COUNT);
+    printf("%-8s %10s %10s\n", "", "cycles", "ns");
+    printf("%-8s %10.1f %10.2f\n", "chain", chain.cyclesPerSample, chain.nsPerSample);
+    printf("%-8s %10.1f %10.2f\n", "fused", fused.cyclesPerSample, fused.nsPerSample);
+    printf("Speedup %.2fx, max output difference %g dps\n", chain.nsPerSample / fused.nsPerSample, maxError);
+
+    free(input);
+    free(chainOutput);
+    free(cascadeOutput);
+
+    // Both implementations run the same filters, only rounding may differ
+    return maxError < 0.01f ? 0 : 1;
+}
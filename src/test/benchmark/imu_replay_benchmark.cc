@@ -0,0 +1,760 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Replays gyro/acc/mag/GPS streams through the attitude estimator in flight/imu.c
+ * and compares the estimated attitude with a reference attitude.
+ *
+ * Input is a CSV file as written by blackbox_decode (use --merge-gps to get the
+ * GPS columns) or a SITL capture in the same format. Columns are looked up by name:
+ *   time (us)                              sample time
+ *   gyroADC[0..2]                          deg/s
+ *   accSmooth[0..2]                        acc_1G units, see -a
+ *   magADC[0..2]                           optional
+ *   GPS_fixType, GPS_numSat, GPS_speed,
+ *   GPS_ground_course, GPS_velned[0..2]    optional, a new GPS frame is detected when any of them changes
+ *   attitude[0..2]                         optional reference in decidegrees
+ *
+ * Blackbox attitude is the estimate of the firmware that flew the log, SITL logs
+ * carry the simulator attitude. Without a file a synthetic flight with known
+ * attitude, gyro bias and sensor noise is generated.
+ *
+ * Reports RMS and largest roll/pitch/yaw error, cycles and nanoseconds per
+ * imuUpdateAttitude call, how often the error went above the divergence threshold
+ * and how many times the estimator had to reset its quaternion.
+ *
+ * Usage: imu_replay_benchmark [-f log.csv] [-a acc_1G] [-d update_divider] [-e divergence_deg]
+ *                             [-s settle_s] [-t synthetic_s] [-l synthetic_looptime_us] [-M] [-P]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "blackbox/blackbox.h"
+    #include "build/debug.h"
+    #include "common/axis.h"
+    #include "common/time.h"
+    #include "common/utils.h"
+    #include "config/feature.h"
+    #include "fc/config.h"
+    #include "fc/runtime_config.h"
+    #include "flight/imu.h"
+    #include "flight/pid.h"
+    #include "io/gps.h"
+    #include "sensors/acceleration.h"
+    #include "sensors/compass.h"
+    #include "sensors/gyro.h"
+    #include "sensors/sensors.h"
+
+    extern const imuConfig_t pgResetTemplate_imuConfig;
+
+    void imuComputeQuaternionFromRPY(int16_t initialRoll, int16_t initialPitch, int16_t initialYaw);
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC
+#endif
+
+#define MAG_FIELD_STRENGTH      1024.0      // Field strength imu.c expects from the compass driver
+#define MAG_INCLINATION_DEG     60.0
+
+typedef struct {
+    timeUs_t timeUs;
+    float gyro[XYZ_AXIS_COUNT];             // deg/s
+    float acc[XYZ_AXIS_COUNT];              // g
+    float mag[XYZ_AXIS_COUNT];
+    int16_t reference[XYZ_AXIS_COUNT];      // decidegrees, roll, pitch, yaw
+    bool gpsUpdated;
+    uint8_t gpsFixType;
+    uint8_t gpsNumSat;
+    int16_t gpsSpeed;                       // cm/s
+    int16_t gpsGroundCourse;                // decidegrees
+    int16_t gpsVelNED[XYZ_AXIS_COUNT];      // cm/s
+} replaySample_t;
+
+typedef struct {
+    bool hasMag;
+    bool hasGps;
+    bool hasReference;
+    std::vector<replaySample_t> samples;
+} replayLog_t;
+
+// Sensor values seen by imu.c through the stubs below
+static float replayGyro[XYZ_AXIS_COUNT];
+static timeUs_t replayTimeUs;
+static uint32_t enabledSensors;
+static int quaternionResetCount;
+
+/*
+ * Double precision quaternion in the imu.c convention, used for the synthetic ground truth
+ */
+typedef struct {
+    double w, x, y, z;
+} quatd_t;
+
+static quatd_t quatdMultiply(const quatd_t &a, const quatd_t &b)
+{
+    return {
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+    };
+}
+
+static quatd_t quatdConjugate(const quatd_t &q)
+{
+    return { q.w, -q.x, -q.y, -q.z };
+}
+
+// Same rotation order and yaw sign as imuComputeQuaternionFromRPY()
+static quatd_t quatdFromRPY(double roll, double pitch, double yaw)
+{
+    const double cr = cos(roll / 2), sr = sin(roll / 2);
+    const double cp = cos(pitch / 2), sp = sin(pitch / 2);
+    const double cy = cos(-yaw / 2), sy = sin(-yaw / 2);
+
+    return {
+        cr * cp * cy + sr * sp * sy,
+        sr * cp * cy - cr * sp * sy,
+        cr * sp * cy + sr * cp * sy,
+        cr * cp * sy - sr * sp * cy,
+    };
+}
+
+// Earth frame to body frame, same as quaternionRotateVector()
+static void quatdRotateVector(double result[3], const double v[3], const quatd_t &q)
+{
+    const quatd_t vq = { 0, v[0], v[1], v[2] };
+    const quatd_t r = quatdMultiply(quatdMultiply(quatdConjugate(q), vq), q);
+
+    result[0] = r.x;
+    result[1] = r.y;
+    result[2] = r.z;
+}
+
+static uint32_t rngState = 2463534242u;
+
+static double noise(double amplitude)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return ((double)(rngState & 0xFFFF) / 0xFFFF - 0.5) * 2 * amplitude;
+}
+
+/*
+ * Synthetic flight: hover, then rolling/pitching manoeuvres up to 50 degrees while the
+ * heading turns through a full circle, with a short burst of faster stick input every 20s.
+ * The craft does not translate, so acc only measures gravity plus noise.
+ */
+static void syntheticAttitude(double t, double *roll, double *pitch, double *yaw)
+{
+    const double manoeuvre = std::min(std::max(t - 2.0, 0.0) / 3.0, 1.0);
+    const double burst = fmod(t, 20.0) > 17.0 && fmod(t, 20.0) < 18.5 ? 1.0 : 0.0;
+
+    *roll = manoeuvre * (DEGREES_TO_RADIANS(35.0) * sin(2 * M_PI * 0.23 * t) + burst * DEGREES_TO_RADIANS(15.0) * sin(2 * M_PI * 2.1 * t));
+    *pitch = manoeuvre * (DEGREES_TO_RADIANS(25.0) * sin(2 * M_PI * 0.17 * t + 1.0) + burst * DEGREES_TO_RADIANS(10.0) * sin(2 * M_PI * 1.7 * t));
+    *yaw = DEGREES_TO_RADIANS(30.0) + manoeuvre * 2 * M_PI * t / 90.0;
+}
+
+static int16_t wrapDecidegrees(double rad)
+{
+    int16_t value = lrint(rad * 1800.0 / M_PI);
+    while (value < 0) {
+        value += 3600;
+    }
+    while (value >= 3600) {
+        value -= 3600;
+    }
+    return value;
+}
+
+static void generateSyntheticLog(replayLog_t *log, double durationS, uint32_t looptimeUs, bool useMag)
+{
+    const double dt = looptimeUs * 1e-6;
+    const int sampleCount = durationS / dt;
+    const double gyroBias[XYZ_AXIS_COUNT] = { 0.1, -0.08, 0.05 };     // deg/s
+    const double gravityEF[XYZ_AXIS_COUNT] = { 0, 0, 1 };
+    const double magEF[XYZ_AXIS_COUNT] = {
+        MAG_FIELD_STRENGTH * cos(DEGREES_TO_RADIANS(MAG_INCLINATION_DEG)), 0, MAG_FIELD_STRENGTH * sin(DEGREES_TO_RADIANS(MAG_INCLINATION_DEG))
+    };
+
+    log->hasMag = useMag;
+    log->hasGps = false;
+    log->hasReference = true;
+    log->samples.resize(sampleCount);
+
+    double roll, pitch, yaw;
+    syntheticAttitude(0, &roll, &pitch, &yaw);
+    quatd_t q = quatdFromRPY(roll, pitch, yaw);
+
+    for (int n = 0; n < sampleCount; n++) {
+        replaySample_t *sample = &log->samples[n];
+        memset(sample, 0, sizeof(*sample));
+
+        // Body rate is the rotation from this sample to the next one, as the estimator integrates it
+        syntheticAttitude((n + 1) * dt, &roll, &pitch, &yaw);
+        const quatd_t next = quatdFromRPY(roll, pitch, yaw);
+        quatd_t delta = quatdMultiply(quatdConjugate(q), next);
+        if (delta.w < 0) {
+            delta = { -delta.w, -delta.x, -delta.y, -delta.z };
+        }
+        const double sinHalfAngle = sqrt(delta.x * delta.x + delta.y * delta.y + delta.z * delta.z);
+        const double angle = 2 * atan2(sinHalfAngle, delta.w);
+        const double scale = sinHalfAngle > 1e-12 ? angle / sinHalfAngle / dt : 2 / dt;
+
+        double gravityBF[XYZ_AXIS_COUNT];
+        double magBF[XYZ_AXIS_COUNT];
+        quatdRotateVector(gravityBF, gravityEF, next);
+        quatdRotateVector(magBF, magEF, next);
+
+        sample->timeUs = (n + 1) * looptimeUs;
+        sample->gyro[X] = RADIANS_TO_DEGREES(delta.x * scale) + gyroBias[X] + noise(3.0);
+        sample->gyro[Y] = RADIANS_TO_DEGREES(delta.y * scale) + gyroBias[Y] + noise(3.0);
+        sample->gyro[Z] = RADIANS_TO_DEGREES(delta.z * scale) + gyroBias[Z] + noise(3.0);
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            sample->acc[axis] = gravityBF[axis] + noise(0.08);
+            sample->mag[axis] = magBF[axis] + noise(20.0);
+        }
+        sample->reference[FD_ROLL] = lrint(roll * 1800.0 / M_PI);
+        sample->reference[FD_PITCH] = lrint(pitch * 1800.0 / M_PI);
+        sample->reference[FD_YAW] = wrapDecidegrees(yaw);
+
+        q = next;
+    }
+}
+
+/*
+ * blackbox_decode CSV reader
+ */
+static std::vector<std::string> splitCsvLine(const char *line)
+{
+    std::vector<std::string> fields;
+    std::string field;
+
+    for (const char *c = line; *c && *c != '\n' && *c != '\r'; c++) {
+        if (*c == ',') {
+            fields.push_back(field);
+            field.clear();
+        } else if (*c != ' ' || !field.empty()) {
+            field += *c;
+        }
+    }
+    fields.push_back(field);
+
+    for (auto &f : fields) {
+        while (!f.empty() && f.back() == ' ') {
+            f.pop_back();
+        }
+    }
+
+    return fields;
+}
+
+static int findColumn(const std::vector<std::string> &header, const char *name)
+{
+    for (size_t i = 0; i < header.size(); i++) {
+        if (header[i] == name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool findAxisColumns(const std::vector<std::string> &header, const char *name, int columns[XYZ_AXIS_COUNT])
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        char indexedName[32];
+        snprintf(indexedName, sizeof(indexedName), "%s[%d]", name, axis);
+        columns[axis] = findColumn(header, indexedName);
+        if (columns[axis] < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool readCsvLog(replayLog_t *log, const char *fileName, float acc1G)
+{
+    FILE *file = fopen(fileName, "r");
+    if (!file) {
+        perror(fileName);
+        return false;
+    }
+
+    static char line[8192];
+    if (!fgets(line, sizeof(line), file)) {
+        fprintf(stderr, "%s: empty file\n", fileName);
+        fclose(file);
+        return false;
+    }
+
+    const std::vector<std::string> header = splitCsvLine(line);
+
+    int timeColumn = findColumn(header, "time (us)");
+    if (timeColumn < 0) {
+        timeColumn = findColumn(header, "time");
+    }
+
+    int gyroColumns[XYZ_AXIS_COUNT], accColumns[XYZ_AXIS_COUNT], magColumns[XYZ_AXIS_COUNT];
+    int referenceColumns[XYZ_AXIS_COUNT], velNEDColumns[XYZ_AXIS_COUNT];
+    if (timeColumn < 0 || !findAxisColumns(header, "gyroADC", gyroColumns) || !findAxisColumns(header, "accSmooth", accColumns)) {
+        fprintf(stderr, "%s: time, gyroADC[] and accSmooth[] columns are required\n", fileName);
+        fclose(file);
+        return false;
+    }
+
+    log->hasMag = findAxisColumns(header, "magADC", magColumns);
+    log->hasReference = findAxisColumns(header, "attitude", referenceColumns);
+
+    const int fixTypeColumn = findColumn(header, "GPS_fixType");
+    const int numSatColumn = findColumn(header, "GPS_numSat");
+    const int speedColumn = findColumn(header, "GPS_speed");
+    const int courseColumn = findColumn(header, "GPS_ground_course");
+    const bool hasVelNED = findAxisColumns(header, "GPS_velned", velNEDColumns);
+    log->hasGps = fixTypeColumn >= 0 && numSatColumn >= 0 && speedColumn >= 0 && courseColumn >= 0;
+
+    replaySample_t previous;
+    memset(&previous, 0, sizeof(previous));
+
+    while (fgets(line, sizeof(line), file)) {
+        const std::vector<std::string> fields = splitCsvLine(line);
+        if (fields.size() < header.size()) {
+            continue;
+        }
+
+        auto value = [&fields](int column) { return atof(fields[column].c_str()); };
+        // Merged GPS columns are empty until the first GPS frame
+        auto gpsValue = [&fields](int column, int16_t last) { return fields[column].empty() ? last : (int16_t)atoi(fields[column].c_str()); };
+
+        replaySample_t sample = previous;
+        sample.timeUs = value(timeColumn);
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            sample.gyro[axis] = value(gyroColumns[axis]);
+            sample.acc[axis] = value(accColumns[axis]) / acc1G;
+            if (log->hasMag) {
+                sample.mag[axis] = value(magColumns[axis]);
+            }
+            if (log->hasReference) {
+                sample.reference[axis] = value(referenceColumns[axis]);
+            }
+        }
+
+        sample.gpsUpdated = false;
+        if (log->hasGps) {
+            sample.gpsFixType = gpsValue(fixTypeColumn, previous.gpsFixType);
+            sample.gpsNumSat = gpsValue(numSatColumn, previous.gpsNumSat);
+            sample.gpsSpeed = gpsValue(speedColumn, previous.gpsSpeed);
+            sample.gpsGroundCourse = gpsValue(courseColumn, previous.gpsGroundCourse);
+            for (int axis = 0; hasVelNED && axis < XYZ_AXIS_COUNT; axis++) {
+                sample.gpsVelNED[axis] = gpsValue(velNEDColumns[axis], previous.gpsVelNED[axis]);
+            }
+            sample.gpsUpdated = sample.gpsFixType != previous.gpsFixType || sample.gpsNumSat != previous.gpsNumSat
+                || sample.gpsSpeed != previous.gpsSpeed || sample.gpsGroundCourse != previous.gpsGroundCourse
+                || memcmp(sample.gpsVelNED, previous.gpsVelNED, sizeof(sample.gpsVelNED));
+        }
+
+        log->samples.push_back(sample);
+        previous = sample;
+    }
+
+    fclose(file);
+
+    if (log->samples.size() < 2) {
+        fprintf(stderr, "%s: no samples\n", fileName);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Replay
+ */
+typedef struct {
+    int updates;
+    int scoredUpdates;
+    double squaredError[XYZ_AXIS_COUNT];
+    double maxError[XYZ_AXIS_COUNT];
+    int divergences;
+    double cyclesPerUpdate;
+    double nsPerUpdate;
+} replayResult_t;
+
+static double angleErrorDeg(int16_t estimate, int16_t reference)
+{
+    double error = (estimate - reference) / 10.0;
+    while (error > 180.0) {
+        error -= 360.0;
+    }
+    while (error < -180.0) {
+        error += 360.0;
+    }
+    return error;
+}
+
+static void applyGpsSample(const replaySample_t *sample)
+{
+    if (sample->gpsUpdated) {
+        gpsSol.flags.gpsHeartbeat = !gpsSol.flags.gpsHeartbeat;
+    }
+
+    gpsSol.fixType = (gpsFixType_e)sample->gpsFixType;
+    gpsSol.numSat = sample->gpsNumSat;
+    gpsSol.groundSpeed = sample->gpsSpeed;
+    gpsSol.groundCourse = sample->gpsGroundCourse;
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        gpsSol.velNED[axis] = sample->gpsVelNED[axis];
+    }
+
+    if (gpsSol.fixType >= GPS_FIX_3D) {
+        ENABLE_STATE(GPS_FIX);
+    } else {
+        DISABLE_STATE(GPS_FIX);
+    }
+}
+
+static replayResult_t replay(const replayLog_t *log, int updateDivider, double settleS, double divergenceDeg, double armDelayS, bool airplane)
+{
+    replayResult_t result;
+    memset(&result, 0, sizeof(result));
+
+    stateFlags = 0;
+    armingFlags = 0;
+    ENABLE_STATE(airplane ? AIRPLANE : MULTIROTOR);
+    ENABLE_STATE(ACCELEROMETER_CALIBRATED);
+
+    enabledSensors = SENSOR_GYRO | SENSOR_ACC;
+    if (log->hasMag) {
+        enabledSensors |= SENSOR_MAG;
+        ENABLE_STATE(COMPASS_CALIBRATED);
+    }
+    if (log->hasGps) {
+        enabledSensors |= SENSOR_GPS;
+    }
+
+    memset(&gpsSol, 0, sizeof(gpsSol));
+    quaternionResetCount = 0;
+
+    const timeUs_t startTimeUs = log->samples[0].timeUs;
+    replayTimeUs = startTimeUs;
+
+    imuConfigure();
+    imuInit();
+    imuUpdateAccelerometer();
+    imuUpdateAttitude(startTimeUs);   // Sets the dT reference, no sensor data consumed yet
+
+    // Logs start mid flight, begin from the logged attitude instead of waiting for convergence
+    if (log->hasReference && armDelayS == 0) {
+        const replaySample_t *first = &log->samples[0];
+        imuComputeQuaternionFromRPY(first->reference[FD_ROLL], first->reference[FD_PITCH], first->reference[FD_YAW]);
+    }
+
+    bool diverged = false;
+    float gyroSum[XYZ_AXIS_COUNT] = { 0, 0, 0 };
+    int gyroSumCount = 0;
+    uint64_t totalCycles = 0;
+    double totalNs = 0;
+
+    for (const replaySample_t &sample : log->samples) {
+        // Average the gyro over skipped loops, like gyroGetMeasuredRotationRate() with a slower attitude update
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            gyroSum[axis] += sample.gyro[axis];
+        }
+        if (log->hasGps) {
+            applyGpsSample(&sample);
+        }
+        if (++gyroSumCount < updateDivider) {
+            continue;
+        }
+
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            replayGyro[axis] = gyroSum[axis] / gyroSumCount;
+            gyroSum[axis] = 0;
+            acc.accADCf[axis] = sample.acc[axis];
+            mag.magADC[axis] = sample.mag[axis];
+        }
+        gyroSumCount = 0;
+
+        replayTimeUs = sample.timeUs;
+        const double elapsedS = (sample.timeUs - startTimeUs) * 1e-6;
+        if (elapsedS >= armDelayS) {
+            ENABLE_ARMING_FLAG(ARMED);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+        const uint64_t startCycles = __rdtsc();
+#endif
+
+        imuUpdateAttitude(sample.timeUs);
+
+#ifdef HAVE_RDTSC
+        totalCycles += __rdtsc() - startCycles;
+#endif
+        totalNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        result.updates++;
+
+        if (!log->hasReference || elapsedS < settleS) {
+            continue;
+        }
+
+        const double error[XYZ_AXIS_COUNT] = {
+            angleErrorDeg(attitude.values.roll, sample.reference[FD_ROLL]),
+            angleErrorDeg(attitude.values.pitch, sample.reference[FD_PITCH]),
+            angleErrorDeg(attitude.values.yaw, sample.reference[FD_YAW]),
+        };
+
+        bool aboveThreshold = false;
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            result.squaredError[axis] += error[axis] * error[axis];
+            result.maxError[axis] = std::max(result.maxError[axis], fabs(error[axis]));
+            aboveThreshold |= fabs(error[axis]) > divergenceDeg;
+        }
+
+        // Count episodes, not samples
+        if (aboveThreshold && !diverged) {
+            result.divergences++;
+        }
+        diverged = aboveThreshold;
+        result.scoredUpdates++;
+    }
+
+    result.cyclesPerUpdate = result.updates ? (double)totalCycles / result.updates : 0;
+    result.nsPerUpdate = result.updates ? totalNs / result.updates : 0;
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *fileName = NULL;
+    float acc1G = 4096;
+    int updateDivider = 1;
+    double divergenceDeg = 10.0;
+    double settleS = -1;
+    double durationS = 120.0;
+    uint32_t looptimeUs = 1000;
+    bool useMag = true;
+    bool airplane = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:a:d:e:s:t:l:MPh")) != -1) {
+        switch (opt) {
+        case 'f':
+            fileName = optarg;
+            break;
+        case 'a':
+            acc1G = std::max(1.0, atof(optarg));
+            break;
+        case 'd':
+            updateDivider = std::min(std::max(1, atoi(optarg)), 64);
+            break;
+        case 'e':
+            divergenceDeg = std::max(0.1, atof(optarg));
+            break;
+        case 's':
+            settleS = std::max(0.0, atof(optarg));
+            break;
+        case 't':
+            durationS = std::max(1.0, atof(optarg));
+            break;
+        case 'l':
+            looptimeUs = std::max(100, atoi(optarg));
+            break;
+        case 'M':
+            useMag = false;
+            break;
+        case 'P':
+            airplane = true;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-f log.csv] [-a acc_1G] [-d update_divider] [-e divergence_deg]\n"
+                "       [-s settle_s] [-t synthetic_s] [-l synthetic_looptime_us] [-M] [-P]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    memcpy(imuConfigMutable(), &pgResetTemplate_imuConfig, sizeof(imuConfig_t));
+
+    replayLog_t log;
+    double armDelayS;
+    if (fileName) {
+        if (!readCsvLog(&log, fileName, acc1G)) {
+            return 1;
+        }
+        // Blackbox logs are recorded armed
+        armDelayS = 0;
+        settleS = std::max(settleS, 0.0);
+    } else {
+        generateSyntheticLog(&log, durationS, looptimeUs, useMag);
+        // Start disarmed with the fast gains like on the bench, converged attitude is only expected after arming
+        armDelayS = std::min(5.0, durationS / 4);
+        if (settleS < 0) {
+            settleS = armDelayS;
+        }
+    }
+
+    const replayResult_t result = replay(&log, updateDivider, settleS, divergenceDeg, armDelayS, airplane);
+
+    const replaySample_t &first = log.samples.front();
+    const replaySample_t &last = log.samples.back();
+    printf("%s: %d samples over %.1fs, %d attitude updates at %.0fHz, sensors: gyro acc%s%s\n",
+        fileName ? fileName : "synthetic flight", (int)log.samples.size(), (last.timeUs - first.timeUs) * 1e-6, result.updates,
+        result.updates / std::max((last.timeUs - first.timeUs) * 1e-6, 1e-6),
+        log.hasMag ? " mag" : "", log.hasGps ? " gps" : "");
+    printf("%-8s %10s %10s\n", "", "cycles", "ns");
+    printf("%-8s %10.1f %10.2f\n", "update", result.cyclesPerUpdate, result.nsPerUpdate);
+
+    if (result.scoredUpdates) {
+        const char *axisNames[XYZ_AXIS_COUNT] = { "roll", "pitch", "yaw" };
+        printf("%-8s %10s %10s\n", "error", "rms deg", "max deg");
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            printf("%-8s %10.3f %10.3f\n", axisNames[axis], sqrt(result.squaredError[axis] / result.scoredUpdates), result.maxError[axis]);
+        }
+    } else {
+        printf("No reference attitude, error not computed\n");
+    }
+    printf("Divergences above %.1f deg: %d, quaternion resets: %d\n", divergenceDeg, result.divergences, quaternionResetCount);
+
+    if (result.divergences || quaternionResetCount) {
+        return 1;
+    }
+
+    // Synthetic flight has known truth, hold the estimator to it
+    if (!fileName && log.hasMag) {
+        const double rollRms = sqrt(result.squaredError[FD_ROLL] / result.scoredUpdates);
+        const double pitchRms = sqrt(result.squaredError[FD_PITCH] / result.scoredUpdates);
+        const double yawRms = sqrt(result.squaredError[FD_YAW] / result.scoredUpdates);
+        return rollRms < 2.0 && pitchRms < 2.0 && yawRms < 5.0 ? 0 : 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Stubs for the firmware parts imu.c depends on
+ */
+extern "C" {
+int32_t debug[DEBUG32_VALUE_COUNT];
+uint8_t debugMode;
+
+uint32_t stateFlags;
+uint32_t flightModeFlags;
+uint32_t armingFlags;
+
+acc_t acc;
+mag_t mag;
+gpsSolutionData_t gpsSol;
+
+compassConfig_t compassConfig_System;
+static pidProfile_t replayPidProfile;
+pidProfile_t *pidProfile_ProfileCurrent = &replayPidProfile;
+
+bool isMixerTransitionMixing = false;
+
+bool sensors(uint32_t mask)
+{
+    return enabledSensors & mask;
+}
+
+bool feature(uint32_t mask)
+{
+    return mask == FEATURE_BLACKBOX;
+}
+
+void blackboxLogEvent(FlightLogEvent event, flightLogEventData_t *data)
+{
+    UNUSED(data);
+    if (event == FLIGHT_LOG_EVENT_IMU_FAILURE) {
+        quaternionResetCount++;
+    }
+}
+
+timeMs_t millis(void)
+{
+    return replayTimeUs / 1000;
+}
+
+timeUs_t micros(void)
+{
+    return replayTimeUs;
+}
+
+bool compassIsHealthy(void)
+{
+    return true;
+}
+
+bool isGPSHeadingValid(void)
+{
+    return STATE(GPS_FIX) && gpsSol.numSat >= 6 && gpsSol.groundSpeed >= 300;
+}
+
+void gyroGetMeasuredRotationRate(fpVector3_t *measuredRotationRate)
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        measuredRotationRate->v[axis] = DEGREES_TO_RADIANS(replayGyro[axis]);
+    }
+}
+
+bool gyroIsCalibrationComplete(void)
+{
+    return true;
+}
+
+void accGetMeasuredAcceleration(fpVector3_t *measuredAcc)
+{
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        measuredAcc->v[axis] = acc.accADCf[axis] * GRAVITY_CMSS;
+    }
+}
+
+void accGetVibrationLevels(fpVector3_t *accVibeLevels)
+{
+    accVibeLevels->x = 0;
+    accVibeLevels->y = 0;
+    accVibeLevels->z = 0;
+}
+
+uint32_t accGetClipCount(void)
+{
+    return 0;
+}
+
+void accUpdate(void) {}
+
+void resetHeadingHoldTarget(int16_t heading)
+{
+    UNUSED(heading);
+}
+}
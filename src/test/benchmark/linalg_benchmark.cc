@@ -0,0 +1,265 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Cost of the common/linalg.c kernels next to the helpers they replace:
+ * quaternion rotation written as two quaternionMultiply() calls, one
+ * rotationMatrixRotateVector() call per vector and plain nested loop matrix products.
+ *
+ * Reports cycles and nanoseconds per operation and the max absolute difference
+ * from the reference.
+ *
+ * Usage: linalg_benchmark [-n operations]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+extern "C" {
+    #include "platform.h"
+    #include "common/maths.h"
+    #include "common/linalg.h"
+    #include "common/quaternion.h"
+    #include "common/vector.h"
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC
+#endif
+
+#define BATCH_SIZE  16
+
+typedef struct {
+    const char *name;
+    double cyclesPerOp;
+    double nsPerOp;
+    double maxError;
+} kernelResult_t;
+
+typedef struct {
+    fpQuaternion_t *q;
+    fpVector3_t *v;
+    fpMat3_t *a3;
+    fpMat3_t *b3;
+    fpMat4_t *a4;
+    fpMat4_t *b4;
+} benchmarkInput_t;
+
+static benchmarkInput_t in;
+static volatile float sink;
+
+template <typename Fn>
+static kernelResult_t timeKernel(const char *name, Fn fn, int count)
+{
+    kernelResult_t result = { name, 0, 0, 0 };
+    float acc = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+    const uint64_t startCycles = __rdtsc();
+#endif
+
+    for (int i = 0; i < count; i++) {
+        acc += fn(i);
+    }
+
+#ifdef HAVE_RDTSC
+    result.cyclesPerOp = (double)(__rdtsc() - startCycles) / count;
+#endif
+    result.nsPerOp = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+
+    sink = acc;
+    return result;
+}
+
+static void fillUniform(float *data, int count, float from, float to, uint32_t seed)
+{
+    uint32_t rng = seed;
+
+    for (int i = 0; i < count; i++) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        data[i] = from + (to - from) * (float)(rng & 0xFFFFFF) / 0xFFFFFF;
+    }
+}
+
+static fpVector3_t * quaternionRotateVectorProduct(fpVector3_t *result, const fpVector3_t *vect, const fpQuaternion_t *ref)
+{
+    fpQuaternion_t vectQuat, refConj;
+
+    quaternionInitFromVector(&vectQuat, vect);
+    quaternionConjugate(&refConj, ref);
+    quaternionMultiply(&vectQuat, &refConj, &vectQuat);
+    quaternionMultiply(&vectQuat, &vectQuat, ref);
+
+    result->x = vectQuat.q1;
+    result->y = vectQuat.q2;
+    result->z = vectQuat.q3;
+    return result;
+}
+
+static void mat3MultiplyLoop(fpMat3_t *result, const fpMat3_t *a, const fpMat3_t *b)
+{
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            result->m[i][j] = 0;
+            for (int k = 0; k < 3; k++) {
+                result->m[i][j] += a->m[i][k] * b->m[k][j];
+            }
+        }
+    }
+}
+
+static void mat4MultiplyLoop(fpMat4_t *result, const fpMat4_t *a, const fpMat4_t *b)
+{
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            result->m[i][j] = 0;
+            for (int k = 0; k < 4; k++) {
+                result->m[i][j] += a->m[i][k] * b->m[k][j];
+            }
+        }
+    }
+}
+
+template <typename Mat>
+static float maxDifference(const Mat &a, const Mat &b)
+{
+    const float *x = &a.m[0][0];
+    const float *y = &b.m[0][0];
+    float error = 0;
+
+    for (size_t i = 0; i < sizeof(Mat) / sizeof(float); i++) {
+        error = std::max(error, std::fabs(x[i] - y[i]));
+    }
+
+    return error;
+}
+
+static float maxDifference(const fpVector3_t &a, const fpVector3_t &b)
+{
+    return std::max(std::fabs(a.x - b.x), std::max(std::fabs(a.y - b.y), std::fabs(a.z - b.z)));
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 1000000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            count = std::max(BATCH_SIZE, atoi(optarg));
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n operations]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    in.q = (fpQuaternion_t *)malloc(sizeof(fpQuaternion_t) * count);
+    in.v = (fpVector3_t *)malloc(sizeof(fpVector3_t) * count);
+    in.a3 = (fpMat3_t *)malloc(sizeof(fpMat3_t) * count);
+    in.b3 = (fpMat3_t *)malloc(sizeof(fpMat3_t) * count);
+    in.a4 = (fpMat4_t *)malloc(sizeof(fpMat4_t) * count);
+    in.b4 = (fpMat4_t *)malloc(sizeof(fpMat4_t) * count);
+    fpVector3_t *out = (fpVector3_t *)malloc(sizeof(fpVector3_t) * count);
+
+    fillUniform(&in.q[0].q0, count * 4, -1.0f, 1.0f, 2463534242u);
+    fillUniform(in.v[0].v, count * 3, -1000.0f, 1000.0f, 88675123u);
+    fillUniform(&in.a3[0].m[0][0], count * 9, -10.0f, 10.0f, 521288629u);
+    fillUniform(&in.b3[0].m[0][0], count * 9, -10.0f, 10.0f, 3816402881u);
+    fillUniform(&in.a4[0].m[0][0], count * 16, -10.0f, 10.0f, 1350568201u);
+    fillUniform(&in.b4[0].m[0][0], count * 16, -10.0f, 10.0f, 2752599721u);
+    for (int i = 0; i < count; i++) {
+        quaternionNormalize(&in.q[i], &in.q[i]);
+    }
+
+    // One matrix for all batches, as board alignment uses it
+    fpMat3_t rmat;
+    rotationMatrixFromQuaternion(rmat.m, &in.q[0]);
+    const int batches = count / BATCH_SIZE;
+
+    kernelResult_t results[] = {
+        timeKernel("quat rotate (product)", [](int i) { fpVector3_t r; return quaternionRotateVectorProduct(&r, &in.v[i], &in.q[i])->x; }, count),
+        timeKernel("quat rotate", [](int i) { fpVector3_t r; return quaternionRotateVector(&r, &in.v[i], &in.q[i])->x; }, count),
+        timeKernel("rotate vector x16", [&](int i) {
+            for (int n = 0; n < BATCH_SIZE; n++) {
+                rotationMatrixRotateVector(&out[n], &in.v[i * BATCH_SIZE + n], &rmat);
+            }
+            return out[i % BATCH_SIZE].x;
+        }, batches),
+        timeKernel("rotate vectors x16", [&](int i) { rotationMatrixRotateVectors(out, &in.v[i * BATCH_SIZE], BATCH_SIZE, &rmat); return out[i % BATCH_SIZE].x; }, batches),
+        timeKernel("mat3 multiply (loop)", [](int i) { fpMat3_t r; mat3MultiplyLoop(&r, &in.a3[i], &in.b3[i]); return r.m[i % 3][1]; }, count),
+        timeKernel("mat3 multiply", [](int i) { fpMat3_t r; mat3Multiply(&r, &in.a3[i], &in.b3[i]); return r.m[i % 3][1]; }, count),
+        timeKernel("mat4 multiply (loop)", [](int i) { fpMat4_t r; mat4MultiplyLoop(&r, &in.a4[i], &in.b4[i]); return r.m[i % 4][1]; }, count),
+        timeKernel("mat4 multiply", [](int i) { fpMat4_t r; mat4Multiply(&r, &in.a4[i], &in.b4[i]); return r.m[i % 4][1]; }, count),
+    };
+
+    // Accuracy against the replaced helpers, rotations are of vectors up to 1000 long
+    for (int i = 0; i < count; i++) {
+        fpVector3_t expected, actual;
+        fpMat3_t expected3, actual3;
+        fpMat4_t expected4, actual4;
+
+        quaternionRotateVectorProduct(&expected, &in.v[i], &in.q[i]);
+        quaternionRotateVector(&actual, &in.v[i], &in.q[i]);
+        results[1].maxError = std::max(results[1].maxError, (double)maxDifference(expected, actual));
+
+        rotationMatrixRotateVector(&expected, &in.v[i], &rmat);
+        rotationMatrixRotateVectors(&actual, &in.v[i], 1, &rmat);
+        results[3].maxError = std::max(results[3].maxError, (double)maxDifference(expected, actual));
+
+        mat3MultiplyLoop(&expected3, &in.a3[i], &in.b3[i]);
+        mat3Multiply(&actual3, &in.a3[i], &in.b3[i]);
+        results[5].maxError = std::max(results[5].maxError, (double)maxDifference(expected3, actual3));
+
+        mat4MultiplyLoop(&expected4, &in.a4[i], &in.b4[i]);
+        mat4Multiply(&actual4, &in.a4[i], &in.b4[i]);
+        results[7].maxError = std::max(results[7].maxError, (double)maxDifference(expected4, actual4));
+    }
+
+    printf("%d operations per kernel\n", count);
+    printf("%-26s %10s %10s %12s\n", "", "cycles", "ns", "max error");
+
+    bool withinBounds = true;
+    for (const kernelResult_t &result : results) {
+        // Rotated vectors are up to 1000 long, products of matrices up to 10 * 10 * 4
+        const bool ok = result.maxError < 1e-3;
+        printf("%-26s %10.1f %10.2f %12.3g%s\n", result.name, result.cyclesPerOp, result.nsPerOp, result.maxError, ok ? "" : "  EXCEEDED");
+        withinBounds = withinBounds && ok;
+    }
+
+    free(in.q);
+    free(in.v);
+    free(in.a3);
+    free(in.b3);
+    free(in.a4);
+    free(in.b4);
+    free(out);
+
+    return withinBounds ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Cost and accuracy of the trigonometry and square root tiers in common/maths.c
+ * (default *_approx, *_approx_fast) next to libm.
+ *
+ * Reports cycles and nanoseconds per call and the max absolute (relative for
+ * inverse square root) error against double precision libm. Host numbers are only
+ * indicative, an out of order x86 core hides most of the cost difference between
+ * the tiers that an in order Cortex-M FPU pays for.
+ *
+ * Usage: maths_benchmark [-n calls]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+extern "C" {
+    #include "platform.h"
+    #include "common/maths.h"
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_RDTSC
+#endif
+
+typedef struct {
+    const char *name;
+    double cyclesPerCall;
+    double nsPerCall;
+    double maxError;
+    double bound;
+} kernelResult_t;
+
+static volatile float sink;
+
+// Inputs are generated up front so the timed loop only contains the kernel
+typedef struct {
+    float *angle;       // -2PI..2PI
+    float *x;           // Points on a 1m circle for atan2
+    float *y;
+    float *unit;        // -1..1
+    float *positive;    // 1e-3..1e3
+} benchmarkInput_t;
+
+static benchmarkInput_t in;
+
+template <typename Fn>
+static void timeKernel(kernelResult_t *result, Fn fn, int count)
+{
+    float acc = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_RDTSC
+    const uint64_t startCycles = __rdtsc();
+#endif
+
+    for (int i = 0; i < count; i++) {
+        acc += fn(i);
+    }
+
+#ifdef HAVE_RDTSC
+    result->cyclesPerCall = (double)(__rdtsc() - startCycles) / count;
+#endif
+    result->nsPerCall = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+
+    sink = acc;
+}
+
+template <typename Fn, typename Ref>
+static kernelResult_t runKernel(const char *name, Fn fn, Ref reference, int count, double bound, bool relative = false)
+{
+    kernelResult_t result = { name, 0, 0, 0, bound };
+
+    timeKernel(&result, fn, count);
+
+    for (int i = 0; i < count; i++) {
+        const double expected = reference(i);
+        double error = fabs((double)fn(i) - expected);
+        if (relative) {
+            error /= fabs(expected);
+        }
+        else if (error > M_PI) {
+            error = 2 * M_PI - error;   // +PI and -PI are the same angle
+        }
+        result.maxError = std::max(result.maxError, error);
+    }
+
+    return result;
+}
+
+static void fillUniform(float *data, int count, float from, float to, uint32_t seed)
+{
+    uint32_t rng = seed;
+
+    for (int i = 0; i < count; i++) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        data[i] = from + (to - from) * (float)(rng & 0xFFFFFF) / 0xFFFFFF;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 4000000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            count = std::max(1, atoi(optarg));
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n calls]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    in.angle = (float *)malloc(sizeof(float) * count);
+    in.x = (float *)malloc(sizeof(float) * count);
+    in.y = (float *)malloc(sizeof(float) * count);
+    in.unit = (float *)malloc(sizeof(float) * count);
+    in.positive = (float *)malloc(sizeof(float) * count);
+
+    fillUniform(in.angle, count, -2 * M_PIf, 2 * M_PIf, 2463534242u);
+    fillUniform(in.unit, count, -1.0f, 1.0f, 88675123u);
+    fillUniform(in.positive, count, 1e-3f, 1e3f, 521288629u);
+    for (int i = 0; i < count; i++) {
+        in.x[i] = 100.0f * cosf(in.angle[i]);
+        in.y[i] = 100.0f * sinf(in.angle[i]);
+    }
+
+    auto refSin = [](int i) { return sin((double)in.angle[i]); };
+    auto refAtan2 = [](int i) { return atan2((double)in.y[i], (double)in.x[i]); };
+    auto refAcos = [](int i) { return acos((double)in.unit[i]); };
+    auto refInvSqrt = [](int i) { return 1.0 / sqrt((double)in.positive[i]); };
+
+    const kernelResult_t results[] = {
+        runKernel("sinf", [](int i) { return sinf(in.angle[i]); }, refSin, count, 1e-6),
+        runKernel("sin_approx", [](int i) { return sin_approx(in.angle[i]); }, refSin, count, 2e-6),
+        runKernel("sin_approx_fast", [](int i) { return sin_approx_fast(in.angle[i]); }, refSin, count, 2e-6),
+        runKernel("atan2f", [](int i) { return atan2f(in.y[i], in.x[i]); }, refAtan2, count, 1e-6),
+        runKernel("atan2_approx", [](int i) { return atan2_approx(in.y[i], in.x[i]); }, refAtan2, count, 2e-6),
+        runKernel("atan2_approx_fast", [](int i) { return atan2_approx_fast(in.y[i], in.x[i]); }, refAtan2, count, 1.6e-3),
+        runKernel("acosf", [](int i) { return acosf(in.unit[i]); }, refAcos, count, 1e-6),
+        runKernel("acos_approx", [](int i) { return acos_approx(in.unit[i]); }, refAcos, count, 1e-4),
+        runKernel("acos_approx_fast", [](int i) { return acos_approx_fast(in.unit[i]); }, refAcos, count, 4e-4),
+        runKernel("1/sqrtf", [](int i) { return 1.0f / sqrtf(in.positive[i]); }, refInvSqrt, count, 1e-6, true),
+        runKernel("fast_invsqrtf", [](int i) { return fast_invsqrtf(in.positive[i]); }, refInvSqrt, count, 1e-6, true),
+    };
+
+    printf("%d calls per kernel\n", count);
+    printf("%-22s %10s %10s %12s %12s\n", "", "cycles", "ns", "max error", "bound");
+
+    bool withinBounds = true;
+    for (const kernelResult_t &result : results) {
+        const bool ok = result.maxError < result.bound;
+        printf("%-22s %10.1f %10.2f %12.3g %12.3g%s\n", result.name, result.cyclesPerCall, result.nsPerCall, result.maxError, result.bound, ok ? "" : "  EXCEEDED");
+        withinBounds = withinBounds && ok;
+    }
+
+    free(in.angle);
+    free(in.x);
+    free(in.y);
+    free(in.unit);
+    free(in.positive);
+
+    return withinBounds ? 0 : 1;
+}
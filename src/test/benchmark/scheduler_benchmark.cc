@@ -0,0 +1,396 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Replays a recorded task load through the real scheduler with a simulated clock.
+ *
+ * The load profile is read from the output of the "tasks" CLI command: every task
+ * listed there is enabled and consumes CPU time matching the reported average and
+ * maximum execution times. Realtime tasks (PID, GYRO) use the reported rate as their
+ * period, RX is signalled at its reported rate, all other tasks keep their firmware
+ * default periods.
+ *
+ * Usage: scheduler_benchmark [-t tasks.txt] [-d seconds] [-m OFF|AVERAGE|MAX] [-s seed] [-o overhead_us]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+    #include "scheduler/scheduler.h"
+}
+
+#include "unittest_macros.h"
+
+extern "C" {
+    extern cfTask_t *currentTask;
+
+    uint32_t simulatedTime = 0;
+    uint32_t micros(void) {return simulatedTime;}
+
+    static void benchmarkTaskFunc(timeUs_t currentTimeUs);
+    static bool benchmarkRxCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTimeUs);
+
+    void taskRunRealtimeCallbacks(timeUs_t) {}
+
+#define BENCHMARK_TASK(name, period, priority) { \
+    .taskName = name, .taskFunc = benchmarkTaskFunc, .desiredPeriod = period, .staticPriority = priority }
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+    // Same periods and priorities as fc_tasks.c
+    cfTask_t cfTasks[TASK_COUNT] = {
+        [TASK_SYSTEM] = BENCHMARK_TASK("SYSTEM", TASK_PERIOD_HZ(10), TASK_PRIORITY_HIGH),
+        [TASK_PID] = BENCHMARK_TASK("PID", TASK_PERIOD_US(1000), TASK_PRIORITY_REALTIME),
+        [TASK_GYRO] = BENCHMARK_TASK("GYRO", TASK_PERIOD_US(250), TASK_PRIORITY_REALTIME),
+        [TASK_RX] = {
+            .taskName = "RX",
+            .checkFunc = benchmarkRxCheck,
+            .taskFunc = benchmarkTaskFunc,
+            .desiredPeriod = TASK_PERIOD_HZ(10),
+            .staticPriority = TASK_PRIORITY_HIGH,
+        },
+        [TASK_SERIAL] = BENCHMARK_TASK("SERIAL", TASK_PERIOD_HZ(100), TASK_PRIORITY_LOW),
+        [TASK_BATTERY] = BENCHMARK_TASK("BATTERY", TASK_PERIOD_HZ(50), TASK_PRIORITY_MEDIUM),
+        [TASK_TEMPERATURE] = BENCHMARK_TASK("TEMPERATURE", TASK_PERIOD_HZ(100), TASK_PRIORITY_LOW),
+        [TASK_BEEPER] = BENCHMARK_TASK("BEEPER", TASK_PERIOD_HZ(100), TASK_PRIORITY_MEDIUM),
+        [TASK_GPS] = BENCHMARK_TASK("GPS", TASK_PERIOD_HZ(50), TASK_PRIORITY_MEDIUM),
+        [TASK_COMPASS] = BENCHMARK_TASK("COMPASS", TASK_PERIOD_HZ(10), TASK_PRIORITY_MEDIUM),
+        [TASK_BARO] = BENCHMARK_TASK("BARO", TASK_PERIOD_HZ(20), TASK_PRIORITY_MEDIUM),
+        [TASK_PITOT] = BENCHMARK_TASK("PITOT", TASK_PERIOD_MS(20), TASK_PRIORITY_MEDIUM),
+        [TASK_RANGEFINDER] = BENCHMARK_TASK("RANGEFINDER", TASK_PERIOD_MS(70), TASK_PRIORITY_MEDIUM),
+        [TASK_DASHBOARD] = BENCHMARK_TASK("DASHBOARD", TASK_PERIOD_HZ(10), TASK_PRIORITY_LOW),
+        [TASK_TELEMETRY] = BENCHMARK_TASK("TELEMETRY", TASK_PERIOD_HZ(500), TASK_PRIORITY_IDLE),
+        [TASK_LEDSTRIP] = BENCHMARK_TASK("LEDSTRIP", TASK_PERIOD_HZ(100), TASK_PRIORITY_IDLE),
+        [TASK_PWMDRIVER] = BENCHMARK_TASK("SERVOS", TASK_PERIOD_HZ(200), TASK_PRIORITY_HIGH),
+        [TASK_OSD] = BENCHMARK_TASK("OSD", TASK_PERIOD_HZ(250), TASK_PRIORITY_LOW),
+        [TASK_CMS] = BENCHMARK_TASK("CMS", TASK_PERIOD_HZ(50), TASK_PRIORITY_LOW),
+        [TASK_OPFLOW] = BENCHMARK_TASK("OPFLOW", TASK_PERIOD_HZ(100), TASK_PRIORITY_MEDIUM),
+        [TASK_VTXCTRL] = BENCHMARK_TASK("VTXCTRL", TASK_PERIOD_HZ(5), TASK_PRIORITY_IDLE),
+        [TASK_PROGRAMMING_FRAMEWORK] = BENCHMARK_TASK("PROGRAMMING", TASK_PERIOD_HZ(10), TASK_PRIORITY_IDLE),
+        [TASK_RPM_FILTER] = BENCHMARK_TASK("RPM", TASK_PERIOD_HZ(500), TASK_PRIORITY_LOW),
+        [TASK_AUX] = BENCHMARK_TASK("AUX", TASK_PERIOD_HZ(100), TASK_PRIORITY_HIGH),
+    };
+#pragma GCC diagnostic pop
+}
+
+typedef struct {
+    bool enabled;
+    uint32_t rateHz;                    // as reported by the firmware
+    uint32_t maxExecutionTime;
+    uint32_t averageExecutionTime;
+
+    std::vector<int32_t> latencies;     // start time minus the time the task became due
+    std::vector<int32_t> periods;       // time between consecutive starts
+    uint32_t starvedCount;              // started more than one full period late
+} taskLoad_t;
+
+static taskLoad_t taskLoad[TASK_COUNT];
+
+static uint32_t rngState = 1;
+static uint32_t rxFrameIntervalUs = 20000;
+static timeUs_t rxNextFrameAt = 0;
+
+// Taken from the "tasks" output of a F7 quad at 1kHz PID loop / 4kHz gyro
+static const char *defaultTrace =
+    " 0 -       SYSTEM       10       6       1    0.0%    0.0%         0\n"
+    " 1 -          PID     1000     209     120   21.4%   12.5%      3412\n"
+    " 2 -         GYRO     4000      38      19   15.7%    8.1%      2193\n"
+    " 3 -           RX       50      44      25    0.2%    0.1%        21\n"
+    " 4 -       SERIAL      100     120       7    1.2%    0.0%        18\n"
+    " 5 -      BATTERY       50      16       4    0.0%    0.0%         5\n"
+    " 6 -  TEMPERATURE      100       3       1    0.0%    0.0%         2\n"
+    " 7 -       BEEPER      100       7       1    0.0%    0.0%         3\n"
+    " 8 -          GPS       50      62      13    0.3%    0.0%        19\n"
+    "10 -         BARO       20      51      21    0.1%    0.0%         6\n"
+    "17 -          OSD      250     430      48   10.7%    1.2%       372\n"
+    "22 -          RPM      500       5       2    0.2%    0.1%        30\n"
+    "23 -          AUX      100      22       9    0.2%    0.0%        27\n";
+
+static uint32_t nextRandom(void)
+{
+    // xorshift32, keeps runs reproducible for a given seed
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+/*
+ * Execution time model: the reported maximum is hit once every 32 calls on average,
+ * the remaining calls are spread +/-20% around a base chosen so the mean matches the
+ * reported average.
+ */
+static uint32_t sampleExecutionTime(const taskLoad_t *load)
+{
+    const float tailProbability = 1.0f / 32;
+
+    if (load->maxExecutionTime <= load->averageExecutionTime) {
+        return load->averageExecutionTime;
+    }
+    if ((nextRandom() % 32) == 0) {
+        return load->maxExecutionTime;
+    }
+
+    const float base = std::max(0.0f, (load->averageExecutionTime - tailProbability * load->maxExecutionTime) / (1.0f - tailProbability));
+    const float jitter = ((nextRandom() % 4001) / 10000.0f) - 0.2f;
+    return (uint32_t)lrintf(base * (1.0f + jitter));
+}
+
+static void benchmarkTaskFunc(timeUs_t currentTimeUs)
+{
+    cfTask_t *task = currentTask;
+    taskLoad_t *load = &taskLoad[task - cfTasks];
+
+    int32_t latency;
+    if (task->checkFunc) {
+        latency = (int32_t)(currentTimeUs - task->lastSignaledAt);
+    } else {
+        latency = task->taskLatestDeltaTime - task->desiredPeriod;
+    }
+    load->latencies.push_back(latency);
+    load->periods.push_back(task->taskLatestDeltaTime);
+    if (latency > task->desiredPeriod) {
+        load->starvedCount++;
+    }
+
+    simulatedTime += sampleExecutionTime(load);
+}
+
+static bool benchmarkRxCheck(timeUs_t currentTimeUs, timeDelta_t currentDeltaTimeUs)
+{
+    UNUSED(currentDeltaTimeUs);
+
+    if ((int32_t)(currentTimeUs - rxNextFrameAt) >= 0) {
+        rxNextFrameAt += rxFrameIntervalUs;
+        return true;
+    }
+    return false;
+}
+
+static int findTaskByName(const std::string &name)
+{
+    for (int taskId = 0; taskId < TASK_COUNT; taskId++) {
+        if (name == cfTasks[taskId].taskName) {
+            return taskId;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Parses one line of "tasks" CLI output:
+ * "%2d - %12s  %6d   %5d   %5d %4d.%1d%% %4d.%1d%%  %8d"
+ */
+static bool parseTaskLine(const char *line)
+{
+    const char *separator = strstr(line, " - ");
+    if (!separator) {
+        return false;
+    }
+
+    // Task name may contain spaces, it is followed by rate, max, avg, maxload, avgload and total
+    std::vector<std::string> tokens;
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", separator + 3);
+    for (char *token = strtok(buffer, " \t\r\n"); token; token = strtok(NULL, " \t\r\n")) {
+        tokens.push_back(token);
+    }
+    if (tokens.size() < 7) {
+        return false;
+    }
+
+    std::string name;
+    for (size_t i = 0; i < tokens.size() - 6; i++) {
+        name += (i ? " " : "") + tokens[i];
+    }
+
+    const int taskId = findTaskByName(name);
+    if (taskId < 0) {
+        fprintf(stderr, "Unknown task '%s' ignored\n", name.c_str());
+        return false;
+    }
+
+    const size_t values = tokens.size() - 6;
+    taskLoad[taskId].enabled = true;
+    taskLoad[taskId].rateHz = strtoul(tokens[values].c_str(), NULL, 10);
+    taskLoad[taskId].maxExecutionTime = strtoul(tokens[values + 1].c_str(), NULL, 10);
+    taskLoad[taskId].averageExecutionTime = strtoul(tokens[values + 2].c_str(), NULL, 10);
+    return true;
+}
+
+static bool loadTrace(const char *fileName)
+{
+    FILE *f = fileName ? fopen(fileName, "r") : fmemopen((void *)defaultTrace, strlen(defaultTrace), "r");
+    if (!f) {
+        fprintf(stderr, "Can't open %s\n", fileName);
+        return false;
+    }
+
+    char line[256];
+    int taskCount = 0;
+    while (fgets(line, sizeof(line), f)) {
+        taskCount += parseTaskLine(line) ? 1 : 0;
+    }
+    fclose(f);
+
+    if (taskCount == 0) {
+        fprintf(stderr, "No tasks found in trace\n");
+        return false;
+    }
+    return true;
+}
+
+static int32_t percentile(std::vector<int32_t> &samples, int percent)
+{
+    if (samples.empty()) {
+        return 0;
+    }
+    std::sort(samples.begin(), samples.end());
+    const size_t index = std::min(samples.size() - 1, (samples.size() * percent) / 100);
+    return samples[index];
+}
+
+static void reportLoopJitter(cfTaskId_e taskId)
+{
+    taskLoad_t *load = &taskLoad[taskId];
+    if (load->periods.size() < 2) {
+        return;
+    }
+
+    double sum = 0, sumSq = 0;
+    std::vector<int32_t> deviation;
+    // first period is measured from boot
+    for (size_t i = 1; i < load->periods.size(); i++) {
+        sum += load->periods[i];
+        sumSq += (double)load->periods[i] * load->periods[i];
+        deviation.push_back(abs(load->periods[i] - cfTasks[taskId].desiredPeriod));
+    }
+    const double count = load->periods.size() - 1;
+    const double mean = sum / count;
+    const double stddev = sqrt(std::max(0.0, sumSq / count - mean * mean));
+
+    printf("%-12s period %7.1fus (desired %dus)  stddev %6.1fus  |jitter| p50 %4d p99 %4d max %5d us\n",
+        cfTasks[taskId].taskName, mean, cfTasks[taskId].desiredPeriod, stddev,
+        percentile(deviation, 50), percentile(deviation, 99), percentile(deviation, 100));
+}
+
+int main(int argc, char *argv[])
+{
+    const char *traceFile = NULL;
+    double durationSec = 10;
+    schedulerDeadlineMode_e deadlineMode = SCHEDULER_DEADLINE_OFF;
+    uint32_t overheadUs = 2;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:d:m:s:o:h")) != -1) {
+        switch (opt) {
+        case 't':
+            traceFile = optarg;
+            break;
+        case 'd':
+            durationSec = atof(optarg);
+            break;
+        case 'm':
+            if (!strcasecmp(optarg, "AVERAGE")) {
+                deadlineMode = SCHEDULER_DEADLINE_AVERAGE;
+            } else if (!strcasecmp(optarg, "MAX")) {
+                deadlineMode = SCHEDULER_DEADLINE_MAX;
+            }
+            break;
+        case 's':
+            rngState = std::max(1ul, strtoul(optarg, NULL, 10));
+            break;
+        case 'o':
+            overheadUs = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-t tasks.txt] [-d seconds] [-m OFF|AVERAGE|MAX] [-s seed] [-o overhead_us]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (!loadTrace(traceFile)) {
+        return 1;
+    }
+
+    schedulerInit();
+    schedulerSetDeadlineMode(deadlineMode);
+    for (int taskId = 0; taskId < TASK_COUNT; taskId++) {
+        const taskLoad_t *load = &taskLoad[taskId];
+        if (!load->enabled) {
+            continue;
+        }
+        if (cfTasks[taskId].staticPriority == TASK_PRIORITY_REALTIME && load->rateHz > 0) {
+            rescheduleTask((cfTaskId_e)taskId, TASK_PERIOD_HZ(load->rateHz));
+        }
+        if (taskId == TASK_RX && load->rateHz > 0) {
+            rxFrameIntervalUs = TASK_PERIOD_HZ(load->rateHz);
+        }
+        setTaskEnabled((cfTaskId_e)taskId, true);
+    }
+    if (!taskLoad[TASK_SYSTEM].enabled) {
+        setTaskEnabled(TASK_SYSTEM, false);
+    }
+
+    const uint64_t durationUs = (uint64_t)(durationSec * 1e6);
+    uint64_t elapsedUs = 0;
+    uint64_t idleCycles = 0, cycles = 0;
+    while (elapsedUs < durationUs) {
+        const uint32_t startTime = simulatedTime;
+        scheduler();
+        if (!currentTask) {
+            idleCycles++;
+        }
+        cycles++;
+        simulatedTime += overheadUs;
+        elapsedUs += simulatedTime - startTime;
+    }
+
+    printf("Simulated %.1fs, %llu scheduler cycles (%.1f%% idle), deadline mode %s, %u tasks deferred\n\n",
+        durationSec, (unsigned long long)cycles, 100.0 * idleCycles / cycles,
+        deadlineMode == SCHEDULER_DEADLINE_OFF ? "OFF" : (deadlineMode == SCHEDULER_DEADLINE_AVERAGE ? "AVERAGE" : "MAX"),
+        schedulerGetDeferredTaskCount());
+
+    reportLoopJitter(TASK_GYRO);
+    reportLoopJitter(TASK_PID);
+
+    printf("\nTask            runs   rate/hz  latency/us p50    p90    p99    max   starved\n");
+    for (int taskId = 0; taskId < TASK_COUNT; taskId++) {
+        taskLoad_t *load = &taskLoad[taskId];
+        if (!load->enabled) {
+            continue;
+        }
+        std::vector<int32_t> &latencies = load->latencies;
+        printf("%-12s %7u %9.1f %15d %6d %6d %6d %9u\n",
+            cfTasks[taskId].taskName, (unsigned)latencies.size(), latencies.size() / durationSec,
+            percentile(latencies, 50), percentile(latencies, 90), percentile(latencies, 99), percentile(latencies, 100),
+            load->starvedCount);
+    }
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+    #include "drivers/accgyro/accgyro.h"
+    #include "drivers/accgyro/accgyro_fake.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static gyroDev_t gyroDev;
+
+static void initFakeGyro(uint8_t fifoBurstSamples)
+{
+    memset(&gyroDev, 0, sizeof(gyroDev));
+    gyroDev.requestedFifoBurstSamples = fifoBurstSamples;
+    fakeGyroDetect(&gyroDev);
+    gyroDev.initFn(&gyroDev);
+}
+
+TEST(AccGyroFakeUnittest, TestFifoDisabledByDefault)
+{
+    initFakeGyro(0);
+
+    EXPECT_EQ(NULL, gyroDev.readFifoFn);
+
+    fakeGyroSet(1, 2, 3);
+    EXPECT_EQ(0, fakeGyroFifoLevel());
+
+    EXPECT_TRUE(gyroDev.readFn(&gyroDev));
+    EXPECT_EQ(1, gyroDev.gyroADCRaw[X]);
+    EXPECT_EQ(2, gyroDev.gyroADCRaw[Y]);
+    EXPECT_EQ(3, gyroDev.gyroADCRaw[Z]);
+}
+
+TEST(AccGyroFakeUnittest, TestFifoReturnsSamplesInOrder)
+{
+    initFakeGyro(4);
+    ASSERT_NE((void *)NULL, (void *)gyroDev.readFifoFn);
+
+    for (int i = 0; i < 5; i++) {
+        fakeGyroSet(i, -i, 10 * i);
+    }
+    EXPECT_EQ(5, fakeGyroFifoLevel());
+
+    float samples[GYRO_FIFO_MAX_SAMPLES][XYZ_AXIS_COUNT];
+
+    // Burst is limited by the caller, the rest stays queued
+    EXPECT_EQ(3, gyroDev.readFifoFn(&gyroDev, samples, 3));
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(i, samples[i][X]);
+        EXPECT_EQ(-i, samples[i][Y]);
+        EXPECT_EQ(10 * i, samples[i][Z]);
+    }
+
+    // Single sample view follows the newest drained sample
+    EXPECT_EQ(2, gyroDev.gyroADCRaw[X]);
+
+    EXPECT_EQ(2, gyroDev.readFifoFn(&gyroDev, samples, GYRO_FIFO_MAX_SAMPLES));
+    EXPECT_EQ(3, samples[0][X]);
+    EXPECT_EQ(4, samples[1][X]);
+
+    EXPECT_EQ(0, gyroDev.readFifoFn(&gyroDev, samples, GYRO_FIFO_MAX_SAMPLES));
+    EXPECT_EQ(0, fakeGyroFifoLevel());
+}
+
+TEST(AccGyroFakeUnittest, TestFifoDropsSamplesWhenFull)
+{
+    initFakeGyro(8);
+
+    for (int i = 0; i < 100; i++) {
+        fakeGyroSet(i, 0, 0);
+    }
+
+    const uint8_t level = fakeGyroFifoLevel();
+    EXPECT_GT(level, GYRO_FIFO_MAX_SAMPLES);
+    EXPECT_LT(level, 100);
+
+    // Oldest samples are kept
+    float samples[GYRO_FIFO_MAX_SAMPLES][XYZ_AXIS_COUNT];
+    EXPECT_EQ(GYRO_FIFO_MAX_SAMPLES, gyroDev.readFifoFn(&gyroDev, samples, GYRO_FIFO_MAX_SAMPLES));
+    EXPECT_EQ(0, samples[0][X]);
+    EXPECT_EQ(GYRO_FIFO_MAX_SAMPLES - 1, samples[GYRO_FIFO_MAX_SAMPLES - 1][X]);
+}
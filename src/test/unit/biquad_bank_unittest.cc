@@ -0,0 +1,239 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+    #include "common/axis.h"
+    #include "common/biquad_bank.h"
+    #include "common/filter.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define LOOPTIME_US     500
+#define MOTOR_COUNT     12
+#define HARMONICS       3
+#define SAMPLE_COUNT    4000
+
+static biquadFilter_t referenceFilters[XYZ_AXIS_COUNT][BIQUAD_BANK_MAX_STAGES];
+static biquadBank_t bank;
+
+static float notchFrequency(int motor, int harmonic)
+{
+    return (90.0f + 11.0f * motor) * (harmonic + 1);
+}
+
+// Octo-sized worst case, every stage of the bank in use
+static void initBank(void)
+{
+    biquadBankInit(&bank);
+
+    for (int motor = 0; motor < MOTOR_COUNT; motor++) {
+        for (int harmonic = 0; harmonic < HARMONICS; harmonic++) {
+            const int stage = motor * HARMONICS + harmonic;
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                biquadFilterInit(&referenceFilters[axis][stage], notchFrequency(motor, harmonic), LOOPTIME_US, 5.0f, FILTER_NOTCH);
+            }
+            EXPECT_EQ(stage, biquadBankAddStage(&bank, &referenceFilters[X][stage]));
+        }
+    }
+}
+
+static float gyroSample(int n, int axis)
+{
+    const float t = n * LOOPTIME_US * 1e-6f;
+    return 200.0f * sinf(2 * (float)M_PI * (2.0f + axis) * t) + 30.0f * sinf(2 * (float)M_PI * 143.0f * t) + 10.0f * sinf(2 * (float)M_PI * (310.0f + 20 * axis) * t);
+}
+
+TEST(BiquadBankUnittest, TestStageLimit)
+{
+    initBank();
+
+    biquadFilter_t filter;
+    biquadFilterInit(&filter, 100, LOOPTIME_US, 1.0f, FILTER_NOTCH);
+    EXPECT_EQ(-1, biquadBankAddStage(&bank, &filter));
+    EXPECT_EQ(BIQUAD_BANK_MAX_STAGES, bank.stageCount);
+}
+
+// Selected kernel (SSE on x86 hosts) keeps the DF1 operation order, so results are bit exact
+TEST(BiquadBankUnittest, TestMatchesDF1)
+{
+    initBank();
+
+    for (int n = 0; n < SAMPLE_COUNT; n++) {
+        float sample[XYZ_AXIS_COUNT];
+        float reference[XYZ_AXIS_COUNT];
+
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            sample[axis] = reference[axis] = gyroSample(n, axis);
+            for (int stage = 0; stage < bank.stageCount; stage++) {
+                reference[axis] = biquadFilterApplyDF1(&referenceFilters[axis][stage], reference[axis]);
+            }
+        }
+
+        biquadBankApply(&bank, sample);
+
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            ASSERT_EQ(reference[axis], sample[axis]) << "sample " << n << " axis " << axis;
+        }
+    }
+}
+
+TEST(BiquadBankUnittest, TestScalarMatchesSelectedKernel)
+{
+    static biquadBank_t scalarBank;
+
+    initBank();
+    scalarBank = bank;
+
+    for (int n = 0; n < SAMPLE_COUNT; n++) {
+        float sample[XYZ_AXIS_COUNT];
+        float scalarSample[XYZ_AXIS_COUNT];
+
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            sample[axis] = scalarSample[axis] = gyroSample(n, axis);
+        }
+
+        biquadBankApply(&bank, sample);
+        biquadBankApplyScalar(&scalarBank, scalarSample);
+
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            ASSERT_EQ(scalarSample[axis], sample[axis]) << "sample " << n << " axis " << axis;
+        }
+    }
+}
+
+// biquadFilterApply uses transposed direct form II, same transfer function with different rounding
+TEST(BiquadBankUnittest, TestMatchesBiquadFilterApply)
+{
+    initBank();
+
+    float maxError = 0.0f;
+
+    for (int n = 0; n < SAMPLE_COUNT; n++) {
+        float sample[XYZ_AXIS_COUNT];
+        float reference[XYZ_AXIS_COUNT];
+
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            sample[axis] = reference[axis] = gyroSample(n, axis);
+            for (int stage = 0; stage < bank.stageCount; stage++) {
+                reference[axis] = biquadFilterApply(&referenceFilters[axis][stage], reference[axis]);
+            }
+        }
+
+        biquadBankApply(&bank, sample);
+
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            maxError = fmaxf(maxError, fabsf(reference[axis] - sample[axis]));
+        }
+    }
+
+    EXPECT_LT(maxError, 0.01f);
+}
+
+TEST(BiquadBankUnittest, TestCoefficientUpdateKeepsState)
+{
+    initBank();
+
+    for (int n = 0; n < SAMPLE_COUNT; n++) {
+        float sample[XYZ_AXIS_COUNT];
+        float reference[XYZ_AXIS_COUNT];
+
+        // Sweep one notch the way the RPM filter update task does
+        if (n % 10 == 0) {
+            const float frequency = 120.0f + 0.02f * n;
+            for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                biquadFilterUpdate(&referenceFilters[axis][4], frequency, LOOPTIME_US, 5.0f, FILTER_NOTCH);
+            }
+            biquadBankSetCoefficients(&bank, 4, &referenceFilters[X][4]);
+        }
+
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            sample[axis] = reference[axis] = gyroSample(n, axis);
+            for (int stage = 0; stage < bank.stageCount; stage++) {
+                reference[axis] = biquadFilterApplyDF1(&referenceFilters[axis][stage], reference[axis]);
+            }
+        }
+
+        biquadBankApply(&bank, sample);
+
+        for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+            ASSERT_EQ(reference[axis], sample[axis]) << "sample " << n << " axis " << axis;
+        }
+    }
+}
+
+TEST(BiquadBankUnittest, TestFastNotchUpdateMatchesInit)
+{
+    biquadFilter_t reference;
+    biquadFilter_t fast;
+
+    // Whole Hz only, biquadFilterInit rounds the frequency
+    for (int frequency = 30; frequency < 980; frequency += 7) {
+        biquadFilterInit(&reference, frequency, LOOPTIME_US, 3.0f, FILTER_NOTCH);
+        biquadFilterUpdateNotchFast(&fast, frequency, LOOPTIME_US, 3.0f);
+
+        EXPECT_NEAR(reference.b0, fast.b0, 2e-3f) << frequency << "Hz";
+        EXPECT_NEAR(reference.b1, fast.b1, 2e-3f) << frequency << "Hz";
+        EXPECT_NEAR(reference.b2, fast.b2, 2e-3f) << frequency << "Hz";
+        EXPECT_NEAR(reference.a1, fast.a1, 2e-3f) << frequency << "Hz";
+        EXPECT_NEAR(reference.a2, fast.a2, 2e-3f) << frequency << "Hz";
+    }
+}
+
+// The centre frequency follows from cos(omega), where sin(omega) is small any cos error moves it the most
+TEST(BiquadBankUnittest, TestFastNotchFrequencyErrorAtLowEnd)
+{
+    const uint32_t looptimes[] = { 125, 250, 500 };
+    biquadFilter_t fast;
+
+    for (uint32_t looptime : looptimes) {
+        for (float frequency = 20.0f; frequency < 120.0f; frequency += 0.37f) {
+            biquadFilterUpdateNotchFast(&fast, frequency, looptime, 3.0f);
+
+            // b1 = -2 * cos(omega) * b0
+            const double omega = acos(-(double)fast.b1 / (2.0 * fast.b0));
+            const double centre = omega / (2 * M_PI * looptime * 1e-6);
+            EXPECT_NEAR(frequency, centre, 0.05) << looptime << "us";
+        }
+    }
+}
+
+TEST(BiquadBankUnittest, TestCachedNotchUpdateHysteresis)
+{
+    biquadFilter_t notch;
+    float appliedFrequency = 0.0f;
+
+    EXPECT_TRUE(biquadFilterUpdateNotchCached(&notch, &appliedFrequency, 200.0f, LOOPTIME_US, 3.0f, 0.5f));
+    EXPECT_FLOAT_EQ(200.0f, appliedFrequency);
+
+    // Small moves keep the last coefficients
+    EXPECT_FALSE(biquadFilterUpdateNotchCached(&notch, &appliedFrequency, 200.3f, LOOPTIME_US, 3.0f, 0.5f));
+    EXPECT_FALSE(biquadFilterUpdateNotchCached(&notch, &appliedFrequency, 199.6f, LOOPTIME_US, 3.0f, 0.5f));
+    EXPECT_FLOAT_EQ(200.0f, appliedFrequency);
+
+    EXPECT_TRUE(biquadFilterUpdateNotchCached(&notch, &appliedFrequency, 200.6f, LOOPTIME_US, 3.0f, 0.5f));
+    EXPECT_FLOAT_EQ(200.6f, appliedFrequency);
+
+    // Zero hysteresis updates on every new frequency
+    EXPECT_TRUE(biquadFilterUpdateNotchCached(&notch, &appliedFrequency, 200.61f, LOOPTIME_US, 3.0f, 0.0f));
+}
@@ -0,0 +1,249 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+    #include "blackbox/blackbox_compression.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+typedef std::vector<uint8_t> bytes_t;
+
+static uint32_t rng;
+
+static uint32_t nextRandom(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+// Looks like P-frames: the same tags, fields that keep their delta for a while, the odd large one
+static bytes_t framesLike(int count)
+{
+    int32_t fields[30] = { 0 };
+    bytes_t data;
+
+    rng = 2463534242u;
+    while ((int)data.size() < count) {
+        data.push_back('P');
+        for (int32_t &value : fields) {
+            const uint32_t r = nextRandom();
+            if ((r & 0x300) == 0) {
+                value = (r & 0xF000) == 0 ? (int32_t)(r % 8001) - 4000 : (int32_t)(r % 7) - 3;
+            }
+            uint32_t zigzag = (uint32_t)((value << 1) ^ (value >> 31));
+            while (zigzag > 127) {
+                data.push_back((uint8_t)(zigzag | 0x80));
+                zigzag >>= 7;
+            }
+            data.push_back(zigzag);
+        }
+    }
+    data.resize(count);
+
+    return data;
+}
+
+static bytes_t randomBytes(int count)
+{
+    bytes_t data(count);
+
+    rng = 88675123u;
+    for (uint8_t &byte : data) {
+        byte = nextRandom() >> 24;
+    }
+
+    return data;
+}
+
+// Feeds the compressor in uneven pieces like blackboxWriteBufferFlush() does, optionally dropping one block
+static bytes_t compress(const bytes_t &data, int droppedBlock = -1)
+{
+    static blackboxCompressor_t compressor;
+    static uint8_t block[BLACKBOX_COMPRESSION_MAX_OUTPUT + 4];
+    bytes_t stream;
+    int blockIndex = 0;
+
+    blackboxCompressorInit(&compressor);
+    rng = 521288629u;
+
+    for (size_t written = 0; written < data.size(); ) {
+        const int piece = std::min<int>(1 + nextRandom() % 200, data.size() - written);
+
+        for (int appended = 0; appended < piece; ) {
+            appended += blackboxCompressorAppend(&compressor, &data[written + appended], piece - appended);
+
+            if (blackboxCompressorBlockFull(&compressor)) {
+                const int length = blackboxCompressBlock(&compressor, block);
+                EXPECT_LE(length, BLACKBOX_COMPRESSION_MAX_OUTPUT);
+                if (blockIndex++ != droppedBlock) {
+                    stream.insert(stream.end(), block, block + length);
+                }
+            }
+        }
+        written += piece;
+    }
+
+    const int length = blackboxCompressorEnd(&compressor, block);
+    stream.insert(stream.end(), block, block + length);
+
+    return stream;
+}
+
+// Returns the decoded frames, stops at the end of stream marker
+static bytes_t decompress(const bytes_t &stream, bool *ended = NULL)
+{
+    static blackboxDecompressor_t decompressor;
+    bytes_t data;
+    size_t position = 0;
+
+    blackboxDecompressorInit(&decompressor);
+
+    while (position < stream.size() && !decompressor.ended) {
+        const uint8_t *out;
+        int outCount;
+        const int used = blackboxDecompressBlock(&decompressor, &stream[position], stream.size() - position, &out, &outCount);
+
+        if (used == 0) {
+            break;
+        }
+        if (used < 0) {
+            position++;
+            continue;
+        }
+
+        data.insert(data.end(), out, out + outCount);
+        position += used;
+    }
+
+    if (ended) {
+        *ended = decompressor.ended;
+    }
+
+    return data;
+}
+
+TEST(BlackboxCompressionTest, TestRoundTripFrames)
+{
+    const bytes_t data = framesLike(100000);
+    const bytes_t stream = compress(data);
+    bool ended;
+
+    EXPECT_EQ(data, decompress(stream, &ended));
+    EXPECT_TRUE(ended);
+
+    // Frames mostly repeat the one before, which is well within the window
+    EXPECT_LT(stream.size(), data.size() * 3 / 4);
+}
+
+TEST(BlackboxCompressionTest, TestRoundTripRandom)
+{
+    const bytes_t data = randomBytes(20000);
+    const bytes_t stream = compress(data);
+
+    EXPECT_EQ(data, decompress(stream));
+    // Incompressible blocks grow by no more than their header and length extensions
+    const size_t blocks = (data.size() + BLACKBOX_COMPRESSION_BLOCK_SIZE - 1) / BLACKBOX_COMPRESSION_BLOCK_SIZE;
+    EXPECT_LE(stream.size(), data.size() + blocks * 9 + 4);
+}
+
+TEST(BlackboxCompressionTest, TestRoundTripLongRuns)
+{
+    bytes_t data(5000, 0);
+    memset(&data[2000], 0x55, 1000);
+
+    const bytes_t stream = compress(data);
+
+    EXPECT_EQ(data, decompress(stream));
+    EXPECT_LT(stream.size(), 200u);
+}
+
+TEST(BlackboxCompressionTest, TestEmptyStream)
+{
+    bool ended;
+
+    const bytes_t stream = compress(bytes_t());
+    EXPECT_EQ(4u, stream.size());
+    EXPECT_TRUE(decompress(stream, &ended).empty());
+    EXPECT_TRUE(ended);
+}
+
+TEST(BlackboxCompressionTest, TestPartialLastBlock)
+{
+    const bytes_t data = framesLike(BLACKBOX_COMPRESSION_BLOCK_SIZE * 3 + 17);
+
+    EXPECT_EQ(data, decompress(compress(data)));
+}
+
+TEST(BlackboxCompressionTest, TestResyncAfterDroppedBlock)
+{
+    const int dropped = 3;
+    const bytes_t data = framesLike(BLACKBOX_COMPRESSION_BLOCK_SIZE * BLACKBOX_COMPRESSION_RESET_INTERVAL * 3);
+    const bytes_t decoded = decompress(compress(data, dropped));
+
+    // Blocks before the dropped one decode, the rest of its reset interval is lost
+    const size_t before = BLACKBOX_COMPRESSION_BLOCK_SIZE * dropped;
+    const size_t resumed = BLACKBOX_COMPRESSION_BLOCK_SIZE * BLACKBOX_COMPRESSION_RESET_INTERVAL;
+
+    ASSERT_EQ(before + data.size() - resumed, decoded.size());
+    EXPECT_TRUE(std::equal(data.begin(), data.begin() + before, decoded.begin()));
+    EXPECT_TRUE(std::equal(data.begin() + resumed, data.end(), decoded.begin() + before));
+}
+
+TEST(BlackboxCompressionTest, TestIncompleteInput)
+{
+    const bytes_t stream = compress(framesLike(2000));
+    blackboxDecompressor_t decompressor;
+    const uint8_t *out;
+    int outCount;
+
+    blackboxDecompressorInit(&decompressor);
+
+    // Every prefix of the first block asks for more data
+    for (int length = 0; length < 9; length++) {
+        EXPECT_EQ(0, blackboxDecompressBlock(&decompressor, stream.data(), length, &out, &outCount));
+    }
+}
+
+TEST(BlackboxCompressionTest, TestCorruptStreamStaysInBounds)
+{
+    const bytes_t data = framesLike(30000);
+    const bytes_t clean = compress(data);
+
+    for (int n = 0; n < 200; n++) {
+        bytes_t stream = clean;
+
+        rng = 3816402881u + n;
+        for (int i = 0; i < 8; i++) {
+            stream[nextRandom() % stream.size()] = nextRandom() >> 24;
+        }
+
+        // Must not crash or run past the buffers, the decoded length is bounded by the input
+        const bytes_t decoded = decompress(stream);
+        EXPECT_LE(decoded.size(), data.size() + BLACKBOX_COMPRESSION_BLOCK_SIZE * 8);
+    }
+}
@@ -0,0 +1,287 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "blackbox/blackbox.h"
+    #include "blackbox/blackbox_io.h"
+
+    #include "config/parameter_group.h"
+    #include "config/parameter_group_ids.h"
+
+    #include "drivers/serial.h"
+
+    PG_REGISTER(blackboxConfig_t, blackboxConfig, PG_BLACKBOX_CONFIG, 0);
+
+    extern serialPort_t *blackboxPort;
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define FRAMES_PER_SYNC_POINT   8
+
+typedef std::vector<uint8_t> bytes_t;
+
+static serialPort_t port;
+static struct serialPortVTable vTable;
+static uint32_t txFree;
+static uint32_t txPerFrame;     // What the device takes between two frames
+
+static bytes_t logged;      // Everything the encoder wrote
+static bytes_t device;      // What reached the port
+static uint32_t frameIndex;
+
+static void portWriteBuf(serialPort_t *instance, const void *data, int count)
+{
+    UNUSED(instance);
+    const uint8_t *p = (const uint8_t *)data;
+    txFree -= count;
+    device.insert(device.end(), p, p + count);
+}
+
+static void resetDevice(void)
+{
+    memset(&port, 0, sizeof(port));
+    vTable.writeBuf = portWriteBuf;
+    port.vTable = &vTable;
+    blackboxPort = &port;
+    blackboxConfigMutable()->device = BLACKBOX_DEVICE_SERIAL;
+    blackboxWriteBuffer.count = 0;
+    txPerFrame = 1 << 20;
+
+    logged.clear();
+    device.clear();
+    frameIndex = 0;
+}
+
+// Frames of varying length that carry their index, every FRAMES_PER_SYNC_POINT one is an I-frame
+static void writeFrame(void)
+{
+    const bool intraframe = frameIndex % FRAMES_PER_SYNC_POINT == 0;
+
+    if (intraframe) {
+        blackboxDeviceMarkPretriggerSyncPoint();
+    }
+
+    bytes_t frame;
+    frame.push_back(intraframe ? 'I' : 'P');
+    for (int i = 0; i < 4; i++) {
+        frame.push_back(frameIndex >> (8 * i));
+    }
+    frame.resize(20 + frameIndex % 37, 0x55);
+
+    for (uint8_t byte : frame) {
+        blackboxWrite(byte);
+    }
+    logged.insert(logged.end(), frame.begin(), frame.end());
+
+    txFree = txPerFrame;
+    blackboxDeviceFlush();
+    frameIndex++;
+}
+
+static void writeFrames(int count)
+{
+    while (count-- > 0) {
+        writeFrame();
+    }
+}
+
+// Offset of data in what was logged, -1 if it isn't a contiguous piece of it
+static int findInLogged(const bytes_t &data)
+{
+    const auto it = std::search(logged.begin(), logged.end(), data.begin(), data.end());
+    return it == logged.end() ? -1 : it - logged.begin();
+}
+
+TEST(BlackboxIoTest, TestNothingWrittenBeforeTrigger)
+{
+    resetDevice();
+    blackboxDeviceBeginPretrigger();
+
+    writeFrames(3000);
+
+    EXPECT_TRUE(device.empty());
+    EXPECT_FALSE(blackboxDevicePretriggerPending());
+}
+
+TEST(BlackboxIoTest, TestCommitStartsAtSyncPointWithinBuffer)
+{
+    resetDevice();
+    blackboxDeviceBeginPretrigger();
+
+    writeFrames(3000);
+    const size_t triggerOffset = logged.size();
+
+    blackboxDeviceCommitPretrigger();
+    writeFrames(100);
+    blackboxDeviceReleasePretrigger();
+    const size_t releaseOffset = logged.size();
+    writeFrames(1000);
+
+    EXPECT_FALSE(blackboxDevicePretriggerPending());
+    ASSERT_FALSE(device.empty());
+    EXPECT_EQ('I', device[0]);
+
+    // One piece of the log that ends at the release and goes back close to the buffer size
+    const int start = findInLogged(device);
+    ASSERT_GE(start, 0);
+    EXPECT_EQ(releaseOffset, start + device.size());
+    EXPECT_LE(triggerOffset - start, (size_t)BLACKBOX_PRETRIGGER_BUFFER_SIZE);
+    EXPECT_GT(triggerOffset - start, (size_t)BLACKBOX_PRETRIGGER_BUFFER_SIZE * 3 / 4);
+}
+
+TEST(BlackboxIoTest, TestSecondTriggerDoesNotRepeatFrames)
+{
+    resetDevice();
+    blackboxDeviceBeginPretrigger();
+
+    writeFrames(500);
+    blackboxDeviceCommitPretrigger();
+    writeFrames(20);
+    blackboxDeviceReleasePretrigger();
+    const size_t firstEnd = device.size();
+
+    // Shortly after, the buffer still holds frames that already went out
+    writeFrames(20);
+    blackboxDeviceCommitPretrigger();
+    writeFrames(20);
+    blackboxDeviceReleasePretrigger();
+
+    const bytes_t second(device.begin() + firstEnd, device.end());
+    ASSERT_FALSE(second.empty());
+    EXPECT_EQ('I', second[0]);
+    EXPECT_GE(findInLogged(second), findInLogged(bytes_t(device.begin(), device.begin() + firstEnd)) + (int)firstEnd);
+}
+
+TEST(BlackboxIoTest, TestSlowDeviceResumesAtSyncPoint)
+{
+    resetDevice();
+    blackboxDeviceBeginPretrigger();
+
+    writeFrames(3000);
+
+    // The device takes less than the frames need, the buffer overruns while committing
+    txPerFrame = 10;
+    blackboxDeviceCommitPretrigger();
+    writeFrames(3000);
+    txPerFrame = 1 << 20;
+    blackboxDeviceReleasePretrigger();
+    writeFrames(200);
+
+    EXPECT_FALSE(blackboxDevicePretriggerPending());
+
+    // Frames go out whole and in order, after a gap the next one is an I-frame
+    size_t position = 0;
+    uint32_t lastIndex = 0;
+    int gaps = 0;
+    while (position < device.size()) {
+        ASSERT_LE(position + 5, device.size());
+        uint32_t index = 0;
+        for (int i = 0; i < 4; i++) {
+            index |= device[position + 1 + i] << (8 * i);
+        }
+
+        if (position > 0 && index != lastIndex + 1) {
+            EXPECT_GT(index, lastIndex);
+            EXPECT_EQ('I', device[position]);
+            gaps++;
+        }
+
+        const size_t length = 20 + index % 37;
+        ASSERT_LE(position + length, device.size());
+        position += length;
+        lastIndex = index;
+    }
+    EXPECT_GT(gaps, 0);
+    // Frames dropped right before the release are lost, none after it go out
+    EXPECT_LE(lastIndex, frameIndex - 201);
+    EXPECT_GT(lastIndex, frameIndex - 201 - 200);
+    EXPECT_LT(device.size(), logged.size() / 2);
+}
+
+TEST(BlackboxIoTest, TestEndWithoutCommitKeepsOnlyLaterFrames)
+{
+    resetDevice();
+    blackboxDeviceBeginPretrigger();
+
+    writeFrames(1000);
+    blackboxDeviceEndPretrigger(false);
+
+    // Like the log end event
+    blackboxWrite('E');
+    blackboxWrite(0xFF);
+    blackboxDeviceFlush();
+
+    EXPECT_EQ(bytes_t({ 'E', 0xFF }), device);
+}
+
+TEST(BlackboxIoTest, TestEndWithCommit)
+{
+    resetDevice();
+    blackboxDeviceBeginPretrigger();
+
+    writeFrames(1000);
+    const size_t endOffset = logged.size();
+    blackboxDeviceEndPretrigger(true);
+
+    blackboxWrite('E');
+    blackboxWrite(0xFF);
+    while (blackboxDevicePretriggerPending() || blackboxWriteBuffer.count) {
+        blackboxDeviceFlush();
+    }
+
+    ASSERT_GT(device.size(), 2u);
+    EXPECT_EQ('I', device[0]);
+    EXPECT_EQ(endOffset, findInLogged(bytes_t(device.begin(), device.end() - 2)) + device.size() - 2);
+    EXPECT_EQ('E', device[device.size() - 2]);
+}
+
+// STUBS
+
+extern "C" {
+void serialWrite(serialPort_t *instance, uint8_t ch)
+{
+    portWriteBuf(instance, &ch, 1);
+}
+
+void serialWriteBuf(serialPort_t *instance, const uint8_t *data, int count)
+{
+    instance->vTable->writeBuf(instance, data, count);
+}
+
+bool isSerialTransmitBufferEmpty(const serialPort_t *instance)
+{
+    UNUSED(instance);
+    return true;
+}
+
+uint32_t serialTxBytesFree(const serialPort_t *instance)
+{
+    UNUSED(instance);
+    return txFree;
+}
+}
@@ -0,0 +1,554 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "blackbox/blackbox.h"
+    #include "blackbox/blackbox_io.h"
+
+    #include "build/debug.h"
+    #include "build/version.h"
+
+    #include "common/axis.h"
+    #include "common/encoding.h"
+    #include "common/maths.h"
+    #include "common/time.h"
+
+    #include "config/feature.h"
+    #include "config/parameter_group.h"
+    #include "config/parameter_group_ids.h"
+
+    #include "drivers/serial.h"
+    #include "drivers/time.h"
+
+    #include "fc/config.h"
+    #include "fc/controlrate_profile.h"
+    #include "fc/fc_core.h"
+    #include "fc/rc_controls.h"
+    #include "fc/rc_modes.h"
+    #include "fc/runtime_config.h"
+
+    #include "flight/failsafe.h"
+    #include "flight/imu.h"
+    #include "flight/mixer.h"
+    #include "flight/pid.h"
+    #include "flight/servos.h"
+
+    #include "io/beeper.h"
+    #include "io/gps.h"
+
+    #include "navigation/navigation.h"
+
+    #include "rx/rx.h"
+
+    #include "sensors/acceleration.h"
+    #include "sensors/barometer.h"
+    #include "sensors/battery.h"
+    #include "sensors/compass.h"
+    #include "sensors/diagnostics.h"
+    #include "sensors/gyro.h"
+    #include "sensors/sensors.h"
+
+    extern boxBitmask_t rcModeActivationMask;
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+typedef std::vector<uint8_t> bytes_t;
+
+static bytes_t logged;          // Everything that left the write buffer
+static int flushForceCount;
+static timeMs_t currentTimeMs;
+static uint32_t enabledFeatures = FEATURE_BLACKBOX | FEATURE_GPS;
+
+/*
+ * Logs at every PID loop, blackbox_deferred queues the iterations and
+ * blackboxUpdateDeferred() encodes them.
+ */
+class BlackboxDeferredTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        memset(blackboxConfigMutable(), 0, sizeof(blackboxConfig_t));
+        blackboxConfigMutable()->rate_num = 1;
+        blackboxConfigMutable()->rate_denom = 1;
+        blackboxConfigMutable()->deferred = 1;
+        blackboxConfigMutable()->navRateDenom = 1;
+        blackboxConfigMutable()->rcRateDenom = 1;
+        blackboxConfigMutable()->attitudeRateDenom = 1;
+        blackboxConfigMutable()->batteryRateDenom = 1;
+        blackboxConfigMutable()->includeFlags = 0xFFFFFFFF;
+        gyroConfigMutable()->looptime = 1000;
+
+        memset(&gpsSol, 0, sizeof(gpsSol));
+        gpsSol.fixType = GPS_FIX_3D;
+        setFlightModes(0);
+
+        // Run the state machine through the headers
+        blackboxInit();
+        blackboxStart();
+        flushForceCount = 0;
+        for (int i = 0; i < 1000 && flushForceCount == 0; i++) {
+            pidLoop();
+        }
+        ASSERT_GT(flushForceCount, 0);
+        logged.clear();
+    }
+
+    void TearDown() override
+    {
+        blackboxFinish();
+        blackboxUpdate(currentTimeMs * 1000);
+    }
+
+    void setFlightModes(uint32_t flags)
+    {
+        memset(&rcModeActivationMask, 0, sizeof(rcModeActivationMask));
+        memcpy(&rcModeActivationMask, &flags, sizeof(flags));
+    }
+
+    void pidLoop(void)
+    {
+        currentTimeMs += 10;
+        blackboxUpdate(currentTimeMs * 1000);
+    }
+
+    // Position of a flight mode event frame in the log
+    size_t flightModeEvent(uint8_t flags, uint8_t lastFlags)
+    {
+        const uint8_t frame[] = { 'E', FLIGHT_LOG_EVENT_FLIGHTMODE, flags, lastFlags };
+        return std::search(logged.begin(), logged.end(), frame, frame + sizeof(frame)) - logged.begin();
+    }
+
+    // Position of a GPS frame with the given satellite count in the log
+    size_t gpsFrame(uint8_t numSat)
+    {
+        const uint8_t frame[] = { 'G', GPS_FIX_3D, numSat };
+        return std::search(logged.begin(), logged.end(), frame, frame + sizeof(frame)) - logged.begin();
+    }
+
+    // Position of an inflight adjustment event frame with a small value in the log
+    size_t adjustmentEvent(uint8_t function, int8_t value)
+    {
+        const uint8_t frame[] = { 'E', FLIGHT_LOG_EVENT_INFLIGHT_ADJUSTMENT, function, (uint8_t)zigzagEncode(value) };
+        return std::search(logged.begin(), logged.end(), frame, frame + sizeof(frame)) - logged.begin();
+    }
+
+    size_t logEnd(void)
+    {
+        const char text[] = "End of log";
+        return std::search(logged.begin(), logged.end(), text, text + strlen(text)) - logged.begin();
+    }
+
+    // An I-frame, then iterations that each change the flight mode and the satellite count
+    void queueIterations(int count)
+    {
+        pidLoop();
+        for (int i = 1; i <= count; i++) {
+            setFlightModes(i);
+            gpsSol.numSat = 10 + i;
+            pidLoop();
+        }
+
+        // The encoder must not see the state the flight controller moved on to
+        setFlightModes(0x7F);
+        gpsSol.numSat = 99;
+    }
+
+    void expectIterationsInOrder(int count)
+    {
+        size_t previous = 0;
+        for (int i = 1; i <= count; i++) {
+            const size_t event = flightModeEvent(i, i - 1);
+            const size_t gps = gpsFrame(10 + i);
+            ASSERT_LT(event, logged.size()) << "iteration " << i;
+            ASSERT_LT(gps, logged.size()) << "iteration " << i;
+            EXPECT_LT(previous, event) << "iteration " << i;
+            EXPECT_LT(event, gps) << "iteration " << i;
+            previous = gps;
+        }
+
+        EXPECT_EQ(logged.size(), flightModeEvent(0x7F, count));
+        EXPECT_EQ(logged.size(), gpsFrame(99));
+    }
+};
+
+TEST_F(BlackboxDeferredTest, TestQueuedIterationsKeepOrderAndState)
+{
+    queueIterations(3);
+    EXPECT_TRUE(logged.empty());
+
+    blackboxUpdateDeferred(currentTimeMs * 1000);
+    expectIterationsInOrder(3);
+}
+
+TEST_F(BlackboxDeferredTest, TestFullQueueEncodesOldestFirst)
+{
+    // More iterations than the queue holds, the PID task encodes the oldest ones itself
+    queueIterations(7);
+    EXPECT_FALSE(logged.empty());
+
+    blackboxUpdateDeferred(currentTimeMs * 1000);
+    expectIterationsInOrder(7);
+}
+
+TEST_F(BlackboxDeferredTest, TestEventQueuedBehindIterations)
+{
+    queueIterations(2);
+
+    // Logged by the PID task between the second and the third iteration
+    flightLogEventData_t data;
+    memset(&data, 0, sizeof(data));
+    data.inflightAdjustment.adjustmentFunction = 5;
+    data.inflightAdjustment.newValue = 3;
+    blackboxLogEvent(FLIGHT_LOG_EVENT_INFLIGHT_ADJUSTMENT, &data);
+    EXPECT_TRUE(logged.empty());
+
+    setFlightModes(3);
+    pidLoop();
+    EXPECT_TRUE(logged.empty());
+
+    blackboxUpdateDeferred(currentTimeMs * 1000);
+    const size_t event = adjustmentEvent(5, 3);
+    ASSERT_LT(event, logged.size());
+    EXPECT_LT(gpsFrame(12), event);
+    EXPECT_LT(event, flightModeEvent(3, 2));
+}
+
+TEST_F(BlackboxDeferredTest, TestCompressedLogQueuesEveryEvent)
+{
+    pidLoop();
+    blackboxUpdateDeferred(currentTimeMs * 1000);
+    logged.clear();
+
+    flightLogEventData_t data;
+    memset(&data, 0, sizeof(data));
+    data.inflightAdjustment.adjustmentFunction = 5;
+    data.inflightAdjustment.newValue = 3;
+
+    // Nothing queued, the event is written by the caller
+    blackboxLogEvent(FLIGHT_LOG_EVENT_INFLIGHT_ADJUSTMENT, &data);
+    blackboxDeviceFlush();
+    EXPECT_LT(adjustmentEvent(5, 3), logged.size());
+    logged.clear();
+
+    // Compressed, it waits for the blackbox task even with nothing queued. Flash and SD card aren't built here,
+    // any device but serial does
+    blackboxConfigMutable()->device = BLACKBOX_DEVICE_END;
+    blackboxConfigMutable()->compression = 1;
+    blackboxLogEvent(FLIGHT_LOG_EVENT_INFLIGHT_ADJUSTMENT, &data);
+    blackboxDeviceFlush();
+    EXPECT_TRUE(logged.empty());
+
+    blackboxUpdateDeferred(currentTimeMs * 1000);
+    blackboxDeviceFlush();
+    EXPECT_LT(adjustmentEvent(5, 3), logged.size());
+}
+
+TEST_F(BlackboxDeferredTest, TestFinishDrainsQueue)
+{
+    // Disarmed before the blackbox task got to the queued iterations
+    queueIterations(3);
+    blackboxFinish();
+    pidLoop();
+
+    expectIterationsInOrder(3);
+    EXPECT_LT(gpsFrame(13), logEnd());
+    EXPECT_LT(logEnd(), logged.size());
+}
+
+/*
+ * Nothing but the roll attitude changes, every P-frame is zero but for its time and the roll delta.
+ * No GPS so the periodic home frame stays out of the way.
+ */
+class BlackboxFieldGroupTest : public BlackboxDeferredTest
+{
+protected:
+    void SetUp() override
+    {
+        enabledFeatures = FEATURE_BLACKBOX;
+        attitude.values.roll = 0;
+        BlackboxDeferredTest::SetUp();
+    }
+
+    void TearDown() override
+    {
+        BlackboxDeferredTest::TearDown();
+        enabledFeatures = FEATURE_BLACKBOX | FEATURE_GPS;
+    }
+
+    // Runs one PID loop and has the blackbox task encode it, returns the frames of the iteration
+    bytes_t logIteration(void)
+    {
+        logged.clear();
+        pidLoop();
+        blackboxUpdateDeferred(currentTimeMs * 1000);
+        return logged;
+    }
+
+    // Bytes of a P-frame after its time
+    bytes_t pFramePayload(const bytes_t &frame)
+    {
+        EXPECT_EQ('P', frame[0]);
+
+        size_t i = 1;
+        while (frame[i++] & 0x80);
+
+        return bytes_t(frame.begin() + i, frame.end());
+    }
+
+    // Every field but the roll attitude is zero, a single non-zero byte is the roll delta
+    int rollDelta(const bytes_t &payload)
+    {
+        uint8_t zigzag = 0;
+        int nonZero = 0;
+        for (const uint8_t b : payload) {
+            if (b) {
+                zigzag = b;
+                nonZero++;
+            }
+        }
+        EXPECT_LE(nonZero, 1);
+        EXPECT_LT(zigzag, 0x80);
+
+        return (zigzag >> 1) ^ -(zigzag & 1);
+    }
+};
+
+TEST_F(BlackboxFieldGroupTest, TestGroupOnlyInDueFrames)
+{
+    blackboxConfigMutable()->attitudeRateDenom = 3;
+
+    // What a decoder holds, newest first
+    int history[2] = { 0, 0 };
+    size_t duePayloadSize = 0;
+
+    // Past the I-frame at iteration 32
+    for (int i = 0; i < 40; i++) {
+        attitude.values.roll = 2 * i;
+        const bytes_t frame = logIteration();
+        const int mainFrameIndex = i % 32;
+
+        int roll;
+        if (mainFrameIndex == 0) {
+            // I-frames log everything and are both history states of the next P-frame
+            roll = attitude.values.roll;
+            history[0] = roll;
+        } else {
+            const bytes_t payload = pFramePayload(frame);
+
+            // Due on every third main frame counted from the last I-frame
+            if (mainFrameIndex % 3 == 0) {
+                roll = rollDelta(payload) + (history[0] + history[1]) / 2;
+                EXPECT_EQ(attitude.values.roll, roll) << "iteration " << i;
+                duePayloadSize = payload.size();
+            } else {
+                // No attitude fields, the decoder holds the last value
+                roll = history[0];
+                EXPECT_EQ(0, rollDelta(payload)) << "iteration " << i;
+                if (duePayloadSize) {
+                    EXPECT_EQ(duePayloadSize - XYZ_AXIS_COUNT, payload.size()) << "iteration " << i;
+                }
+            }
+        }
+        history[1] = history[0];
+        history[0] = roll;
+    }
+    EXPECT_GT(duePayloadSize, 0u);
+}
+
+TEST_F(BlackboxFieldGroupTest, TestHeldGroupsShrinkPFrames)
+{
+    blackboxConfigMutable()->navRateDenom = 4;
+    blackboxConfigMutable()->rcRateDenom = 4;
+    blackboxConfigMutable()->attitudeRateDenom = 4;
+    blackboxConfigMutable()->batteryRateDenom = 4;
+
+    // The I-frame and the first P-frame, which comes after the first periodic slow frame
+    logIteration();
+    logIteration();
+
+    size_t size[9];
+    for (int i = 2; i <= 8; i++) {
+        size[i] = pFramePayload(logIteration()).size();
+    }
+
+    // Frames 4 and 8 carry every group
+    EXPECT_EQ(size[4], size[8]);
+    for (int i : { 3, 5, 6, 7 }) {
+        EXPECT_EQ(size[2], size[i]) << "frame " << i;
+    }
+    EXPECT_LT(2 * size[2], size[4]);
+}
+
+// STUBS
+
+extern "C" {
+blackboxWriteBuffer_t blackboxWriteBuffer;
+int32_t blackboxHeaderBudget;
+
+void blackboxWriteBufferFlush(void)
+{
+    logged.insert(logged.end(), blackboxWriteBuffer.data, blackboxWriteBuffer.data + blackboxWriteBuffer.count);
+    blackboxWriteBuffer.count = 0;
+}
+
+void blackboxDeviceFlush(void) { blackboxWriteBufferFlush(); }
+bool blackboxDeviceFlushForce(void)
+{
+    blackboxWriteBufferFlush();
+    flushForceCount++;
+    return true;
+}
+
+int blackboxPrint(const char *s)
+{
+    const int length = strlen(s);
+    for (int i = 0; i < length; i++) {
+        blackboxWrite(s[i]);
+    }
+    return length;
+}
+
+bool blackboxDeviceOpen(void) { return true; }
+void blackboxDeviceClose(void) {}
+bool blackboxDeviceBeginLog(void) { return true; }
+bool blackboxDeviceEndLog(bool) { return true; }
+void blackboxDeviceBeginCompression(void) {}
+void blackboxDeviceEndCompression(void) {}
+bool isBlackboxDeviceFull(void) { return false; }
+void blackboxReplenishHeaderBudget(void) { blackboxHeaderBudget = BLACKBOX_MAX_ACCUMULATED_HEADER_BUDGET; }
+blackboxBufferReserveStatus_e blackboxDeviceReserveBufferSpace(int32_t) { return BLACKBOX_RESERVE_SUCCESS; }
+
+timeMs_t millis(void) { return currentTimeMs; }
+
+const char* const buildDate = "Jan 01 2026";
+const char* const buildTime = "00:00:00";
+const char* const shortGitRevision = "00000000";
+const char* const targetName = "TEST";
+
+int32_t debug[DEBUG32_VALUE_COUNT];
+uint8_t debugMode;
+
+uint32_t flightModeFlags;
+uint32_t stateFlags;
+boxBitmask_t rcModeActivationMask;
+
+bool feature(uint32_t mask) { return mask & enabledFeatures; }
+bool sensors(uint32_t) { return false; }
+bool IS_RC_MODE_ACTIVE(boxId_e) { return false; }
+bool isModeActivationConditionPresent(boxId_e) { return false; }
+
+accelerometerConfig_t accelerometerConfig_System;
+barometerConfig_t barometerConfig_System;
+batteryMetersConfig_t batteryMetersConfig_System;
+compassConfig_t compassConfig_System;
+featureConfig_t featureConfig_System;
+gyroConfig_t gyroConfig_System;
+motorConfig_t motorConfig_System;
+rcControlsConfig_t rcControlsConfig_System;
+rxConfig_t rxConfig_System;
+systemConfig_t systemConfig_System;
+static pidProfile_t profile;
+pidProfile_t *pidProfile_ProfileCurrent = &profile;
+
+static controlRateConfig_t rateProfile;
+const controlRateConfig_t *currentControlRateProfile = &rateProfile;
+static pidBank_t bank;
+const pidBank_t *pidBank(void) { return &bank; }
+
+acc_t acc;
+attitudeEulerAngles_t attitude;
+baro_t baro;
+gyro_t gyro;
+mag_t mag;
+int32_t axisPID_P[FLIGHT_DYNAMICS_INDEX_COUNT], axisPID_I[FLIGHT_DYNAMICS_INDEX_COUNT], axisPID_D[FLIGHT_DYNAMICS_INDEX_COUNT];
+int32_t axisPID_F[FLIGHT_DYNAMICS_INDEX_COUNT], axisPID_Setpoint[FLIGHT_DYNAMICS_INDEX_COUNT];
+int16_t motor[MAX_SUPPORTED_MOTORS];
+int16_t servo[MAX_SUPPORTED_SERVOS];
+int16_t rcCommand[4];
+
+gpsSolutionData_t gpsSol;
+gpsLocation_t GPS_home;
+
+int16_t navAccNEU[3];
+int16_t navActualSurface;
+int16_t navActualVelocity[3];
+int16_t navCurrentState;
+uint16_t navDesiredHeading;
+int16_t navDesiredVelocity[3];
+uint16_t navEPH;
+uint16_t navEPV;
+uint16_t navFlags;
+int32_t navLatestActualPosition[3];
+int32_t navTargetPosition[3];
+
+static navigationPIDControllers_t navPids;
+const navigationPIDControllers_t *getNavigationPIDControllers(void) { return &navPids; }
+int8_t navigationGetHeadingControlState(void) { return 0; }
+bool navigationRequiresTurnAssistance(void) { return false; }
+uint8_t getActiveWpNumber(void) { return 0; }
+int getWaypointCount(void) { return 0; }
+bool isWaypointListValid(void) { return false; }
+
+float accGetVibrationLevel(void) { return 0.0f; }
+int16_t getAmperage(void) { return 0; }
+uint32_t getArmingBeepTimeMicros(void) { return 0; }
+bool getBaroTemperature(int16_t *) { return false; }
+bool getIMUTemperature(int16_t *) { return false; }
+uint16_t getBatteryRawVoltage(void) { return 0; }
+uint16_t getBatterySagCompensatedVoltage(void) { return 0; }
+uint16_t getPowerSupplyImpedance(void) { return 0; }
+disarmReason_t getDisarmReason(void) { return DISARM_NONE; }
+failsafePhase_e failsafePhase(void) { return FAILSAFE_IDLE; }
+
+hardwareSensorStatus_e getHwAccelerometerStatus(void) { return HW_SENSOR_NONE; }
+hardwareSensorStatus_e getHwBarometerStatus(void) { return HW_SENSOR_NONE; }
+hardwareSensorStatus_e getHwCompassStatus(void) { return HW_SENSOR_NONE; }
+hardwareSensorStatus_e getHwGPSStatus(void) { return HW_SENSOR_NONE; }
+hardwareSensorStatus_e getHwGyroStatus(void) { return HW_SENSOR_NONE; }
+hardwareSensorStatus_e getHwPitotmeterStatus(void) { return HW_SENSOR_NONE; }
+hardwareSensorStatus_e getHwRangefinderStatus(void) { return HW_SENSOR_NONE; }
+
+uint32_t getLooptime(void) { return 1000; }
+uint32_t getEscUpdateFrequency(void) { return 0; }
+uint16_t getRcUpdateFrequency(void) { return 0; }
+uint8_t getMotorCount(void) { return 4; }
+int getThrottleIdleValue(void) { return 1150; }
+bool isMixerUsingServos(void) { return false; }
+
+uint16_t getRSSI(void) { return 0; }
+rssiSource_e getRSSISource(void) { return RSSI_SOURCE_NONE; }
+bool rxAreFlightChannelsValid(void) { return true; }
+bool rxIsReceivingSignal(void) { return true; }
+int16_t rxGetChannelValue(unsigned) { return PWM_RANGE_MIDDLE; }
+
+bool rtcGetDateTime(dateTime_t *) { return false; }
+bool dateTimeFormatLocal(char *, dateTime_t *) { return false; }
+void serialWrite(serialPort_t *, uint8_t) {}
+bool isSerialTransmitBufferEmpty(const serialPort_t *) { return true; }
+}
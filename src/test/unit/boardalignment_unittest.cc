@@ -0,0 +1,203 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+    #include "common/axis.h"
+    #include "common/maths.h"
+    #include "common/vector.h"
+    #include "drivers/sensor.h"
+    #include "fc/runtime_config.h"
+    #include "sensors/boardalignment.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+typedef struct {
+    int16_t roll;
+    int16_t pitch;
+    int16_t yaw;
+    bool rightAngle;    // Whole rotation is a multiple of 90 deg for any sensor alignment
+} boardAngles_t;
+
+static const boardAngles_t boardAngles[] = {
+    { 0,    0,    0,    true  },
+    { 0,    0,    900,  true  },
+    { 0,    0,    1800, true  },
+    { 0,    0,    2700, true  },
+    { 1800, 0,    0,    true  },
+    { 1800, 0,    900,  true  },
+    { 0,    900,  0,    false },
+    { 100,  -50,  450,  false },
+};
+
+static const float samples[][XYZ_AXIS_COUNT] = {
+    { 0, 0, 0 },
+    { 1000, 0, 0 },
+    { 0, -1000, 0 },
+    { 0, 0, 4096 },
+    { 123, -4567, 8901 },
+    { -32768, 32767, -1 },
+};
+
+static void setBoardAlignment(const boardAngles_t *angles)
+{
+    boardAlignmentMutable()->rollDeciDegrees = angles->roll;
+    boardAlignmentMutable()->pitchDeciDegrees = angles->pitch;
+    boardAlignmentMutable()->yawDeciDegrees = angles->yaw;
+    initBoardAlignment();
+}
+
+// Sensor alignment and board rotation applied separately, as the sensor code did before
+static void referenceAlignment(float *vec, const boardAngles_t *angles, uint8_t sensorRotation)
+{
+    applySensorAlignment(vec, vec, sensorRotation);
+
+    if (!angles->roll && !angles->pitch && !angles->yaw && !STATE(TAILSITTER)) {
+        return;
+    }
+
+    fp_angles_t rotationAngles;
+    fpMat3_t rmat;
+    fpVector3_t fpVec = { .v = { vec[X], vec[Y], vec[Z] } };
+
+    rotationAngles.angles.roll  = DECIDEGREES_TO_RADIANS(angles->roll);
+    rotationAngles.angles.pitch = DECIDEGREES_TO_RADIANS(angles->pitch);
+    rotationAngles.angles.yaw   = DECIDEGREES_TO_RADIANS(angles->yaw);
+    rotationMatrixFromAngles(&rmat, &rotationAngles);
+    rotationMatrixRotateVector(&fpVec, &fpVec, &rmat);
+
+    applyTailSitterAlignment(&fpVec);
+
+    vec[X] = fpVec.x;
+    vec[Y] = fpVec.y;
+    vec[Z] = fpVec.z;
+}
+
+static void expectSameAlignment(bool tailSitter)
+{
+    if (tailSitter) {
+        ENABLE_STATE(TAILSITTER);
+    } else {
+        DISABLE_STATE(TAILSITTER);
+    }
+
+    for (const boardAngles_t &angles : boardAngles) {
+        setBoardAlignment(&angles);
+
+        for (uint8_t rotation = ALIGN_DEFAULT; rotation <= CW270_DEG_FLIP; rotation++) {
+            sensorAlignment_t alignment;
+            memset(&alignment, 0, sizeof(alignment));
+
+            for (const auto &sample : samples) {
+                float expected[XYZ_AXIS_COUNT] = { sample[X], sample[Y], sample[Z] };
+                float actual[XYZ_AXIS_COUNT] = { sample[X], sample[Y], sample[Z] };
+
+                referenceAlignment(expected, &angles, rotation);
+                applySensorAndBoardAlignment(&alignment, actual, rotation);
+
+                // Full rotations are rounded to integers
+                for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+                    EXPECT_NEAR(expected[axis], actual[axis], 1.0f);
+                }
+            }
+
+            EXPECT_EQ(angles.rightAngle, alignment.rotation[0].rotation != ALIGN_DEFAULT);
+        }
+    }
+
+    DISABLE_STATE(TAILSITTER);
+}
+
+TEST(BoardAlignmentTest, TestFusedMatchesSeparateAlignment)
+{
+    expectSameAlignment(false);
+}
+
+TEST(BoardAlignmentTest, TestFusedMatchesSeparateAlignmentTailSitter)
+{
+    expectSameAlignment(true);
+}
+
+TEST(BoardAlignmentTest, TestRightAngleAlignmentIsExact)
+{
+    const boardAngles_t angles = { 0, 0, 900, true };
+    sensorAlignment_t alignment;
+    memset(&alignment, 0, sizeof(alignment));
+
+    setBoardAlignment(&angles);
+
+    // CW90 sensor on a board yawed by another 90 deg is a 180 deg yaw, no rounding involved
+    float vec[XYZ_AXIS_COUNT] = { 1.25f, -2.5f, 3.75f };
+    applySensorAndBoardAlignment(&alignment, vec, CW90_DEG);
+
+    EXPECT_EQ(CW180_DEG, alignment.rotation[0].rotation);
+    EXPECT_FLOAT_EQ(-1.25f, vec[X]);
+    EXPECT_FLOAT_EQ(2.5f, vec[Y]);
+    EXPECT_FLOAT_EQ(3.75f, vec[Z]);
+}
+
+TEST(BoardAlignmentTest, TestRebuildOnChange)
+{
+    const boardAngles_t level = { 0, 0, 0, true };
+    const boardAngles_t tilted = { 0, 900, 0, false };
+    sensorAlignment_t alignment;
+    memset(&alignment, 0, sizeof(alignment));
+
+    setBoardAlignment(&level);
+
+    float vec[XYZ_AXIS_COUNT] = { 0, 0, 1000 };
+    applySensorAndBoardAlignment(&alignment, vec, CW0_DEG);
+    EXPECT_EQ(CW0_DEG, alignment.rotation[0].rotation);
+    EXPECT_FLOAT_EQ(1000, vec[Z]);
+
+    // Board alignment changed at runtime
+    setBoardAlignment(&tilted);
+    float expected[XYZ_AXIS_COUNT] = { 0, 0, 1000 };
+    referenceAlignment(expected, &tilted, CW0_DEG);
+
+    vec[X] = 0;
+    vec[Y] = 0;
+    vec[Z] = 1000;
+    applySensorAndBoardAlignment(&alignment, vec, CW0_DEG);
+    EXPECT_EQ(ALIGN_DEFAULT, alignment.rotation[0].rotation);
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        EXPECT_NEAR(expected[axis], vec[axis], 1.0f);
+    }
+
+    // Sensor alignment changed
+    setBoardAlignment(&level);
+    vec[X] = 1000;
+    vec[Y] = 0;
+    vec[Z] = 0;
+    applySensorAndBoardAlignment(&alignment, vec, CW180_DEG);
+    EXPECT_EQ(CW180_DEG, alignment.rotation[0].rotation);
+    EXPECT_FLOAT_EQ(-1000, vec[X]);
+}
+
+// STUBS
+
+extern "C" {
+uint32_t stateFlags;
+}
@@ -0,0 +1,106 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+    #include "common/axis.h"
+    #include "common/fir_decimator.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define GYRO_INTERVAL_US    125     // 8kHz gyro
+#define DECIMATION          8       // 1kHz PID loop
+#define SAMPLE_COUNT        4000
+
+static firDecimator_t decimator;
+
+// Peak output amplitude of a sine of given frequency, decimated to the PID rate
+static float decimatedAmplitude(float frequencyHz)
+{
+    float peak = 0.0f;
+
+    for (int n = 0; n < SAMPLE_COUNT; n++) {
+        const float t = n * GYRO_INTERVAL_US * 1e-6f;
+        const float value = sinf(2 * (float)M_PI * frequencyHz * t);
+        const float sample[XYZ_AXIS_COUNT] = { value, -value, 0.5f * value };
+        firDecimatorPush(&decimator, sample);
+
+        if (n % DECIMATION == 0 && n > FIR_DECIMATOR_MAX_TAPS) {
+            float output[XYZ_AXIS_COUNT];
+            firDecimatorApply(&decimator, output);
+            EXPECT_NEAR(-output[X], output[Y], 1e-5f);
+            peak = fmaxf(peak, fabsf(output[X]));
+        }
+    }
+
+    return peak;
+}
+
+TEST(FirDecimatorUnittest, TestUnityDcGain)
+{
+    firDecimatorInit(&decimator, 16, 250, GYRO_INTERVAL_US);
+
+    const float sample[XYZ_AXIS_COUNT] = { 100.0f, -20.0f, 3.0f };
+    for (int n = 0; n < 16; n++) {
+        firDecimatorPush(&decimator, sample);
+    }
+
+    float output[XYZ_AXIS_COUNT];
+    firDecimatorApply(&decimator, output);
+
+    EXPECT_NEAR(100.0f, output[X], 1e-3f);
+    EXPECT_NEAR(-20.0f, output[Y], 1e-3f);
+    EXPECT_NEAR(3.0f, output[Z], 1e-4f);
+}
+
+TEST(FirDecimatorUnittest, TestLinearPhaseDelay)
+{
+    firDecimatorInit(&decimator, 9, 250, GYRO_INTERVAL_US);
+
+    // Ramp is delayed by (taps - 1) / 2 samples and not distorted
+    for (int n = 0; n < 40; n++) {
+        const float sample[XYZ_AXIS_COUNT] = { (float)n, (float)n, (float)n };
+        firDecimatorPush(&decimator, sample);
+    }
+
+    float output[XYZ_AXIS_COUNT];
+    firDecimatorApply(&decimator, output);
+
+    EXPECT_NEAR(39.0f - 4.0f, output[X], 1e-3f);
+}
+
+TEST(FirDecimatorUnittest, TestAntiAliasing)
+{
+    firDecimatorInit(&decimator, 32, 250, GYRO_INTERVAL_US);
+
+    // Stick motion passes, motor noise that would alias at 1kHz PID rate is suppressed
+    EXPECT_GT(decimatedAmplitude(20), 0.95f);
+    EXPECT_LT(decimatedAmplitude(900), 0.05f);
+    EXPECT_LT(decimatedAmplitude(1500), 0.05f);
+}
+
+TEST(FirDecimatorUnittest, TestTapCountLimit)
+{
+    firDecimatorInit(&decimator, 200, 250, GYRO_INTERVAL_US);
+    EXPECT_EQ(FIR_DECIMATOR_MAX_TAPS, decimator.tapCount);
+}
@@ -0,0 +1,266 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+    #include "common/maths.h"
+    #include "common/linalg.h"
+    #include "common/quaternion.h"
+    #include "common/vector.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define VECTOR_COUNT    64
+
+static uint32_t rng = 2463534242u;
+
+static float randomFloat(float from, float to)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return from + (to - from) * (float)(rng & 0xFFFFFF) / 0xFFFFFF;
+}
+
+static void randomQuaternion(fpQuaternion_t *q)
+{
+    q->q0 = randomFloat(-1, 1);
+    q->q1 = randomFloat(-1, 1);
+    q->q2 = randomFloat(-1, 1);
+    q->q3 = randomFloat(-1, 1);
+    quaternionNormalize(q, q);
+}
+
+static void randomVector(fpVector3_t *v)
+{
+    v->x = randomFloat(-1000, 1000);
+    v->y = randomFloat(-1000, 1000);
+    v->z = randomFloat(-1000, 1000);
+}
+
+// Rotations as they were written before, with two full quaternion products
+static void referenceRotate(fpVector3_t *result, const fpVector3_t *v, const fpQuaternion_t *a, const fpQuaternion_t *b)
+{
+    fpQuaternion_t vectQuat;
+
+    quaternionInitFromVector(&vectQuat, v);
+    quaternionMultiply(&vectQuat, a, &vectQuat);
+    quaternionMultiply(&vectQuat, &vectQuat, b);
+
+    result->x = vectQuat.q1;
+    result->y = vectQuat.q2;
+    result->z = vectQuat.q3;
+}
+
+static void expectVectorNear(const fpVector3_t *expected, const fpVector3_t *actual, float tolerance)
+{
+    EXPECT_NEAR(expected->x, actual->x, tolerance);
+    EXPECT_NEAR(expected->y, actual->y, tolerance);
+    EXPECT_NEAR(expected->z, actual->z, tolerance);
+}
+
+TEST(LinalgUnittest, TestMat3Multiply)
+{
+    for (int n = 0; n < 100; n++) {
+        fpMat3_t a, b, expected, actual;
+
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                a.m[i][j] = randomFloat(-10, 10);
+                b.m[i][j] = randomFloat(-10, 10);
+            }
+        }
+
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                expected.m[i][j] = 0;
+                for (int k = 0; k < 3; k++) {
+                    expected.m[i][j] += a.m[i][k] * b.m[k][j];
+                }
+            }
+        }
+
+        mat3Multiply(&actual, &a, &b);
+
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                EXPECT_FLOAT_EQ(expected.m[i][j], actual.m[i][j]);
+            }
+        }
+
+        // Result aliasing the arguments
+        mat3Multiply(&a, &a, &b);
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                EXPECT_FLOAT_EQ(expected.m[i][j], a.m[i][j]);
+            }
+        }
+    }
+}
+
+TEST(LinalgUnittest, TestMat4Multiply)
+{
+    for (int n = 0; n < 100; n++) {
+        fpMat4_t a, b, expected, actual;
+
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 4; j++) {
+                a.m[i][j] = randomFloat(-10, 10);
+                b.m[i][j] = randomFloat(-10, 10);
+            }
+        }
+
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 4; j++) {
+                expected.m[i][j] = 0;
+                for (int k = 0; k < 4; k++) {
+                    expected.m[i][j] += a.m[i][k] * b.m[k][j];
+                }
+            }
+        }
+
+        mat4Multiply(&actual, &a, &b);
+
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 4; j++) {
+                EXPECT_FLOAT_EQ(expected.m[i][j], actual.m[i][j]);
+            }
+        }
+
+        mat4Multiply(&b, &a, &b);
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 4; j++) {
+                EXPECT_FLOAT_EQ(expected.m[i][j], b.m[i][j]);
+            }
+        }
+    }
+}
+
+TEST(LinalgUnittest, TestRotateVectorsMatchesSingleRotate)
+{
+    fpVector3_t src[VECTOR_COUNT];
+    fpVector3_t batched[VECTOR_COUNT];
+    fp_angles_t angles;
+    fpMat3_t rmat;
+
+    angles.angles.roll = DEGREES_TO_RADIANS(30);
+    angles.angles.pitch = DEGREES_TO_RADIANS(-45);
+    angles.angles.yaw = DEGREES_TO_RADIANS(120);
+    rotationMatrixFromAngles(&rmat, &angles);
+
+    for (int i = 0; i < VECTOR_COUNT; i++) {
+        randomVector(&src[i]);
+    }
+
+    rotationMatrixRotateVectors(batched, src, VECTOR_COUNT, &rmat);
+
+    for (int i = 0; i < VECTOR_COUNT; i++) {
+        fpVector3_t expected;
+        rotationMatrixRotateVector(&expected, &src[i], &rmat);
+        EXPECT_FLOAT_EQ(expected.x, batched[i].x);
+        EXPECT_FLOAT_EQ(expected.y, batched[i].y);
+        EXPECT_FLOAT_EQ(expected.z, batched[i].z);
+    }
+
+    // In place
+    rotationMatrixRotateVectors(src, src, VECTOR_COUNT, &rmat);
+    for (int i = 0; i < VECTOR_COUNT; i++) {
+        EXPECT_FLOAT_EQ(batched[i].x, src[i].x);
+        EXPECT_FLOAT_EQ(batched[i].y, src[i].y);
+        EXPECT_FLOAT_EQ(batched[i].z, src[i].z);
+    }
+}
+
+TEST(LinalgUnittest, TestRotationComposition)
+{
+    fp_angles_t angles;
+    fpMat3_t a, b, ab;
+    fpVector3_t v = { .v = { 100, -200, 300 } };
+    fpVector3_t twice, once;
+
+    angles.angles.roll = DEGREES_TO_RADIANS(10);
+    angles.angles.pitch = DEGREES_TO_RADIANS(20);
+    angles.angles.yaw = DEGREES_TO_RADIANS(30);
+    rotationMatrixFromAngles(&a, &angles);
+
+    angles.angles.roll = 0;
+    angles.angles.pitch = DEGREES_TO_RADIANS(90);
+    angles.angles.yaw = 0;
+    rotationMatrixFromAngles(&b, &angles);
+
+    rotationMatrixRotateVector(&twice, &v, &a);
+    rotationMatrixRotateVector(&twice, &twice, &b);
+
+    mat3Multiply(&ab, &a, &b);
+    rotationMatrixRotateVector(&once, &v, &ab);
+
+    expectVectorNear(&twice, &once, 1e-3f);
+}
+
+TEST(LinalgUnittest, TestQuaternionRotateVectorMatchesProduct)
+{
+    for (int n = 0; n < 1000; n++) {
+        fpQuaternion_t q, qConj;
+        fpVector3_t v, expected, actual;
+
+        randomQuaternion(&q);
+        quaternionConjugate(&qConj, &q);
+        randomVector(&v);
+
+        referenceRotate(&expected, &v, &qConj, &q);
+        quaternionRotateVector(&actual, &v, &q);
+        expectVectorNear(&expected, &actual, 1e-3f);
+
+        referenceRotate(&expected, &v, &q, &qConj);
+        quaternionRotateVectorInv(&actual, &v, &q);
+        expectVectorNear(&expected, &actual, 1e-3f);
+
+        // Round trip
+        quaternionRotateVector(&actual, &actual, &q);
+        expectVectorNear(&v, &actual, 1e-3f);
+    }
+}
+
+TEST(LinalgUnittest, TestRotationMatrixFromQuaternion)
+{
+    for (int n = 0; n < 1000; n++) {
+        fpQuaternion_t q;
+        fpMat3_t rmat;
+        fpVector3_t v, expected, actual;
+
+        randomQuaternion(&q);
+        randomVector(&v);
+        rotationMatrixFromQuaternion(rmat.m, &q);
+
+        quaternionRotateVectorInv(&expected, &v, &q);
+        actual.x = rmat.m[0][0] * v.x + rmat.m[0][1] * v.y + rmat.m[0][2] * v.z;
+        actual.y = rmat.m[1][0] * v.x + rmat.m[1][1] * v.y + rmat.m[1][2] * v.z;
+        actual.z = rmat.m[2][0] * v.x + rmat.m[2][1] * v.y + rmat.m[2][2] * v.z;
+        expectVectorNear(&expected, &actual, 1e-3f);
+
+        quaternionRotateVector(&expected, &v, &q);
+        rotationMatrixRotateVector(&actual, &v, &rmat);
+        expectVectorNear(&expected, &actual, 1e-3f);
+    }
+}
@@ -206,6 +206,75 @@ TEST(MathsUnittest, TestFastTrigonometryACos)
     EXPECT_NEAR(acos_approx(-0.707106781f), 3 * M_PIf / 4, 1e-4);
 }
 
+// Max absolute error of a tier against double precision libm over a sweep
+template <typename F, typename R>
+static double maxErrorOverRange(F fn, R reference, double from, double to, int steps)
+{
+    double maxError = 0;
+    for (int i = 0; i <= steps; i++) {
+        const double x = from + (to - from) * i / steps;
+        maxError = fmax(maxError, fabs((double)fn((float)x) - reference((double)(float)x)));
+    }
+    return maxError;
+}
+
+static double maxAtan2Error(float (*fn)(float, float))
+{
+    double maxError = 0;
+    for (int i = 0; i < 3600; i++) {
+        const double angle = -M_PI + 2 * M_PI * i / 3600;
+        const float y = 50.0f * sin(angle);
+        const float x = 50.0f * cos(angle);
+        double error = fabs((double)fn(y, x) - atan2((double)y, (double)x));
+        error = fmin(error, 2 * M_PI - error);                  // +PI and -PI are the same angle
+        maxError = fmax(maxError, error);
+    }
+    return maxError;
+}
+
+TEST(MathsUnittest, TestTrigonometryTierErrorBounds)
+{
+    const double range = 4 * M_PI;
+    auto refSin = [](double x) { return sin(x); };
+    auto refCos = [](double x) { return cos(x); };
+    auto refAcos = [](double x) { return acos(x); };
+
+    EXPECT_LT(maxErrorOverRange([](float x) { return sin_approx(x); }, refSin, -range, range, 100000), 2e-6);
+    EXPECT_LT(maxErrorOverRange([](float x) { return cos_approx(x); }, refCos, -range, range, 100000), 2e-6);
+    EXPECT_LT(maxErrorOverRange([](float x) { return sin_approx_fast(x); }, refSin, -range, range, 100000), 2e-6);
+    EXPECT_LT(maxErrorOverRange([](float x) { return cos_approx_fast(x); }, refCos, -range, range, 100000), 2e-6);
+
+    EXPECT_LT(maxAtan2Error(atan2_approx), 2e-6);
+    EXPECT_LT(maxAtan2Error(atan2_approx_fast), 1.6e-3);
+
+    EXPECT_LT(maxErrorOverRange([](float x) { return acos_approx(x); }, refAcos, -1, 1, 20000), 1e-4);
+    EXPECT_LT(maxErrorOverRange([](float x) { return acos_approx_fast(x); }, refAcos, -1, 1, 20000), 4e-4);
+}
+
+TEST(MathsUnittest, TestTrigonometryTierSymmetry)
+{
+    // Quadrant boundaries of the range reduction of the fast tier
+    for (int quarter = -8; quarter <= 8; quarter++) {
+        const float x = quarter * M_PIf / 2;
+        EXPECT_NEAR(sin_approx_fast(x), sinf(x), 2e-6) << "quarter " << quarter;
+        EXPECT_NEAR(sin_approx_fast(-x), -sin_approx_fast(x), 1e-6);
+    }
+
+    EXPECT_FLOAT_EQ(atan2_approx_fast(0, 0), 0.0f);
+}
+
+TEST(MathsUnittest, TestInverseSqrt)
+{
+    EXPECT_FLOAT_EQ(fast_invsqrtf(0.0f), 0.0f);
+    EXPECT_FLOAT_EQ(fast_invsqrtf(-1.0f), 0.0f);
+
+    for (int i = -300; i <= 300; i++) {
+        const float x = powf(10.0f, i / 10.0f);
+        const double reference = 1.0 / sqrt((double)x);
+        EXPECT_NEAR(fast_invsqrtf(x), reference, reference * 1e-6);
+    }
+}
+
 /*
 TEST(MathsUnittest, TestSensorScaleUnitTest)
 {
@@ -0,0 +1,112 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+    #include "common/axis.h"
+    #include "flight/mixer_matrix.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+// Octo X, last motor stopped to exercise the inactive motor flag
+static const motorMixer_t octoMixer[] = {
+    { 1.0f, -0.414178f,  1.0f, -1.0f },
+    { 1.0f, -0.414178f, -1.0f,  1.0f },
+    { 1.0f,  0.414178f,  1.0f,  1.0f },
+    { 1.0f,  0.414178f, -1.0f, -1.0f },
+    { 1.0f, -1.0f,  0.414178f,  1.0f },
+    { 1.0f,  1.0f, -0.414178f,  1.0f },
+    { 1.0f, -1.0f, -0.414178f, -1.0f },
+    { 0.0f,  1.0f,  0.414178f, -1.0f },
+};
+
+#define OCTO_MOTORS (sizeof(octoMixer) / sizeof(octoMixer[0]))
+
+TEST(MixerMatrixUnittest, TestMatchesPerMotorMix)
+{
+    mixerMatrix_t matrix;
+    mixerMatrixInit(&matrix, octoMixer, OCTO_MOTORS, 0.5f, -1.0f);
+
+    EXPECT_EQ(OCTO_MOTORS, matrix.motorCount);
+    EXPECT_TRUE(matrix.hasInactiveMotors);
+
+    const float input[XYZ_AXIS_COUNT] = { 123.0f, -77.5f, 310.0f };
+    float rpyMix[MAX_SUPPORTED_MOTORS];
+    float rpyMixMin, rpyMixMax;
+
+    mixerMatrixApplyRpy(&matrix, input, rpyMix, &rpyMixMin, &rpyMixMax);
+
+    float expectedMin = 0.0f;
+    float expectedMax = 0.0f;
+    for (unsigned i = 0; i < OCTO_MOTORS; i++) {
+        const float expected = (input[FD_PITCH] * octoMixer[i].pitch + input[FD_ROLL] * octoMixer[i].roll - input[FD_YAW] * octoMixer[i].yaw) * 0.5f;
+        EXPECT_NEAR(expected, rpyMix[i], 1e-3f) << "motor " << i;
+        expectedMin = fminf(expectedMin, expected);
+        expectedMax = fmaxf(expectedMax, expected);
+    }
+
+    EXPECT_NEAR(expectedMin, rpyMixMin, 1e-3f);
+    EXPECT_NEAR(expectedMax, rpyMixMax, 1e-3f);
+}
+
+// Small inputs that the former int16_t mixer rounded to zero keep their share
+TEST(MixerMatrixUnittest, TestNoRoundingToZero)
+{
+    mixerMatrix_t matrix;
+    mixerMatrixInit(&matrix, octoMixer, OCTO_MOTORS, 1.0f, -1.0f);
+
+    const float input[XYZ_AXIS_COUNT] = { 2.0f, 0.0f, 0.0f };
+    float rpyMix[MAX_SUPPORTED_MOTORS];
+    float rpyMixMin, rpyMixMax;
+
+    mixerMatrixApplyRpy(&matrix, input, rpyMix, &rpyMixMin, &rpyMixMax);
+
+    EXPECT_NEAR(-0.828356f, rpyMix[0], 1e-5f);
+    EXPECT_NEAR(0.828356f, rpyMix[2], 1e-5f);
+
+    mixerMatrixScale(&matrix, rpyMix, 0.5f);
+    EXPECT_NEAR(0.414178f, rpyMix[2], 1e-5f);
+}
+
+TEST(MixerMatrixUnittest, TestThrustLinearization)
+{
+    thrustLinearization_t linearization;
+
+    thrustLinearizationInit(&linearization, 0.0f);
+    EXPECT_FALSE(linearization.enabled);
+    EXPECT_FLOAT_EQ(0.3f, thrustLinearizationApply(&linearization, 0.3f));
+
+    const float k = 0.35f;
+    thrustLinearizationInit(&linearization, k);
+    EXPECT_TRUE(linearization.enabled);
+
+    // Inverse of thrust = (1 - k) * u + k * u^2, end points stay in place
+    EXPECT_NEAR(0.0f, thrustLinearizationApply(&linearization, 0.0f), 1e-6f);
+    EXPECT_NEAR(1.0f, thrustLinearizationApply(&linearization, 1.0f), 1e-3f);
+
+    for (float thrust = 0.05f; thrust < 1.0f; thrust += 0.05f) {
+        const float u = thrustLinearizationApply(&linearization, thrust);
+        EXPECT_NEAR(thrust, (1.0f - k) * u + k * u * u, 1e-3f) << "thrust " << thrust;
+        EXPECT_GE(u, thrust);
+    }
+}
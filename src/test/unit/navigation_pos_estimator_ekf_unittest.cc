@@ -0,0 +1,216 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+    #include "common/time.h"
+
+    #include "navigation/navigation.h"
+    #include "navigation/navigation_pos_estimator_private.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define LOOP_US     10000       // 100Hz estimator
+#define GPS_US      100000      // 10Hz fixes
+#define GPS_DELAY_US 100000
+
+/*
+ * Hovering copter: the true position is fixed, the accelerometer reads a constant bias.
+ * GPS reports the true position from GPS_DELAY_US ago, shifted by gpsOffset.
+ */
+class NavEkfTest : public ::testing::Test
+{
+protected:
+    timeUs_t now;
+    fpVector3_t truth;
+    fpVector3_t accBias;
+    fpVector3_t gpsOffset;
+
+    void SetUp() override
+    {
+        memset(&posEstimator, 0, sizeof(posEstimator));
+        memset(positionEstimationConfigMutable(), 0, sizeof(positionEstimationConfig_t));
+        positionEstimationConfigMutable()->max_eph_epv = 1000;
+        positionEstimationConfigMutable()->w_xy_res_v = 0.5f;
+        positionEstimationConfigMutable()->w_z_res_v = 0.5f;
+        positionEstimationConfigMutable()->ekf_innov_gate = 5;
+        positionEstimationConfigMutable()->ekf_acc_noise = 50;
+        positionEstimationConfigMutable()->ekf_gps_vel_noise = 30;
+
+        debugMode = DEBUG_POS_EST_EKF;
+
+        now = 1000000;
+        truth = { .v = { 1000.0f, -500.0f, 2000.0f } };
+        accBias = { .v = { 20.0f, -15.0f, 30.0f } };
+        gpsOffset = { .v = { 0.0f, 0.0f, 0.0f } };
+
+        // Estimate starts valid but off by a few meters
+        posEstimator.est.lastUpdateTime = now;
+        posEstimator.est.pos = { .v = { truth.x + 300.0f, truth.y - 300.0f, truth.z + 300.0f } };
+        posEstimator.est.eph = 500.0f;
+        posEstimator.est.epv = 500.0f;
+
+        estimationHistoryReset();
+        estimationEkfReset();
+    }
+
+    void run(timeUs_t durationUs)
+    {
+        for (const timeUs_t end = now + durationUs; cmpTimeUs(end, now) > 0;) {
+            now += LOOP_US;
+            posEstimator.est.lastUpdateTime = now;
+            posEstimator.imu.accelNEU = accBias;
+
+            if ((now % GPS_US) == 0) {
+                posEstimator.gps.lastUpdateTime = now;
+                posEstimator.gps.measurementTime = now - GPS_DELAY_US;
+                posEstimator.gps.pos = { .v = { truth.x + gpsOffset.x, truth.y + gpsOffset.y, truth.z + gpsOffset.z } };
+                posEstimator.gps.vel = { .v = { 0.0f, 0.0f, 0.0f } };
+                posEstimator.gps.eph = 100.0f;
+                posEstimator.gps.epv = 150.0f;
+            }
+
+            estimationContext_t ctx;
+            memset(&ctx, 0, sizeof(ctx));
+            ctx.dt = US2S(LOOP_US);
+            if (posEstimator.gps.lastUpdateTime) {
+                ctx.newFlags |= EST_GPS_XY_VALID | EST_GPS_Z_VALID;
+            }
+            if (posEstimator.est.eph < positionEstimationConfig()->max_eph_epv) {
+                ctx.newFlags |= EST_XY_VALID;
+            }
+            if (posEstimator.est.epv < positionEstimationConfig()->max_eph_epv) {
+                ctx.newFlags |= EST_Z_VALID;
+            }
+
+            estimationEkfUpdate(&ctx, now);
+
+            posEstimator.est.eph = ctx.newEPH;
+            posEstimator.est.epv = ctx.newEPV;
+        }
+    }
+
+    float error(int axis)
+    {
+        return posEstimator.est.pos.v[axis] - truth.v[axis] - gpsOffset.v[axis];
+    }
+};
+
+TEST_F(NavEkfTest, TestStaticHoverConverges)
+{
+    run(60000000);
+
+    for (int axis = 0; axis < XYZ_AXIS_COUNT; axis++) {
+        EXPECT_NEAR(0.0f, error(axis), 20.0f) << "axis " << axis;
+        EXPECT_NEAR(0.0f, posEstimator.est.vel.v[axis], 5.0f) << "axis " << axis;
+
+        // DEBUG_POS_EST_EKF logs the accelerometer bias
+        EXPECT_NEAR(accBias.v[axis], debug[axis], 3) << "axis " << axis;
+    }
+
+    // Fusing a stream of fixes ends up better than a single fix
+    EXPECT_LT(posEstimator.est.eph, 100.0f);
+    EXPECT_LT(posEstimator.est.epv, 150.0f);
+}
+
+TEST_F(NavEkfTest, TestGpsStepIsFollowed)
+{
+    run(30000000);
+
+    // A 3m jump is well inside the innovation gate, the estimate moves over smoothly
+    gpsOffset = { .v = { 300.0f, -300.0f, 0.0f } };
+
+    float maxSpeed = 0.0f;
+    for (int i = 0; i < 100; i++) {
+        run(100000);
+        maxSpeed = MAX(maxSpeed, calc_length_pythagorean_2D(posEstimator.est.vel.x, posEstimator.est.vel.y));
+
+        // No overshoot past the new position
+        EXPECT_LT(posEstimator.est.pos.x, truth.x + 300.0f + 30.0f);
+        EXPECT_GT(posEstimator.est.pos.y, truth.y - 300.0f - 30.0f);
+    }
+
+    EXPECT_NEAR(0.0f, error(X), 30.0f);
+    EXPECT_NEAR(0.0f, error(Y), 30.0f);
+    EXPECT_NEAR(0.0f, error(Z), 20.0f);
+    EXPECT_LT(maxSpeed, 300.0f);
+}
+
+TEST_F(NavEkfTest, TestInnovationGateRejectsGlitch)
+{
+    run(30000000);
+
+    // One second of fixes 50m off, far outside the gate
+    gpsOffset = { .v = { 5000.0f, 0.0f, 0.0f } };
+    for (int i = 0; i < 10; i++) {
+        run(100000);
+        EXPECT_NEAR(truth.x, posEstimator.est.pos.x, 30.0f);
+        EXPECT_NEAR(truth.y, posEstimator.est.pos.y, 30.0f);
+    }
+
+    gpsOffset = { .v = { 0.0f, 0.0f, 0.0f } };
+    run(5000000);
+    EXPECT_NEAR(0.0f, error(X), 20.0f);
+    EXPECT_NEAR(0.0f, error(Y), 20.0f);
+}
+
+TEST_F(NavEkfTest, TestPersistentJumpResetsAfterTimeout)
+{
+    run(30000000);
+
+    // GPS keeps disagreeing, after INAV_EKF_GPS_GLITCH_TIMEOUT_MS the estimate gives in
+    gpsOffset = { .v = { 5000.0f, 0.0f, 0.0f } };
+    run(MS2US(INAV_EKF_GPS_GLITCH_TIMEOUT_MS) - 500000);
+    EXPECT_NEAR(truth.x, posEstimator.est.pos.x, 30.0f);
+
+    run(1000000);
+    EXPECT_NEAR(0.0f, error(X), 30.0f);
+}
+
+// STUBS
+
+extern "C" {
+navigationPosEstimator_t posEstimator;
+positionEstimationConfig_t positionEstimationConfig_System;
+
+int32_t debug[DEBUG32_VALUE_COUNT];
+uint8_t debugMode;
+
+float navGetAccelerometerWeight(void) { return 1.0f; }
+bool navIsHeadingUsable(void) { return true; }
+float estimationGetBaroAltitude(estimationContext_t *, bool * isAirCushionEffectDetected)
+{
+    *isAirCushionEffectDetected = false;
+    return 0.0f;
+}
+bool estimationCalculateCorrection_XY_FLOW(estimationContext_t *) { return false; }
+timeUs_t estimationGetGpsMeasurementTime(void) { return posEstimator.gps.measurementTime; }
+timeUs_t estimationGetBaroMeasurementTime(void) { return posEstimator.baro.measurementTime; }
+}
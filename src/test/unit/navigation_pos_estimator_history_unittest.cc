@@ -0,0 +1,205 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "common/axis.h"
+    #include "common/maths.h"
+    #include "common/time.h"
+
+    #include "navigation/navigation.h"
+    #include "navigation/navigation_pos_estimator_private.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define START_US    1000000
+#define LOOP_US     1000        // 1kHz estimator, history keeps every INAV_POSITION_HISTORY_INTERVAL_US
+
+/*
+ * Climbing at 1m/s and accelerating along X, the state at any time is known exactly.
+ * X is quadratic so interpolation between entries is not exact for it, Z is linear and is.
+ */
+static void stateAt(timeUs_t time, fpVector3_t * pos, fpVector3_t * vel)
+{
+    const float t = US2S(cmpTimeUs(time, START_US));
+
+    *pos = { .v = { 50.0f * t * t, 0.0f, 100.0f * t } };
+    *vel = { .v = { 100.0f * t, 0.0f, 100.0f } };
+}
+
+class NavHistoryTest : public ::testing::Test
+{
+protected:
+    timeUs_t now;
+
+    void SetUp() override
+    {
+        memset(&posEstimator, 0, sizeof(posEstimator));
+        now = START_US;
+        estimationHistoryReset();
+        update();
+    }
+
+    void update(void)
+    {
+        posEstimator.est.lastUpdateTime = now;
+        stateAt(now, &posEstimator.est.pos, &posEstimator.est.vel);
+    }
+
+    timeUs_t newestEntryTime(void)
+    {
+        return START_US + (now - LOOP_US - START_US) / INAV_POSITION_HISTORY_INTERVAL_US * INAV_POSITION_HISTORY_INTERVAL_US;
+    }
+
+    void run(timeUs_t durationUs)
+    {
+        for (const timeUs_t end = now + durationUs; cmpTimeUs(end, now) > 0;) {
+            estimationHistoryPush(now);
+            now += LOOP_US;
+            update();
+        }
+    }
+};
+
+TEST_F(NavHistoryTest, TestNewerThanEstimateReturnsCurrent)
+{
+    run(100000);
+
+    fpVector3_t pos;
+    fpVector3_t vel;
+    EXPECT_TRUE(estimationHistoryGetState(now, &pos, &vel));
+    EXPECT_EQ(posEstimator.est.pos.x, pos.x);
+    EXPECT_EQ(posEstimator.est.pos.z, pos.z);
+    EXPECT_EQ(posEstimator.est.vel.x, vel.x);
+
+    EXPECT_TRUE(estimationHistoryGetState(now + 5000, &pos, &vel));
+    EXPECT_EQ(posEstimator.est.pos.z, pos.z);
+}
+
+TEST_F(NavHistoryTest, TestLookupAndInterpolation)
+{
+    run(500000);
+
+    fpVector3_t pos;
+    fpVector3_t vel;
+    fpVector3_t expectedPos;
+    fpVector3_t expectedVel;
+
+    // Stored entries are exact
+    for (timeUs_t age = 0; age < 400000; age += INAV_POSITION_HISTORY_INTERVAL_US) {
+        const timeUs_t time = newestEntryTime() - age;
+        stateAt(time, &expectedPos, &expectedVel);
+
+        EXPECT_TRUE(estimationHistoryGetState(time, &pos, &vel));
+        EXPECT_FLOAT_EQ(expectedPos.x, pos.x) << "age " << age;
+        EXPECT_FLOAT_EQ(expectedPos.z, pos.z) << "age " << age;
+        EXPECT_FLOAT_EQ(expectedVel.x, vel.x) << "age " << age;
+    }
+
+    // In between, linear Z and linear X velocity are exact, the quadratic X position is close
+    for (timeUs_t age = 3000; age < 400000; age += 7000) {
+        const timeUs_t time = now - age;
+        stateAt(time, &expectedPos, &expectedVel);
+
+        EXPECT_TRUE(estimationHistoryGetState(time, &pos, &vel));
+        EXPECT_NEAR(expectedPos.z, pos.z, 0.01f) << "age " << age;
+        EXPECT_NEAR(expectedVel.x, vel.x, 0.01f) << "age " << age;
+        EXPECT_NEAR(expectedPos.x, pos.x, 50.0f * sq(US2S(INAV_POSITION_HISTORY_INTERVAL_US)) / 4 + 0.01f) << "age " << age;
+    }
+}
+
+TEST_F(NavHistoryTest, TestHistoryCoversDelayAndFixInterval)
+{
+    run(2000000);
+
+    // Max inav_gps_delay of 300ms plus a fix interval at 5Hz
+    fpVector3_t pos;
+    fpVector3_t vel;
+    fpVector3_t expectedPos;
+    fpVector3_t expectedVel;
+    const timeUs_t time = now - MS2US(300) - MS2US(200);
+    stateAt(time, &expectedPos, &expectedVel);
+
+    EXPECT_TRUE(estimationHistoryGetState(time, &pos, &vel));
+    EXPECT_NEAR(expectedPos.z, pos.z, 0.01f);
+}
+
+TEST_F(NavHistoryTest, TestTooOldIsRejected)
+{
+    fpVector3_t pos;
+    fpVector3_t vel;
+
+    // Nothing stored yet, anything older than the estimate is out of range
+    EXPECT_FALSE(estimationHistoryGetState(now - 1000, &pos, &vel));
+    EXPECT_EQ(posEstimator.est.pos.z, pos.z);
+
+    run(2000000);
+
+    const timeUs_t oldest = newestEntryTime() - (INAV_POSITION_HISTORY_SIZE - 1) * INAV_POSITION_HISTORY_INTERVAL_US;
+    fpVector3_t expectedPos;
+    fpVector3_t expectedVel;
+    stateAt(oldest, &expectedPos, &expectedVel);
+
+    EXPECT_TRUE(estimationHistoryGetState(oldest, &pos, &vel));
+    EXPECT_FLOAT_EQ(expectedPos.z, pos.z);
+
+    // Older than the oldest entry, the state returned is the oldest one and must not be used
+    EXPECT_FALSE(estimationHistoryGetState(oldest - 1, &pos, &vel));
+    EXPECT_FLOAT_EQ(expectedPos.z, pos.z);
+    EXPECT_FALSE(estimationHistoryGetState(oldest - 1000000, &pos, &vel));
+}
+
+TEST_F(NavHistoryTest, TestCorrectionShiftsHistory)
+{
+    run(500000);
+
+    const timeUs_t measurementTime = now - 200000;
+    const float currentZ = posEstimator.est.pos.z;
+    fpVector3_t pos;
+    fpVector3_t vel;
+    EXPECT_TRUE(estimationHistoryGetState(measurementTime, &pos, &vel));
+    const float pastZ = pos.z;
+    EXPECT_TRUE(estimationHistoryGetState(measurementTime - 100000, &pos, &vel));
+    const float olderZ = pos.z;
+
+    // 1m up and 0.5m/s faster at the measurement time, the velocity error has acted for 200ms since
+    estimationHistoryApplyCorrection(Z, 100.0f, 50.0f, measurementTime);
+
+    EXPECT_NEAR(currentZ + 100.0f + 50.0f * 0.2f, posEstimator.est.pos.z, 0.01f);
+    EXPECT_NEAR(150.0f, posEstimator.est.vel.z, 0.01f);
+
+    EXPECT_TRUE(estimationHistoryGetState(measurementTime, &pos, &vel));
+    EXPECT_NEAR(pastZ + 100.0f, pos.z, 0.01f);
+    EXPECT_NEAR(150.0f, vel.z, 0.01f);
+
+    // Entries before the measurement only get the position shift
+    EXPECT_TRUE(estimationHistoryGetState(measurementTime - 100000, &pos, &vel));
+    EXPECT_NEAR(olderZ + 100.0f, pos.z, 0.01f);
+}
+
+// STUBS
+
+extern "C" {
+navigationPosEstimator_t posEstimator;
+}
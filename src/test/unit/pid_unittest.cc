@@ -0,0 +1,250 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+
+    #include "build/debug.h"
+
+    #include "common/axis.h"
+    #include "common/fp_pid.h"
+    #include "common/maths.h"
+
+    #include "config/parameter_group.h"
+
+    #include "fc/controlrate_profile.h"
+    #include "fc/rc_controls.h"
+    #include "fc/rc_modes.h"
+    #include "fc/runtime_config.h"
+
+    #include "flight/imu.h"
+    #include "flight/mixer.h"
+    #include "flight/mixer_profile.h"
+    #include "flight/pid.h"
+
+    #include "navigation/navigation.h"
+
+    #include "rx/rx.h"
+
+    #include "sensors/battery_config_structs.h"
+    #include "sensors/gyro.h"
+
+    extern float pidAppliedTPAFactor[XYZ_AXIS_COUNT];
+    extern pidBaseGains_t pidBaseGains[XYZ_AXIS_COUNT];
+    extern uint8_t usedPidControllerType;
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+static controlRateConfig_t rateProfile;
+static int throttleIdle;
+
+static float multirotorTPA(uint16_t throttle)
+{
+    const float rate = rateProfile.throttle.dynPID / 100.0f;
+    const float breakpoint = rateProfile.throttle.pa_breakpoint;
+
+    if (throttle <= breakpoint) {
+        return 1.0f;
+    }
+
+    return 1.0f - rate * MIN(throttle - breakpoint, motorConfig()->maxthrottle - breakpoint) / (motorConfig()->maxthrottle - breakpoint);
+}
+
+static float fixedWingTPA(uint16_t throttle)
+{
+    const float tpa = throttle > throttleIdle ? constrainf(0.5f + (rateProfile.throttle.pa_breakpoint - throttleIdle) / (2.0f * (throttle - throttleIdle)), 0.5f, 2.0f) : 2.0f;
+    return 1.0f + (tpa - 1.0f) * rateProfile.throttle.dynPID / 100.0f;
+}
+
+static void updateAtThrottle(uint16_t throttle)
+{
+    rcCommand[THROTTLE] = throttle;
+    updatePIDCoefficients();
+}
+
+class PidTpaTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        memset(&rateProfile, 0, sizeof(rateProfile));
+        rateProfile.throttle.dynPID = 50;
+        rateProfile.throttle.pa_breakpoint = 1500;
+        throttleIdle = 1150;
+        motorConfigMutable()->maxthrottle = 1850;
+        armingFlags = 0;
+        flightModeFlags = 0;
+
+        usedPidControllerType = PID_TYPE_PID;
+        schedulePidGainsUpdate();
+        updateAtThrottle(1000);
+    }
+};
+
+TEST_F(PidTpaTest, TestMultirotorCurveIsExact)
+{
+    // Breakpoint and max throttle are table nodes, no smoothing of the corners
+    for (uint16_t throttle = 1400; throttle <= 2000; throttle++) {
+        updateAtThrottle(throttle);
+        EXPECT_NEAR(multirotorTPA(throttle), pidAppliedTPAFactor[FD_ROLL], 1e-5f) << "throttle " << throttle;
+        EXPECT_EQ(pidAppliedTPAFactor[FD_ROLL], pidAppliedTPAFactor[FD_PITCH]);
+        EXPECT_EQ(1.0f, pidAppliedTPAFactor[FD_YAW]);
+    }
+}
+
+TEST_F(PidTpaTest, TestTpaChangeInFlightHasNoGainSpike)
+{
+    updateAtThrottle(1700);
+    float previous = pidAppliedTPAFactor[FD_ROLL];
+
+    // tpa_rate stepped by in flight adjustments, the throttle does not move
+    for (int rate = 51; rate <= 80; rate++) {
+        rateProfile.throttle.dynPID = rate;
+        updateAtThrottle(1700);
+
+        const float factor = pidAppliedTPAFactor[FD_ROLL];
+        EXPECT_NEAR(multirotorTPA(1700), factor, 1e-5f) << "tpa_rate " << rate;
+        EXPECT_LT(factor, previous);
+        EXPECT_NEAR(previous, factor, 0.01f * 200 / 350 + 1e-5f);
+        previous = factor;
+    }
+
+    // Breakpoint moved up past the throttle, the factor climbs back to 1 without overshooting
+    for (uint16_t breakpoint = 1500; breakpoint <= 1800; breakpoint += 10) {
+        rateProfile.throttle.pa_breakpoint = breakpoint;
+        updateAtThrottle(1700);
+
+        const float factor = pidAppliedTPAFactor[FD_ROLL];
+        EXPECT_NEAR(multirotorTPA(1700), factor, 1e-5f) << "tpa_breakpoint " << breakpoint;
+        EXPECT_GE(factor, previous);
+        EXPECT_LE(factor, 1.0f);
+        previous = factor;
+    }
+
+    // Rate and PID changes only rebuild the base gains, TPA stays put
+    rateProfile.throttle.pa_breakpoint = 1500;
+    updateAtThrottle(1700);
+    const float factor = pidAppliedTPAFactor[FD_ROLL];
+
+    pidProfileMutable()->bank_mc.pid[PID_ROLL].P += 10;
+    rateProfile.stabilized.rates[FD_ROLL] += 10;
+    schedulePidAxisGainsUpdate(FD_ROLL);
+    updateAtThrottle(1700);
+    EXPECT_EQ(factor, pidAppliedTPAFactor[FD_ROLL]);
+}
+
+TEST_F(PidTpaTest, TestBankWriteOnlyReloadsScheduledAxes)
+{
+    updateAtThrottle(1700);
+    const float pitchP = pidBaseGains[FD_PITCH].P;
+    const float pitchFactor = pidAppliedTPAFactor[FD_PITCH];
+
+    pidProfileMutable()->bank_mc.pid[PID_ROLL].P += 10;
+    pidProfileMutable()->bank_mc.pid[PID_PITCH].P += 10;
+    schedulePidAxisGainsUpdate(FD_ROLL);
+    updateAtThrottle(1700);
+
+    EXPECT_EQ(pidBank()->pid[PID_ROLL].P / FP_PID_RATE_P_MULTIPLIER, pidBaseGains[FD_ROLL].P);
+    EXPECT_EQ(pitchP, pidBaseGains[FD_PITCH].P);
+
+    // A throttle change rescales TPA on the cached gains, it doesn't reload the bank
+    updateAtThrottle(1800);
+    EXPECT_NE(pitchFactor, pidAppliedTPAFactor[FD_PITCH]);
+    EXPECT_EQ(pitchP, pidBaseGains[FD_PITCH].P);
+
+    schedulePidGainsUpdate();
+    updateAtThrottle(1800);
+    EXPECT_EQ(pidBank()->pid[PID_PITCH].P / FP_PID_RATE_P_MULTIPLIER, pidBaseGains[FD_PITCH].P);
+}
+
+TEST_F(PidTpaTest, TestFixedWingCurve)
+{
+    usedPidControllerType = PID_TYPE_PIFF;
+    rateProfile.throttle.dynPID = 100;
+    ENABLE_ARMING_FLAG(ARMED);
+
+    for (uint16_t throttle = 1000; throttle <= 2000; throttle++) {
+        updateAtThrottle(throttle);
+        EXPECT_NEAR(fixedWingTPA(throttle), pidAppliedTPAFactor[FD_ROLL], 0.005f) << "throttle " << throttle;
+        EXPECT_EQ(pidAppliedTPAFactor[FD_ROLL], pidAppliedTPAFactor[FD_YAW]);
+    }
+
+    // Cruise throttle changed in flight, the new curve applies at once
+    updateAtThrottle(1600);
+    rateProfile.throttle.pa_breakpoint = 1600;
+    updateAtThrottle(1600);
+    EXPECT_NEAR(1.0f, pidAppliedTPAFactor[FD_ROLL], 0.005f);
+}
+
+// STUBS
+
+extern "C" {
+const controlRateConfig_t *currentControlRateProfile = &rateProfile;
+const batteryProfile_t *currentBatteryProfile;
+mixerConfig_t currentMixerConfig;
+bool isMixerTransitionMixing;
+
+uint32_t armingFlags;
+uint32_t flightModeFlags;
+uint32_t stateFlags;
+
+int32_t debug[DEBUG32_VALUE_COUNT];
+uint8_t debugMode;
+
+int16_t rcCommand[4];
+attitudeEulerAngles_t attitude;
+gyro_t gyro;
+
+navConfig_t navConfig_System;
+motorConfig_t motorConfig_System;
+
+bool IS_RC_MODE_ACTIVE(boxId_e) { return false; }
+bool areSticksDeflected(void) { return false; }
+rollPitchStatus_e calculateRollPitchCenterStatus(void) { return CENTERED; }
+int32_t getRcStickDeflection(int32_t) { return 0; }
+int16_t rxGetChannelValue(unsigned) { return PWM_RANGE_MIDDLE; }
+
+uint32_t getLooptime(void) { return 1000; }
+int getThrottleIdleValue(void) { return throttleIdle; }
+float getMotorMixRange(void) { return 0.0f; }
+bool mixerIsOutputSaturated(void) { return false; }
+
+float calculateCosTiltAngle(void) { return 1.0f; }
+void imuTransformVectorEarthToBody(fpVector3_t *) {}
+
+float getFlightAxisAngleOverride(uint8_t, float angle) { return angle; }
+float getFlightAxisRateOverride(uint8_t, float rate) { return rate; }
+bool isFlightAxisAngleOverrideActive(uint8_t) { return false; }
+
+float getEstimatedActualVelocity(int) { return 0.0f; }
+int8_t navCheckActiveAngleHoldAxis(void) { return -1; }
+int8_t navigationGetHeadingControlState(void) { return 0; }
+bool navigationIsControllingAltitude(void) { return false; }
+bool navigationIsControllingThrottle(void) { return false; }
+bool navigationRequiresTurnAssistance(void) { return false; }
+
+float navPidApply3(pidController_t *, const float, const float, const float, const float, const float, const pidControllerFlags_e, const float, const float) { return 0.0f; }
+void navPidReset(pidController_t *) {}
+void navPidInit(pidController_t *, float, float, float, float, float, float) {}
+}
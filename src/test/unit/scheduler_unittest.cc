@@ -0,0 +1,737 @@
+/*
+ * This file is part of Cleanflight.
+ *
+ * Cleanflight is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Cleanflight is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Cleanflight.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+
+#include <vector>
+
+extern "C" {
+    #include "platform.h"
+    #include "scheduler/scheduler.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+enum {
+    systemTime = 10,
+    pidLoopTime = 650,
+    gyroTime = 40,
+    handleSerialTime = 30,
+    updateBatteryTime = 1,
+    updateTemperatureTime = 5,
+    updateRxCheckTime = 34,
+    updateRxMainTime = 10,
+    processGPSTime = 10,
+    updateCompassTime = 195,
+    updateBaroTime = 201,
+    updateDisplayTime = 10,
+    telemetryTime = 10,
+    ledStripTime = 10,
+    auxTime = 20
+};
+
+extern "C" {
+    extern cfTask_t *currentTask;
+
+// set up micros() to simulate time
+    uint32_t simulatedTime = 0;
+    uint32_t micros(void) {return simulatedTime;}
+
+    bool rxSignalPending = false;
+    timeDelta_t pidRescheduleUs = 0;
+
+// set up tasks to take a simulated representative time to execute
+    void taskSystemStub(timeUs_t) {simulatedTime+=systemTime;}
+    void taskMainPidLoop(timeUs_t) {
+        simulatedTime+=pidLoopTime;
+        if (pidRescheduleUs) {
+            rescheduleTask(TASK_SELF, pidRescheduleUs);
+        }
+    }
+    void taskGyro(timeUs_t) {simulatedTime+=gyroTime;}
+    void taskHandleSerial(timeUs_t) {simulatedTime+=handleSerialTime;}
+    void taskUpdateBattery(timeUs_t) {simulatedTime+=updateBatteryTime;}
+    void taskUpdateTemperature(timeUs_t) {simulatedTime+=updateTemperatureTime;}
+    bool taskUpdateRxCheck(timeUs_t, timeDelta_t) {simulatedTime+=updateRxCheckTime;return rxSignalPending;}
+    void taskUpdateRxMain(timeUs_t) {simulatedTime+=updateRxMainTime;rxSignalPending=false;}
+    void taskProcessGPS(timeUs_t) {simulatedTime+=processGPSTime;}
+    void taskUpdateCompass(timeUs_t) {simulatedTime+=updateCompassTime;}
+    void taskUpdateBaro(timeUs_t) {simulatedTime+=updateBaroTime;}
+    void taskDashboardUpdate(timeUs_t) {simulatedTime+=updateDisplayTime;}
+    void taskTelemetry(timeUs_t) {simulatedTime+=telemetryTime;}
+    void taskLedStrip(timeUs_t) {simulatedTime+=ledStripTime;}
+    void taskUpdateAux(timeUs_t) {simulatedTime+=auxTime;}
+    void taskRunRealtimeCallbacks(timeUs_t) {}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+    cfTask_t cfTasks[TASK_COUNT] = {
+        [TASK_SYSTEM] = {
+            .taskName = "SYSTEM",
+            .taskFunc = taskSystemStub,
+            .desiredPeriod = TASK_PERIOD_HZ(10),
+            .staticPriority = TASK_PRIORITY_HIGH,
+        },
+        [TASK_PID] = {
+            .taskName = "PID",
+            .taskFunc = taskMainPidLoop,
+            .desiredPeriod = TASK_PERIOD_US(1000),
+            .staticPriority = TASK_PRIORITY_REALTIME,
+        },
+        [TASK_GYRO] = {
+            .taskName = "GYRO",
+            .taskFunc = taskGyro,
+            .desiredPeriod = TASK_PERIOD_US(250),
+            .staticPriority = TASK_PRIORITY_REALTIME,
+        },
+        [TASK_RX] = {
+            .taskName = "RX",
+            .checkFunc = taskUpdateRxCheck,
+            .taskFunc = taskUpdateRxMain,
+            .desiredPeriod = TASK_PERIOD_HZ(10),
+            .staticPriority = TASK_PRIORITY_HIGH,
+        },
+        [TASK_SERIAL] = {
+            .taskName = "SERIAL",
+            .taskFunc = taskHandleSerial,
+            .desiredPeriod = TASK_PERIOD_HZ(100),
+            .staticPriority = TASK_PRIORITY_LOW,
+        },
+        [TASK_BATTERY] = {
+            .taskName = "BATTERY",
+            .taskFunc = taskUpdateBattery,
+            .desiredPeriod = TASK_PERIOD_HZ(50),
+            .staticPriority = TASK_PRIORITY_MEDIUM,
+        },
+        [TASK_TEMPERATURE] = {
+            .taskName = "TEMPERATURE",
+            .taskFunc = taskUpdateTemperature,
+            .desiredPeriod = TASK_PERIOD_HZ(100),
+            .staticPriority = TASK_PRIORITY_LOW,
+        },
+        [TASK_GPS] = {
+            .taskName = "GPS",
+            .taskFunc = taskProcessGPS,
+            .desiredPeriod = TASK_PERIOD_HZ(50),
+            .staticPriority = TASK_PRIORITY_MEDIUM,
+        },
+        [TASK_COMPASS] = {
+            .taskName = "COMPASS",
+            .taskFunc = taskUpdateCompass,
+            .desiredPeriod = TASK_PERIOD_HZ(10),
+            .staticPriority = TASK_PRIORITY_MEDIUM,
+        },
+        [TASK_BARO] = {
+            .taskName = "BARO",
+            .taskFunc = taskUpdateBaro,
+            .desiredPeriod = TASK_PERIOD_HZ(20),
+            .staticPriority = TASK_PRIORITY_MEDIUM,
+        },
+        [TASK_DASHBOARD] = {
+            .taskName = "DASHBOARD",
+            .taskFunc = taskDashboardUpdate,
+            .desiredPeriod = TASK_PERIOD_HZ(10),
+            .staticPriority = TASK_PRIORITY_LOW,
+        },
+        [TASK_TELEMETRY] = {
+            .taskName = "TELEMETRY",
+            .taskFunc = taskTelemetry,
+            .desiredPeriod = TASK_PERIOD_HZ(500),
+            .staticPriority = TASK_PRIORITY_IDLE,
+        },
+        [TASK_LEDSTRIP] = {
+            .taskName = "LEDSTRIP",
+            .taskFunc = taskLedStrip,
+            .desiredPeriod = TASK_PERIOD_HZ(100),
+            .staticPriority = TASK_PRIORITY_IDLE,
+        },
+        [TASK_AUX] = {
+            .taskName = "AUX",
+            .taskFunc = taskUpdateAux,
+            .desiredPeriod = TASK_PERIOD_HZ(100),
+            .staticPriority = TASK_PRIORITY_HIGH,
+        },
+    };
+#pragma GCC diagnostic pop
+
+    extern cfTask_t* taskQueueArray[];
+    extern cfTask_t* taskDueHeap[];
+    extern int taskDueHeapSize;
+
+    extern void queueClear(void);
+    extern int queueSize();
+    extern bool queueContains(cfTask_t *task);
+    extern bool queueAdd(cfTask_t *task);
+    extern bool queueRemove(cfTask_t *task);
+    extern cfTask_t *queueFirst(void);
+    extern cfTask_t *queueNext(void);
+}
+
+static void disableAllTasks(void)
+{
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<cfTaskId_e>(taskId), false);
+    }
+}
+
+static void resetAllTasks(void)
+{
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        cfTasks[taskId].dynamicPriority = 0;
+        cfTasks[taskId].taskAgeCycles = 0;
+        cfTasks[taskId].lastExecutedAt = 0;
+        cfTasks[taskId].lastSignaledAt = 0;
+        cfTasks[taskId].taskLatestDeltaTime = 0;
+        cfTasks[taskId].deadlineDeferred = false;
+    }
+}
+
+// Re-insert enabled tasks after their timing was modified directly
+static void resetAllTasksQueue(void)
+{
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        if (queueContains(&cfTasks[taskId])) {
+            setTaskEnabled(static_cast<cfTaskId_e>(taskId), false);
+            setTaskEnabled(static_cast<cfTaskId_e>(taskId), true);
+        }
+    }
+}
+
+static timeUs_t dueAt(const cfTask_t *task)
+{
+    return task->lastExecutedAt + task->desiredPeriod + (task->staticPriority == TASK_PRIORITY_REALTIME ? 1 : 0);
+}
+
+static void checkDueHeap(void)
+{
+    for (int ii = 1; ii < taskDueHeapSize; ++ii) {
+        const cfTask_t *parent = taskDueHeap[(ii - 1) / 2];
+        EXPECT_LE(0, (timeDelta_t)(dueAt(taskDueHeap[ii]) - dueAt(parent)));
+    }
+}
+
+/*
+ * Linear priority scan as used by the scheduler before the due time heap was introduced.
+ * Kept here as the reference the heap based dispatcher has to match.
+ */
+static cfTask_t *referenceScheduler(void)
+{
+    const timeUs_t currentTimeUs = micros();
+
+    cfTask_t *selectedTask = NULL;
+    uint16_t selectedTaskDynamicPriority = 0;
+    bool forcedRealTimeTask = false;
+
+    for (cfTask_t *task = queueFirst(); task != NULL; task = queueNext()) {
+        if (task->checkFunc) {
+            const timeUs_t currentTimeBeforeCheckFuncCallUs = micros();
+            if (task->dynamicPriority > 0) {
+                task->taskAgeCycles = 1 + ((timeDelta_t)(currentTimeUs - task->lastSignaledAt)) / task->desiredPeriod;
+                task->dynamicPriority = 1 + task->staticPriority * task->taskAgeCycles;
+            } else if (task->checkFunc(currentTimeBeforeCheckFuncCallUs, currentTimeBeforeCheckFuncCallUs - task->lastExecutedAt)) {
+                task->lastSignaledAt = currentTimeBeforeCheckFuncCallUs;
+                task->taskAgeCycles = 1;
+                task->dynamicPriority = 1 + task->staticPriority;
+            } else {
+                task->taskAgeCycles = 0;
+            }
+        } else if (task->staticPriority == TASK_PRIORITY_REALTIME) {
+            if (((timeDelta_t)(currentTimeUs - task->lastExecutedAt)) > task->desiredPeriod) {
+                selectedTaskDynamicPriority = task->dynamicPriority;
+                selectedTask = task;
+                forcedRealTimeTask = true;
+            }
+        } else {
+            task->taskAgeCycles = ((timeDelta_t)(currentTimeUs - task->lastExecutedAt)) / task->desiredPeriod;
+            if (task->taskAgeCycles > 0) {
+                task->dynamicPriority = 1 + task->staticPriority * task->taskAgeCycles;
+            }
+        }
+
+        if (!forcedRealTimeTask && task->dynamicPriority > selectedTaskDynamicPriority) {
+            selectedTaskDynamicPriority = task->dynamicPriority;
+            selectedTask = task;
+        }
+    }
+
+    currentTask = selectedTask;
+
+    if (selectedTask) {
+        selectedTask->taskLatestDeltaTime = (timeDelta_t)(currentTimeUs - selectedTask->lastExecutedAt);
+        selectedTask->lastExecutedAt = currentTimeUs;
+        selectedTask->dynamicPriority = 0;
+        selectedTask->taskFunc(micros());
+    }
+
+    return selectedTask;
+}
+
+struct scheduledTask_t {
+    timeUs_t time;
+    int taskId;
+};
+
+static std::vector<scheduledTask_t> runScenario(bool useReference, int cycles)
+{
+    std::vector<scheduledTask_t> trace;
+
+    queueClear();
+    resetAllTasks();
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        setTaskEnabled(static_cast<cfTaskId_e>(taskId), true);
+    }
+    rescheduleTask(TASK_PID, 1000);
+    simulatedTime = 1000;
+    rxSignalPending = false;
+
+    for (int ii = 0; ii < cycles; ++ii) {
+        // RX frames arrive every 7 ms
+        if ((ii % 700) == 0) {
+            rxSignalPending = true;
+        }
+        // Switch PID rate mid-flight to exercise rescheduling from within a task
+        pidRescheduleUs = (ii == cycles / 2) ? 500 : 0;
+
+        const timeUs_t startTime = simulatedTime;
+        cfTask_t *task;
+        if (useReference) {
+            task = referenceScheduler();
+        } else {
+            scheduler();
+            task = currentTask;
+        }
+        trace.push_back({ startTime, task ? (int)(task - cfTasks) : -1 });
+
+        // scheduler overhead
+        simulatedTime += 3;
+    }
+
+    pidRescheduleUs = 0;
+    return trace;
+}
+
+TEST(SchedulerUnittest, TestPriorites)
+{
+    EXPECT_EQ(14, TASK_COUNT);
+          // if any of these fail then task priorities have changed and ordering in TestQueue needs to be re-checked
+    EXPECT_EQ(TASK_PRIORITY_HIGH, cfTasks[TASK_SYSTEM].staticPriority);
+    EXPECT_EQ(TASK_PRIORITY_REALTIME, cfTasks[TASK_PID].staticPriority);
+    EXPECT_EQ(TASK_PRIORITY_REALTIME, cfTasks[TASK_GYRO].staticPriority);
+    EXPECT_EQ(TASK_PRIORITY_LOW, cfTasks[TASK_SERIAL].staticPriority);
+    EXPECT_EQ(TASK_PRIORITY_MEDIUM, cfTasks[TASK_BATTERY].staticPriority);
+    EXPECT_EQ(TASK_PRIORITY_HIGH, cfTasks[TASK_RX].staticPriority);
+}
+
+TEST(SchedulerUnittest, TestQueueInit)
+{
+    queueClear();
+    EXPECT_EQ(0, queueSize());
+    EXPECT_EQ(0, queueFirst());
+    EXPECT_EQ(0, queueNext());
+    EXPECT_EQ(0, taskDueHeapSize);
+    for (int ii = 0; ii <= TASK_COUNT; ++ii) {
+        EXPECT_EQ(0, taskQueueArray[ii]);
+    }
+}
+
+cfTask_t *deadBeefPtr = reinterpret_cast<cfTask_t*>(0xDEADBEEF);
+
+TEST(SchedulerUnittest, TestQueue)
+{
+    queueClear();
+    taskQueueArray[TASK_COUNT + 1] = deadBeefPtr;
+
+    queueAdd(&cfTasks[TASK_SYSTEM]); // TASK_PRIORITY_HIGH
+    EXPECT_EQ(1, queueSize());
+    EXPECT_EQ(&cfTasks[TASK_SYSTEM], queueFirst());
+    EXPECT_EQ(deadBeefPtr, taskQueueArray[TASK_COUNT + 1]);
+
+    queueAdd(&cfTasks[TASK_PID]); // TASK_PRIORITY_REALTIME
+    EXPECT_EQ(2, queueSize());
+    EXPECT_EQ(&cfTasks[TASK_PID], queueFirst());
+    EXPECT_EQ(&cfTasks[TASK_SYSTEM], queueNext());
+    EXPECT_EQ(NULL, queueNext());
+    EXPECT_EQ(deadBeefPtr, taskQueueArray[TASK_COUNT + 1]);
+
+    queueAdd(&cfTasks[TASK_SERIAL]); // TASK_PRIORITY_LOW
+    EXPECT_EQ(3, queueSize());
+    EXPECT_EQ(&cfTasks[TASK_PID], queueFirst());
+    EXPECT_EQ(&cfTasks[TASK_SYSTEM], queueNext());
+    EXPECT_EQ(&cfTasks[TASK_SERIAL], queueNext());
+    EXPECT_EQ(NULL, queueNext());
+    EXPECT_EQ(deadBeefPtr, taskQueueArray[TASK_COUNT + 1]);
+
+    queueAdd(&cfTasks[TASK_BATTERY]); // TASK_PRIORITY_MEDIUM
+    EXPECT_EQ(4, queueSize());
+    EXPECT_EQ(&cfTasks[TASK_PID], queueFirst());
+    EXPECT_EQ(&cfTasks[TASK_SYSTEM], queueNext());
+    EXPECT_EQ(&cfTasks[TASK_BATTERY], queueNext());
+    EXPECT_EQ(&cfTasks[TASK_SERIAL], queueNext());
+    EXPECT_EQ(NULL, queueNext());
+    EXPECT_EQ(deadBeefPtr, taskQueueArray[TASK_COUNT + 1]);
+
+    queueAdd(&cfTasks[TASK_RX]); // TASK_PRIORITY_HIGH
+    EXPECT_EQ(5, queueSize());
+    EXPECT_EQ(&cfTasks[TASK_PID], queueFirst());
+    EXPECT_EQ(&cfTasks[TASK_SYSTEM], queueNext());
+    EXPECT_EQ(&cfTasks[TASK_RX], queueNext());
+    EXPECT_EQ(&cfTasks[TASK_BATTERY], queueNext());
+    EXPECT_EQ(&cfTasks[TASK_SERIAL], queueNext());
+    EXPECT_EQ(NULL, queueNext());
+    EXPECT_EQ(deadBeefPtr, taskQueueArray[TASK_COUNT + 1]);
+
+    // event driven TASK_RX is not kept in the due time heap
+    EXPECT_EQ(4, taskDueHeapSize);
+
+    queueRemove(&cfTasks[TASK_SYSTEM]); // TASK_PRIORITY_HIGH
+    EXPECT_EQ(4, queueSize());
+    EXPECT_EQ(&cfTasks[TASK_PID], queueFirst());
+    EXPECT_EQ(&cfTasks[TASK_RX], queueNext());
+    EXPECT_EQ(&cfTasks[TASK_BATTERY], queueNext());
+    EXPECT_EQ(&cfTasks[TASK_SERIAL], queueNext());
+    EXPECT_EQ(NULL, queueNext());
+    EXPECT_EQ(3, taskDueHeapSize);
+}
+
+TEST(SchedulerUnittest, TestQueueAddAndRemove)
+{
+    queueClear();
+    taskQueueArray[TASK_COUNT + 1] = deadBeefPtr;
+
+    // fill up the queue
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        const bool added = queueAdd(&cfTasks[taskId]);
+        EXPECT_EQ(true, added);
+        EXPECT_EQ(taskId + 1, queueSize());
+        EXPECT_EQ(deadBeefPtr, taskQueueArray[TASK_COUNT + 1]);
+        checkDueHeap();
+    }
+    // double check end of queue
+    EXPECT_EQ(TASK_COUNT, queueSize());
+    EXPECT_EQ(TASK_COUNT - 1, taskDueHeapSize); // all but TASK_RX
+    EXPECT_NE(static_cast<cfTask_t*>(0), taskQueueArray[TASK_COUNT - 1]); // last item was indeed added to queue
+    EXPECT_EQ(NULL, taskQueueArray[TASK_COUNT]); // null pointer at end of queue is preserved
+    EXPECT_EQ(deadBeefPtr, taskQueueArray[TASK_COUNT + 1]); // there hasn't been an out by one error
+
+    // and empty it again
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        const bool removed = queueRemove(&cfTasks[taskId]);
+        EXPECT_EQ(true, removed);
+        EXPECT_EQ(TASK_COUNT - taskId - 1, queueSize());
+        EXPECT_EQ(NULL, taskQueueArray[TASK_COUNT - taskId]);
+        EXPECT_EQ(deadBeefPtr, taskQueueArray[TASK_COUNT + 1]);
+        checkDueHeap();
+    }
+    // double check size and end of queue
+    EXPECT_EQ(0, queueSize()); // queue is indeed empty
+    EXPECT_EQ(0, taskDueHeapSize);
+    EXPECT_EQ(NULL, taskQueueArray[0]); // there is a null pointer at the end of the queueu
+    EXPECT_EQ(deadBeefPtr, taskQueueArray[TASK_COUNT + 1]); // no accidental overwrites past end of queue
+}
+
+TEST(SchedulerUnittest, TestDueHeapOrder)
+{
+    queueClear();
+    resetAllTasks();
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        cfTasks[taskId].lastExecutedAt = 1000 * ((taskId * 7) % TASK_COUNT);
+        setTaskEnabled(static_cast<cfTaskId_e>(taskId), true);
+        checkDueHeap();
+    }
+
+    // earliest due task is at the root
+    for (int ii = 0; ii < taskDueHeapSize; ++ii) {
+        EXPECT_LE(0, (timeDelta_t)(dueAt(taskDueHeap[ii]) - dueAt(taskDueHeap[0])));
+    }
+
+    rescheduleTask(TASK_SYSTEM, 50);
+    checkDueHeap();
+    EXPECT_EQ(&cfTasks[TASK_SYSTEM], taskDueHeap[0]);
+
+    rescheduleTask(TASK_SYSTEM, 100000);
+    checkDueHeap();
+
+    setTaskEnabled(TASK_GYRO, false);
+    setTaskEnabled(TASK_BATTERY, false);
+    checkDueHeap();
+    EXPECT_EQ(TASK_COUNT - 3, taskDueHeapSize);
+}
+
+TEST(SchedulerUnittest, TestSchedulerInit)
+{
+    schedulerInit();
+    EXPECT_EQ(1, queueSize());
+    EXPECT_EQ(&cfTasks[TASK_SYSTEM], queueFirst());
+}
+
+TEST(SchedulerUnittest, TestScheduleEmptyQueue)
+{
+    queueClear();
+    simulatedTime = 4000;
+    // run the with an empty queue
+    scheduler();
+    EXPECT_EQ(NULL, currentTask);
+}
+
+TEST(SchedulerUnittest, TestSingleTask)
+{
+    schedulerInit();
+    resetAllTasks();
+    // disable all tasks except TASK_PID
+    disableAllTasks();
+    cfTasks[TASK_PID].lastExecutedAt = 1000;
+    cfTasks[TASK_PID].totalExecutionTime = 0;
+    setTaskEnabled(TASK_PID, true);
+    simulatedTime = 4000;
+    // run the scheduler and check the task has executed
+    scheduler();
+    EXPECT_NE(static_cast<cfTask_t*>(0), currentTask);
+    EXPECT_EQ(&cfTasks[TASK_PID], currentTask);
+    EXPECT_EQ(3000, cfTasks[TASK_PID].taskLatestDeltaTime);
+    EXPECT_EQ(4000, cfTasks[TASK_PID].lastExecutedAt);
+    EXPECT_EQ(pidLoopTime, cfTasks[TASK_PID].totalExecutionTime);
+    // task has run, so its dynamic priority should have been set to zero
+    EXPECT_EQ(0, cfTasks[TASK_PID].dynamicPriority);
+}
+
+TEST(SchedulerUnittest, TestTwoTasks)
+{
+    resetAllTasks();
+    // disable all tasks except TASK_PID and TASK_BATTERY
+    disableAllTasks();
+
+    // set it up so that TASK_BATTERY ran just before TASK_PID
+    static const uint32_t startTime = 4000;
+    simulatedTime = startTime;
+    cfTasks[TASK_PID].lastExecutedAt = simulatedTime;
+    cfTasks[TASK_BATTERY].lastExecutedAt = cfTasks[TASK_PID].lastExecutedAt - updateBatteryTime;
+    setTaskEnabled(TASK_BATTERY, true);
+    setTaskEnabled(TASK_PID, true);
+    EXPECT_EQ(0, cfTasks[TASK_BATTERY].taskAgeCycles);
+    // run the scheduler
+    scheduler();
+    // no tasks should have run, since neither task's desired time has elapsed
+    EXPECT_EQ(static_cast<cfTask_t*>(0), currentTask);
+
+    // NOTE:
+    // TASK_PID desiredPeriod is  1000 microseconds
+    // TASK_BATTERY desiredPeriod is 20000 microseconds
+    // 500 microseconds later
+    simulatedTime += 500;
+    // no tasks should run, since neither task's desired time has elapsed
+    scheduler();
+    EXPECT_EQ(static_cast<cfTask_t*>(0), currentTask);
+
+    // 501 microseconds later, TASK_PID is overdue
+    simulatedTime += 501;
+    // TASK_PID should now run
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_PID], currentTask);
+    EXPECT_EQ(5001 + pidLoopTime, simulatedTime);
+
+    simulatedTime += 1001 - pidLoopTime;
+    scheduler();
+    // TASK_PID should run again
+    EXPECT_EQ(&cfTasks[TASK_PID], currentTask);
+
+    scheduler();
+    EXPECT_EQ(static_cast<cfTask_t*>(0), currentTask);
+
+    simulatedTime = startTime + 20500; // TASK_PID and TASK_BATTERY desiredPeriods have elapsed
+    // of the two TASK_PID should run first
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_PID], currentTask);
+    // and finally TASK_BATTERY should now run
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_BATTERY], currentTask);
+}
+
+TEST(SchedulerUnittest, TestRealtimeTaskTieBreak)
+{
+    resetAllTasks();
+    disableAllTasks();
+    setTaskEnabled(TASK_PID, true);
+    setTaskEnabled(TASK_GYRO, true);
+    setTaskEnabled(TASK_SYSTEM, true);
+
+    // all overdue, the realtime task queued last takes precedence like in the linear scan
+    simulatedTime = 200000;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_GYRO], currentTask);
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_PID], currentTask);
+
+    // TASK_SYSTEM only runs once no realtime task is overdue
+    simulatedTime = cfTasks[TASK_GYRO].lastExecutedAt + 100;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_SYSTEM], currentTask);
+}
+
+TEST(SchedulerUnittest, TestTaskHistogram)
+{
+    resetAllTasks();
+    disableAllTasks();
+    schedulerResetTaskStatistics(TASK_PID);
+    cfTasks[TASK_PID].lastExecutedAt = 10000;
+    setTaskEnabled(TASK_PID, true);
+
+    // started 100us late, execution takes 650us
+    simulatedTime = 11100;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_PID], currentTask);
+
+    cfTaskHistogram_t histogram;
+    getTaskHistogram(TASK_PID, &histogram);
+    EXPECT_EQ(1, histogram.executionTime[10]);  // [512, 1024)
+    EXPECT_EQ(1, histogram.startLatency[7]);    // [64, 128)
+    EXPECT_EQ(1023u, taskHistogramPercentile(histogram.executionTime, 99));
+    EXPECT_EQ(127u, taskHistogramPercentile(histogram.startLatency, 50));
+
+    // started 1us late
+    simulatedTime = cfTasks[TASK_PID].lastExecutedAt + 1001;
+    scheduler();
+    getTaskHistogram(TASK_PID, &histogram);
+    EXPECT_EQ(2, histogram.executionTime[10]);
+    EXPECT_EQ(1, histogram.startLatency[1]);
+    EXPECT_EQ(1u, taskHistogramPercentile(histogram.startLatency, 50));
+    EXPECT_EQ(127u, taskHistogramPercentile(histogram.startLatency, 99));
+
+    schedulerResetTaskStatistics(TASK_PID);
+    getTaskHistogram(TASK_PID, &histogram);
+    for (int ii = 0; ii < TASK_HISTOGRAM_BUCKETS; ++ii) {
+        EXPECT_EQ(0, histogram.executionTime[ii]);
+        EXPECT_EQ(0, histogram.startLatency[ii]);
+    }
+    EXPECT_EQ(0u, taskHistogramPercentile(histogram.executionTime, 50));
+}
+
+TEST(SchedulerUnittest, TestDeadlineMode)
+{
+    resetAllTasks();
+    disableAllTasks();
+    schedulerResetTaskStatistics(TASK_BARO);
+    cfTasks[TASK_PID].lastExecutedAt = 100000;
+    cfTasks[TASK_BARO].lastExecutedAt = 100000 - cfTasks[TASK_BARO].desiredPeriod;
+    setTaskEnabled(TASK_PID, true);
+    setTaskEnabled(TASK_BARO, true);
+
+    // pretend TASK_BARO always takes updateBaroTime
+    cfTasks[TASK_BARO].movingSumExecutionTime = updateBaroTime * 32;
+    cfTasks[TASK_BARO].maxExecutionTime = updateBaroTime;
+
+    // TASK_PID is due in 150us, TASK_BARO would not finish in time
+    schedulerSetDeadlineMode(SCHEDULER_DEADLINE_AVERAGE);
+    const uint32_t deferredBefore = schedulerGetDeferredTaskCount();
+    simulatedTime = 100850;
+    scheduler();
+    EXPECT_EQ(NULL, currentTask);
+    EXPECT_EQ(deferredBefore + 1, schedulerGetDeferredTaskCount());
+
+    // Still waiting for a window, that is the same deferral
+    simulatedTime = 100900;
+    scheduler();
+    EXPECT_EQ(NULL, currentTask);
+    EXPECT_EQ(deferredBefore + 1, schedulerGetDeferredTaskCount());
+
+    // TASK_PID runs as usual, afterwards there is enough time for TASK_BARO
+    simulatedTime = 101001;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_PID], currentTask);
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_BARO], currentTask);
+    EXPECT_EQ(deferredBefore + 1, schedulerGetDeferredTaskCount());
+
+    // without deadline mode TASK_BARO is started right away
+    schedulerSetDeadlineMode(SCHEDULER_DEADLINE_OFF);
+    cfTasks[TASK_PID].lastExecutedAt = 200000;
+    cfTasks[TASK_BARO].lastExecutedAt = 200000 - cfTasks[TASK_BARO].desiredPeriod;
+    resetAllTasksQueue();
+    simulatedTime = 200850;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_BARO], currentTask);
+}
+
+TEST(SchedulerUnittest, TestDeadlineModeFallsThrough)
+{
+    resetAllTasks();
+    disableAllTasks();
+    schedulerResetTaskStatistics(TASK_BARO);
+    schedulerResetTaskStatistics(TASK_TEMPERATURE);
+    cfTasks[TASK_PID].lastExecutedAt = 100000;
+    cfTasks[TASK_BARO].lastExecutedAt = 100000 - cfTasks[TASK_BARO].desiredPeriod;
+    cfTasks[TASK_TEMPERATURE].lastExecutedAt = 100000 - cfTasks[TASK_TEMPERATURE].desiredPeriod;
+    setTaskEnabled(TASK_PID, true);
+    setTaskEnabled(TASK_BARO, true);
+    setTaskEnabled(TASK_TEMPERATURE, true);
+
+    cfTasks[TASK_BARO].movingSumExecutionTime = updateBaroTime * 32;
+    cfTasks[TASK_TEMPERATURE].movingSumExecutionTime = updateTemperatureTime * 32;
+
+    // TASK_PID is due in 150us, TASK_BARO is preferred but would not finish in time, TASK_TEMPERATURE does
+    schedulerSetDeadlineMode(SCHEDULER_DEADLINE_AVERAGE);
+    const uint32_t deferredBefore = schedulerGetDeferredTaskCount();
+    simulatedTime = 100850;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_TEMPERATURE], currentTask);
+    EXPECT_EQ(deferredBefore + 1, schedulerGetDeferredTaskCount());
+
+    // Nothing else fits
+    scheduler();
+    EXPECT_EQ(NULL, currentTask);
+    EXPECT_EQ(deferredBefore + 1, schedulerGetDeferredTaskCount());
+
+    simulatedTime = 101001;
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_PID], currentTask);
+    scheduler();
+    EXPECT_EQ(&cfTasks[TASK_BARO], currentTask);
+
+    schedulerSetDeadlineMode(SCHEDULER_DEADLINE_OFF);
+}
+
+TEST(SchedulerUnittest, TestMatchesLinearScan)
+{
+    const int cycles = 20000;
+    const std::vector<scheduledTask_t> expected = runScenario(true, cycles);
+    const std::vector<scheduledTask_t> actual = runScenario(false, cycles);
+
+    ASSERT_EQ(expected.size(), actual.size());
+    int executedTasks = 0;
+    for (size_t ii = 0; ii < expected.size(); ++ii) {
+        ASSERT_EQ(expected[ii].time, actual[ii].time) << "cycle " << ii;
+        ASSERT_EQ(expected[ii].taskId, actual[ii].taskId) << "cycle " << ii;
+        if (actual[ii].taskId >= 0) {
+            executedTasks++;
+        }
+    }
+
+    // make sure the scenario actually exercised every task
+    for (int taskId = 0; taskId < TASK_COUNT; ++taskId) {
+        bool executed = false;
+        for (const scheduledTask_t &entry : actual) {
+            executed |= entry.taskId == taskId;
+        }
+        EXPECT_TRUE(executed) << cfTasks[taskId].taskName;
+    }
+    EXPECT_GT(executedTasks, 0);
+    checkDueHeap();
+}
+
+// STUBS
+extern "C" {
+}
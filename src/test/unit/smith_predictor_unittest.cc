@@ -0,0 +1,177 @@
+/*
+ * This file is part of INAV.
+ *
+ * INAV is free software. You can redistribute this software
+ * and/or modify this software under the terms of the
+ * GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * INAV is distributed in the hope that they will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+extern "C" {
+    #include "platform.h"
+    #include "common/filter.h"
+    #include "flight/smith_predictor.h"
+}
+
+#include "unittest_macros.h"
+#include "gtest/gtest.h"
+
+#define LOOPTIME_US     1000
+#define MAX_DELAY_MS    8
+#define PLANT_HISTORY   64
+
+static uint32_t rng;
+
+static float noise(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (float)(rng & 0xFFFF) / 0x8000 - 1.0f;
+}
+
+/*
+ * Rate plant: angular acceleration follows the PID output delayed by a number of
+ * loops, the measured rate goes through a PT1 like a gyro LPF would and picks up
+ * sensor noise. The PID output is a PD controller on the measured rate plus stick
+ * input, which like real stick and PID output is mostly low frequency. Gyro noise
+ * goes straight through P and D to the output, it correlates with the measured
+ * rate at the shortest lags whatever the plant delay is.
+ */
+typedef struct {
+    float gain;
+    float lpfHz;
+    float gyroNoise;
+    float dGain;
+} plant_t;
+
+static float identifyDelay(int plantDelay, const plant_t *plant, int loops)
+{
+    smithDelayEstimator_t estimator;
+    pt1Filter_t gyroLpf;
+    float output[PLANT_HISTORY] = { 0 };
+    float rate = 0;
+    float previousGyroRate = 0;
+    float pidOutput = 0;
+    float stick = 0;
+
+    rng = 2463534242u;
+    smithDelayEstimatorInit(&estimator, MAX_DELAY_MS, LOOPTIME_US);
+    pt1FilterInit(&gyroLpf, plant->lpfHz, LOOPTIME_US * 1e-6f);
+
+    for (int loop = 0; loop < loops; loop++) {
+        rate += plant->gain * output[(loop - plantDelay + PLANT_HISTORY) % PLANT_HISTORY];
+        const float gyroRate = (plant->lpfHz > 0 ? pt1FilterApply(&gyroLpf, rate) : rate) + plant->gyroNoise * noise();
+
+        smithDelayEstimatorPush(&estimator, pidOutput, gyroRate);
+        smithDelayEstimatorUpdate(&estimator);
+
+        stick = 0.99f * stick + 10.0f * noise();
+        pidOutput = -5.0f * plant->gain * gyroRate - plant->dGain * (gyroRate - previousGyroRate) + stick;
+        output[loop % PLANT_HISTORY] = pidOutput;
+        previousGyroRate = gyroRate;
+    }
+
+    return estimator.delaySamples;
+}
+
+static float identifyDelay(int plantDelay, float gain, float lpfHz, int loops)
+{
+    const plant_t plant = { .gain = gain, .lpfHz = lpfHz, .gyroNoise = 0, .dGain = 0 };
+    return identifyDelay(plantDelay, &plant, loops);
+}
+
+TEST(SmithPredictorTest, TestDelayIdentification)
+{
+    for (int delay = 3; delay <= 6; delay++) {
+        EXPECT_NEAR(delay, identifyDelay(delay, 0.01f, 0, 20000), 0.5f) << "plant delay " << delay;
+    }
+}
+
+TEST(SmithPredictorTest, TestNoEstimateBelowFeedbackLags)
+{
+    // The response is all at the lags gyro noise feedback also correlates at, they are not used
+    for (int delay = 1; delay <= 2; delay++) {
+        EXPECT_EQ(0, identifyDelay(delay, 0.01f, 0, 20000)) << "plant delay " << delay;
+    }
+}
+
+TEST(SmithPredictorTest, TestDelayIdentificationSignReversed)
+{
+    EXPECT_NEAR(3, identifyDelay(3, -0.01f, 0, 20000), 0.5f);
+}
+
+TEST(SmithPredictorTest, TestDelayIdentificationIncludesFilterDelay)
+{
+    // PT1 at 80Hz adds 1 / (2 * PI * 80) = 2ms of group delay at low frequencies
+    const float identified = identifyDelay(2, 0.01f, 80, 20000);
+    EXPECT_GT(identified, 3.0f);
+    EXPECT_LT(identified, 5.0f);
+}
+
+TEST(SmithPredictorTest, TestNoEstimateWithoutExcitation)
+{
+    smithDelayEstimator_t estimator;
+    smithDelayEstimatorInit(&estimator, MAX_DELAY_MS, LOOPTIME_US);
+
+    for (int loop = 0; loop < 20000; loop++) {
+        smithDelayEstimatorPush(&estimator, 0, 0);
+        EXPECT_FALSE(smithDelayEstimatorUpdate(&estimator));
+    }
+    EXPECT_EQ(0, estimator.delaySamples);
+}
+
+TEST(SmithPredictorTest, TestDelayChangeKeepsHistory)
+{
+    smithPredictor_t predictor;
+    memset(&predictor, 0, sizeof(predictor));
+
+    // Full strength and a filter far above the sample rate, output is 2 * x(t) - x(t - delay)
+    smithPredictorInit(&predictor, 3.0f, 1.0f, 10000, LOOPTIME_US);
+    EXPECT_TRUE(predictor.enabled);
+    EXPECT_EQ(3, predictor.samples);
+
+    for (int i = 1; i <= 20; i++) {
+        applySmithPredictor(0, &predictor, i);
+    }
+
+    smithPredictorSetDelaySamples(&predictor, 5);
+    const float predicted = applySmithPredictor(0, &predictor, 21);
+    EXPECT_NEAR(2 * 21 - 16, predicted, 1.0f);
+}
+
+TEST(SmithPredictorTest, TestSetDelayDoesNotEnable)
+{
+    smithPredictor_t predictor;
+    memset(&predictor, 0, sizeof(predictor));
+
+    smithPredictorInit(&predictor, 0.0f, 1.0f, 10000, LOOPTIME_US);
+    EXPECT_FALSE(predictor.enabled);
+
+    smithPredictorSetDelaySamples(&predictor, 5);
+    EXPECT_FALSE(predictor.enabled);
+    EXPECT_EQ(7.0f, applySmithPredictor(0, &predictor, 7.0f));
+}
+
+TEST(SmithPredictorTest, TestDelayIdentificationWithGyroNoise)
+{
+    // Noise through P and D is much larger than the response to it, it must not pull the estimate down
+    const plant_t plant = { .gain = 0.01f, .lpfHz = 0, .gyroNoise = 0.05f, .dGain = 20.0f };
+
+    for (int delay = 3; delay <= 6; delay++) {
+        EXPECT_NEAR(delay, identifyDelay(delay, &plant, 40000), 0.5f) << "plant delay " << delay;
+    }
+}